@@ -75,11 +75,17 @@ while [ $STEP -lt $NUM_IT ]; do
         if notExists "$TMP_PATH/aln_$STEP.dbtype"; then
             STEPONE=$((STEP-1))
 
+            # queries without new hits keep their profile and would find the same hits again
+            if [ -n "$SKIP_CONVERGED" ] && [ $STEP -ne $((NUM_IT  - 1)) ]; then
+                awk '$3 > 1 { print $1 }' "$TMP_PATH/aln_tmp_$STEP.index" > "$TMP_PATH/changed_$STEP" \
+                    || fail "Awk step $STEP died"
+            fi
+            # merge over all queries, converged ones are not part of $QUERYDB anymore
             if [ $STEP -ne $((NUM_IT  - 1)) ]; then
-                "$MMSEQS" mergedbs "$QUERYDB" "$TMP_PATH/aln_$STEP" "$TMP_PATH/aln_$STEPONE" "$TMP_PATH/aln_tmp_$STEP" \
+                "$MMSEQS" mergedbs "$1" "$TMP_PATH/aln_$STEP" "$TMP_PATH/aln_$STEPONE" "$TMP_PATH/aln_tmp_$STEP" \
                     || fail "Alignment died"
             else
-                "$MMSEQS" mergedbs "$QUERYDB" "$3" "$TMP_PATH/aln_$STEPONE" "$TMP_PATH/aln_tmp_$STEP" \
+                "$MMSEQS" mergedbs "$1" "$3" "$TMP_PATH/aln_$STEPONE" "$TMP_PATH/aln_tmp_$STEP" \
                         || fail "Alignment died"
             fi
             "$MMSEQS" rmdb "$TMP_PATH/aln_$STEPONE"
@@ -89,12 +95,26 @@ while [ $STEP -lt $NUM_IT ]; do
 
 # create profiles
     if [ $STEP -ne $((NUM_IT  - 1)) ]; then
+        if [ -f "$TMP_PATH/changed_$STEP" ] && [ ! -s "$TMP_PATH/changed_$STEP" ]; then
+            # all queries converged, the remaining iterations would not find anything new
+            "$MMSEQS" mvdb "$TMP_PATH/aln_$STEP" "$3" || fail "Mvdb died"
+            break
+        fi
         if notExists "$TMP_PATH/profile_$STEP.dbtype"; then
+            PROFILE_INPUT="$TMP_PATH/aln_$STEP"
+            if [ -f "$TMP_PATH/changed_$STEP" ]; then
+                "$MMSEQS" createsubdb "$TMP_PATH/changed_$STEP" "$TMP_PATH/aln_$STEP" "$TMP_PATH/aln_changed_$STEP" --subdb-mode 1 \
+                    || fail "Createsubdb died"
+                PROFILE_INPUT="$TMP_PATH/aln_changed_$STEP"
+            fi
             PARAM="PROFILE_PAR_$STEP"
             eval TMP="\$$PARAM"
             # shellcheck disable=SC2086
-            $RUNNER "$MMSEQS" result2profile "$QUERYDB" "$2" "$TMP_PATH/aln_$STEP" "$TMP_PATH/profile_$STEP" ${TMP} \
+            $RUNNER "$MMSEQS" result2profile "$QUERYDB" "$2" "$PROFILE_INPUT" "$TMP_PATH/profile_$STEP" ${TMP} \
             || fail "Create profile died"
+            if [ -f "$TMP_PATH/changed_$STEP" ]; then
+                "$MMSEQS" rmdb "$TMP_PATH/aln_changed_$STEP"
+            fi
         fi
     fi
 	QUERYDB="$TMP_PATH/profile_$STEP"
@@ -108,6 +128,7 @@ if [ -n "$REMOVE_TMP" ]; then
         "$MMSEQS" rmdb "${TMP_PATH}/pref_$STEP"
         "$MMSEQS" rmdb "${TMP_PATH}/aln_$STEP"
         "$MMSEQS" rmdb "${TMP_PATH}/profile_$STEP"
+        rm -f "${TMP_PATH}/changed_$STEP"
         STEP=$((STEP+1))
     done
     rm -f "$TMP_PATH/blastpgp.sh"
@@ -52,6 +52,8 @@ cp -f "${NCBITAXINFO}/names.dmp"     "${TAXDBNAME}_names.dmp"
 cp -f "${NCBITAXINFO}/nodes.dmp"     "${TAXDBNAME}_nodes.dmp"
 cp -f "${NCBITAXINFO}/merged.dmp"    "${TAXDBNAME}_merged.dmp"
 cp -f "${NCBITAXINFO}/delnodes.dmp"  "${TAXDBNAME}_delnodes.dmp"
+"$MMSEQS" createbintaxonomy "${TAXDBNAME}" \
+    || { echo "createbintaxonomy died"; exit 1; }
 echo "Database created"
 
 if [ -n "$REMOVE_TMP" ]; then
@@ -183,9 +183,9 @@ echo "==================================================="
 echo "======= Extract representative sequences =========="
 echo "==================================================="
 if notExists "${TMP_PATH}/OLDDB.repSeq.dbtype"; then
-    "$MMSEQS" result2repseq "$OLDDB" "$OLDCLUST" "${TMP_PATH}/OLDDB.repSeq" \
-    || fail "result2repseq died"
-    ln -sf "${OLDDB}.dbtype" "${TMP_PATH}/OLDDB.repSeq.dbtype"
+    # shellcheck disable=SC2086
+    "$MMSEQS" createsubdb "$OLDCLUST" "$OLDDB" "${TMP_PATH}/OLDDB.repSeq" ${VERBOSITY} --subdb-mode 1 \
+        || fail "Order of rep. seq. died"
 fi
 
 debugWait
@@ -200,55 +200,14 @@ if notExists "${TMP_PATH}/newSeqsHits.dbtype"; then
         || fail "Search died"
 fi
 
-if notExists "${TMP_PATH}/newSeqsHits.swapped.all"; then
-    "$MMSEQS" swapdb "${TMP_PATH}/newSeqsHits" "${TMP_PATH}/newSeqsHits.swapped.all" \
-        || fail "Swapresults died"
-fi
-
-if [ -s "${TMP_PATH}/newSeqsHits.swapped.all.index" ]; then
-    if notExists "${TMP_PATH}/newSeqsHits.swapped"; then
-        "$MMSEQS" filterdb "${TMP_PATH}/newSeqsHits.swapped.all" "${TMP_PATH}/newSeqsHits.swapped" --trim-to-one-column \
-            || fail "Trimming died"
-    fi
-fi
-
 debugWait
 echo "==================================================="
 echo "=  Merge found sequences with previous clustering ="
 echo "==================================================="
-if [ -f "${TMP_PATH}/newSeqsHits.swapped.dbtype" ]; then
-    if notExists "${TMP_PATH}/updatedClust.dbtype"; then
-        "$MMSEQS" mergedbs "$OLDCLUST" "${TMP_PATH}/updatedClust" "$OLDCLUST" "${TMP_PATH}/newSeqsHits.swapped" \
-            || fail "Mergeffindex died"
-    fi
-else
-    if notExists "${TMP_PATH}/updatedClust"; then
-        ln -sf "$OLDCLUST" "${TMP_PATH}/updatedClust" \
-            || fail "Mv Oldclust to update died"
-    fi
-    if notExists "${TMP_PATH}/updatedClust.index"; then
-        ln -sf "$OLDCLUST.index" "${TMP_PATH}/updatedClust.index" \
-            || fail "Mv Oldclust to update died"
-    fi
-    if notExists "${TMP_PATH}/updatedClust.dbtype"; then
-        ln -sf "$OLDCLUST.dbtype" "${TMP_PATH}/updatedClust.dbtype" \
-            || fail "Mv Oldclust to update died"
-    fi
-fi
-
-debugWait
-echo "==================================================="
-echo "=========== Extract unmapped sequences ============"
-echo "==================================================="
-if notExists "${TMP_PATH}/noHitSeqList.dbtype"; then
-    awk '$3==1 {print $1}' "${TMP_PATH}/newSeqsHits.index" > "${TMP_PATH}/noHitSeqList" \
-        || fail "awk died"
-fi
-if notExists "${TMP_PATH}/toBeClusteredSeparately.dbtype"; then
+if notExists "${TMP_PATH}/updatedClust.dbtype"; then
     # shellcheck disable=SC2086
-    "$MMSEQS" createsubdb "${TMP_PATH}/noHitSeqList" "$NEWDB" "${TMP_PATH}/toBeClusteredSeparately" ${VERBOSITY} --subdb-mode 1 \
-        || fail "Order of no hit seq. died"
-    ln -sf "${NEWDB}.dbtype" "${TMP_PATH}/toBeClusteredSeparately.dbtype"
+    "$MMSEQS" addtoclusters "${TMP_PATH}/newSeqsHits" "$OLDCLUST" "$NEWDB" "${TMP_PATH}/updatedClust" "${TMP_PATH}/toBeClusteredSeparately" ${THREADS_COMP_PAR} \
+        || fail "Adding to clusters died"
 fi
 
 debugWait
@@ -258,7 +217,7 @@ echo "==================================================="
 
 mkdir -p "${TMP_PATH}/cluster"
 if notExists "${TMP_PATH}/newClusters.dbtype"; then
-    if  [ -s "${TMP_PATH}/toBeClusteredSeparately" ]; then
+    if  [ -s "${TMP_PATH}/toBeClusteredSeparately.index" ]; then
         # shellcheck disable=SC2086
         "$MMSEQS" cluster "${TMP_PATH}/toBeClusteredSeparately" "${TMP_PATH}/newClusters" "${TMP_PATH}/cluster" ${CLUST_PAR} \
             || fail "Clustering of new seq. died"
@@ -283,14 +242,12 @@ debugWait
 if [ -n "$REMOVE_TMP" ]; then
     echo "Remove temporary files 3/3"
     rm -f "${TMP_PATH}/newSeqs.mapped" "${TMP_PATH}/mappingSeqs.reverse" "${TMP_PATH}/newMappingSeqs"
-	rm -f  "${TMP_PATH}/noHitSeqList" "${TMP_PATH}/mappingSeqs" "${TMP_PATH}/newSeqs" "${TMP_PATH}/removedSeqs"
+	rm -f "${TMP_PATH}/mappingSeqs" "${TMP_PATH}/newSeqs" "${TMP_PATH}/removedSeqs"
 
-	"$MMSEQS" rmdb "${TMP_PATH}/newSeqsHits.swapped"
 	"$MMSEQS" rmdb "${TMP_PATH}/newClusters"
 	"$MMSEQS" rmdb "${TMP_PATH}/newSeqsHits"
 	"$MMSEQS" rmdb "${TMP_PATH}/toBeClusteredSeparately"
 	"$MMSEQS" rmdb "${TMP_PATH}/NEWDB.newSeqs"
-    "$MMSEQS" rmdb "${TMP_PATH}/newSeqsHits.swapped.all"
 	"$MMSEQS" rmdb "${TMP_PATH}/OLDDB.repSeq"
 	"$MMSEQS" rmdb "${TMP_PATH}/updatedClust"
 
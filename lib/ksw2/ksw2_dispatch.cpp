@@ -0,0 +1,70 @@
+/*
+The MIT License
+
+Copyright (c) 2018-     Dana-Farber Cancer Institute
+              2017-2018 Broad Institute, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+See: https://github.com/lh3/minimap2
+ */
+
+#include "ksw2.h"
+
+typedef void (*ksw_extz2_func_t)(void *km, int qlen, const uint8_t *query, int tlen, const uint8_t *target, int8_t m, const int8_t *mat, int8_t q, int8_t e, int w, int zdrop, int flag, ksw_extz_t *ez);
+
+static ksw_extz2_func_t ksw_extz2_func(int isa)
+{
+#if defined(KSW_HAVE_AVX512)
+	if (isa >= KSW_ISA_AVX512) return ksw_extz2_avx512;
+#endif
+#if defined(KSW_HAVE_AVX2)
+	if (isa >= KSW_ISA_AVX2) return ksw_extz2_avx2;
+#endif
+	(void)isa;
+	return ksw_extz2_sse;
+}
+
+int ksw_extz2_best_isa(void)
+{
+#if !defined(NEON) && (defined(__GNUC__) || defined(__clang__))
+	__builtin_cpu_init();
+#if defined(KSW_HAVE_AVX512)
+	if (__builtin_cpu_supports("avx512bw")) return KSW_ISA_AVX512;
+#endif
+#if defined(KSW_HAVE_AVX2)
+	if (__builtin_cpu_supports("avx2")) return KSW_ISA_AVX2;
+#endif
+#endif
+	return KSW_ISA_SSE;
+}
+
+void ksw_extz2_isa(int isa, void *km, int qlen, const uint8_t *query, int tlen, const uint8_t *target, int8_t m, const int8_t *mat, int8_t q, int8_t e, int w, int zdrop, int flag, ksw_extz_t *ez)
+{
+	ksw_extz2_func(isa)(km, qlen, query, tlen, target, m, mat, q, e, w, zdrop, flag, ez);
+}
+
+void ksw_extz2_simd(void *km, int qlen, const uint8_t *query, int tlen, const uint8_t *target, int8_t m, const int8_t *mat, int8_t q, int8_t e, int w, int zdrop, int flag, ksw_extz_t *ez)
+{
+	// resolved once, thread-safe static initialization
+	static const ksw_extz2_func_t func = ksw_extz2_func(ksw_extz2_best_isa());
+	func(km, qlen, query, tlen, target, m, mat, q, e, w, zdrop, flag, ez);
+}
@@ -0,0 +1,79 @@
+/*
+The MIT License
+
+Copyright (c) 2018-     Dana-Farber Cancer Institute
+              2017-2018 Broad Institute, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+See: https://github.com/lh3/minimap2
+ */
+
+#include <string.h>
+#include <assert.h>
+#include "ksw2.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+typedef __m256i ksw_vec_t;
+typedef __m256i ksw_h_vec_t;
+
+#define KSW_FUNC ksw_extz2_avx2
+#define KSW_W 32
+#define KSW_W32 8
+
+#define KSW_LOAD(p)          _mm256_load_si256((const __m256i*)(p))
+#define KSW_LOADU(p)         _mm256_loadu_si256((const __m256i*)(p))
+#define KSW_STORE(p, a)      _mm256_store_si256((__m256i*)(p), (a))
+#define KSW_STOREU(p, a)     _mm256_storeu_si256((__m256i*)(p), (a))
+#define KSW_SET1(a)          _mm256_set1_epi8(a)
+#define KSW_ADD8(a, b)       _mm256_add_epi8((a), (b))
+#define KSW_SUB8(a, b)       _mm256_sub_epi8((a), (b))
+#define KSW_MAX8(a, b)       _mm256_max_epi8((a), (b))
+#define KSW_MAXU8(a, b)      _mm256_max_epu8((a), (b))
+#define KSW_MINU8(a, b)      _mm256_min_epu8((a), (b))
+#define KSW_CMPEQ8(a, b)     _mm256_cmpeq_epi8((a), (b))
+#define KSW_CMPGT8(a, b)     _mm256_cmpgt_epi8((a), (b))
+#define KSW_BLENDV(a, b, m)  _mm256_blendv_epi8((a), (b), (m))
+#define KSW_AND(a, b)        _mm256_and_si256((a), (b))
+#define KSW_OR(a, b)         _mm256_or_si256((a), (b))
+#define KSW_ANDNOT(a, b)     _mm256_andnot_si256((a), (b))
+// byte shifts of _mm256 work per 128-bit lane, carry the lane boundary byte with a lane permute
+#define KSW_SHL1(a, c)       _mm256_or_si256(_mm256_alignr_epi8((a), _mm256_permute2x128_si256((a), (a), 0x08), 15), (c))
+#define KSW_TOP(a)           _mm256_srli_si256(_mm256_permute2x128_si256((a), (a), 0x81), 15)
+#define KSW_BYTE0(v)         _mm256_inserti128_si256(_mm256_setzero_si256(), _mm_cvtsi32_si128((uint8_t)(v)), 0)
+
+#define KSW_H_SET1(a)        _mm256_set1_epi32(a)
+#define KSW_H_LOADU(p)       _mm256_loadu_si256((const __m256i*)(p))
+#define KSW_H_STOREU(p, a)   _mm256_storeu_si256((__m256i*)(p), (a))
+#define KSW_H_ADD(a, b)      _mm256_add_epi32((a), (b))
+#define KSW_H_SUB(a, b)      _mm256_sub_epi32((a), (b))
+#define KSW_H_CVTU8(p)       _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(p)))
+#define KSW_H_MAXSEL(maxH, maxT, h, t) { \
+	__m256i gt_ = _mm256_cmpgt_epi32((h), (maxH)); \
+	(maxH) = _mm256_blendv_epi8((maxH), (h), gt_); \
+	(maxT) = _mm256_blendv_epi8((maxT), (t), gt_); \
+}
+
+#include "ksw2_extz2_wide.h"
+
+#endif // __AVX2__
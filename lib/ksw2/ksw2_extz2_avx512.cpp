@@ -0,0 +1,80 @@
+/*
+The MIT License
+
+Copyright (c) 2018-     Dana-Farber Cancer Institute
+              2017-2018 Broad Institute, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+See: https://github.com/lh3/minimap2
+ */
+
+#include <string.h>
+#include <assert.h>
+#include "ksw2.h"
+
+#if defined(__AVX512BW__)
+#include <immintrin.h>
+
+typedef __m512i ksw_vec_t;
+typedef __m512i ksw_h_vec_t;
+
+#define KSW_FUNC ksw_extz2_avx512
+#define KSW_W 64
+#define KSW_W32 16
+
+// AVX-512 compares produce mask registers, expand them to byte masks to keep the SSE data flow
+#define KSW_LOAD(p)          _mm512_load_si512((const void*)(p))
+#define KSW_LOADU(p)         _mm512_loadu_si512((const void*)(p))
+#define KSW_STORE(p, a)      _mm512_store_si512((void*)(p), (a))
+#define KSW_STOREU(p, a)     _mm512_storeu_si512((void*)(p), (a))
+#define KSW_SET1(a)          _mm512_set1_epi8(a)
+#define KSW_ADD8(a, b)       _mm512_add_epi8((a), (b))
+#define KSW_SUB8(a, b)       _mm512_sub_epi8((a), (b))
+#define KSW_MAX8(a, b)       _mm512_max_epi8((a), (b))
+#define KSW_MAXU8(a, b)      _mm512_max_epu8((a), (b))
+#define KSW_MINU8(a, b)      _mm512_min_epu8((a), (b))
+#define KSW_CMPEQ8(a, b)     _mm512_movm_epi8(_mm512_cmpeq_epi8_mask((a), (b)))
+#define KSW_CMPGT8(a, b)     _mm512_movm_epi8(_mm512_cmpgt_epi8_mask((a), (b)))
+#define KSW_BLENDV(a, b, m)  _mm512_mask_blend_epi8(_mm512_movepi8_mask(m), (a), (b))
+#define KSW_AND(a, b)        _mm512_and_si512((a), (b))
+#define KSW_OR(a, b)         _mm512_or_si512((a), (b))
+#define KSW_ANDNOT(a, b)     _mm512_andnot_si512((a), (b))
+// move every 128-bit lane up by one, then shift bytes within the lanes
+#define KSW_SHL1(a, c)       _mm512_or_si512(_mm512_alignr_epi8((a), _mm512_alignr_epi64((a), _mm512_setzero_si512(), 6), 15), (c))
+#define KSW_TOP(a)           _mm512_srli_epi64(_mm512_alignr_epi64(_mm512_setzero_si512(), (a), 7), 56)
+#define KSW_BYTE0(v)         _mm512_inserti32x4(_mm512_setzero_si512(), _mm_cvtsi32_si128((uint8_t)(v)), 0)
+
+#define KSW_H_SET1(a)        _mm512_set1_epi32(a)
+#define KSW_H_LOADU(p)       _mm512_loadu_si512((const void*)(p))
+#define KSW_H_STOREU(p, a)   _mm512_storeu_si512((void*)(p), (a))
+#define KSW_H_ADD(a, b)      _mm512_add_epi32((a), (b))
+#define KSW_H_SUB(a, b)      _mm512_sub_epi32((a), (b))
+#define KSW_H_CVTU8(p)       _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*)(p)))
+#define KSW_H_MAXSEL(maxH, maxT, h, t) { \
+	__mmask16 gt_ = _mm512_cmpgt_epi32_mask((h), (maxH)); \
+	(maxH) = _mm512_mask_blend_epi32(gt_, (maxH), (h)); \
+	(maxT) = _mm512_mask_blend_epi32(gt_, (maxT), (t)); \
+}
+
+#include "ksw2_extz2_wide.h"
+
+#endif // __AVX512BW__
@@ -0,0 +1,282 @@
+/*
+The MIT License
+
+Copyright (c) 2018-     Dana-Farber Cancer Institute
+              2017-2018 Broad Institute, Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+See: https://github.com/lh3/minimap2
+ */
+
+// Width independent body of ksw_extz2 for 256-bit and 512-bit registers.
+// It is a line by line port of the SSE4.1 path in ksw2_extz2_sse.cpp and is
+// included by ksw2_extz2_avx2.cpp and ksw2_extz2_avx512.cpp, which define
+// the vector primitives below before including this file:
+//
+//   KSW_FUNC                 name of the generated function
+//   KSW_W                    register width in bytes
+//   ksw_vec_t                register type
+//   KSW_* 8-bit ops          load/store/add/sub/max/min/cmp/blend/and/or/andnot
+//   KSW_SHL1(x, c)           shift x up by one byte across the whole register, c in byte 0
+//   KSW_TOP(x)               the highest byte of x moved to byte 0
+//   KSW_BYTE0(v)             register with byte 0 set to v
+//   KSW_W32 and KSW_H_*      32-bit lanes used to compute the exact max
+
+void KSW_FUNC(void *km, int qlen, const uint8_t *query, int tlen, const uint8_t *target, int8_t m, const int8_t *mat, int8_t q, int8_t e, int w, int zdrop, int flag, ksw_extz_t *ez)
+{
+#define __dp_code_block1 \
+	z = KSW_ADD8(KSW_LOAD(&s[t]), qe2_); \
+	xt1 = KSW_LOAD(&x[t]);                           /* xt1 <- x[r-1][t..t+W-1] */ \
+	tmp = KSW_TOP(xt1);                              /* tmp <- x[r-1][t+W-1] */ \
+	xt1 = KSW_SHL1(xt1, x1_);                        /* xt1 <- x[r-1][t-1..t+W-2] */ \
+	x1_ = tmp; \
+	vt1 = KSW_LOAD(&v[t]);                           /* vt1 <- v[r-1][t..t+W-1] */ \
+	tmp = KSW_TOP(vt1);                              /* tmp <- v[r-1][t+W-1] */ \
+	vt1 = KSW_SHL1(vt1, v1_);                        /* vt1 <- v[r-1][t-1..t+W-2] */ \
+	v1_ = tmp; \
+	a = KSW_ADD8(xt1, vt1);                          /* a <- x[r-1][t-1..t+W-2] + v[r-1][t-1..t+W-2] */ \
+	ut = KSW_LOAD(&u[t]);                            /* ut <- u[t..t+W-1] */ \
+	b = KSW_ADD8(KSW_LOAD(&y[t]), ut);               /* b <- y[r-1][t..t+W-1] + u[r-1][t..t+W-1] */
+
+#define __dp_code_block2 \
+	z = KSW_MAXU8(z, b);                             /* z = max(z, b); this works because both are non-negative */ \
+	z = KSW_MINU8(z, max_sc_); \
+	KSW_STORE(&u[t], KSW_SUB8(z, vt1));              /* u[r][t..t+W-1] <- z - v[r-1][t-1..t+W-2] */ \
+	KSW_STORE(&v[t], KSW_SUB8(z, ut));               /* v[r][t..t+W-1] <- z - u[r-1][t..t+W-1] */ \
+	z = KSW_SUB8(z, q_); \
+	a = KSW_SUB8(a, z); \
+	b = KSW_SUB8(b, z);
+
+	int r, t, qe = q + e, n_col_, *off = 0, *off_end = 0, tlen_, qlen_, last_st, last_en, wl, wr, max_sc, min_sc;
+	int with_cigar = !(flag&KSW_EZ_SCORE_ONLY), approx_max = !!(flag&KSW_EZ_APPROX_MAX);
+	int32_t *H = 0, H0 = 0, last_H0_t = 0;
+	uint8_t *qr, *sf, *mem, *mem2 = 0;
+	ksw_vec_t q_, qe2_, zero_, flag1_, flag2_, flag8_, flag16_, sc_mch_, sc_mis_, m1_, max_sc_;
+	ksw_vec_t *u, *v, *x, *y, *s, *p = 0;
+
+	ksw_reset_extz(ez);
+	if (m <= 0 || qlen <= 0 || tlen <= 0) return;
+
+	zero_   = KSW_SET1(0);
+	q_      = KSW_SET1(q);
+	qe2_    = KSW_SET1((q + e) * 2);
+	flag1_  = KSW_SET1(1);
+	flag2_  = KSW_SET1(2);
+	flag8_  = KSW_SET1(0x08);
+	flag16_ = KSW_SET1(0x10);
+	sc_mch_ = KSW_SET1(mat[0]);
+	sc_mis_ = KSW_SET1(mat[1]);
+	m1_     = KSW_SET1(m - 1); // wildcard
+	max_sc_ = KSW_SET1(mat[0] + (q + e) * 2);
+
+	if (w < 0) w = tlen > qlen? tlen : qlen;
+	wl = wr = w;
+	tlen_ = (tlen + KSW_W - 1) / KSW_W;
+	n_col_ = qlen < tlen? qlen : tlen;
+	n_col_ = ((n_col_ < w + 1? n_col_ : w + 1) + KSW_W - 1) / KSW_W + 1;
+	qlen_ = (qlen + KSW_W - 1) / KSW_W;
+	for (t = 1, max_sc = mat[0], min_sc = mat[1]; t < m * m; ++t) {
+		max_sc = max_sc > mat[t]? max_sc : mat[t];
+		min_sc = min_sc < mat[t]? min_sc : mat[t];
+	}
+	if (-min_sc > 2 * (q + e)) return; // otherwise, we won't see any mismatches
+
+	mem = (uint8_t*)kcalloc(km, tlen_ * 6 + qlen_ + 1, KSW_W);
+	u = (ksw_vec_t*)(((size_t)mem + KSW_W - 1) / KSW_W * KSW_W); // register aligned
+	v = u + tlen_, x = v + tlen_, y = x + tlen_, s = y + tlen_, sf = (uint8_t*)(s + tlen_), qr = sf + tlen_ * KSW_W;
+	if (!approx_max) {
+		H = (int32_t*)kmalloc(km, tlen_ * KSW_W * 4);
+		for (t = 0; t < tlen_ * KSW_W; ++t) H[t] = KSW_NEG_INF;
+	}
+	if (with_cigar) {
+		mem2 = (uint8_t*)kmalloc(km, ((qlen + tlen - 1) * n_col_ + 1) * KSW_W);
+		p = (ksw_vec_t*)(((size_t)mem2 + KSW_W - 1) / KSW_W * KSW_W);
+		off = (int*)kmalloc(km, (qlen + tlen - 1) * sizeof(int) * 2);
+		off_end = off + qlen + tlen - 1;
+	}
+
+	for (t = 0; t < qlen; ++t) qr[t] = query[qlen - 1 - t];
+	memcpy(sf, target, tlen);
+
+	for (r = 0, last_st = last_en = -1; r < qlen + tlen - 1; ++r) {
+		int st = 0, en = tlen - 1, st0, en0, st_, en_;
+		int8_t x1, v1;
+		uint8_t *qrr = qr + (qlen - 1 - r), *u8 = (uint8_t*)u, *v8 = (uint8_t*)v;
+		ksw_vec_t x1_, v1_;
+		// find the boundaries
+		if (st < r - qlen + 1) st = r - qlen + 1;
+		if (en > r) en = r;
+		if (st < (r-wr+1)>>1) st = (r-wr+1)>>1; // take the ceil
+		if (en > (r+wl)>>1) en = (r+wl)>>1; // take the floor
+		if (st > en) {
+			ez->zdropped = 1;
+			break;
+		}
+		st0 = st, en0 = en;
+		st = st / KSW_W * KSW_W, en = (en + KSW_W) / KSW_W * KSW_W - 1;
+		// set boundary conditions
+		if (st > 0) {
+			if (st - 1 >= last_st && st - 1 <= last_en)
+				x1 = ((uint8_t*)x)[st - 1], v1 = v8[st - 1]; // (r-1,s-1) calculated in the last round
+			else x1 = v1 = 0; // not calculated; set to zeros
+		} else x1 = 0, v1 = r? q : 0;
+		if (en >= r) ((uint8_t*)y)[r] = 0, u8[r] = r? q : 0;
+		// loop fission: set scores first
+		if (!(flag & KSW_EZ_GENERIC_SC)) {
+			for (t = st0; t <= en0; t += KSW_W) {
+				ksw_vec_t sq, st, tmp, mask;
+				sq = KSW_LOADU(&sf[t]);
+				st = KSW_LOADU(&qrr[t]);
+				mask = KSW_OR(KSW_CMPEQ8(sq, m1_), KSW_CMPEQ8(st, m1_));
+				tmp = KSW_CMPEQ8(sq, st);
+				tmp = KSW_BLENDV(sc_mis_, sc_mch_, tmp);
+				tmp = KSW_ANDNOT(mask, tmp);
+				KSW_STOREU((uint8_t*)s + t, tmp);
+			}
+		} else {
+			for (t = st0; t <= en0; ++t)
+				((uint8_t*)s)[t] = mat[sf[t] * m + qrr[t]];
+		}
+		// core loop
+		x1_ = KSW_BYTE0(x1);
+		v1_ = KSW_BYTE0(v1);
+		st_ = st / KSW_W, en_ = en / KSW_W;
+		assert(en_ - st_ + 1 <= n_col_);
+		if (!with_cigar) { // score only
+			for (t = st_; t <= en_; ++t) {
+				ksw_vec_t z, a, b, xt1, vt1, ut, tmp;
+				__dp_code_block1;
+				z = KSW_MAX8(z, a);                              // z = z > a? z : a (signed)
+				__dp_code_block2;
+				KSW_STORE(&x[t], KSW_MAX8(a, zero_));
+				KSW_STORE(&y[t], KSW_MAX8(b, zero_));
+			}
+		} else if (!(flag&KSW_EZ_RIGHT)) { // gap left-alignment
+			ksw_vec_t *pr = p + r * n_col_ - st_;
+			off[r] = st, off_end[r] = en;
+			for (t = st_; t <= en_; ++t) {
+				ksw_vec_t d, z, a, b, xt1, vt1, ut, tmp;
+				__dp_code_block1;
+				d = KSW_AND(KSW_CMPGT8(a, z), flag1_);          // d = a > z? 1 : 0
+				z = KSW_MAX8(z, a);                              // z = z > a? z : a (signed)
+				tmp = KSW_CMPGT8(b, z);
+				d = KSW_BLENDV(d, flag2_, tmp);                  // d = b > z? 2 : d
+				__dp_code_block2;
+				tmp = KSW_CMPGT8(a, zero_);
+				KSW_STORE(&x[t], KSW_AND(tmp, a));
+				d = KSW_OR(d, KSW_AND(tmp, flag8_));             // d = a > 0? 0x08 : 0
+				tmp = KSW_CMPGT8(b, zero_);
+				KSW_STORE(&y[t], KSW_AND(tmp, b));
+				d = KSW_OR(d, KSW_AND(tmp, flag16_));            // d = b > 0? 0x10 : 0
+				KSW_STORE(&pr[t], d);
+			}
+		} else { // gap right-alignment
+			ksw_vec_t *pr = p + r * n_col_ - st_;
+			off[r] = st, off_end[r] = en;
+			for (t = st_; t <= en_; ++t) {
+				ksw_vec_t d, z, a, b, xt1, vt1, ut, tmp;
+				__dp_code_block1;
+				d = KSW_ANDNOT(KSW_CMPGT8(z, a), flag1_);       // d = z > a? 0 : 1
+				z = KSW_MAX8(z, a);                              // z = z > a? z : a (signed)
+				tmp = KSW_CMPGT8(z, b);
+				d = KSW_BLENDV(flag2_, d, tmp);                  // d = z > b? d : 2
+				__dp_code_block2;
+				tmp = KSW_CMPGT8(zero_, a);
+				KSW_STORE(&x[t], KSW_ANDNOT(tmp, a));
+				d = KSW_OR(d, KSW_ANDNOT(tmp, flag8_));          // d = 0 > a? 0 : 0x08
+				tmp = KSW_CMPGT8(zero_, b);
+				KSW_STORE(&y[t], KSW_ANDNOT(tmp, b));
+				d = KSW_OR(d, KSW_ANDNOT(tmp, flag16_));         // d = 0 > b? 0 : 0x10
+				KSW_STORE(&pr[t], d);
+			}
+		}
+		if (!approx_max) { // find the exact max with a 32-bit score array
+			int32_t max_H, max_t;
+			// compute H[], max_H and max_t
+			if (r > 0) {
+				int32_t HH[KSW_W32], tt[KSW_W32], en1 = st0 + (en0 - st0) / KSW_W32 * KSW_W32, i;
+				ksw_h_vec_t max_H_, max_t_, qe_;
+				max_H = H[en0] = en0 > 0? H[en0-1] + u8[en0] - qe : H[en0] + v8[en0] - qe; // special casing the last element
+				max_t = en0;
+				max_H_ = KSW_H_SET1(max_H);
+				max_t_ = KSW_H_SET1(max_t);
+				qe_    = KSW_H_SET1(q + e);
+				for (t = st0; t < en1; t += KSW_W32) { // this implements: H[t]+=v8[t]-qe; if(H[t]>max_H) max_H=H[t],max_t=t;
+					ksw_h_vec_t H1, t_;
+					H1 = KSW_H_LOADU(&H[t]);
+					t_ = KSW_H_CVTU8(&v8[t]);
+					H1 = KSW_H_ADD(H1, t_);
+					H1 = KSW_H_SUB(H1, qe_);
+					KSW_H_STOREU(&H[t], H1);
+					t_ = KSW_H_SET1(t);
+					KSW_H_MAXSEL(max_H_, max_t_, H1, t_);
+				}
+				KSW_H_STOREU(HH, max_H_);
+				KSW_H_STOREU(tt, max_t_);
+				for (i = 0; i < KSW_W32; ++i)
+					if (max_H < HH[i]) max_H = HH[i], max_t = tt[i] + i;
+				for (; t < en0; ++t) { // for the rest of values that haven't been computed with SIMD
+					H[t] += (int32_t)v8[t] - qe;
+					if (H[t] > max_H)
+						max_H = H[t], max_t = t;
+				}
+			} else H[0] = v8[0] - qe - qe, max_H = H[0], max_t = 0; // special casing r==0
+			// update ez
+			if (en0 == tlen - 1 && H[en0] > ez->mte)
+				ez->mte = H[en0], ez->mte_q = r - en;
+			if (r - st0 == qlen - 1 && H[st0] > ez->mqe)
+				ez->mqe = H[st0], ez->mqe_t = st0;
+			if (ksw_apply_zdrop(ez, 1, max_H, r, max_t, zdrop, e)) break;
+			if (r == qlen + tlen - 2 && en0 == tlen - 1)
+				ez->score = H[tlen - 1];
+		} else { // find approximate max; Z-drop might be inaccurate, too.
+			if (r > 0) {
+				if (last_H0_t >= st0 && last_H0_t <= en0 && last_H0_t + 1 >= st0 && last_H0_t + 1 <= en0) {
+					int32_t d0 = v8[last_H0_t] - qe;
+					int32_t d1 = u8[last_H0_t + 1] - qe;
+					if (d0 > d1) H0 += d0;
+					else H0 += d1, ++last_H0_t;
+				} else if (last_H0_t >= st0 && last_H0_t <= en0) {
+					H0 += v8[last_H0_t] - qe;
+				} else {
+					++last_H0_t, H0 += u8[last_H0_t] - qe;
+				}
+				if ((flag & KSW_EZ_APPROX_DROP) && ksw_apply_zdrop(ez, 1, H0, r, last_H0_t, zdrop, e)) break;
+			} else H0 = v8[0] - qe - qe, last_H0_t = 0;
+			if (r == qlen + tlen - 2 && en0 == tlen - 1)
+				ez->score = H0;
+		}
+		last_st = st, last_en = en;
+	}
+	kfree(km, mem);
+	if (!approx_max) kfree(km, H);
+	if (with_cigar) { // backtrack
+		int rev_cigar = !!(flag & KSW_EZ_REV_CIGAR);
+		if (!ez->zdropped && !(flag&KSW_EZ_EXTZ_ONLY))
+			ksw_backtrack(km, 1, rev_cigar, 0, (uint8_t*)p, off, off_end, n_col_*KSW_W, tlen-1, qlen-1, &ez->m_cigar, &ez->n_cigar, &ez->cigar);
+		else if (ez->max_t >= 0 && ez->max_q >= 0)
+			ksw_backtrack(km, 1, rev_cigar, 0, (uint8_t*)p, off, off_end, n_col_*KSW_W, ez->max_t, ez->max_q, &ez->m_cigar, &ez->n_cigar, &ez->cigar);
+		kfree(km, mem2); kfree(km, off);
+	}
+#undef __dp_code_block1
+#undef __dp_code_block2
+}
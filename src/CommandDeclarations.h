@@ -56,6 +56,7 @@ extern int taxonomyreport(int argc, const char **argv, const Command& command);
 extern int linclust(int argc, const char **argv, const Command& command);
 extern int map(int argc, const char **argv, const Command& command);
 extern int maskbygff(int argc, const char **argv, const Command& command);
+extern int addtoclusters(int argc, const char **argv, const Command& command);
 extern int mergeclusters(int argc, const char **argv, const Command& command);
 extern int mergedbs(int argc, const char **argv, const Command& command);
 extern int mergeresultsbyset(int argc, const char **argv, const Command &command);
@@ -99,6 +100,7 @@ extern int swapresults(int argc, const char **argv, const Command& command);
 extern int taxonomy(int argc, const char **argv, const Command& command);
 extern int easytaxonomy(int argc, const char **argv, const Command& command);
 extern int createtaxdb(int argc, const char **argv, const Command& command);
+extern int createbintaxonomy(int argc, const char **argv, const Command& command);
 extern int translateaa(int argc, const char **argv, const Command& command);
 extern int translatenucs(int argc, const char **argv, const Command& command);
 extern int tsv2db(int argc, const char **argv, const Command& command);
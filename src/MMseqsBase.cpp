@@ -193,6 +193,12 @@ std::vector<Command> baseCommands = {
                 "<i:sequenceDB> <tmpDir>",
                 CITATION_MMSEQS2, {{"sequenceDB",  DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::sequenceDb },
                                          {"tmpDir", DbType::ACCESS_MODE_OUTPUT, DbType::NEED_DATA, &DbValidator::directory }}},
+        {"createbintaxonomy",    createbintaxonomy,    &par.onlyverbosity,        COMMAND_HIDDEN,
+                "Write the NCBI taxonomy of a sequence database in a binary format that is mapped directly",
+                NULL,
+                "Martin Steinegger <martin.steinegger@mpibpc.mpg.de>",
+                "<i:sequenceDB>",
+                CITATION_MMSEQS2, {{"sequenceDB",  DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::sequenceDb }}},
         {"addtaxonomy",          addtaxonomy,          &par.addtaxonomy, COMMAND_TAXONOMY,
                 "Add taxonomy information to result database.",
                 NULL,
@@ -298,6 +304,16 @@ std::vector<Command> baseCommands = {
                 CITATION_MMSEQS2, {{"sequenceDB",  DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::sequenceDb },
                                          {"clusterDB", DbType::ACCESS_MODE_OUTPUT, DbType::NEED_DATA, &DbValidator::clusterDb },
                                          {"clusterDB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA | DbType::VARIADIC, &DbValidator::clusterDb }}},
+        {"addtoclusters",        addtoclusters,        &par.threadsandcompression,COMMAND_HIDDEN,
+                "Add sequences to the clusters of their best hit and extract sequences without hit",
+                NULL,
+                "Martin Steinegger <martin.steinegger@mpibpc.mpg.de>",
+                "<i:alignmentDB> <i:clusterDB> <i:sequenceDB> <o:clusterDB> <o:sequenceDB>",
+                CITATION_MMSEQS2, {{"alignmentDB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::alignmentDb },
+                                         {"clusterDB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::clusterDb },
+                                         {"sequenceDB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::sequenceDb },
+                                         {"clusterDB", DbType::ACCESS_MODE_OUTPUT, DbType::NEED_DATA, &DbValidator::clusterDb },
+                                         {"sequenceDB", DbType::ACCESS_MODE_OUTPUT, DbType::NEED_DATA, &DbValidator::sequenceDb }}},
 // Expert tools (for advanced users)
         {"prefilter",            prefilter,            &par.prefilter,            COMMAND_EXPERT,
                 "Search with query sequence / profile DB through target DB (k-mer matching + ungapped alignment)",
@@ -26,7 +26,7 @@ Alignment::Alignment(const std::string &querySeqDB,
                      const Parameters &par) :
 
         covThr(par.covThr), canCovThr(par.covThr), covMode(par.covMode), seqIdMode(par.seqIdMode), evalThr(par.evalThr), seqIdThr(par.seqIdThr),
-        alnLenThr(par.alnLenThr), includeIdentity(par.includeIdentity), addBacktrace(par.addBacktrace), realign(par.realign), scoreBias(par.scoreBias),
+        alnLenThr(par.alnLenThr), includeIdentity(par.includeIdentity), addBacktrace(par.addBacktrace), realign(par.realign), packedAlignment(par.packedAlignment), scoreBias(par.scoreBias),
         threads(static_cast<unsigned int>(par.threads)), compressed(par.compressed), outDB(outDB), outDBIndex(outDBIndex),
         maxSeqLen(par.maxSeqLen), compBiasCorrection(par.compBiasCorrection), altAlignment(par.altAlignment), qdbr(NULL), qDbrIdx(NULL),
         tdbr(NULL), tDbrIdx(NULL) {
@@ -296,6 +296,8 @@ void Alignment::run(const std::string &outDB, const std::string &outDBIndex,
             Sequence dbSeq(maxSeqLen, targetSeqType, m, 0, false, compBiasCorrection);
             Matcher matcher(querySeqType, maxSeqLen, m, &evaluer, compBiasCorrection, gapOpen, gapExtend);
             Matcher *realigner = NULL;
+            // profile targets are mapped as a whole, only plain sequences can be cut to the earlier region
+            const bool realignInRegion = Parameters::isEqualDbtype(targetSeqType, Parameters::DBTYPE_AMINO_ACIDS);
             if (realign ==  true && wrappedScoring == false) {
                 realigner = new Matcher(querySeqType, maxSeqLen, realign_m, &evaluer, compBiasCorrection, gapOpen, gapExtend);
             }
@@ -412,7 +414,8 @@ void Alignment::run(const std::string &outDB, const std::string &outDBIndex,
                 // write the results
                 if(swResults.size() > 1)
                     std::sort(swResults.begin(), swResults.end(), Matcher::compareHits);
-                if (realign == true) {
+                if (realign == true && swResults.empty() == false) {
+                    // the realignment query profile is built once per query and only if there is something to realign
                     realigner->initQuery(&qSeq);
                     for (size_t result = 0; result < swResults.size(); result++) {
                         size_t dbId = tdbr->getId(swResults[result].dbKey);
@@ -424,8 +427,16 @@ void Alignment::run(const std::string &outDB, const std::string &outDBIndex,
                         dbSeq.mapSequence(static_cast<size_t>(-1), swResults[result].dbKey, dbSeqData,
                                           tdbr->getSeqLen(dbId));
                         const bool isIdentity = (queryDbKey == swResults[result].dbKey && (includeIdentity || sameQTDB)) ? true : false;
-                        Matcher::result_t res = realigner->getSWResult(&dbSeq, INT_MAX, false, covMode, covThr, FLT_MAX,
-                                                                       Matcher::SCORE_COV_SEQID, seqIdMode, isIdentity);
+                        // only the region found with the first matrix is rescored, widened by the unaligned
+                        // query ends it could still be extended with
+                        const Matcher::result_t &prev = swResults[result];
+                        const int regionStart = prev.dbStartPos - prev.qStartPos - REALIGN_REGION_PADDING;
+                        const int regionEnd = prev.dbEndPos + (static_cast<int>(prev.qLen) - 1 - prev.qEndPos) + REALIGN_REGION_PADDING;
+                        Matcher::result_t res = (isIdentity == false && realignInRegion)
+                                ? realigner->getSWResultInRegion(&dbSeq, regionStart, regionEnd,
+                                                                 covMode, covThr, FLT_MAX, Matcher::SCORE_COV_SEQID, seqIdMode)
+                                : realigner->getSWResult(&dbSeq, INT_MAX, false, covMode, covThr, FLT_MAX,
+                                                         Matcher::SCORE_COV_SEQID, seqIdMode, isIdentity);
                         const bool covOK = Util::hasCoverage(realignCov, covMode, res.qcov, res.dbcov);
                         if(covOK == true|| isIdentity){
                             swResults[result].backtrace  = res.backtrace;
@@ -448,7 +459,8 @@ void Alignment::run(const std::string &outDB, const std::string &outDBIndex,
 
                 // put the contents of the swResults list into a result DB
                 for (size_t result = 0; result < swResults.size(); result++) {
-                    size_t len = Matcher::resultToBuffer(buffer, swResults[result], addBacktrace);
+                    size_t len = (packedAlignment == true) ? Matcher::resultToPackedBuffer(buffer, swResults[result], addBacktrace)
+                                                           : Matcher::resultToBuffer(buffer, swResults[result], addBacktrace);
                     alnResultsOutString.append(buffer, len);
                 }
 
@@ -39,6 +39,9 @@ public:
 
 
 private:
+    // extra target residues around the earlier alignment region that realignment may extend into
+    static const int REALIGN_REGION_PADDING = 32;
+
     // sequence coverage threshold
     double covThr;
 
@@ -70,6 +73,9 @@ private:
     const bool realign;
     float realignCov;
 
+    // write packed binary instead of text records
+    const bool packedAlignment;
+
     bool sameQTDB;
 
     //to increase/decrease the threshold for finishing the alignment 
@@ -8,6 +8,7 @@
 #include "DistanceCalculator.h"
 #include "ksw2.h"
 #include "BandedNucleotideAligner.h"
+#include "WavefrontAligner.h"
 
 #include "Util.h"
 #include "SubstitutionMatrix.h"
@@ -35,6 +36,7 @@ fastMatrix(SubstitutionMatrix::createAsciiSubMat(*subMat))
     }
     this->gape = gape;
     this->gapo = gapo;
+    wavefront = new WavefrontAligner(mat, subMat->alphabetSize, gapo, gape, 40);
 }
 
 BandedNucleotideAligner::~BandedNucleotideAligner(){
@@ -48,6 +50,7 @@ BandedNucleotideAligner::~BandedNucleotideAligner(){
     delete [] fastMatrix.matrixData;
     delete [] fastMatrix.matrix;
     delete [] mat;
+    delete wavefront;
 }
 
 void BandedNucleotideAligner::initQuery(Sequence * query){
@@ -160,7 +163,10 @@ s_align BandedNucleotideAligner::align(Sequence * targetSeqObj,
     if (wrappedScoring && queryRevLenToAlign > origQueryLen)
         queryRevLenToAlign = origQueryLen;
 
-    ksw_extz2_sse(0, queryRevLenToAlign, querySeqRevAlign + qStartRev, targetSeqObj->L - tStartRev, targetSeqRev + tStartRev, 5, mat, gapo, gape, 64, 40, flag, &ez);
+    // high identity extensions are cheaper with the wavefront aligner, everything else goes to ksw2
+    if (wavefront->extend(queryRevLenToAlign, querySeqRevAlign + qStartRev, targetSeqObj->L - tStartRev, targetSeqRev + tStartRev, true, &ez) == false) {
+        ksw_extz2_simd(0, queryRevLenToAlign, querySeqRevAlign + qStartRev, targetSeqObj->L - tStartRev, targetSeqRev + tStartRev, 5, mat, gapo, gape, 64, 40, flag, &ez);
+    }
 
     int qStartPos = querySeqObj->L  - ( qStartRev + ez.max_q ) -1;
     int tStartPos = targetSeqObj->L - ( tStartRev + ez.max_t ) -1;
@@ -176,16 +182,21 @@ s_align BandedNucleotideAligner::align(Sequence * targetSeqObj,
     int queryLenToAlign = querySeqObj->L-qStartPos;
     if (wrappedScoring && queryLenToAlign > origQueryLen)
         queryLenToAlign = origQueryLen;
-    ksw_extz2_sse(0, queryLenToAlign, querySeqAlign+qStartPos, targetSeqObj->L-tStartPos, targetSeq+tStartPos, 5,
-                  mat, gapo, gape, 64, 40, alignFlag, &ezAlign);
+    if (wavefront->extend(queryLenToAlign, querySeqAlign+qStartPos, targetSeqObj->L-tStartPos, targetSeq+tStartPos, false, &ezAlign) == false) {
+        ksw_extz2_simd(0, queryLenToAlign, querySeqAlign+qStartPos, targetSeqObj->L-tStartPos, targetSeq+tStartPos, 5,
+                      mat, gapo, gape, 64, 40, alignFlag, &ezAlign);
+    }
 
     std::string letterCode = "MID";
     uint32_t * retCigar;
 
     if (ez.max_q > ezAlign.max_q && ez.max_t > ezAlign.max_t){
 
-        ksw_extz2_sse(0, queryRevLenToAlign, querySeqRevAlign + qStartRev, targetSeqObj->L - tStartRev,
-                      targetSeqRev + tStartRev, 5, mat, gapo, gape, 64, 40, alignFlag, &ezAlign);
+        if (wavefront->extend(queryRevLenToAlign, querySeqRevAlign + qStartRev, targetSeqObj->L - tStartRev,
+                              targetSeqRev + tStartRev, false, &ezAlign) == false) {
+            ksw_extz2_simd(0, queryRevLenToAlign, querySeqRevAlign + qStartRev, targetSeqObj->L - tStartRev,
+                          targetSeqRev + tStartRev, 5, mat, gapo, gape, 64, 40, alignFlag, &ezAlign);
+        }
 
         retCigar = new uint32_t[ezAlign.n_cigar];
         for(int i = 0; i < ezAlign.n_cigar; i++){
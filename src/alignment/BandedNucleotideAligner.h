@@ -12,6 +12,8 @@
 #include "SubstitutionMatrix.h"
 #include "Debug.h"
 
+class WavefrontAligner;
+
 
 class BandedNucleotideAligner {
 public:
@@ -41,4 +43,5 @@ private:
 //    uint32_t * cigar;
     int gapo;
     int gape;
+    WavefrontAligner * wavefront;
 };
@@ -4,6 +4,7 @@
 #include "Util.h"
 #include "Parameters.h"
 #include "StripedSmithWaterman.h"
+#include "PackedAlignment.h"
 
 
 Matcher::Matcher(int querySeqType, int maxSeqLen, BaseMatrix *m, EvalueComputation * evaluer,
@@ -94,34 +95,7 @@ Matcher::result_t Matcher::getSWResult(Sequence* dbSeq, const int diagonal, bool
         }
         if(alignmentMode == Matcher::SCORE_COV_SEQID){
             if(isIdentity==false){
-                if(alignment.cigar){
-                    int32_t targetPos = alignment.dbStartPos1, queryPos = alignment.qStartPos1;
-                    for (int32_t c = 0; c < alignment.cigarLen; ++c) {
-                        char letter = SmithWaterman::cigar_int_to_op(alignment.cigar[c]);
-                        uint32_t length = SmithWaterman::cigar_int_to_len(alignment.cigar[c]);
-                        backtrace.reserve(length);
-
-                        for (uint32_t i = 0; i < length; ++i){
-                            if (letter == 'M') {
-                                if (dbSeq->int_sequence[targetPos] == currentQuery->int_sequence[queryPos]){
-                                    aaIds++;
-                                }
-                                ++queryPos;
-                                ++targetPos;
-                                backtrace.append("M");
-                            } else {
-                                if (letter == 'I') {
-                                    ++queryPos;
-                                    backtrace.append("I");
-                                }
-                                else{
-                                    ++targetPos;
-                                    backtrace.append("D");
-                                }
-                            }
-                        }
-                    }
-                }
+                cigarToBacktrace(alignment, dbSeq->int_sequence, backtrace, aaIds);
             } else {
                 for (int32_t c = 0; c < origQueryLen; ++c) {
                     aaIds++;
@@ -132,6 +106,46 @@ Matcher::result_t Matcher::getSWResult(Sequence* dbSeq, const int diagonal, bool
 
     }
 
+    result_t result = alignmentResult(alignment, dbSeq->getDbKey(), dbSeq->L, isReverse, alignmentMode, seqIdMode, origQueryLen, backtrace, aaIds);
+    delete [] alignment.cigar;
+    return result;
+}
+
+void Matcher::cigarToBacktrace(const s_align &alignment, const int *dbSequence, std::string &backtrace, int &aaIds) {
+    if(alignment.cigar == NULL){
+        return;
+    }
+    int32_t targetPos = alignment.dbStartPos1, queryPos = alignment.qStartPos1;
+    for (int32_t c = 0; c < alignment.cigarLen; ++c) {
+        char letter = SmithWaterman::cigar_int_to_op(alignment.cigar[c]);
+        uint32_t length = SmithWaterman::cigar_int_to_len(alignment.cigar[c]);
+        backtrace.reserve(length);
+
+        for (uint32_t i = 0; i < length; ++i){
+            if (letter == 'M') {
+                if (dbSequence[targetPos] == currentQuery->int_sequence[queryPos]){
+                    aaIds++;
+                }
+                ++queryPos;
+                ++targetPos;
+                backtrace.append("M");
+            } else {
+                if (letter == 'I') {
+                    ++queryPos;
+                    backtrace.append("I");
+                }
+                else{
+                    ++targetPos;
+                    backtrace.append("D");
+                }
+            }
+        }
+    }
+}
+
+Matcher::result_t Matcher::alignmentResult(const s_align &alignment, unsigned int dbKey, int dbLen, bool isReverse,
+                                           unsigned int alignmentMode, unsigned int seqIdMode, int origQueryLen,
+                                           const std::string &backtrace, int aaIds) {
     // calculation of the coverage and e-value
     float qcov = 0.0;
     float dbcov = 0.0;
@@ -142,7 +156,7 @@ Matcher::result_t Matcher::getSWResult(Sequence* dbSeq, const int diagonal, bool
     const unsigned int qEndPos = alignment.qEndPos1;
     const unsigned int dbEndPos = alignment.dbEndPos1;
     // normalize score
-//    alignment->score1 = alignment->score1 - log2(dbSeq->L);
+//    alignment->score1 = alignment->score1 - log2(dbLen);
     if(alignmentMode == Matcher::SCORE_COV || alignmentMode == Matcher::SCORE_COV_SEQID) {
         qcov  = alignment.qCov;
         dbcov = alignment.tCov;
@@ -156,7 +170,7 @@ Matcher::result_t Matcher::getSWResult(Sequence* dbSeq, const int diagonal, bool
             // OVERWRITE alnLength with gapped value
             alnLength = backtrace.size();
         }
-        seqId = Util::computeSeqId(seqIdMode, aaIds, origQueryLen, dbSeq->L, alnLength);
+        seqId = Util::computeSeqId(seqIdMode, aaIds, origQueryLen, dbLen, alnLength);
 
     }else if( alignmentMode == Matcher::SCORE_COV){
         // "20%   30%   40%   50%   60%   70%   80%   90%   99%"
@@ -178,17 +192,43 @@ Matcher::result_t Matcher::getSWResult(Sequence* dbSeq, const int diagonal, bool
 
     result_t result;
     if(isReverse){
-        result = result_t(dbSeq->getDbKey(), bitScore, qcov, dbcov, seqId, evalue, alnLength, qStartPos, qEndPos, origQueryLen, dbEndPos, dbStartPos, dbSeq->L, backtrace);
+        result = result_t(dbKey, bitScore, qcov, dbcov, seqId, evalue, alnLength, qStartPos, qEndPos, origQueryLen, dbEndPos, dbStartPos, dbLen, backtrace);
     }else{
-        result = result_t(dbSeq->getDbKey(), bitScore, qcov, dbcov, seqId, evalue, alnLength, qStartPos, qEndPos, origQueryLen, dbStartPos, dbEndPos, dbSeq->L, backtrace);
+        result = result_t(dbKey, bitScore, qcov, dbcov, seqId, evalue, alnLength, qStartPos, qEndPos, origQueryLen, dbStartPos, dbEndPos, dbLen, backtrace);
     }
+    return result;
+}
 
+Matcher::result_t Matcher::getSWResultInRegion(Sequence* dbSeq, int dbStartPos, int dbEndPos, const int covMode, const float covThr,
+                                               const double evalThr, unsigned int alignmentMode, unsigned int seqIdMode) {
+    const int fullLen = dbSeq->L;
+    dbStartPos = std::max(dbStartPos, 0);
+    dbEndPos = std::min(dbEndPos, fullLen - 1);
+    if (dbStartPos > dbEndPos) {
+        return getSWResult(dbSeq, INT_MAX, false, covMode, covThr, evalThr, alignmentMode, seqIdMode, false);
+    }
 
+    // align against the region only, the query profile was set up by initQuery
+    const int32_t maskLen = currentQuery->L / 2;
+    s_align alignment = aligner->ssw_align(dbSeq->int_sequence + dbStartPos, dbEndPos - dbStartPos + 1, gapOpen, gapExtend,
+                                           alignmentMode, evalThr, evaluer, covMode, covThr, maskLen);
+    // shift the target positions back onto the full sequence, so the backtrace, coverage and
+    // sequence identity are computed exactly as for an alignment against the full target
+    if (alignment.dbStartPos1 >= 0 && alignment.dbEndPos1 >= 0) {
+        alignment.dbStartPos1 += dbStartPos;
+        alignment.dbEndPos1 += dbStartPos;
+        alignment.tCov = SmithWaterman::computeCov(alignment.dbStartPos1, alignment.dbEndPos1, fullLen);
+    }
+    std::string backtrace;
+    int aaIds = 0;
+    if (alignmentMode == Matcher::SCORE_COV_SEQID) {
+        cigarToBacktrace(alignment, dbSeq->int_sequence, backtrace, aaIds);
+    }
+    result_t result = alignmentResult(alignment, dbSeq->getDbKey(), fullLen, false, alignmentMode, seqIdMode, currentQuery->L, backtrace, aaIds);
     delete [] alignment.cigar;
     return result;
 }
 
-
 void Matcher::readAlignmentResults(std::vector<result_t> &result, char *data, bool readCompressed) {
     if(data == NULL) {
         return;
@@ -247,7 +287,73 @@ std::string Matcher::uncompressAlignment(const std::string &cbt) {
     return bt;
 }
 
+Matcher::result_t Matcher::parsePackedAlignmentRecord(const char *data, bool readCompressed) {
+    PackedAlignment::Record rec;
+    PackedAlignment::readRecord(data, rec);
+
+    int adjustQstart = (rec.qStartPos==-1)? 0 : rec.qStartPos;
+    int adjustDBstart = (rec.dbStartPos==-1)? 0 : rec.dbStartPos;
+    double qCov = SmithWaterman::computeCov(adjustQstart, rec.qEndPos, rec.qLen);
+    double dbCov = SmithWaterman::computeCov(adjustDBstart, rec.dbEndPos, rec.dbLen);
+    size_t alnLength = Matcher::computeAlnLength(adjustQstart, rec.qEndPos, adjustDBstart, rec.dbEndPos);
+    float seqId = rec.seqIdPermille / 1000.0f;
+
+    std::string backtrace;
+    const char *cigar = rec.cigar;
+    for (size_t i = 0; i < rec.cigarRuns; i++) {
+        unsigned int length;
+        char op;
+        cigar = PackedAlignment::nextCigarRun(cigar, length, op);
+        if (readCompressed) {
+            backtrace.append(SSTR(length));
+            backtrace.push_back(op);
+        } else {
+            backtrace.append(length, op);
+        }
+    }
+
+    return Matcher::result_t(rec.dbKey, rec.score, qCov, dbCov, seqId, rec.eval,
+                             alnLength, rec.qStartPos, rec.qEndPos, rec.qLen, rec.dbStartPos, rec.dbEndPos,
+                             rec.dbLen, backtrace);
+}
+
+void Matcher::packedRecordToText(const char *data, std::string &out) {
+    PackedAlignment::Record rec;
+    PackedAlignment::readRecord(data, rec);
+    packedRecordToText(rec, out);
+}
+
+void Matcher::packedRecordToText(const PackedAlignment::Record &rec, std::string &out, bool withKey) {
+    char buffer[256];
+    if (withKey) {
+        char *end = Itoa::u32toa_sse2(rec.dbKey, buffer);
+        out.append(buffer, end - buffer - 1);
+    }
+    // the sequence identity is written from the stored permille value, converting it
+    // to float and back would truncate values like 0.253 to 0.252
+    int len = snprintf(buffer, sizeof(buffer), "\t%d\t%u.%03u\t%.3E\t%d\t%d\t%u\t%d\t%d\t%u",
+                       rec.score, rec.seqIdPermille / 1000, rec.seqIdPermille % 1000, rec.eval,
+                       rec.qStartPos, rec.qEndPos, rec.qLen, rec.dbStartPos, rec.dbEndPos, rec.dbLen);
+    out.append(buffer, len);
+    if (rec.flags & PackedAlignment::FLAG_BACKTRACE) {
+        out.push_back('\t');
+        const char *cigar = rec.cigar;
+        for (size_t i = 0; i < rec.cigarRuns; i++) {
+            unsigned int length;
+            char op;
+            cigar = PackedAlignment::nextCigarRun(cigar, length, op);
+            char *end = Itoa::u32toa_sse2(length, buffer);
+            out.append(buffer, end - buffer - 1);
+            out.push_back(op);
+        }
+    }
+    out.push_back('\n');
+}
+
 Matcher::result_t Matcher::parseAlignmentRecord(const char *data, bool readCompressed) {
+    if (PackedAlignment::isPacked(data)) {
+        return parsePackedAlignmentRecord(data, readCompressed);
+    }
     const char *entry[255];
     size_t columns = Util::getWordsOfLine(data, entry, 255);
     if (columns < ALN_RES_WITH_OUT_BT_COL_CNT) {
@@ -373,3 +479,49 @@ size_t Matcher::resultToBuffer(char * buff1, const result_t &result, bool addBac
 }
 
 
+
+size_t Matcher::resultToPackedBuffer(char * buffer, const result_t &result, bool addBacktrace) {
+    PackedAlignment::Record rec;
+    rec.flags = addBacktrace ? PackedAlignment::FLAG_BACKTRACE : 0;
+    rec.dbKey = result.dbKey;
+    rec.score = result.score;
+    rec.seqIdPermille = PackedAlignment::seqIdToPermille(result.seqId);
+    rec.eval = result.eval;
+    rec.qStartPos = result.qStartPos;
+    rec.qEndPos = result.qEndPos;
+    rec.qLen = result.qLen;
+    rec.dbStartPos = result.dbStartPos;
+    rec.dbEndPos = result.dbEndPos;
+    rec.dbLen = result.dbLen;
+    char *tmpBuff = PackedAlignment::writeFields(buffer, rec);
+    if (addBacktrace == true) {
+        const std::string &bt = result.backtrace;
+        // accepts both the uncompressed (MMMID) and the run-length encoded (3M1I1D) backtrace
+        char state = '\0';
+        size_t runLength = 0;
+        size_t count = 0;
+        bool hasCount = false;
+        for (size_t pos = 0; pos < bt.size(); pos++) {
+            if (isdigit(bt[pos])) {
+                count = count * 10 + (bt[pos] - '0');
+                hasCount = true;
+                continue;
+            }
+            if (bt[pos] != state && runLength > 0) {
+                tmpBuff = PackedAlignment::writeCigarRun(tmpBuff, runLength, state);
+                runLength = 0;
+            }
+            state = bt[pos];
+            runLength += hasCount ? count : 1;
+            count = 0;
+            hasCount = false;
+        }
+        if (runLength > 0) {
+            tmpBuff = PackedAlignment::writeCigarRun(tmpBuff, runLength, state);
+        }
+    }
+    *(tmpBuff) = '\n';
+    tmpBuff++;
+    *(tmpBuff) = '\0';
+    return tmpBuff - buffer;
+}
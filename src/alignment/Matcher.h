@@ -17,6 +17,7 @@
 #include "StripedSmithWaterman.h"
 #include "EvalueComputation.h"
 #include "BandedNucleotideAligner.h"
+#include "PackedAlignment.h"
 
 class Matcher{
 
@@ -130,6 +131,11 @@ public:
     result_t getSWResult(Sequence* dbSeq, const int diagonal, bool isReverse, const int covMode, const float covThr, const double evalThr,
                          unsigned int alignmentMode, unsigned int seqIdMode, bool isIdentical, bool wrappedScoring=false);
 
+    // align only the target region [dbStartPos, dbEndPos] of a previous alignment (e.g. for realignment)
+    // with the current query profile, positions, coverage and sequence identity refer to the full target
+    result_t getSWResultInRegion(Sequence* dbSeq, int dbStartPos, int dbEndPos, const int covMode, const float covThr,
+                                 const double evalThr, unsigned int alignmentMode, unsigned int seqIdMode);
+
     // need for sorting the results
     static bool compareHits (const result_t &first, const result_t &second){
         //return (first.eval < second.eval);
@@ -214,6 +220,15 @@ public:
 
     static size_t resultToBuffer(char * buffer, const result_t &result, bool addBacktrace, bool compress  = true);
 
+    // packed binary record (see PackedAlignment.h), read transparently by parseAlignmentRecord
+    static size_t resultToPackedBuffer(char * buffer, const result_t &result, bool addBacktrace);
+
+    // appends the text line of a packed record (compressed backtrace, '\n' terminated)
+    static void packedRecordToText(const char *data, std::string &out);
+
+    // same for a decoded record, without the key column the text starts with the tab in front of the score
+    static void packedRecordToText(const PackedAlignment::Record &rec, std::string &out, bool withKey = true);
+
     static int computeAlnLength(int anEnd, int start, int dbEnd, int dbStart);
 
 
@@ -240,6 +255,17 @@ private:
     // set substituion matrix
     void setSubstitutionMatrix(BaseMatrix *m);
 
+    static result_t parsePackedAlignmentRecord(const char *data, bool readCompressed);
+
+    // walk the CIGAR of an alignment of the current query against dbSequence, appends M/I/D to backtrace
+    // and counts the identical residues
+    void cigarToBacktrace(const s_align &alignment, const int *dbSequence, std::string &backtrace, int &aaIds);
+
+    // coverage, sequence identity, e-value and bit score of an alignment, positions refer to a target of length dbLen
+    result_t alignmentResult(const s_align &alignment, unsigned int dbKey, int dbLen, bool isReverse,
+                             unsigned int alignmentMode, unsigned int seqIdMode, int origQueryLen,
+                             const std::string &backtrace, int aaIds);
+
 };
 
 #endif
@@ -5,8 +5,6 @@
 #include <Debug.h>
 #include <Util.h>
 #include "MsaFilter.h"
-#include "simd.h"
-#include "MathUtil.h"
 #include "MultipleAlignment.h"
 
 MsaFilter::MsaFilter(int maxSeqLen, int maxSetSize, SubstitutionMatrix *m, int gapOpen, int gapExtend) :
@@ -27,6 +25,9 @@ MsaFilter::MsaFilter(int maxSeqLen, int maxSetSize, SubstitutionMatrix *m, int g
     this->ksort = new int[maxSetSize];
     this->display = new char[maxSetSize + 2];
     this->keep = new char[maxSetSize];
+    this->packed = NULL;
+    this->packedSize = 0;
+    this->packedBlocks = 0;
 }
 
 MsaFilter::~MsaFilter() {
@@ -42,6 +43,7 @@ MsaFilter::~MsaFilter() {
     delete [] nres;
     delete [] ksort;
     delete [] display;
+    free(packed);
 }
 
 void MsaFilter::filter(const int N_in, const int L, const int coverage, const int qid,
@@ -262,6 +264,8 @@ void MsaFilter::filter(const int N_in, const int L, const int coverage, const in
         return;
     }
 
+    packSequences(X, N_in, L);
+
     // Successively increment idmax[i] at positons where N[i]<Ndiff
     seqid = seqid1;
     while (seqid <= max_seqid) {
@@ -346,52 +350,7 @@ void MsaFilter::filter(const int N_in, const int L, const int coverage, const in
                 last_kj = std::min(last[k], last[j]);
                 cov_kj = last_kj - first_kj + 1;
                 diff_suff = int(diff_min_frac * std::min(nres[k], cov_kj) + 0.999);  // nres[j]>nres[k] anyway because of sorting
-                diff = 0;
-                const simd_int * XK = (simd_int *) X[k];
-                const simd_int * XJ = (simd_int *) X[j];
-                const int first_kj_simd = first_kj / (VECSIZE_INT * 4);
-                const int last_kj_simd = last_kj / (VECSIZE_INT * 4) + 1;
-                // coverage correction for simd
-                // because we do not always hit the right start with simd.
-                // This works because all sequence vector are initialized with GAPs so the sequnces is surrounded by GAPs
-                const int first_diff_simd_scalar = std::abs(
-                        first_kj_simd * (VECSIZE_INT * 4) - first_kj);
-                const int last_diff_simd_scalar = std::abs(
-                        last_kj_simd * (VECSIZE_INT * 4) - (last_kj + 1));
-
-                cov_kj += (first_diff_simd_scalar + last_diff_simd_scalar);
-
-                // _mm_set1_epi8 pseudo-instruction is slow!
-                const simd_int NAAx16 = simdi8_set(MultipleAlignment::NAA - 1);
-                for (int i = first_kj_simd; i < last_kj_simd && diff < diff_suff; ++i) {
-                    // None SIMD function
-                    // enough different residues to accept? => break
-                    // if (X[k][i] >= NAA || X[j][i] >= NAA)
-                    //    cov_kj--;
-                    // else if (X[k][i] != X[j][i] && ++diff >= diff_suff)
-                    //    break; // accept (k,j)
-
-                    const simd_int NO_AA_K = simdi8_gt(XK[i], NAAx16);  // pos without amino acid in seq k
-                    const simd_int NO_AA_J = simdi8_gt(XJ[i], NAAx16);  // pos without amino acid in seq j
-
-                    // Compute 16 bits indicating positions with GAP, ANY or ENDGAP in seq k or j
-                    // int _mm_movemask_epi8(__m128i a) creates 16-bit mask from most significant bits of
-                    // the 16 signed or unsigned 8-bit integers in a and zero-extends the upper bits.
-                    int res = simdi8_movemask(simdi_or(NO_AA_K, NO_AA_J));
-//                    for (int u = 0; u < 32; ++u) {
-//                        printf("%02d:%02d ", (int) ((char*)&XK[i])[u], (int) ((char*)&XK[i])[u]);
-//                    }
-//                    std::cout << std::endl;
-                    cov_kj -= MathUtil::popCount(res);  // subtract positions that should not contribute to coverage
-
-                    // Compute 16 bit mask that indicates positions where k and j have identical residues
-                    int c = simdi8_movemask(simdi8_eq(XK[i], XJ[i]));
-
-                    // Count positions where  k and j have different amino acids, which is equal to 16 minus the
-                    //  number of positions for which either j and k are equal or which contain ANY, GAP, or ENDGAP
-                    diff += (VECSIZE_INT * 4) - MathUtil::popCount(c | res);
-
-                }
+                countDifferences(k, j, first_kj, last_kj, diff_suff, diff, cov_kj);
 //            // DEBUG
 //            printf("%20.20s with %20.20s:  diff=%i  diff_min_frac*cov_kj=%f  diff_suff=%i  nres=%i  cov_kj=%i\n",sname[k],sname[j],diff,diff_min_frac*cov_kj,diff_suff,nres[k],cov_kj);
 //            printf("%s\n%s\n\n",seq[k],seq[j]);
@@ -453,6 +412,52 @@ void MsaFilter::filter(const int N_in, const int L, const int coverage, const in
     *N_out = n;
 }
 
+void MsaFilter::packSequences(const char **X, int N_in, int L) {
+    packedBlocks = (L + 63) / 64;
+    const size_t size = N_in * packedBlocks * PLANES;
+    if (size > packedSize) {
+        free(packed);
+        packed = (uint64_t *) malloc(size * sizeof(uint64_t));
+        packedSize = size;
+    }
+    memset(packed, 0, size * sizeof(uint64_t));
+    for (int k = 0; k < N_in; ++k) {
+        uint64_t *seqBlocks = packed + k * packedBlocks * PLANES;
+        for (int i = first[k]; i <= last[k]; ++i) {
+            const int aa = X[k][i];
+            if (aa >= MultipleAlignment::NAA) {
+                continue;
+            }
+            uint64_t *block = seqBlocks + (i / 64) * PLANES;
+            const uint64_t bit = 1ULL << (i % 64);
+            block[0] |= bit;
+            for (int b = 0; b < RESIDUE_BITS; ++b) {
+                block[b + 1] |= ((aa >> b) & 1) ? bit : 0;
+            }
+        }
+    }
+}
+
+void MsaFilter::countDifferences(int k, int j, int firstPos, int lastPos, int diffSuff, int &diff, int &cov) const {
+    diff = 0;
+    cov = 0;
+    if (firstPos > lastPos) {
+        return;
+    }
+    const uint64_t *K = packed + k * packedBlocks * PLANES;
+    const uint64_t *J = packed + j * packedBlocks * PLANES;
+    for (int b = firstPos / 64; b <= lastPos / 64 && diff < diffSuff; ++b) {
+        const uint64_t *blockK = K + b * PLANES;
+        const uint64_t *blockJ = J + b * PLANES;
+        // positions where both sequences have an amino acid (no ANY, GAP or ENDGAP)
+        const uint64_t aligned = blockK[0] & blockJ[0];
+        const uint64_t different = (blockK[1] ^ blockJ[1]) | (blockK[2] ^ blockJ[2]) | (blockK[3] ^ blockJ[3])
+                                   | (blockK[4] ^ blockJ[4]) | (blockK[5] ^ blockJ[5]);
+        cov += __builtin_popcountll(aligned);
+        diff += __builtin_popcountll(different & aligned);
+    }
+}
+
 void MsaFilter::shuffleSequences(const char ** X, size_t setSize) {
     for (size_t i = 0, j = 0; j < setSize; j++) {
         if (keep[j] != 0) {
@@ -9,6 +9,8 @@
 #include <SubstitutionMatrix.h>
 #include "MultipleAlignment.h"
 
+#include <stdint.h>
+
 class MsaFilter {
 
 public:
@@ -53,6 +55,15 @@ private:
     // prune sequence based on score
     int prune(int start, int end, float b, char * query, char *target);
 
+    // Packs the MSA into bit planes of 64 columns: per sequence and block one word marking the
+    // amino acid positions followed by RESIDUE_BITS words holding the bits of the residue code.
+    // Identities of two sequences are then counted 64 columns at a time with popcount.
+    enum { RESIDUE_BITS = 5, PLANES = RESIDUE_BITS + 1 };
+    void packSequences(const char **X, int N_in, int L);
+    // number of aligned amino acid pairs of sequences k and j and how many of them differ,
+    // stops early once at least diffSuff differences were found
+    void countDifferences(int k, int j, int firstPos, int lastPos, int diffSuff, int &diff, int &cov) const;
+
     BaseMatrix *m;
 
     int maxSeqLen;
@@ -83,6 +94,10 @@ private:
     char* display;
     // keep[k]=1 if sequence is included in amino acid frequencies; 0 otherwise (first=0)
     char *keep;
+    // bit planes of the MSA, see packSequences
+    uint64_t *packed;
+    size_t packedSize;
+    size_t packedBlocks;
 };
 
 
@@ -28,6 +28,8 @@ PSSMCalculator::PSSMCalculator(SubstitutionMatrix *subMat, size_t maxSeqLength,
     }
     wi = new float[maxSetSize];
     naa = new int[maxSeqLength + 1];
+    msaColumns = NULL;
+    msaColumnsSize = 0;
     this->pca = pca;
     this->pcb = pcb;
 
@@ -47,23 +49,48 @@ PSSMCalculator::~PSSMCalculator() {
     delete [] w_contrib;
     delete [] wi;
     delete [] naa;
+    free(msaColumns);
+}
+
+#ifdef AVX2
+// table[index] for indices below 24, three permutes are much faster than a gather
+static inline __m256 lookup24(const float *table, __m256i index) {
+    __m256 low = _mm256_permutevar8x32_ps(_mm256_load_ps(table), index);
+    __m256 mid = _mm256_permutevar8x32_ps(_mm256_load_ps(table + 8), index);
+    __m256 high = _mm256_permutevar8x32_ps(_mm256_load_ps(table + 16), index);
+    __m256 result = _mm256_blendv_ps(low, mid, _mm256_castsi256_ps(_mm256_cmpgt_epi32(index, _mm256_set1_epi32(7))));
+    return _mm256_blendv_ps(result, high, _mm256_castsi256_ps(_mm256_cmpgt_epi32(index, _mm256_set1_epi32(15))));
+}
+#endif
+
+// sequence count rounded up to full 32 byte vectors
+static size_t columnStride(size_t setSize) {
+    return ((setSize + 31) / 32) * 32;
 }
 
 PSSMCalculator::Profile PSSMCalculator::computePSSMFromMSA(size_t setSize,
                                            size_t queryLength,
                                            const char **msaSeqs,
                                            bool wg) {
+    const size_t stride = columnStride(setSize);
+    if (queryLength * stride > msaColumnsSize) {
+        free(msaColumns);
+        msaColumnsSize = queryLength * stride;
+        msaColumns = (char *) malloc_simd_int(msaColumnsSize);
+    }
+    transposeMSA(msaSeqs, setSize, queryLength, msaColumns, stride);
+
     // Quick and dirty calculation of the weight per sequence wg[k]
-    computeSequenceWeights(seqWeight, queryLength, setSize, msaSeqs);
+    computeSequenceWeights(seqWeight, queryLength, setSize, msaColumns, stride);
     MathUtil::NormalizeTo1(seqWeight, setSize);
     if (wg == false) {
         // compute context specific counts and Neff
-        computeContextSpecificWeights(matchWeight, seqWeight, Neff_M, queryLength, setSize, msaSeqs);
+        computeContextSpecificWeights(matchWeight, seqWeight, Neff_M, queryLength, setSize, msaSeqs, msaColumns, stride);
     } else {
         // compute matchWeight based on sequence weight
-        computeMatchWeights(matchWeight, seqWeight, setSize, queryLength, msaSeqs);
+        computeMatchWeights(matchWeight, seqWeight, setSize, queryLength, msaColumns, stride);
         // compute NEFF_M
-        computeNeff_M(matchWeight, seqWeight, Neff_M, queryLength, setSize, msaSeqs);
+        computeNeff_M(matchWeight, seqWeight, Neff_M, queryLength, setSize, msaColumns, stride);
     }
     // compute consensus sequence
     std::string consensusSequence = computeConsensusSequence(matchWeight, queryLength, subMat->pBack, subMat->int2aa);
@@ -148,7 +175,7 @@ void PSSMCalculator::preparePseudoCounts(float *frequency, float *frequency_with
     }
 }
 void PSSMCalculator::computeNeff_M(float *frequency, float *seqWeight, float *Neff_M,
-                                   size_t queryLength, size_t setSize, char const **msaSeqs) {
+                                   size_t queryLength, size_t setSize, const char *msaColumns, size_t stride) {
     float Neff_HMM = 0.0f;
     for (size_t pos = 0; pos < queryLength; pos++) {
         float sum = 0.0f;
@@ -164,9 +191,10 @@ void PSSMCalculator::computeNeff_M(float *frequency, float *seqWeight, float *Ne
     float Nlim = fmax(10.0, Neff_HMM + 1.0);    // limiting Neff
     float scale = MathUtil::flog2((Nlim - Neff_HMM) / (Nlim - 1.0));  // for calculating Neff for those seqs with inserts at specific pos
     for (size_t pos = 0; pos < queryLength; pos++) {
+        const char *column = msaColumns + pos * stride;
         float w_M = -1.0 / setSize;
         for (size_t k = 0; k < setSize; ++k){
-            if ( msaSeqs[k][pos] != MultipleAlignment::GAP) {
+            if (column[k] != MultipleAlignment::GAP) {
                 w_M += seqWeight[k];
             }
         }
@@ -175,32 +203,60 @@ void PSSMCalculator::computeNeff_M(float *frequency, float *seqWeight, float *Ne
     }
 }
 
+void PSSMCalculator::transposeMSA(const char **msaSeqs, size_t setSize, size_t queryLength, char *msaColumns, size_t stride) {
+    // tiles keep the read rows and the written columns in cache
+    const size_t TILE = 64;
+    for (size_t kStart = 0; kStart < setSize; kStart += TILE) {
+        const size_t kEnd = std::min(kStart + TILE, setSize);
+        for (size_t posStart = 0; posStart < queryLength; posStart += TILE) {
+            const size_t posEnd = std::min(posStart + TILE, queryLength);
+            for (size_t k = kStart; k < kEnd; ++k) {
+                const char *seq = msaSeqs[k];
+                for (size_t pos = posStart; pos < posEnd; ++pos) {
+                    msaColumns[pos * stride + k] = seq[pos];
+                }
+            }
+        }
+    }
+}
+
 void PSSMCalculator::computeSequenceWeights(float *seqWeight, size_t queryLength,
                                             size_t setSize, const char **msaSeqs) {
+    const size_t stride = columnStride(setSize);
+    char *msaColumns = (char *) malloc_simd_int(queryLength * stride);
+    transposeMSA(msaSeqs, setSize, queryLength, msaColumns, stride);
+    computeSequenceWeights(seqWeight, queryLength, setSize, msaColumns, stride);
+    free(msaColumns);
+}
+
+void PSSMCalculator::computeSequenceWeights(float *seqWeight, size_t queryLength,
+                                            size_t setSize, const char *msaColumns, size_t stride) {
     unsigned int *number_res = new unsigned int[setSize];
+    float *lengthTerm = new float[setSize];
     // initialized wg[k] with tiny pseudo counts
     std::fill(seqWeight, seqWeight + setSize,  1e-6);
     // count number of residues per sequence
-    for (size_t k = 0; k < setSize; ++k)
-    {
-        unsigned int nr = 0;
-        for (size_t pos = 0; pos < queryLength; pos++) {
-            if (msaSeqs[k][pos] != MultipleAlignment::GAP) {
-                nr++;
-            }
+    std::fill(number_res, number_res + setSize, 0);
+    for (size_t pos = 0; pos < queryLength; pos++) {
+        const char *column = msaColumns + pos * stride;
+        for (size_t k = 0; k < setSize; ++k) {
+            number_res[k] += (column[k] != MultipleAlignment::GAP);
         }
-        number_res[k] = nr;
+    }
+    // ensure that each residue of a short sequence contributes as much as a residue of a long sequence:
+    // contribution is proportional to one over sequence length nres[k] plus 30.
+    for (size_t k = 0; k < setSize; ++k) {
+        lengthTerm[k] = float(number_res[k]) + 30.0f;
     }
     for (size_t pos = 0; pos < queryLength; pos++) {
+        const char *column = msaColumns + pos * stride;
         int nl[ Sequence::PROFILE_AA_SIZE ];  //nl[a] = number of seq's with amino acid a at position l
         //number of different amino acids (ignore X)
         std::fill(nl, nl + Sequence::PROFILE_AA_SIZE,  0);
         for (size_t k = 0; k < setSize; ++k) {
-            if (msaSeqs[k][pos] != MultipleAlignment::GAP) {
-                const unsigned int aa_pos = msaSeqs[k][pos];
-                if(aa_pos < Sequence::PROFILE_AA_SIZE){
-                    nl[aa_pos]++;
-                }
+            const unsigned int aa_pos = column[k];
+            if (aa_pos < Sequence::PROFILE_AA_SIZE) {
+                nl[aa_pos]++;
             }
         }
         //count distinct amino acids (ignore X)
@@ -210,34 +266,37 @@ void PSSMCalculator::computeSequenceWeights(float *seqWeight, size_t queryLength
                 ++distinct_aa_count;
             }
         }
-//        if(distinct_aa_count == 0){
-//            Debug(Debug::ERROR) << "Error in computeSequenceWeights. Distinct amino acid count is 0.\n";
-//            EXIT(EXIT_FAILURE);
-//        }
+        if (distinct_aa_count == 0) {
+            continue;
+        }
+        // nl[a] * distinct_aa_count for residues, gaps and X do not contribute (Treat score of X with other amino acid as 0.0)
+        float aaTerm[32] __attribute__((aligned(32)));
+        for (size_t aa = 0; aa < 32; ++aa) {
+            aaTerm[aa] = (aa < Sequence::PROFILE_AA_SIZE) ? float(nl[aa]) * float(distinct_aa_count) : 1.0f;
+        }
         // Compute sequence Weight
         // "Position-based Sequence Weights", Henikoff (1994)
-        for (size_t k = 0; k < setSize; ++k) {
-            if (msaSeqs[k][pos] != MultipleAlignment::GAP) {
-                if(distinct_aa_count == 0){
-                    seqWeight[k] += 0.0;
-                } else {
-                    const unsigned int aa_pos = msaSeqs[k][pos];
-//                    std::cout << "k="<< k << "\t";
-                    if(aa_pos < Sequence::PROFILE_AA_SIZE){ // Treat score of X with other amino acid as 0.0
-                        seqWeight[k] += 1.0f / (float(nl[aa_pos]) * float(distinct_aa_count) * (float(number_res[k]) + 30.0f));
-//                        std::cout << number_res[k] << "\t" << distinct_aa_count << "\t" <<  nl[aa_pos] << "\t";
-                    }
-                }
-                // ensure that each residue of a short sequence contributes as much as a residue of a long sequence:
-                // contribution is proportional to one over sequence length nres[k] plus 30.
+        size_t k = 0;
+#ifdef AVX2
+        // eight sequences at once, every sequence adds its columns in the same order as below
+        const __m256i aaSize = _mm256_set1_epi32(Sequence::PROFILE_AA_SIZE);
+        const __m256 one = _mm256_set1_ps(1.0f);
+        for (; k + 8 <= setSize; k += 8) {
+            __m256i aa = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) (column + k)));
+            __m256 isResidue = _mm256_castsi256_ps(_mm256_cmpgt_epi32(aaSize, aa));
+            __m256 term = _mm256_mul_ps(lookup24(aaTerm, aa), _mm256_loadu_ps(lengthTerm + k));
+            __m256 weight = _mm256_and_ps(isResidue, _mm256_div_ps(one, term));
+            _mm256_storeu_ps(seqWeight + k, _mm256_add_ps(_mm256_loadu_ps(seqWeight + k), weight));
+        }
+#endif
+        for (; k < setSize; ++k) {
+            const unsigned int aa_pos = column[k];
+            if (aa_pos < Sequence::PROFILE_AA_SIZE) {
+                seqWeight[k] += 1.0f / (aaTerm[aa_pos] * lengthTerm[k]);
             }
         }
     }
-//    std::cout << setSize << std::endl;
-//    std::cout << " Seq. Weight: " << std::endl;
-//    for (size_t k = 0; k < setSize; ++k) {
-//        std::cout << " k="<< k << "\t" << seqWeight[k] << std::endl;
-//    }
+    delete [] lengthTerm;
     delete [] number_res;
 }
 
@@ -262,16 +321,15 @@ void PSSMCalculator::computePseudoCounts(float *profile, float *frequency,
     }
 }
 
-void PSSMCalculator::computeMatchWeights(float * matchWeight, float * seqWeight, size_t setSize, size_t queryLength, const char **msaSeqs) {
+void PSSMCalculator::computeMatchWeights(float * matchWeight, float * seqWeight, size_t setSize, size_t queryLength, const char *msaColumns, size_t stride) {
     for (size_t pos = 0; pos < queryLength; pos++) {
+        const char *column = msaColumns + pos * stride;
         memset(matchWeight + pos * Sequence::PROFILE_AA_SIZE, 0,
                Sequence::PROFILE_AA_SIZE * sizeof(float));
         for (size_t k = 0; k < setSize; ++k){
-            if(msaSeqs[k][pos] != MultipleAlignment::GAP){
-                unsigned int aa_pos = msaSeqs[k][pos];
-                if(aa_pos < Sequence::PROFILE_AA_SIZE) { // Treat score of X with other amino acid as 0.0
-                    matchWeight[pos * Sequence::PROFILE_AA_SIZE + aa_pos] += seqWeight[k];
-                }
+            unsigned int aa_pos = column[k];
+            if(aa_pos < Sequence::PROFILE_AA_SIZE) { // Treat score of X with other amino acid as 0.0 (and skip gaps)
+                matchWeight[pos * Sequence::PROFILE_AA_SIZE + aa_pos] += seqWeight[k];
             }
         }
         MathUtil::NormalizeTo1(&matchWeight[pos * Sequence::PROFILE_AA_SIZE], Sequence::PROFILE_AA_SIZE, subMat->pBack);
@@ -279,7 +337,7 @@ void PSSMCalculator::computeMatchWeights(float * matchWeight, float * seqWeight,
 }
 
 void PSSMCalculator::computeContextSpecificWeights(float * matchWeight, float *wg, float * Neff_M, size_t queryLength, size_t setSize,
-                                                   const char **X) {
+                                                   const char **X, char *Xt, size_t stride) {
     //For weighting: include only columns into subalignment i that have a max fraction of seqs with endgap
     const float MAXENDGAPFRAC=0.1;
     const int NCOLMIN=20;   //min number of cols in subalignment for calculating pos-specific weights w[k][i]
@@ -297,12 +355,16 @@ void PSSMCalculator::computeContextSpecificWeights(float * matchWeight, float *w
     for (size_t j = 0; j < queryLength; j++){
         memset(w_contrib[j], 0, NAA_VECSIZE * sizeof(int));
     }
-    // insert endgaps
+    // insert endgaps, Xt is the same MSA in column-major order
     for (size_t k = 0; k < setSize; ++k) {
-        for (size_t i = 0; i < queryLength && X[k][i] == MultipleAlignment::GAP; ++i)
+        for (size_t i = 0; i < queryLength && X[k][i] == MultipleAlignment::GAP; ++i) {
             ((char**)X)[k][i] = ENDGAP;
-        for (int i = queryLength - 1; i >= 0 && X[k][i] == MultipleAlignment::GAP; i--)
+            Xt[i * stride + k] = ENDGAP;
+        }
+        for (int i = queryLength - 1; i >= 0 && X[k][i] == MultipleAlignment::GAP; i--) {
             ((char**)X)[k][i] = ENDGAP;
+            Xt[i * stride + k] = ENDGAP;
+        }
     }
     //////////////////////////////////////////////////////////////////////////////////////////////
     // Main loop through alignment columns
@@ -441,16 +503,21 @@ void PSSMCalculator::computeContextSpecificWeights(float * matchWeight, float *w
         // Calculate amino acid frequencies q->f[i][a] from weights wi[k]
         for (int a = 0; a < 20; ++a)
             matchWeight[i * Sequence::PROFILE_AA_SIZE + a] = 0.0;
+        const char *column = Xt + i * stride;
         for (size_t k = 0; k < setSize; ++k)
-            matchWeight[i * Sequence::PROFILE_AA_SIZE + (int) X[k][i]] += wi[k];
+            matchWeight[i * Sequence::PROFILE_AA_SIZE + (int) column[k]] += wi[k];
         MathUtil::NormalizeTo1((matchWeight+ i * Sequence::PROFILE_AA_SIZE), MultipleAlignment::NAA, subMat->pBack);
     }
     // remove end gaps
     for (size_t k = 0; k < setSize; ++k) {
-        for (size_t i = 0; i < queryLength && X[k][i] == ENDGAP; ++i)
+        for (size_t i = 0; i < queryLength && X[k][i] == ENDGAP; ++i) {
             ((char**)X)[k][i] = MultipleAlignment::GAP;
-        for (int i = queryLength - 1; i >= 0 && X[k][i] == ENDGAP; i--)
+            Xt[i * stride + k] = MultipleAlignment::GAP;
+        }
+        for (int i = queryLength - 1; i >= 0 && X[k][i] == ENDGAP; i--) {
             ((char**)X)[k][i] = MultipleAlignment::GAP;
+            Xt[i * stride + k] = MultipleAlignment::GAP;
+        }
     }
 
     for (size_t j = 0; j < queryLength; ++j){
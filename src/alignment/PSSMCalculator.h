@@ -36,6 +36,11 @@ public:
 
     // Compute weight for sequence based on "Position-based Sequence Weights' (1994)
     static void computeSequenceWeights(float *seqWeight, size_t queryLength, size_t setSize, const char **msaSeqs);
+    // same for an MSA in column-major order (see transposeMSA)
+    static void computeSequenceWeights(float *seqWeight, size_t queryLength, size_t setSize, const char *msaColumns, size_t stride);
+
+    // writes residue pos of sequence k to msaColumns[pos * stride + k], stride has to be at least setSize
+    static void transposeMSA(const char **msaSeqs, size_t setSize, size_t queryLength, char *msaColumns, size_t stride);
 
 private:
     SubstitutionMatrix * subMat;
@@ -70,6 +75,10 @@ private:
     // number of different amino acids
     int *naa;
 
+    // MSA in column-major order, computations over all sequences of a column read one contiguous block
+    char *msaColumns;
+    size_t msaColumnsSize;
+
     size_t maxSeqLength;
 
     // compute position-specific scoring matrix PSSM score
@@ -80,11 +89,11 @@ private:
     void computeLogPSSM(char *pssm, const float *profile, float bitFactor, size_t queryLength, float scoreBias);
 
     // compute the Neff_M per column -p log(p)
-    void computeNeff_M(float *frequency, float *seqWeight, float *Neff_M, size_t queryLength, size_t setSize, char const **msaSeqs);
+    void computeNeff_M(float *frequency, float *seqWeight, float *Neff_M, size_t queryLength, size_t setSize, const char *msaColumns, size_t stride);
 
-    void computeMatchWeights(float * matchWeight, float * seqWeight, size_t setSize, size_t queryLength, const char **msaSeqs);
+    void computeMatchWeights(float * matchWeight, float * seqWeight, size_t setSize, size_t queryLength, const char *msaColumns, size_t stride);
 
-    void computeContextSpecificWeights(float * matchWeight, float *seqWeight, float * Neff_M, size_t queryLength, size_t setSize, const char **msaSeqs);
+    void computeContextSpecificWeights(float * matchWeight, float *seqWeight, float * Neff_M, size_t queryLength, size_t setSize, const char **msaSeqs, char *msaColumns, size_t stride);
 
     float pca;
     float pcb;
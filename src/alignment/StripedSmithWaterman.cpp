@@ -30,10 +30,15 @@
 #include "SubstitutionMatrix.h"
 #include "Debug.h"
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 
 SmithWaterman::SmithWaterman(size_t maxSequenceLength, int aaSize, bool aaBiasCorrection) {
 	maxSequenceLength += 1;
 	this->aaBiasCorrection = aaBiasCorrection;
+	maxDirectionSize = BANDED_SW_MAX_DIRECTION_SIZE;
 	const int segSize = (maxSequenceLength+7)/8;
 	vHStore = (simd_int*) mem_align(ALIGN_INT, segSize * sizeof(simd_int));
 	vHLoad  = (simd_int*) mem_align(ALIGN_INT, segSize * sizeof(simd_int));
@@ -797,6 +802,64 @@ void SmithWaterman::ssw_init (const Sequence* q,
 	profile->query_length = q->L;
 	profile->alphabetSize = alphabetSize;
 }
+template <const unsigned int type>
+int32_t SmithWaterman::banded_sw_row(const int *db_sequence, const int8_t *query_sequence, const int8_t * compositionBias,
+									 int32_t db_length, int32_t i, int32_t queryStart,
+									 const uint32_t gap_open, const uint32_t gap_extend, int32_t band_width, int64_t width,
+									 const int8_t *mat, int32_t n, int32_t *h_b, int32_t *e_b, int32_t *h_c, int8_t *direction_line) {
+	/* Convert the coordinate in the scoring matrix into the coordinate in one line of the band. */
+#define set_u(u, w, i, j) { int x=(i)-(w); x=x>0?x:0; (u)=(j)-x+1; }
+
+	/* Convert the coordinate in the direction matrix into the coordinate in one line of the band. */
+#define set_d(u, w, i, j, p) { int x=(i)-(w); x=x>0?x:0; x=(j)-x; (u)=x*3+p; }
+
+	int32_t j, e, f, temp1, temp2, max = 0;
+	int32_t beg = 0, end = db_length - 1, u = 0, edge;
+	j = i - band_width;	beg = beg > j ? beg : j; // band start
+	j = i + band_width; end = end < j ? end : j; // band end
+	edge = end + 1 < width - 1 ? end + 1 : width - 1;
+	f = h_b[0] = e_b[0] = h_b[edge] = e_b[edge] = h_c[0] = 0;
+
+	for (j = beg; LIKELY(j <= end); j ++) {
+		int32_t b, e1, f1, d, de, df, dh;
+		set_u(u, band_width, i, j);	set_u(e, band_width, i - 1, j);
+		set_u(b, band_width, i, j - 1); set_u(d, band_width, i - 1, j - 1);
+		set_d(de, band_width, i, j, 0);
+		set_d(df, band_width, i, j, 1);
+		set_d(dh, band_width, i, j, 2);
+
+		temp1 = i == 0 ? -gap_open : h_b[e] - gap_open;
+		temp2 = i == 0 ? -gap_extend : e_b[e] - gap_extend;
+		e_b[u] = temp1 > temp2 ? temp1 : temp2;
+		direction_line[de] = temp1 > temp2 ? 3 : 2;
+
+		temp1 = h_c[b] - gap_open;
+		temp2 = f - gap_extend;
+		f = temp1 > temp2 ? temp1 : temp2;
+		direction_line[df] = temp1 > temp2 ? 5 : 4;
+
+		e1 = e_b[u] > 0 ? e_b[u] : 0;
+		f1 = f > 0 ? f : 0;
+		temp1 = e1 > f1 ? e1 : f1;
+		if(type == SUBSTITUTIONMATRIX){
+			temp2 = h_b[d] + mat[query_sequence[i] * n + db_sequence[j]] + compositionBias[i];
+		}
+		if(type == PROFILE) {
+			temp2 = h_b[d] + mat[db_sequence[j] * n + (queryStart + i)];
+		}
+		h_c[u] = temp1 > temp2 ? temp1 : temp2;
+
+		if (h_c[u] > max) max = h_c[u];
+
+		if (temp1 <= temp2) direction_line[dh] = 1;
+		else direction_line[dh] = e1 > f1 ? direction_line[de] : direction_line[df];
+	}
+	for (j = 1; j <= u; j ++) h_b[j] = h_c[j];
+	return max;
+#undef set_u
+#undef set_d
+}
+
 template <const unsigned int type>
 SmithWaterman::cigar * SmithWaterman::banded_sw(const int *db_sequence, const int8_t *query_sequence, const int8_t * compositionBias,
 												int32_t db_length, int32_t query_length, int32_t queryStart,
@@ -809,19 +872,22 @@ SmithWaterman::cigar * SmithWaterman::banded_sw(const int *db_sequence, const in
      */
 #define kroundup32(x) (--(x), (x)|=(x)>>1, (x)|=(x)>>2, (x)|=(x)>>4, (x)|=(x)>>8, (x)|=(x)>>16, ++(x))
 
-	/* Convert the coordinate in the scoring matrix into the coordinate in one line of the band. */
-#define set_u(u, w, i, j) { int x=(i)-(w); x=x>0?x:0; (u)=(j)-x+1; }
-
 	/* Convert the coordinate in the direction matrix into the coordinate in one line of the band. */
 #define set_d(u, w, i, j, p) { int x=(i)-(w); x=x>0?x:0; x=(j)-x; (u)=x*3+p; }
 
 	uint32_t *c = (uint32_t*)malloc(16 * sizeof(uint32_t)), *c1;
-	int32_t i, j, e, f, temp1, temp2, s = 16, s1 = 8, l, max = 0;
+	int32_t i, j, e, temp1, temp2, s = 16, s1 = 8, l, max = 0;
 	int64_t s2 = 1024;
 	char op, prev_op;
 	int64_t width, width_d;
 	int32_t *h_b, *e_b, *h_c;
 	int8_t *direction, *direction_line;
+	// Above maxDirectionSize only the h_b/e_b rows of every checkpointRows-th row are kept
+	// and the directions of one block of rows are recomputed from its checkpoint during the trace back.
+	// The recomputed directions are identical, so is the CIGAR.
+	bool checkpointed = false;
+	int32_t checkpointRows = 1, blockStart = 0, blockEnd = query_length;
+	std::vector<int32_t> checkpoints;
 	cigar* result = new cigar();
 	h_b = (int32_t*)malloc(s1 * sizeof(int32_t));
 	e_b = (int32_t*)malloc(s1 * sizeof(int32_t));
@@ -838,6 +904,12 @@ SmithWaterman::cigar * SmithWaterman::banded_sw(const int *db_sequence, const in
 			h_c = (int32_t*)realloc(h_c, s1 * sizeof(int32_t));
 		}
 		int64_t targetSize = width_d * query_length * 3;
+		checkpointed = targetSize > maxDirectionSize;
+		if (checkpointed) {
+			checkpointRows = std::max(1, static_cast<int32_t>(sqrt(static_cast<double>(query_length))));
+			checkpoints.resize(static_cast<size_t>((query_length + checkpointRows - 1) / checkpointRows) * 2 * width);
+			targetSize = width_d * checkpointRows * 3;
+		}
 		while (targetSize >= s2) {
 			++s2;
 			kroundup32(s2);
@@ -847,56 +919,29 @@ SmithWaterman::cigar * SmithWaterman::banded_sw(const int *db_sequence, const in
 			}
 			direction = (int8_t*)realloc(direction, s2 * sizeof(int8_t));
 		}
-		direction_line = direction;
 		for (j = 1; LIKELY(j < width - 1); j ++) h_b[j] = 0;
 		for (i = 0; LIKELY(i < query_length); i ++) {
-			int32_t beg = 0, end = db_length - 1, u = 0, edge;
-			j = i - band_width;	beg = beg > j ? beg : j; // band start
-			j = i + band_width; end = end < j ? end : j; // band end
-			edge = end + 1 < width - 1 ? end + 1 : width - 1;
-			f = h_b[0] = e_b[0] = h_b[edge] = e_b[edge] = h_c[0] = 0;
-			int64_t directionOffset = width_d * i * 3;
-			direction_line = direction + directionOffset;
-
-			for (j = beg; LIKELY(j <= end); j ++) {
-				int32_t b, e1, f1, d, de, df, dh;
-				set_u(u, band_width, i, j);	set_u(e, band_width, i - 1, j);
-				set_u(b, band_width, i, j - 1); set_u(d, band_width, i - 1, j - 1);
-				set_d(de, band_width, i, j, 0);
-				set_d(df, band_width, i, j, 1);
-				set_d(dh, band_width, i, j, 2);
-
-				temp1 = i == 0 ? -gap_open : h_b[e] - gap_open;
-				temp2 = i == 0 ? -gap_extend : e_b[e] - gap_extend;
-				e_b[u] = temp1 > temp2 ? temp1 : temp2;
-				direction_line[de] = temp1 > temp2 ? 3 : 2;
-
-				temp1 = h_c[b] - gap_open;
-				temp2 = f - gap_extend;
-				f = temp1 > temp2 ? temp1 : temp2;
-				direction_line[df] = temp1 > temp2 ? 5 : 4;
-
-				e1 = e_b[u] > 0 ? e_b[u] : 0;
-				f1 = f > 0 ? f : 0;
-				temp1 = e1 > f1 ? e1 : f1;
-				if(type == SUBSTITUTIONMATRIX){
-					temp2 = h_b[d] + mat[query_sequence[i] * n + db_sequence[j]] + compositionBias[i];
+			if (checkpointed) {
+				if (i % checkpointRows == 0) {
+					int32_t *checkpoint = &checkpoints[static_cast<size_t>(i / checkpointRows) * 2 * width];
+					memcpy(checkpoint, h_b, width * sizeof(int32_t));
+					memcpy(checkpoint + width, e_b, width * sizeof(int32_t));
 				}
-				if(type == PROFILE) {
-					temp2 = h_b[d] + mat[db_sequence[j] * n + (queryStart + i)];
-				}
-				h_c[u] = temp1 > temp2 ? temp1 : temp2;
-
-				if (h_c[u] > max) max = h_c[u];
-
-				if (temp1 <= temp2) direction_line[dh] = 1;
-				else direction_line[dh] = e1 > f1 ? direction_line[de] : direction_line[df];
+				direction_line = direction;
+			} else {
+				direction_line = direction + width_d * i * 3;
 			}
-			for (j = 1; j <= u; j ++) h_b[j] = h_c[j];
+			int32_t rowMax = banded_sw_row<type>(db_sequence, query_sequence, compositionBias, db_length, i, queryStart,
+											   gap_open, gap_extend, band_width, width, mat, n, h_b, e_b, h_c, direction_line);
+			if (rowMax > max) max = rowMax;
 		}
 		band_width *= 2;
 	} while (LIKELY(max < score));
 	band_width /= 2;
+	if (checkpointed) {
+		// no block of directions is available yet
+		blockStart = query_length;
+	}
 
 	// trace back
 	i = query_length - 1;
@@ -906,25 +951,35 @@ SmithWaterman::cigar * SmithWaterman::banded_sw(const int *db_sequence, const in
 	op = prev_op = 'M';
 	temp2 = 2;	// h
 	while (LIKELY(i > 0) || LIKELY(j > 0)) {
+		if (UNLIKELY(i < blockStart) && i >= 0) {
+			blockStart = (i / checkpointRows) * checkpointRows;
+			blockEnd = std::min(blockStart + checkpointRows, query_length);
+			int32_t *checkpoint = &checkpoints[static_cast<size_t>(blockStart / checkpointRows) * 2 * width];
+			memcpy(h_b, checkpoint, width * sizeof(int32_t));
+			memcpy(e_b, checkpoint + width, width * sizeof(int32_t));
+			for (int32_t row = blockStart; row < blockEnd; row++) {
+				banded_sw_row<type>(db_sequence, query_sequence, compositionBias, db_length, row, queryStart,
+									gap_open, gap_extend, band_width, width, mat, n, h_b, e_b, h_c,
+									direction + width_d * (row - blockStart) * 3);
+			}
+		}
+		direction_line = direction + width_d * (i - blockStart) * 3;
 		set_d(temp1, band_width, i, j, temp2);
 		switch (direction_line[temp1]) {
 			case 1:
 				--i;
 				--j;
 				temp2 = 2;
-				direction_line -= width_d * 3;
 				op = 'M';
 				break;
 			case 2:
 				--i;
 				temp2 = 0;	// e
-				direction_line -= width_d * 3;
 				op = 'I';
 				break;
 			case 3:
 				--i;
 				temp2 = 2;
-				direction_line -= width_d * 3;
 				op = 'I';
 				break;
 			case 4:
@@ -999,7 +1054,6 @@ SmithWaterman::cigar * SmithWaterman::banded_sw(const int *db_sequence, const in
 	free(c);
 	return result;
 #undef kroundup32
-#undef set_u
 #undef set_d
 }
 
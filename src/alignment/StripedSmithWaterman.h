@@ -182,6 +182,12 @@ public:
 
     static float computeCov(unsigned int startPos, unsigned int endPos, unsigned int len);
 
+    // direction matrix size (bytes) above which the CIGAR is traced back from checkpoints,
+    // BANDED_SW_MAX_DIRECTION_SIZE by default (tests lower it to compare both trace backs)
+    void setMaxDirectionSize(int64_t size) {
+        maxDirectionSize = size;
+    }
+
     s_align scoreIdentical(int *dbSeq, int L, EvalueComputation * evaluer, int alignmentMode);
 
     static void seq_reverse(int8_t * reverse, const int8_t* seq, int32_t end)	/* end is 0-based alignment ending position */
@@ -276,6 +282,12 @@ private:
                                  uint16_t terminate,
                                  int32_t maskLen);
 
+    // direction matrix size (bytes) above which banded_sw switches to the checkpointed trace back
+    const static int64_t BANDED_SW_MAX_DIRECTION_SIZE = 32 * 1024 * 1024;
+
+    template <const unsigned int type>
+    static int32_t banded_sw_row(const int *db_sequence, const int8_t *query_sequence, const int8_t * compositionBias, int32_t db_length, int32_t i, int32_t queryStart, const uint32_t gap_open, const uint32_t gap_extend, int32_t band_width, int64_t width, const int8_t *mat, int32_t n, int32_t *h_b, int32_t *e_b, int32_t *h_c, int8_t *direction_line);
+
     template <const unsigned int type>
     SmithWaterman::cigar *banded_sw(const int *db_sequence, const int8_t *query_sequence, const int8_t * compositionBias, int32_t db_length, int32_t query_length, int32_t queryStart, int32_t score, const uint32_t gap_open, const uint32_t gap_extend, int32_t band_width, const int8_t *mat, int32_t n);
 
@@ -298,5 +310,6 @@ private:
     float *tmp_composition_bias;
     short * profile_word_linear_data;
     bool aaBiasCorrection;
+    int64_t maxDirectionSize;
 };
 #endif /* SMITH_WATERMAN_SSE2_H */
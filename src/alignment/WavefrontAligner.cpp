@@ -0,0 +1,285 @@
+#include "WavefrontAligner.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+const int WavefrontAligner::NULL_OFFSET;
+const size_t WavefrontAligner::MAX_CELLS_PER_RESIDUE;
+
+WavefrontAligner::WavefrontAligner(const int8_t *mat, int alphabetSize, int gapo, int gape, int zdrop) : zdrop(zdrop) {
+    // ksw2 without KSW_EZ_GENERIC_SC only looks at the match and mismatch score and scores
+    // every pair with the wildcard (alphabetSize - 1) as 0, extensions with wildcards are left to it
+    matchLimit = alphabetSize - 1;
+    matchScore = mat[0];
+    const int mismatchScore = -mat[1];
+    usable = matchScore > 0 && matchScore + mismatchScore > 0 && gapo >= 0 && gape > 0;
+    // the penalties assume one match and one mismatch score for all residues besides the wildcard
+    for (int i = 0; i < matchLimit; i++) {
+        for (int j = 0; j < matchLimit; j++) {
+            usable &= mat[i * alphabetSize + j] == ((i == j) ? mat[0] : mat[1]);
+        }
+    }
+
+    mismatch = 2 * (matchScore + mismatchScore);
+    gapOpen = 2 * gapo;
+    gapExtend = 2 * gape + matchScore;
+}
+
+bool WavefrontAligner::extend(int qlen, const uint8_t *query, int tlen, const uint8_t *target, bool scoreOnly, ksw_extz_t *ez) {
+    if (usable == false) {
+        return false;
+    }
+    // the recurrence has no transition for the zero score of wildcard pairs
+    if (memchr(query, matchLimit, qlen) != NULL || memchr(target, matchLimit, tlen) != NULL) {
+        return false;
+    }
+    wavefronts.clear();
+    offsets.clear();
+    const size_t maxCells = static_cast<size_t>(qlen + tlen) * MAX_CELLS_PER_RESIDUE + 65536;
+    const int maxSourceDistance = std::max(mismatch, gapOpen + gapExtend);
+
+    // scores are kept doubled to stay integer
+    long bestScore2 = 0;
+    int bestScore = 0;
+    int bestK = 0;
+    int bestH = 0;
+    int lastNonEmpty = 0;
+    for (int s = 0; ; s++) {
+        Wavefront wf;
+        if (s == 0) {
+            wf.lo = 0;
+            wf.hi = 0;
+            wf.base = offsets.size();
+            offsets.push_back(0);
+            offsets.push_back(NULL_OFFSET);
+            offsets.push_back(NULL_OFFSET);
+        } else {
+            const int sx = s - mismatch;
+            const int so = s - gapOpen - gapExtend;
+            const int se = s - gapExtend;
+            wf.lo = INT_MAX;
+            wf.hi = INT_MIN;
+            if (sx >= 0 && wavefronts[sx].empty() == false) {
+                wf.lo = std::min(wf.lo, wavefronts[sx].lo);
+                wf.hi = std::max(wf.hi, wavefronts[sx].hi);
+            }
+            if (so >= 0 && wavefronts[so].empty() == false) {
+                wf.lo = std::min(wf.lo, wavefronts[so].lo - 1);
+                wf.hi = std::max(wf.hi, wavefronts[so].hi + 1);
+            }
+            if (se >= 0 && wavefronts[se].empty() == false) {
+                wf.lo = std::min(wf.lo, wavefronts[se].lo - 1);
+                wf.hi = std::max(wf.hi, wavefronts[se].hi + 1);
+            }
+            if (wf.lo > wf.hi) {
+                wf.lo = 1;
+                wf.hi = 0;
+                wf.base = offsets.size();
+                wf.maxScore2 = LONG_MIN;
+                wavefronts.push_back(wf);
+                if (s - lastNonEmpty > maxSourceDistance) {
+                    // all diagonals ran out of sequence
+                    break;
+                }
+                continue;
+            }
+            if (offsets.size() + 3 * static_cast<size_t>(wf.hi - wf.lo + 1) > maxCells) {
+                return false;
+            }
+            wf.base = offsets.size();
+            offsets.resize(wf.base + 3 * static_cast<size_t>(wf.hi - wf.lo + 1));
+            for (int k = wf.lo; k <= wf.hi; k++) {
+                // I consumes query (offset stays), D consumes target
+                int ins = std::max(getOffset(so, 0, k + 1), getOffset(se, 1, k + 1));
+                if (ins < 0 || ins - k > qlen) {
+                    ins = NULL_OFFSET;
+                }
+                int del = std::max(getOffset(so, 0, k - 1), getOffset(se, 2, k - 1)) + 1;
+                if (del < 1 || del > tlen) {
+                    del = NULL_OFFSET;
+                }
+                int mis = getOffset(sx, 0, k) + 1;
+                if (mis < 1 || mis > tlen || mis - k > qlen) {
+                    mis = NULL_OFFSET;
+                }
+                int *cell = &offsets[wf.base + 3 * (k - wf.lo)];
+                cell[0] = std::max(mis, std::max(ins, del));
+                cell[1] = ins;
+                cell[2] = del;
+            }
+        }
+        wavefronts.push_back(wf);
+
+        long currentMax2 = LONG_MIN;
+        for (int k = wf.lo; k <= wf.hi; k++) {
+            int *cell = &offsets[wf.base + 3 * (k - wf.lo)];
+            int h = cell[0];
+            if (h < 0) {
+                continue;
+            }
+            int v = h - k;
+            while (h < tlen && v < qlen && query[v] == target[h] && query[v] < matchLimit) {
+                h++;
+                v++;
+            }
+            cell[0] = h;
+            const long score2 = static_cast<long>(matchScore) * (h + v) - s;
+            currentMax2 = std::max(currentMax2, score2);
+            if (score2 > bestScore2 || (score2 == bestScore2 && (h + v) < (2 * bestH - bestK))) {
+                bestScore2 = score2;
+                bestScore = s;
+                bestK = k;
+                bestH = h;
+            }
+        }
+        // diagonals at the border that dropped more than zdrop below the best score do not
+        // seed the next wavefronts, similar to the z-drop of ksw2
+        Wavefront &current = wavefronts.back();
+        const long dropLimit2 = bestScore2 - 2L * zdrop;
+        while (current.lo <= current.hi) {
+            const int h = offsets[current.base];
+            if (h >= 0 && static_cast<long>(matchScore) * (2 * h - current.lo) - s >= dropLimit2) {
+                break;
+            }
+            current.lo++;
+            current.base += 3;
+        }
+        while (current.hi >= current.lo) {
+            const int h = offsets[current.base + 3 * (current.hi - current.lo)];
+            if (h >= 0 && static_cast<long>(matchScore) * (2 * h - current.hi) - s >= dropLimit2) {
+                break;
+            }
+            current.hi--;
+        }
+        current.maxScore2 = currentMax2;
+        if (currentMax2 == LONG_MIN) {
+            if (s - lastNonEmpty > maxSourceDistance) {
+                break;
+            }
+            continue;
+        }
+        lastNonEmpty = s;
+
+        // the next wavefronts are built from the last maxSourceDistance ones
+        long frontierMax2 = currentMax2;
+        for (int prev = std::max(0, s - maxSourceDistance + 1); prev < s; prev++) {
+            frontierMax2 = std::max(frontierMax2, wavefronts[prev].maxScore2);
+        }
+        if (bestScore2 - frontierMax2 > 2L * zdrop) {
+            // an alignment that stops before the end of both sequences is left to ksw2 and its z-drop
+            if (bestH == tlen || bestH - bestK == qlen) {
+                break;
+            }
+            return false;
+        }
+
+        // below roughly 90% identity the banded ksw2 kernel is faster: give up once the penalty
+        // exceeds a quarter of the perfect score of the best cell
+        if (s > matchScore * (2 * bestH - bestK) / 4 + 2 * zdrop) {
+            return false;
+        }
+
+        // upper bound of any cell reached with a higher penalty: diagonal k needs at least
+        // the penalty of a |k| long gap and can cover at most min(2 * qlen + k, 2 * tlen - k) residues
+        const int nextPenalty = s + 1;
+        const int reachableK = (nextPenalty >= gapOpen + gapExtend) ? (nextPenalty - gapOpen) / gapExtend : 0;
+        const int k = std::max(-reachableK, std::min(reachableK, tlen - qlen));
+        const long bound2 = static_cast<long>(matchScore) * std::min(2 * qlen + k, 2 * tlen - k) - nextPenalty;
+        if (bound2 <= bestScore2) {
+            break;
+        }
+    }
+
+    ez->max = static_cast<uint32_t>(bestScore2 / 2);
+    ez->zdropped = 0;
+    ez->max_t = bestH - 1;
+    ez->max_q = (bestH - bestK) - 1;
+    ez->mqe = ez->mte = ez->score = KSW_NEG_INF;
+    ez->mqe_t = ez->mte_q = -1;
+    ez->n_cigar = 0;
+    if (scoreOnly == false) {
+        traceback(bestScore, bestK, bestH, qlen, tlen, ez);
+    }
+    return true;
+}
+
+void WavefrontAligner::traceback(int score, int k, int h, int qlen, int tlen, ksw_extz_t *ez) {
+    // operations are collected from the end of the alignment
+    std::vector<uint32_t> cigar;
+    int component = 0;
+    while (true) {
+        char op;
+        int length;
+        if (component == 0) {
+            if (score == 0) {
+                op = 0;
+                length = h;
+                score = -1;
+            } else {
+                const int sx = score - mismatch;
+                // same bounds as the forward pass, a mismatch past the end was never taken
+                int mis = getOffset(sx, 0, k) + 1;
+                if (mis < 1 || mis > tlen || mis - k > qlen) {
+                    mis = NULL_OFFSET;
+                }
+                const int ins = getOffset(score, 1, k);
+                const int del = getOffset(score, 2, k);
+                const int base = std::max(mis, std::max(ins, del));
+                op = 0;
+                length = h - base;
+                h = base;
+                if (mis == base) {
+                    length++;
+                    h--;
+                    score = sx;
+                } else if (ins == base) {
+                    component = 1;
+                } else {
+                    component = 2;
+                }
+            }
+        } else if (component == 1) {
+            op = 1;
+            length = 1;
+            const int so = score - gapOpen - gapExtend;
+            if (getOffset(so, 0, k + 1) == h) {
+                score = so;
+                component = 0;
+            } else {
+                score -= gapExtend;
+            }
+            k++;
+        } else {
+            op = 2;
+            length = 1;
+            const int so = score - gapOpen - gapExtend;
+            if (getOffset(so, 0, k - 1) == h - 1) {
+                score = so;
+                component = 0;
+            } else {
+                score -= gapExtend;
+            }
+            k--;
+            h--;
+        }
+        if (length > 0) {
+            if (cigar.empty() == false && (cigar.back() & 0xf) == static_cast<uint32_t>(op)) {
+                cigar.back() += static_cast<uint32_t>(length) << 4;
+            } else {
+                cigar.push_back(static_cast<uint32_t>(length) << 4 | op);
+            }
+        }
+        if (score < 0) {
+            break;
+        }
+    }
+
+    ez->n_cigar = static_cast<int>(cigar.size());
+    ez->m_cigar = ez->n_cigar;
+    ez->cigar = static_cast<uint32_t *>(realloc(ez->cigar, std::max(ez->n_cigar, 1) * sizeof(uint32_t)));
+    for (int i = 0; i < ez->n_cigar; i++) {
+        ez->cigar[i] = cigar[ez->n_cigar - 1 - i];
+    }
+}
@@ -0,0 +1,80 @@
+//
+// Gap-affine wavefront (WFA) extension aligner for nucleotide sequences.
+//
+// Computes the same extension alignment as ksw_extz2 in KSW_EZ_EXTZ_ONLY mode
+// (global start, free end, maximal score), but its cost grows with the number
+// of edits instead of sequence length times band width. Scores with a match bonus
+// are turned into penalties (x = 2(M+X), o = 2O, e = 2E+M) so that an alignment
+// ending in (h, v) has the score (M * (h + v) - penalty) / 2.
+//
+// The extension gives up (extend returns false) if the score of the wavefront
+// drops more than zdrop below the best score before the alignment reached the
+// end of one sequence, if the matrix is not a uniform match/mismatch matrix, or if
+// one of the sequences contains the wildcard, which ksw2 scores as 0 against anything.
+// The caller is expected to fall back to ksw2 in these cases.
+//
+#ifndef MMSEQS_WAVEFRONTALIGNER_H
+#define MMSEQS_WAVEFRONTALIGNER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "ksw2.h"
+
+class WavefrontAligner {
+public:
+    WavefrontAligner(const int8_t *mat, int alphabetSize, int gapo, int gape, int zdrop);
+
+    // fills max, max_q, max_t and (unless scoreOnly) cigar/n_cigar of ez like ksw_extz2
+    // cigar is allocated with malloc and has to be freed by the caller
+    bool extend(int qlen, const uint8_t *query, int tlen, const uint8_t *target, bool scoreOnly, ksw_extz_t *ez);
+
+    bool isUsable() const {
+        return usable;
+    }
+
+private:
+    static const int NULL_OFFSET = -(1 << 29);
+    // work limit in stored offsets per residue, comparable to the memory ksw2 uses for its band
+    static const size_t MAX_CELLS_PER_RESIDUE = 32;
+
+    struct Wavefront {
+        int lo;
+        int hi;
+        // index of M, I and D offsets of diagonal lo in offsets
+        size_t base;
+        // best doubled score of the wavefront after extension
+        long maxScore2;
+
+        bool empty() const {
+            return lo > hi;
+        }
+    };
+
+    bool usable;
+    // index of the wildcard, it never matches
+    int matchLimit;
+    int matchScore;
+    int mismatch;
+    int gapOpen;
+    int gapExtend;
+    int zdrop;
+
+    std::vector<Wavefront> wavefronts;
+    std::vector<int> offsets;
+
+    inline int getOffset(int score, int component, int k) const {
+        if (score < 0) {
+            return NULL_OFFSET;
+        }
+        const Wavefront &wf = wavefronts[score];
+        if (k < wf.lo || k > wf.hi) {
+            return NULL_OFFSET;
+        }
+        return offsets[wf.base + 3 * (k - wf.lo) + component];
+    }
+
+    void traceback(int score, int k, int h, int qlen, int tlen, ksw_extz_t *ez);
+};
+
+#endif
@@ -58,17 +58,17 @@ void AlignmentSymmetry::readInData(DBReader<unsigned int>*alnDbr, DBReader<unsig
                     }
                     char similarity[255 + 1];
                     char dbKey[255 + 1];
-                    Util::parseKey(data, dbKey);
+                    Util::parseKey(data, dbKey, alnDbr->getDbtype());
                     const unsigned int key = (unsigned int) strtoul(dbKey, NULL, 10);
                     const size_t currElement = seqDbr->getId(key);
                     if (elementScoreTable != NULL) {
                         if (scoretype == Parameters::APC_ALIGNMENTSCORE) {
                             //column 1 = alignment score
-                            Util::parseByColumnNumber(data, similarity, 1);
+                            Util::parseByColumnNumber(data, similarity, sizeof(similarity), 1, alnDbr->getDbtype());
                             elementScoreTable[i][writePos] = (unsigned short) (atof(similarity));
                         } else {
                             //column 2 = sequence identity
-                            Util::parseByColumnNumber(data, similarity, 2);
+                            Util::parseByColumnNumber(data, similarity, sizeof(similarity), 2, alnDbr->getDbtype());
                             elementScoreTable[i][writePos] = (unsigned short) (atof(similarity) * 1000.0f);
                         }
                     }
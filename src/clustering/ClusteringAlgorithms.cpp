@@ -3,6 +3,11 @@
 #include "Debug.h"
 #include "AlignmentSymmetry.h"
 #include "Timer.h"
+#include "FileUtil.h"
+#include "Parameters.h"
+#include "itoa.h"
+
+#include "omptl/omptl_algorithm"
 
 #include <queue>
 #include <algorithm>
@@ -14,7 +19,8 @@
 #endif
 
 ClusteringAlgorithms::ClusteringAlgorithms(DBReader<unsigned int>* seqDbr, DBReader<unsigned int>* alnDbr,
-                                           int threads, int scoretype, int maxiterations){
+                                           int threads, int scoretype, int maxiterations,
+                                           size_t memoryLimit, const std::string &tmpPrefix){
     this->seqDbr=seqDbr;
     if(seqDbr->getSize() != alnDbr->getSize()){
         Debug(Debug::ERROR) << "Sequence db size != result db size\n";
@@ -25,6 +31,8 @@ ClusteringAlgorithms::ClusteringAlgorithms(DBReader<unsigned int>* seqDbr, DBRea
     this->threads=threads;
     this->scoretype=scoretype;
     this->maxiterations=maxiterations;
+    this->memoryLimit=memoryLimit;
+    this->tmpPrefix=tmpPrefix;
     ///time
     this->clustersizes=new int[dbSize];
     std::fill_n(clustersizes, dbSize, 0);
@@ -59,8 +67,19 @@ std::unordered_map<unsigned int, std::vector<unsigned int>>  ClusteringAlgorithm
                 elementCount += Util::countLines(data, dataSize);
             }
         }
-        unsigned int * elements = new(std::nothrow) unsigned int[elementCount];
-        Util::checkAllocation(elements, "Can not allocate elements memory in ClusteringAlgorithms::execute");
+        // readInClusterData holds the read and the symmetric sets with scores (at most twice as many) at once
+        const size_t memoryNeeded = elementCount * (sizeof(unsigned int) + 2 * (sizeof(unsigned int) + sizeof(unsigned short)))
+                                    + static_cast<size_t>(threads) * dbSize * sizeof(unsigned int);
+        const size_t availableMemory = (memoryLimit > 0) ? memoryLimit : static_cast<size_t>(Util::getTotalSystemMemory() * 0.9);
+        const bool external = memoryNeeded > availableMemory && tmpPrefix.empty() == false;
+        Debug(Debug::INFO) << "Alignment graph needs " << memoryNeeded / 1024 / 1024 << " MB, memory limit is "
+                           << availableMemory / 1024 / 1024 << " MB"
+                           << ((memoryLimit > 0) ? "" : " (90% of system memory, --split-memory-limit is 0)") << "\n";
+        unsigned int * elements = NULL;
+        if (external == false) {
+            elements = new(std::nothrow) unsigned int[elementCount];
+            Util::checkAllocation(elements, "Can not allocate elements memory in ClusteringAlgorithms::execute");
+        }
         unsigned int ** elementLookupTable = new(std::nothrow) unsigned int*[dbSize];
         Util::checkAllocation(elementLookupTable, "Can not allocate elementLookupTable memory in ClusteringAlgorithms::execute");
         unsigned short **scoreLookupTable = new(std::nothrow) unsigned short *[dbSize];
@@ -73,7 +92,12 @@ std::unordered_map<unsigned int, std::vector<unsigned int>>  ClusteringAlgorithm
         Util::checkAllocation(bestscore, "Can not allocate bestscore memory in ClusteringAlgorithms::execute");
         std::fill_n(bestscore, dbSize, SHRT_MIN);
 
-        readInClusterData(elementLookupTable, elements, scoreLookupTable, score, elementOffsets, elementCount);
+        if (external) {
+            Debug(Debug::INFO) << "Alignment graph exceeds the memory limit, symmetrise it on disk in temporary files " << tmpPrefix << "_*\n";
+            readInClusterDataExternal(elementLookupTable, elements, scoreLookupTable, score, elementOffsets, elementCount);
+        } else {
+            readInClusterData(elementLookupTable, elements, scoreLookupTable, score, elementOffsets, elementCount);
+        }
 
 
         if (mode==2){
@@ -85,34 +109,7 @@ std::unordered_map<unsigned int, std::vector<unsigned int>>  ClusteringAlgorithm
                 setCover(elementLookupTable, scoreLookupTable, assignedcluster, bestscore, elementOffsets);
             } else if (mode == 3) {
                 Debug(Debug::INFO) << "connected component mode" << "\n";
-                for (int cl_size = dbSize - 1; cl_size >= 0; cl_size--) {
-                    unsigned int representative = sorted_clustersizes[cl_size];
-                    if (assignedcluster[representative] == UINT_MAX) {
-                        assignedcluster[representative] = representative;
-                        std::queue<int> myqueue;
-                        myqueue.push(representative);
-                        std::queue<int> iterationcutoffs;
-                        iterationcutoffs.push(0);
-                        //delete clusters of members;
-                        while (!myqueue.empty()) {
-                            int currentid = myqueue.front();
-                            int iterationcutoff = iterationcutoffs.front();
-                            assignedcluster[currentid] = representative;
-                            myqueue.pop();
-                            iterationcutoffs.pop();
-                            size_t elementSize = (elementOffsets[currentid + 1] - elementOffsets[currentid]);
-                            for (size_t elementId = 0; elementId < elementSize; elementId++) {
-                                unsigned int elementtodelete = elementLookupTable[currentid][elementId];
-                                if (assignedcluster[elementtodelete] == UINT_MAX && iterationcutoff < maxiterations) {
-                                    myqueue.push(elementtodelete);
-                                    iterationcutoffs.push((iterationcutoff + 1));
-                                }
-                                assignedcluster[elementtodelete] = representative;
-                            }
-                        }
-
-                    }
-                }
+                connectedComponent(elementLookupTable, elementOffsets, assignedcluster);
             }
             //delete unnecessary datastructures
             delete [] sorted_clustersizes;
@@ -120,11 +117,18 @@ std::unordered_map<unsigned int, std::vector<unsigned int>>  ClusteringAlgorithm
             delete [] borders_of_set;
         }
 
+        if (external) {
+            if (elementOffsets[dbSize] > 0) {
+                FileUtil::munmapData(elements, elementOffsets[dbSize] * sizeof(unsigned int));
+                FileUtil::munmapData(score, elementOffsets[dbSize] * sizeof(unsigned short));
+            }
+        } else {
+            delete [] elements;
+            delete [] score;
+        }
         delete [] elementLookupTable;
-        delete [] elements;
         delete [] elementOffsets;
         delete [] scoreLookupTable;
-        delete [] score;
         delete [] bestscore;
     }
 
@@ -208,6 +212,210 @@ void ClusteringAlgorithms::decreaseClustersize(int clusterid){
     clustersizes[clusterid]--;
 }
 
+static inline unsigned int findRoot(unsigned int *parent, unsigned int id) {
+    unsigned int curr = __atomic_load_n(&parent[id], __ATOMIC_RELAXED);
+    while (curr != id) {
+        // path halving, a lost race only leaves a longer path behind
+        unsigned int next = __atomic_load_n(&parent[curr], __ATOMIC_RELAXED);
+        __atomic_compare_exchange_n(&parent[id], &curr, next, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        id = curr;
+        curr = next;
+    }
+    return id;
+}
+
+void ClusteringAlgorithms::connectedComponent(unsigned int **elementLookupTable, size_t *elementOffsets,
+                                              unsigned int *assignedcluster) {
+    // 1.) components by lock-free union-find, roots are only linked to smaller roots
+    unsigned int *parent = new(std::nothrow) unsigned int[dbSize];
+    Util::checkAllocation(parent, "Can not allocate parent memory in ClusteringAlgorithms::connectedComponent");
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < dbSize; i++) {
+        parent[i] = i;
+    }
+#pragma omp parallel for schedule(dynamic, 1000)
+    for (size_t i = 0; i < dbSize; i++) {
+        const size_t elementSize = (elementOffsets[i + 1] - elementOffsets[i]);
+        for (size_t elementId = 0; elementId < elementSize; elementId++) {
+            unsigned int a = findRoot(parent, i);
+            unsigned int b = findRoot(parent, elementLookupTable[i][elementId]);
+            while (a != b) {
+                if (a < b) {
+                    std::swap(a, b);
+                }
+                unsigned int expected = a;
+                if (__atomic_compare_exchange_n(&parent[a], &expected, b, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                    break;
+                }
+                a = findRoot(parent, a);
+                b = findRoot(parent, b);
+            }
+        }
+    }
+
+    // 2.) the representative is the member the breadth first search would start from:
+    // the one with the largest set (latest position in sorted_clustersizes)
+    unsigned int *componentSize = new(std::nothrow) unsigned int[dbSize];
+    Util::checkAllocation(componentSize, "Can not allocate componentSize memory in ClusteringAlgorithms::connectedComponent");
+    unsigned int *componentRep = new(std::nothrow) unsigned int[dbSize];
+    Util::checkAllocation(componentRep, "Can not allocate componentRep memory in ClusteringAlgorithms::connectedComponent");
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < dbSize; i++) {
+        componentSize[i] = 0;
+        componentRep[i] = 0;
+    }
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < dbSize; i++) {
+        const unsigned int root = findRoot(parent, i);
+        // other threads still walk through parent[i] in findRoot
+        __atomic_store_n(&parent[i], root, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&componentSize[root], 1, __ATOMIC_RELAXED);
+        // positions are stored +1 to tell them apart from the initial 0
+        const unsigned int position = clusterid_to_arrayposition[i] + 1;
+        unsigned int curr = __atomic_load_n(&componentRep[root], __ATOMIC_RELAXED);
+        while (curr < position && !__atomic_compare_exchange_n(&componentRep[root], &curr, position, false,
+                                                               __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    }
+
+    // 3.) the breadth first search assigns all members with a distance of at most maxiterations + 1
+    // to the representative. Only components that are too large to be sure about it are checked.
+    std::vector<unsigned int> checkRoots;
+    for (size_t i = 0; i < dbSize; i++) {
+        if (parent[i] == i && componentSize[i] > static_cast<unsigned int>(maxiterations) + 2) {
+            checkRoots.push_back(i);
+        }
+    }
+    int *depth = NULL;
+    if (checkRoots.empty() == false) {
+        depth = new(std::nothrow) int[dbSize];
+        Util::checkAllocation(depth, "Can not allocate depth memory in ClusteringAlgorithms::connectedComponent");
+        std::fill_n(depth, dbSize, -1);
+    }
+    std::vector<char> complete(checkRoots.size(), 1);
+    // smaller components are searched by one thread each, larger ones level by level with all threads
+    const unsigned int parallelSearchSize = 100000;
+#pragma omp parallel
+    {
+        std::vector<unsigned int> queue;
+#pragma omp for schedule(dynamic, 1)
+        for (size_t c = 0; c < checkRoots.size(); c++) {
+            const unsigned int root = checkRoots[c];
+            if (componentSize[root] >= parallelSearchSize) {
+                continue;
+            }
+            const unsigned int representative = sorted_clustersizes[componentRep[root] - 1];
+            queue.clear();
+            queue.push_back(representative);
+            depth[representative] = 0;
+            size_t visited = 1;
+            for (size_t pos = 0; pos < queue.size(); pos++) {
+                const unsigned int currentid = queue[pos];
+                if (depth[currentid] > maxiterations) {
+                    continue;
+                }
+                const size_t elementSize = (elementOffsets[currentid + 1] - elementOffsets[currentid]);
+                for (size_t elementId = 0; elementId < elementSize; elementId++) {
+                    const unsigned int element = elementLookupTable[currentid][elementId];
+                    if (depth[element] == -1) {
+                        depth[element] = depth[currentid] + 1;
+                        queue.push_back(element);
+                        visited++;
+                    }
+                }
+            }
+            complete[c] = (visited == componentSize[root]);
+        }
+    }
+    std::vector<unsigned int> frontier;
+    std::vector<unsigned int> nextFrontier;
+    for (size_t c = 0; c < checkRoots.size(); c++) {
+        const unsigned int root = checkRoots[c];
+        if (componentSize[root] < parallelSearchSize) {
+            continue;
+        }
+        const unsigned int representative = sorted_clustersizes[componentRep[root] - 1];
+        frontier.clear();
+        frontier.push_back(representative);
+        depth[representative] = 0;
+        size_t visited = 1;
+        // one level at a time, the threads claim the members of the next level by their depth
+        for (int level = 0; level <= maxiterations && frontier.empty() == false; level++) {
+            nextFrontier.clear();
+#pragma omp parallel if(frontier.size() > 1000)
+            {
+                std::vector<unsigned int> threadFrontier;
+#pragma omp for schedule(dynamic, 100) nowait
+                for (size_t pos = 0; pos < frontier.size(); pos++) {
+                    const unsigned int currentid = frontier[pos];
+                    const size_t elementSize = (elementOffsets[currentid + 1] - elementOffsets[currentid]);
+                    for (size_t elementId = 0; elementId < elementSize; elementId++) {
+                        const unsigned int element = elementLookupTable[currentid][elementId];
+                        int expected = -1;
+                        if (__atomic_load_n(&depth[element], __ATOMIC_RELAXED) == -1
+                            && __atomic_compare_exchange_n(&depth[element], &expected, level + 1, false,
+                                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                            threadFrontier.push_back(element);
+                        }
+                    }
+                }
+#pragma omp critical
+                nextFrontier.insert(nextFrontier.end(), threadFrontier.begin(), threadFrontier.end());
+            }
+            visited += nextFrontier.size();
+            frontier.swap(nextFrontier);
+        }
+        complete[c] = (visited == componentSize[root]);
+    }
+    for (size_t c = 0; c < checkRoots.size(); c++) {
+        if (complete[c] == false) {
+            // mark the root so that its members are handled by the breadth first search below
+            componentRep[checkRoots[c]] = 0;
+        }
+    }
+    delete[] depth;
+
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < dbSize; i++) {
+        const unsigned int repPosition = componentRep[parent[i]];
+        if (repPosition != 0) {
+            assignedcluster[i] = sorted_clustersizes[repPosition - 1];
+        }
+    }
+
+    // 4.) components that the depth limit splits up are clustered by the breadth first search
+    for (int cl_size = dbSize - 1; cl_size >= 0; cl_size--) {
+        unsigned int representative = sorted_clustersizes[cl_size];
+        if (assignedcluster[representative] == UINT_MAX) {
+            assignedcluster[representative] = representative;
+            std::queue<int> myqueue;
+            myqueue.push(representative);
+            std::queue<int> iterationcutoffs;
+            iterationcutoffs.push(0);
+            //delete clusters of members;
+            while (!myqueue.empty()) {
+                int currentid = myqueue.front();
+                int iterationcutoff = iterationcutoffs.front();
+                assignedcluster[currentid] = representative;
+                myqueue.pop();
+                iterationcutoffs.pop();
+                size_t elementSize = (elementOffsets[currentid + 1] - elementOffsets[currentid]);
+                for (size_t elementId = 0; elementId < elementSize; elementId++) {
+                    unsigned int elementtodelete = elementLookupTable[currentid][elementId];
+                    if (assignedcluster[elementtodelete] == UINT_MAX && iterationcutoff < maxiterations) {
+                        myqueue.push(elementtodelete);
+                        iterationcutoffs.push((iterationcutoff + 1));
+                    }
+                    assignedcluster[elementtodelete] = representative;
+                }
+            }
+        }
+    }
+
+    delete[] parent;
+    delete[] componentSize;
+    delete[] componentRep;
+}
+
 void ClusteringAlgorithms::setCover(unsigned int **elementLookupTable, unsigned short ** elementScoreLookupTable,
                                     unsigned int *assignedcluster, short *bestscore, size_t *newElementOffsets) {
     for (int cl_size = dbSize - 1; cl_size >= 0; cl_size--) {
@@ -306,7 +514,7 @@ void ClusteringAlgorithms::greedyIncrementalLowMem( unsigned int *assignedcluste
 
             while (*data != '\0') {
                 char dbKey[255 + 1];
-                Util::parseKey(data, dbKey);
+                Util::parseKey(data, dbKey, alnDbr->getDbtype());
                 const unsigned int key = (unsigned int) strtoul(dbKey, NULL, 10);
                 unsigned int currElement = seqDbr->getId(key);
                 unsigned int targetId;
@@ -342,7 +550,7 @@ void ClusteringAlgorithms::greedyIncrementalLowMem( unsigned int *assignedcluste
 
             while (*data != '\0') {
                 char dbKey[255 + 1];
-                Util::parseKey(data, dbKey);
+                Util::parseKey(data, dbKey, alnDbr->getDbtype());
                 const unsigned int key = (unsigned int) strtoul(dbKey, NULL, 10);
                 unsigned int currElement = seqDbr->getId(key);
                 unsigned int targetId;
@@ -463,3 +671,305 @@ void ClusteringAlgorithms::readInClusterData(unsigned int **elementLookupTable,
     delete[] newElementOffsets;
     Debug(Debug::INFO) << "\nTime for read in: " << timer.lap() << "\n";
 }
+
+
+// symmetric connection j <- source that has to be added to set j unless set j already contains source
+struct ReverseLink {
+    unsigned int target;
+    unsigned int source;
+    // position in the set of source, keeps the order of repeated elements
+    unsigned int rank;
+    unsigned short score;
+
+    static bool compare(const ReverseLink &first, const ReverseLink &second) {
+        if (first.target != second.target) {
+            return first.target < second.target;
+        }
+        if (first.source != second.source) {
+            return first.source < second.source;
+        }
+        return first.rank < second.rank;
+    }
+};
+
+// reads the set of an alignment entry like AlignmentSymmetry::readInData
+static void readSet(DBReader<unsigned int> *alnDbr, DBReader<unsigned int> *seqDbr, size_t id, int scoretype,
+                    unsigned int thread_idx, std::vector<unsigned int> &set, std::vector<unsigned short> &scores) {
+    set.clear();
+    scores.clear();
+    char *data = alnDbr->getDataByDBKey(seqDbr->getDbKey(id), thread_idx);
+    if (*data == '\0') {
+        Debug(Debug::ERROR) << "Sequence " << id << " does not contain any sequence for key " << seqDbr->getDbKey(id) << "!\n";
+        return;
+    }
+    char similarity[255 + 1];
+    char dbKey[255 + 1];
+    while (*data != '\0') {
+        Util::parseKey(data, dbKey, alnDbr->getDbtype());
+        const unsigned int key = (unsigned int) strtoul(dbKey, NULL, 10);
+        const size_t currElement = seqDbr->getId(key);
+        if (currElement == UINT_MAX || currElement > seqDbr->getSize()) {
+            Debug(Debug::ERROR) << "Element " << dbKey
+                                << " contained in some alignment list, but not contained in the sequence database!\n";
+            EXIT(EXIT_FAILURE);
+        }
+        if (scoretype == Parameters::APC_ALIGNMENTSCORE) {
+            //column 1 = alignment score
+            Util::parseByColumnNumber(data, similarity, sizeof(similarity), 1, alnDbr->getDbtype());
+            scores.push_back((unsigned short) (atof(similarity)));
+        } else {
+            //column 2 = sequence identity
+            Util::parseByColumnNumber(data, similarity, sizeof(similarity), 2, alnDbr->getDbtype());
+            scores.push_back((unsigned short) (atof(similarity) * 1000.0f));
+        }
+        set.push_back(currElement);
+        data = Util::skipLine(data);
+    }
+}
+
+// links of one bucket that a thread appended to its file in one batch
+struct LinkSegment {
+    size_t bucket;
+    size_t offset;
+    size_t count;
+};
+
+// appends the links of a thread to the file of the thread, sorted by target set, and remembers
+// which part of the file belongs to which bucket
+static void writeLinks(std::vector<ReverseLink> &buffer, const std::vector<unsigned int> &bucketStart,
+                       FILE *handle, size_t &linksWritten, std::vector<LinkSegment> &segments) {
+    std::sort(buffer.begin(), buffer.end(), ReverseLink::compare);
+    size_t start = 0;
+    while (start < buffer.size()) {
+        const size_t bucket = std::upper_bound(bucketStart.begin(), bucketStart.end(), buffer[start].target) - bucketStart.begin() - 1;
+        size_t end = start;
+        while (end < buffer.size() && buffer[end].target < bucketStart[bucket + 1]) {
+            end++;
+        }
+        LinkSegment segment;
+        segment.bucket = bucket;
+        segment.offset = linksWritten + start;
+        segment.count = end - start;
+        segments.push_back(segment);
+        start = end;
+    }
+    if (fwrite(buffer.data(), sizeof(ReverseLink), buffer.size(), handle) != buffer.size()) {
+        Debug(Debug::ERROR) << "Could not write connections\n";
+        EXIT(EXIT_FAILURE);
+    }
+    linksWritten += buffer.size();
+    buffer.clear();
+}
+
+void ClusteringAlgorithms::readInClusterDataExternal(unsigned int **elementLookupTable, unsigned int *&elements,
+                                                     unsigned short **scoreLookupTable, unsigned short *&scores,
+                                                     size_t *elementOffsets, size_t totalElementCount) {
+    Timer timer;
+    const size_t availableMemory = (memoryLimit > 0) ? memoryLimit : static_cast<size_t>(Util::getTotalSystemMemory() * 0.9);
+
+    // buckets are consecutive ranges of sets, half of the memory is used to sort one bucket.
+    // Twice as many buckets as needed on average, larger buckets are assembled in several rounds.
+    const size_t bucketBytes = std::max(availableMemory / 2, sizeof(ReverseLink));
+    const size_t buckets = std::min(static_cast<size_t>(std::max(dbSize, 1u)),
+                                    2 * ((totalElementCount * sizeof(ReverseLink)) / bucketBytes + 1));
+    std::vector<unsigned int> bucketStart;
+    for (size_t bucket = 0; bucket <= buckets; bucket++) {
+        bucketStart.push_back(static_cast<unsigned int>((static_cast<size_t>(dbSize) * bucket) / buckets));
+    }
+    Debug(Debug::INFO) << "Write connections of " << buckets << " buckets\n";
+
+    // 1.) read all sets once, write their reverse connections into one file per thread and
+    // count how many sets contain each element
+    unsigned int *containedIn = new(std::nothrow) unsigned int[dbSize];
+    Util::checkAllocation(containedIn, "Can not allocate containedIn memory in readInClusterDataExternal");
+    std::fill_n(containedIn, dbSize, 0);
+    std::vector<std::string> threadFiles;
+    std::vector<FILE *> threadHandles;
+    for (int thread = 0; thread < threads; thread++) {
+        threadFiles.push_back(tmpPrefix + "_links_" + SSTR(thread));
+        threadHandles.push_back(FileUtil::openFileOrDie(threadFiles.back().c_str(), "wb", false));
+    }
+    std::vector<std::vector<LinkSegment> > threadSegments(threads);
+    const size_t bufferSize = std::max(static_cast<size_t>(1024), availableMemory / 4 / sizeof(ReverseLink) / static_cast<size_t>(threads));
+#pragma omp parallel
+    {
+        unsigned int thread_idx = 0;
+#ifdef OPENMP
+        thread_idx = static_cast<unsigned int>(omp_get_thread_num());
+#endif
+        std::vector<unsigned int> set;
+        std::vector<unsigned short> setScores;
+        std::vector<ReverseLink> buffer;
+        buffer.reserve(bufferSize);
+        size_t linksWritten = 0;
+#pragma omp for schedule(dynamic, 1000)
+        for (size_t i = 0; i < dbSize; i++) {
+            readSet(alnDbr, seqDbr, i, scoretype, thread_idx, set, setScores);
+            for (size_t elementId = 0; elementId < set.size(); elementId++) {
+                __atomic_fetch_add(&containedIn[set[elementId]], 1, __ATOMIC_RELAXED);
+                ReverseLink link;
+                link.target = set[elementId];
+                link.source = i;
+                link.rank = elementId;
+                link.score = setScores[elementId];
+                buffer.push_back(link);
+            }
+            if (buffer.size() >= bufferSize) {
+                writeLinks(buffer, bucketStart, threadHandles[thread_idx], linksWritten, threadSegments[thread_idx]);
+            }
+        }
+        writeLinks(buffer, bucketStart, threadHandles[thread_idx], linksWritten, threadSegments[thread_idx]);
+    }
+    alnDbr->remapData();
+    for (int thread = 0; thread < threads; thread++) {
+        if (fclose(threadHandles[thread]) != 0) {
+            Debug(Debug::ERROR) << "Could not write " << threadFiles[thread] << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+        threadHandles[thread] = FileUtil::openFileOrDie(threadFiles[thread].c_str(), "rb", true);
+    }
+
+    // 2.) each set is its read set followed by the reverse connections it does not contain yet
+    // (in order of their source set), the same layout AlignmentSymmetry::addMissingLinks produces
+    std::string elementsFile = tmpPrefix + "_elements";
+    std::string scoresFile = tmpPrefix + "_scores";
+    FILE *elementsHandle = FileUtil::openFileOrDie(elementsFile.c_str(), "wb", false);
+    FILE *scoresHandle = FileUtil::openFileOrDie(scoresFile.c_str(), "wb", false);
+    const size_t chunkSize = 1000;
+    std::vector<ReverseLink> block(1024 * 1024 / sizeof(ReverseLink));
+    std::vector<ReverseLink> links;
+    for (size_t bucket = 0; bucket < buckets; bucket++) {
+        // split the bucket into rounds whose connections fit into half of the memory
+        std::vector<unsigned int> roundStart(1, bucketStart[bucket]);
+        size_t currBytes = 0;
+        for (size_t i = bucketStart[bucket]; i < bucketStart[bucket + 1]; i++) {
+            const size_t bytes = static_cast<size_t>(containedIn[i]) * sizeof(ReverseLink);
+            if (currBytes > 0 && currBytes + bytes > bucketBytes) {
+                roundStart.push_back(i);
+                currBytes = 0;
+            }
+            currBytes += bytes;
+        }
+        roundStart.push_back(bucketStart[bucket + 1]);
+        for (size_t round = 0; round + 1 < roundStart.size(); round++) {
+            const size_t first = roundStart[round];
+            const size_t last = roundStart[round + 1];
+            size_t linkCount = 0;
+            for (size_t i = first; i < last; i++) {
+                linkCount += containedIn[i];
+            }
+            links.clear();
+            links.reserve(linkCount);
+            for (int thread = 0; thread < threads; thread++) {
+                for (size_t segmentIdx = 0; segmentIdx < threadSegments[thread].size(); segmentIdx++) {
+                    const LinkSegment &segment = threadSegments[thread][segmentIdx];
+                    if (segment.bucket != bucket) {
+                        continue;
+                    }
+                    if (fseek(threadHandles[thread], segment.offset * sizeof(ReverseLink), SEEK_SET) != 0) {
+                        Debug(Debug::ERROR) << "Could not read " << threadFiles[thread] << "\n";
+                        EXIT(EXIT_FAILURE);
+                    }
+                    for (size_t pos = 0; pos < segment.count; pos += block.size()) {
+                        const size_t count = std::min(block.size(), segment.count - pos);
+                        if (fread(block.data(), sizeof(ReverseLink), count, threadHandles[thread]) != count) {
+                            Debug(Debug::ERROR) << "Could not read " << threadFiles[thread] << "\n";
+                            EXIT(EXIT_FAILURE);
+                        }
+                        for (size_t linkIdx = 0; linkIdx < count; linkIdx++) {
+                            if (block[linkIdx].target >= first && block[linkIdx].target < last) {
+                                links.push_back(block[linkIdx]);
+                            }
+                        }
+                    }
+                }
+            }
+            omptl::sort(links.begin(), links.end(), ReverseLink::compare);
+
+            const size_t chunks = (last - first + chunkSize - 1) / chunkSize;
+#pragma omp parallel
+            {
+                unsigned int thread_idx = 0;
+#ifdef OPENMP
+                thread_idx = static_cast<unsigned int>(omp_get_thread_num());
+#endif
+                std::vector<unsigned int> set;
+                std::vector<unsigned short> setScores;
+                std::vector<unsigned int> sortedSet;
+                std::vector<unsigned int> chunkElements;
+                std::vector<unsigned short> chunkScores;
+#pragma omp for ordered schedule(dynamic, 1)
+                for (size_t chunk = 0; chunk < chunks; chunk++) {
+                    chunkElements.clear();
+                    chunkScores.clear();
+                    const size_t start = first + chunk * chunkSize;
+                    const size_t end = std::min(start + chunkSize, last);
+                    ReverseLink startLink;
+                    startLink.target = start;
+                    startLink.source = 0;
+                    startLink.rank = 0;
+                    size_t linkPos = std::lower_bound(links.begin(), links.end(), startLink, ReverseLink::compare) - links.begin();
+                    for (size_t i = start; i < end; i++) {
+                        readSet(alnDbr, seqDbr, i, scoretype, thread_idx, set, setScores);
+                        chunkElements.insert(chunkElements.end(), set.begin(), set.end());
+                        chunkScores.insert(chunkScores.end(), setScores.begin(), setScores.end());
+                        sortedSet = set;
+                        std::sort(sortedSet.begin(), sortedSet.end());
+                        size_t setSize = set.size();
+                        for (; linkPos < links.size() && links[linkPos].target == i; linkPos++) {
+                            if (std::binary_search(sortedSet.begin(), sortedSet.end(), links[linkPos].source) == false) {
+                                chunkElements.push_back(links[linkPos].source);
+                                chunkScores.push_back(links[linkPos].score);
+                                setSize++;
+                            }
+                        }
+                        elementOffsets[i] = setSize;
+                    }
+#pragma omp ordered
+                    {
+                        fwrite(chunkElements.data(), sizeof(unsigned int), chunkElements.size(), elementsHandle);
+                        fwrite(chunkScores.data(), sizeof(unsigned short), chunkScores.size(), scoresHandle);
+                    }
+                }
+            }
+            alnDbr->remapData();
+        }
+    }
+    std::vector<ReverseLink>().swap(links);
+    delete[] containedIn;
+    for (int thread = 0; thread < threads; thread++) {
+        fclose(threadHandles[thread]);
+        FileUtil::remove(threadFiles[thread].c_str());
+    }
+    if (fclose(elementsHandle) != 0 || fclose(scoresHandle) != 0) {
+        Debug(Debug::ERROR) << "Could not write " << elementsFile << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+
+    maxClustersize = 0;
+    for (size_t i = 0; i < dbSize; i++) {
+        maxClustersize = std::max((unsigned int) elementOffsets[i], maxClustersize);
+        clustersizes[i] = elementOffsets[i];
+    }
+    AlignmentSymmetry::computeOffsetFromCounts(elementOffsets, dbSize);
+    const size_t symmetricElementCount = elementOffsets[dbSize];
+    Debug(Debug::INFO) << "Found " << symmetricElementCount - totalElementCount << " new connections.\n";
+
+    // the sets are only read from here on, the files can be removed as soon as they are mapped
+    elements = NULL;
+    scores = NULL;
+    if (symmetricElementCount > 0) {
+        size_t dataSize;
+        FILE *handle = FileUtil::openFileOrDie(elementsFile.c_str(), "rb", true);
+        elements = static_cast<unsigned int *>(FileUtil::mmapFile(handle, &dataSize));
+        fclose(handle);
+        handle = FileUtil::openFileOrDie(scoresFile.c_str(), "rb", true);
+        scores = static_cast<unsigned short *>(FileUtil::mmapFile(handle, &dataSize));
+        fclose(handle);
+    }
+    FileUtil::remove(elementsFile.c_str());
+    FileUtil::remove(scoresFile.c_str());
+    AlignmentSymmetry::setupPointers<unsigned int>(elements, elementLookupTable, elementOffsets, dbSize, symmetricElementCount);
+    AlignmentSymmetry::setupPointers<unsigned short>(scores, scoreLookupTable, elementOffsets, dbSize, symmetricElementCount);
+    Debug(Debug::INFO) << "\nTime for read in: " << timer.lap() << "\n";
+}
@@ -9,12 +9,15 @@
 #include <list>
 #include <vector>
 #include <unordered_map>
+#include <string>
 
 #include "DBReader.h"
 
 class ClusteringAlgorithms {
 public:
-    ClusteringAlgorithms(DBReader<unsigned int>* seqDbr, DBReader<unsigned int>* alnDbr, int threads,int scoretype, int maxiterations);
+    // graphs that do not fit into memoryLimit (0 = system memory) are symmetrised on disk in files starting with tmpPrefix
+    ClusteringAlgorithms(DBReader<unsigned int>* seqDbr, DBReader<unsigned int>* alnDbr, int threads,int scoretype, int maxiterations,
+                         size_t memoryLimit = 0, const std::string &tmpPrefix = "");
     ~ClusteringAlgorithms();
     std::unordered_map<unsigned int, std::vector<unsigned int>> execute(int mode);
 private:
@@ -25,6 +28,8 @@ private:
 
     int threads;
     int scoretype;
+    size_t memoryLimit;
+    std::string tmpPrefix;
 //datastructures
     unsigned int maxClustersize;
     unsigned int dbSize;
@@ -47,6 +52,9 @@ private:
     void setCover(unsigned int **elementLookup, unsigned short ** elementScoreLookupTable,
                   unsigned int *assignedcluster, short *bestscore, size_t *offsets);
 
+    void connectedComponent(unsigned int **elementLookupTable, size_t *elementOffsets,
+                            unsigned int *assignedcluster);
+
     void greedyIncremental(unsigned int **elementLookupTable, size_t *elementOffsets,
                            size_t n, unsigned int *assignedcluster) ;
 
@@ -58,6 +66,12 @@ private:
                            unsigned short **scoreLookupTable, unsigned short *&scores,
                            size_t *elementOffsets, size_t totalElementCount)  ;
 
+    // builds the same symmetric sets as readInClusterData through sorted on-disk buckets,
+    // elements and scores are memory mapped and have to be released with munmapData
+    void readInClusterDataExternal(unsigned int **elementLookupTable, unsigned int *&elements,
+                                   unsigned short **scoreLookupTable, unsigned short *&scores,
+                                   size_t *elementOffsets, size_t totalElementCount);
+
 };
 
 
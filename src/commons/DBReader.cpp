@@ -18,13 +18,14 @@
 #include "Util.h"
 #include "FileUtil.h"
 #include "itoa.h"
+#include "PackedProfile.h"
 
 template <typename T>
 DBReader<T>::DBReader(const char* dataFileName_, const char* indexFileName_, int threads, int dataMode) :
 threads(threads), dataMode(dataMode), dataFileName(strdup(dataFileName_)),
         indexFileName(strdup(indexFileName_)), size(0), dataFiles(NULL), dataSizeOffset(NULL), dataFileCnt(0),
         totalDataSize(0), dataSize(0), lastKey(T()), closed(1), dbtype(Parameters::DBTYPE_GENERIC_DB),
-        compressedBuffers(NULL), compressedBufferSizes(NULL), index(NULL), id2local(NULL), local2id(NULL),
+        compressedBuffers(NULL), compressedBufferSizes(NULL), packedBuffers(NULL), packedBufferSizes(NULL), index(NULL), id2local(NULL), local2id(NULL),
         dataMapped(false), accessType(0), externalData(false), didMlock(false)
 {}
 
@@ -33,7 +34,7 @@ DBReader<T>::DBReader(DBReader<T>::Index *index, size_t size, size_t dataSize, T
         int dbType, unsigned int maxSeqLen, int threads) :
         threads(threads), dataMode(USE_INDEX), dataFileName(NULL), indexFileName(NULL),
         size(size), dataFiles(NULL), dataSizeOffset(NULL), dataFileCnt(0), totalDataSize(0), dataSize(dataSize), lastKey(lastKey),
-        maxSeqLen(maxSeqLen), closed(1), dbtype(dbType), compressedBuffers(NULL), compressedBufferSizes(NULL), index(index), sortedByOffset(true),
+        maxSeqLen(maxSeqLen), closed(1), dbtype(dbType), compressedBuffers(NULL), compressedBufferSizes(NULL), packedBuffers(NULL), packedBufferSizes(NULL), index(index), sortedByOffset(true),
         id2local(NULL), local2id(NULL), dataMapped(false), accessType(NOSORT), externalData(true), didMlock(false)
 {}
 
@@ -183,6 +184,7 @@ template <typename T> bool DBReader<T>::open(int accessType){
     }
 
     compression = isCompressed(dbtype);
+    packedProfile = compression == COMPRESSED && PackedProfile::isPacked(dbtype);
     if(compression == COMPRESSED){
         compressedBufferSizes = new size_t[threads];
         compressedBuffers = new char*[threads];
@@ -201,6 +203,15 @@ template <typename T> bool DBReader<T>::open(int accessType){
                 EXIT(EXIT_FAILURE);
             }
         }
+        if (packedProfile) {
+            packedBufferSizes = new size_t[threads];
+            packedBuffers = new char*[threads];
+            for (int i = 0; i < threads; i++) {
+                packedBufferSizes[i] = compressedBufferSizes[i];
+                packedBuffers[i] = (char*) malloc(packedBufferSizes[i]);
+                Util::checkAllocation(packedBuffers[i], "Can not allocate packedBuffer");
+            }
+        }
     }
 
     closed = 0;
@@ -467,6 +478,14 @@ template <typename T> void DBReader<T>::close(){
         delete [] compressedBufferSizes;
         delete [] dstream;
     }
+    if (packedBuffers) {
+        for (int i = 0; i < threads; i++) {
+            free(packedBuffers[i]);
+        }
+        delete [] packedBuffers;
+        delete [] packedBufferSizes;
+        packedBuffers = NULL;
+    }
 
     if(externalData == false) {
         delete[] index;
@@ -489,6 +508,30 @@ template <typename T> char* DBReader<T>::getDataCompressed(size_t id, int thrIdx
     size_t totalSize = 0;
     const void *cBuff = static_cast<void *>(data + sizeof(unsigned int));
     const char *dataStart = data + sizeof(unsigned int);
+    if (packedProfile) {
+        // the index keeps the length of the unpacked entry including its null byte
+        size_t length = getEntryLen(id) - 1;
+        if (compressedBufferSizes[thrIdx] < length + 1) {
+            compressedBufferSizes[thrIdx] = std::max(length + 1, compressedBufferSizes[thrIdx] * 2);
+            compressedBuffers[thrIdx] = (char*) realloc(compressedBuffers[thrIdx], compressedBufferSizes[thrIdx]);
+            Util::checkAllocation(compressedBuffers[thrIdx], "Can not allocate compressedBuffer");
+        }
+        // the packed columns are zstd compressed as a whole
+        size_t maxSize = PackedProfile::maxPackedSize(length);
+        if (packedBufferSizes[thrIdx] < maxSize) {
+            packedBufferSizes[thrIdx] = std::max(maxSize, packedBufferSizes[thrIdx] * 2);
+            packedBuffers[thrIdx] = (char*) realloc(packedBuffers[thrIdx], packedBufferSizes[thrIdx]);
+            Util::checkAllocation(packedBuffers[thrIdx], "Can not allocate packedBuffer");
+        }
+        size_t packedLength = ZSTD_decompressDCtx(dstream[thrIdx], packedBuffers[thrIdx], packedBufferSizes[thrIdx], cBuff, cSize);
+        if (ZSTD_isError(packedLength)) {
+            Debug(Debug::ERROR) << id << " ZSTD_decompressDCtx " << ZSTD_getErrorName(packedLength) << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+        PackedProfile::unpack(packedBuffers[thrIdx], length, compressedBuffers[thrIdx]);
+        compressedBuffers[thrIdx][length] = '\0';
+        return compressedBuffers[thrIdx];
+    }
     bool isCompressed = (dataStart[cSize] == 0) ? true : false;
     if(isCompressed){
         ZSTD_inBuffer input = {cBuff, cSize, 0};
@@ -1068,6 +1111,7 @@ void DBReader<T>::softlinkDb(const std::string &databaseName, const std::string
         { DBFiles::TAX_NAMES,     "_names.dmp"        },
         { DBFiles::TAX_NODES,     "_nodes.dmp"        },
         { DBFiles::TAX_MERGED,    "_merged.dmp"       },
+        { DBFiles::TAX_BINARY,    "_taxonomy"         },
         { DBFiles::CA3M_DATA,     "_ca3m.ffdata"      },
         { DBFiles::CA3M_INDEX,    "_ca3m.ffindex"     },
         { DBFiles::CA3M_SEQ,      "_sequence.ffdata"  },
@@ -7,6 +7,7 @@
 #include "itoa.h"
 #include "Timer.h"
 #include "Parameters.h"
+#include "PackedProfile.h"
 
 #include <cstdlib>
 #include <cstdio>
@@ -18,7 +19,7 @@
 #endif
 
 DBWriter::DBWriter(const char *dataFileName_, const char *indexFileName_, unsigned int threads, size_t mode, int dbtype)
-        : threads(threads), mode(mode), dbtype(dbtype) {
+        : threads(threads), mode(mode), dbtype(dbtype), packedProfile(false) {
     dataFileName = strdup(dataFileName_);
     indexFileName = strdup(indexFileName_);
 
@@ -39,6 +40,10 @@ DBWriter::DBWriter(const char *dataFileName_, const char *indexFileName_, unsign
         threadBuffer = new char*[threads];
         threadBufferSize = new size_t[threads];
         threadBufferOffset = new size_t[threads];
+        if (Parameters::isEqualDbtype(dbtype, Parameters::DBTYPE_HMM_PROFILE)) {
+            packedProfile = true;
+            this->dbtype |= PackedProfile::DBTYPE_FLAG;
+        }
     }
 
     starts = new size_t[threads];
@@ -233,7 +238,8 @@ void DBWriter::writeDbtypeFile(const char* path, int dbtype, bool isCompressed)
 
     std::string name = std::string(path) + ".dbtype";
     FILE* file = FileUtil::openAndDelete(name.c_str(), "wb");
-    dbtype = isCompressed ? dbtype | (1 << 31) : dbtype & ~(1 << 31);
+    // packed profile entries only exist in compressed databases
+    dbtype = isCompressed ? dbtype | (1 << 31) : dbtype & ~((1 << 31) | PackedProfile::DBTYPE_FLAG);
     size_t written = fwrite(&dbtype, sizeof(int), 1, file);
     if (written != 1) {
         Debug(Debug::ERROR) << "Can not write to data file " << name << "\n";
@@ -281,6 +287,9 @@ void DBWriter::writeStart(unsigned int thrIdx) {
     if((mode & Parameters::WRITER_COMPRESSED_MODE) != 0){
         state[thrIdx] = INIT_STATE;
         threadBufferOffset[thrIdx]=0;
+        if (packedProfile) {
+            return;
+        }
         int cLevel = 3;
         size_t const initResult = ZSTD_initCStream(cstream[thrIdx], cLevel);
         if (ZSTD_isError(initResult)) {
@@ -297,6 +306,15 @@ size_t DBWriter::writeAdd(const char* data, size_t dataSize, unsigned int thrIdx
         Debug(Debug::ERROR) << "Thread index " << thrIdx << " > maximum thread number " << threads << "\n";
         EXIT(EXIT_FAILURE);
     }
+    if (packedProfile) {
+        // a profile column can be split over several calls, the entry is packed in writeEnd
+        size_t written = addToThreadBuffer(data, sizeof(char), dataSize, thrIdx);
+        if (written != dataSize) {
+            Debug(Debug::ERROR) << "Can not write to data file " << dataFileNames[thrIdx] << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+        return 0;
+    }
     bool isCompressedDB = (mode & Parameters::WRITER_COMPRESSED_MODE) != 0;
     if(isCompressedDB && state[thrIdx] == INIT_STATE && dataSize < 60){
         state[thrIdx] = NOTCOMPRESSED;
@@ -342,7 +360,39 @@ size_t DBWriter::writeAdd(const char* data, size_t dataSize, unsigned int thrIdx
 void DBWriter::writeEnd(unsigned int key, unsigned int thrIdx, bool addNullByte, bool addIndexEntry) {
     // close stream
     bool isCompressedDB = (mode & Parameters::WRITER_COMPRESSED_MODE) != 0;
-    if(isCompressedDB) {
+    size_t profileLength = 0;
+    if (packedProfile) {
+        profileLength = threadBufferOffset[thrIdx];
+        size_t maxSize = PackedProfile::maxPackedSize(profileLength);
+        if (compressedBufferSizes[thrIdx] < maxSize) {
+            compressedBufferSizes[thrIdx] = std::max(maxSize, compressedBufferSizes[thrIdx] * 2);
+            compressedBuffers[thrIdx] = (char*) realloc(compressedBuffers[thrIdx], compressedBufferSizes[thrIdx]);
+            Util::checkAllocation(compressedBuffers[thrIdx], "Cannot allocate buffer for DBWriter");
+        }
+        size_t packedLength = PackedProfile::pack(threadBuffer[thrIdx], profileLength, compressedBuffers[thrIdx]);
+        // the profile was packed, its buffer now holds the zstd compressed packed columns
+        size_t bound = ZSTD_compressBound(packedLength);
+        if (threadBufferSize[thrIdx] < bound) {
+            threadBufferSize[thrIdx] = std::max(bound, threadBufferSize[thrIdx] * 2);
+            threadBuffer[thrIdx] = (char*) realloc(threadBuffer[thrIdx], threadBufferSize[thrIdx]);
+            Util::checkAllocation(threadBuffer[thrIdx], "Cannot allocate buffer for DBWriter");
+        }
+        size_t compressedLength = ZSTD_compressCCtx(cstream[thrIdx], threadBuffer[thrIdx], threadBufferSize[thrIdx],
+                                                    compressedBuffers[thrIdx], packedLength, 3);
+        if (ZSTD_isError(compressedLength)) {
+            Debug(Debug::ERROR) << "ZSTD_compressCCtx() error in thread " << thrIdx << ". Error "
+                                << ZSTD_getErrorName(compressedLength) << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+        unsigned int compressedLengthInt = static_cast<unsigned int>(compressedLength);
+        size_t written = fwrite(&compressedLengthInt, sizeof(unsigned int), 1, dataFiles[thrIdx]);
+        written += fwrite(threadBuffer[thrIdx], sizeof(char), compressedLength, dataFiles[thrIdx]);
+        if (written != compressedLength + 1) {
+            Debug(Debug::ERROR) << "Can not write to data file " << dataFileNames[thrIdx] << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+        offsets[thrIdx] += sizeof(unsigned int) + compressedLength;
+    } else if(isCompressedDB) {
         size_t compressedLength = 0;
         if(state[thrIdx] == COMPRESSED) {
             ZSTD_outBuffer output = {compressedBuffers[thrIdx], compressedBufferSizes[thrIdx], 0};
@@ -398,7 +448,9 @@ void DBWriter::writeEnd(unsigned int key, unsigned int thrIdx, bool addNullByte,
     if (addIndexEntry == true) {
         size_t length = offsets[thrIdx] - starts[thrIdx];
 // keep original size in index
-        if (isCompressedDB && state[thrIdx]==COMPRESSED) {
+        if (packedProfile) {
+            length = profileLength + totalWritten;
+        } else if (isCompressedDB && state[thrIdx]==COMPRESSED) {
             ZSTD_frameProgression progression = ZSTD_getFrameProgression(cstream[thrIdx]);
             length = progression.consumed + totalWritten;
         }
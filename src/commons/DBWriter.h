@@ -114,6 +114,8 @@ private:
     const unsigned int threads;
     const size_t mode;
     int dbtype;
+    // profiles written in compressed mode are stored as PackedProfile entries instead of zstd frames
+    bool packedProfile;
 
     bool closed;
 
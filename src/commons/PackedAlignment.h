@@ -0,0 +1,273 @@
+#ifndef PACKED_ALIGNMENT_H
+#define PACKED_ALIGNMENT_H
+
+// Packed binary representation of one alignment result record (DBTYPE_ALIGNMENT_RES).
+//
+// Every field is stored as a 6-bit little-endian varint where each byte has the high
+// bit set (0xC0 = more bytes follow, 0x80 = last byte). A packed record therefore never
+// contains '\0', '\t' or '\n' and is terminated by '\n' like a text record. Code that
+// walks a result entry line by line (Util::skipLine) keeps working, and a record can be
+// told apart from a text record by its first byte (text records start with a digit).
+//
+// Layout: flags dbKey score seqId(permille) eval(upper double bits) qStart qEnd qLen
+//         dbStart dbEnd dbLen [cigarRuns (len << 2 | op)*] '\n'
+
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+class PackedAlignment {
+public:
+    static const unsigned int FLAG_BACKTRACE = 1;
+    static const unsigned int FLAG_FULL_EVAL = 2;
+
+    static const unsigned int OP_MATCH = 0;
+    static const unsigned int OP_INSERTION = 1;
+    static const unsigned int OP_DELETION = 2;
+
+    struct Record {
+        unsigned int flags;
+        unsigned int dbKey;
+        int score;
+        unsigned int seqIdPermille;
+        double eval;
+        int qStartPos;
+        int qEndPos;
+        unsigned int qLen;
+        int dbStartPos;
+        int dbEndPos;
+        unsigned int dbLen;
+        // points into the record buffer, iterate with nextCigarRun
+        const char *cigar;
+        size_t cigarRuns;
+    };
+
+    static inline bool isPacked(const char *data) {
+        return (static_cast<unsigned char>(*data) & 0x80) != 0;
+    }
+
+    static inline char *writeUInt(char *out, uint64_t value) {
+        while (value >= 64) {
+            *(out++) = static_cast<char>(0xC0 | (value & 0x3F));
+            value >>= 6;
+        }
+        *(out++) = static_cast<char>(0x80 | value);
+        return out;
+    }
+
+    static inline const char *readUInt(const char *in, uint64_t &value) {
+        value = 0;
+        unsigned int shift = 0;
+        unsigned char byte;
+        do {
+            byte = static_cast<unsigned char>(*(in++));
+            value |= static_cast<uint64_t>(byte & 0x3F) << shift;
+            shift += 6;
+        } while ((byte & 0xC0) == 0xC0);
+        return in;
+    }
+
+    static inline char *writeInt(char *out, int64_t value) {
+        return writeUInt(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+
+    static inline const char *readInt(const char *in, int64_t &value) {
+        uint64_t zigzag;
+        in = readUInt(in, zigzag);
+        value = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+        return in;
+    }
+
+    // keeps the upper half of the IEEE double: full exponent range (E-values far below
+    // FLT_MIN) with 20 mantissa bits, more than the 4 significant digits of the text format
+    static inline uint32_t evalToBits(double value) {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(double));
+        if ((bits >> 32) != 0xFFFFFFFF) {
+            bits += 0x80000000;
+        }
+        return static_cast<uint32_t>(bits >> 32);
+    }
+
+    static inline double bitsToEval(uint32_t bits) {
+        return fullBitsToEval(static_cast<uint64_t>(bits) << 32);
+    }
+
+    // subnormal E-values have no precision to spare and are stored with all 64 bits
+    static inline bool needsFullEval(double value) {
+        return value != 0.0 && value < DBL_MIN && value > -DBL_MIN;
+    }
+
+    static inline uint64_t evalToFullBits(double value) {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(double));
+        return bits;
+    }
+
+    static inline double fullBitsToEval(uint64_t bits) {
+        double value;
+        memcpy(&value, &bits, sizeof(double));
+        return value;
+    }
+
+    static inline unsigned int seqIdToPermille(float seqId) {
+        // same truncation as the text format ("0.xyz")
+        return (seqId == 1.0f) ? 1000 : static_cast<unsigned int>(seqId * 1000);
+    }
+
+    // writes all fields except the CIGAR, returns the position after the written fields
+    static inline char *writeFields(char *out, const Record &rec) {
+        const bool fullEval = needsFullEval(rec.eval);
+        out = writeUInt(out, fullEval ? (rec.flags | FLAG_FULL_EVAL) : (rec.flags & ~FLAG_FULL_EVAL));
+        out = writeUInt(out, rec.dbKey);
+        out = writeInt(out, rec.score);
+        out = writeUInt(out, rec.seqIdPermille);
+        out = writeUInt(out, fullEval ? evalToFullBits(rec.eval) : evalToBits(rec.eval));
+        out = writeInt(out, rec.qStartPos);
+        out = writeInt(out, rec.qEndPos);
+        out = writeUInt(out, rec.qLen);
+        out = writeInt(out, rec.dbStartPos);
+        out = writeInt(out, rec.dbEndPos);
+        out = writeUInt(out, rec.dbLen);
+        return out;
+    }
+
+    static inline char *writeCigarRun(char *out, uint64_t length, char op) {
+        unsigned int code = (op == 'I') ? OP_INSERTION : ((op == 'D') ? OP_DELETION : OP_MATCH);
+        return writeUInt(out, (length << 2) | code);
+    }
+
+    // decodes a packed record, returns the position after the record ('\n' consumed)
+    static inline const char *readRecord(const char *in, Record &rec) {
+        uint64_t u;
+        int64_t i;
+        in = readUInt(in, u); rec.flags = static_cast<unsigned int>(u);
+        in = readUInt(in, u); rec.dbKey = static_cast<unsigned int>(u);
+        in = readInt(in, i);  rec.score = static_cast<int>(i);
+        in = readUInt(in, u); rec.seqIdPermille = static_cast<unsigned int>(u);
+        in = readUInt(in, u); rec.eval = (rec.flags & FLAG_FULL_EVAL) ? fullBitsToEval(u) : bitsToEval(static_cast<uint32_t>(u));
+        in = readInt(in, i);  rec.qStartPos = static_cast<int>(i);
+        in = readInt(in, i);  rec.qEndPos = static_cast<int>(i);
+        in = readUInt(in, u); rec.qLen = static_cast<unsigned int>(u);
+        in = readInt(in, i);  rec.dbStartPos = static_cast<int>(i);
+        in = readInt(in, i);  rec.dbEndPos = static_cast<int>(i);
+        in = readUInt(in, u); rec.dbLen = static_cast<unsigned int>(u);
+        rec.cigar = in;
+        rec.cigarRuns = 0;
+        while (*in != '\n' && *in != '\0') {
+            in = readUInt(in, u);
+            rec.cigarRuns++;
+        }
+        return (*in == '\n') ? in + 1 : in;
+    }
+
+    static inline const char *nextCigarRun(const char *in, unsigned int &length, char &op) {
+        uint64_t u;
+        in = readUInt(in, u);
+        length = static_cast<unsigned int>(u >> 2);
+        switch (u & 3) {
+            case OP_INSERTION: op = 'I'; break;
+            case OP_DELETION:  op = 'D'; break;
+            default:           op = 'M'; break;
+        }
+        return in;
+    }
+
+    // number of columns of the equivalent text record
+    static inline size_t columnCount(const char *in) {
+        uint64_t flags;
+        readUInt(in, flags);
+        return (flags & FLAG_BACKTRACE) ? 11 : 10;
+    }
+
+    static inline size_t uintLength(uint64_t value) {
+        size_t length = 1;
+        while (value >= 64) {
+            value >>= 6;
+            length++;
+        }
+        return length;
+    }
+
+    // byte offset and length of the dbKey field, used to rewrite keys without decoding the record
+    static inline size_t dbKeyOffset(const char *in) {
+        uint64_t flags;
+        return readUInt(in, flags) - in;
+    }
+
+    static inline size_t dbKeyLength(const char *in) {
+        uint64_t key;
+        const char *keyStart = in + dbKeyOffset(in);
+        return readUInt(keyStart, key) - keyStart;
+    }
+
+    static inline unsigned int readDbKey(const char *in) {
+        uint64_t u;
+        in = readUInt(in, u);
+        readUInt(in, u);
+        return static_cast<unsigned int>(u);
+    }
+
+    // numeric value of column position (0-9) of the equivalent text record
+    static inline double columnValue(const Record &rec, int position) {
+        switch (position) {
+            case 0:  return rec.dbKey;
+            case 1:  return rec.score;
+            case 2:  return rec.seqIdPermille / 1000.0;
+            case 3:  return rec.eval;
+            case 4:  return rec.qStartPos;
+            case 5:  return rec.qEndPos;
+            case 6:  return rec.qLen;
+            case 7:  return rec.dbStartPos;
+            case 8:  return rec.dbEndPos;
+            case 9:  return rec.dbLen;
+            default: return 0.0;
+        }
+    }
+
+    // renders column position of the equivalent text record into out (outSize bytes including '\0'),
+    // returns false if the column had to be truncated
+    static inline bool columnToText(const Record &rec, int position, char *out, size_t outSize) {
+        int written;
+        switch (position) {
+            case 0:  written = snprintf(out, outSize, "%u", rec.dbKey); break;
+            case 1:  written = snprintf(out, outSize, "%d", rec.score); break;
+            case 2:  written = snprintf(out, outSize, "%u.%03u", rec.seqIdPermille / 1000, rec.seqIdPermille % 1000); break;
+            case 3:  written = snprintf(out, outSize, "%.3E", rec.eval); break;
+            case 4:  written = snprintf(out, outSize, "%d", rec.qStartPos); break;
+            case 5:  written = snprintf(out, outSize, "%d", rec.qEndPos); break;
+            case 6:  written = snprintf(out, outSize, "%u", rec.qLen); break;
+            case 7:  written = snprintf(out, outSize, "%d", rec.dbStartPos); break;
+            case 8:  written = snprintf(out, outSize, "%d", rec.dbEndPos); break;
+            case 9:  written = snprintf(out, outSize, "%u", rec.dbLen); break;
+            case 10: {
+                size_t pos = 0;
+                const char *cigar = rec.cigar;
+                for (size_t j = 0; j < rec.cigarRuns; j++) {
+                    unsigned int length;
+                    char op;
+                    cigar = nextCigarRun(cigar, length, op);
+                    written = snprintf(out + pos, outSize - pos, "%u%c", length, op);
+                    if (written < 0 || static_cast<size_t>(written) >= outSize - pos) {
+                        return false;
+                    }
+                    pos += written;
+                }
+                out[pos] = '\0';
+                return true;
+            }
+            default: out[0] = '\0'; return true;
+        }
+        return written >= 0 && static_cast<size_t>(written) < outSize;
+    }
+
+    static inline bool columnToText(const char *in, int position, char *out, size_t outSize) {
+        Record rec;
+        readRecord(in, rec);
+        return columnToText(rec, position, out, outSize);
+    }
+};
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef PACKED_PROFILE_H
+#define PACKED_PROFILE_H
+
+// Sparse lossless representation of one profile entry (DBTYPE_HMM_PROFILE).
+//
+// A profile column holds 20 probability bytes followed by the query residue, the consensus
+// residue and the neff byte (Sequence::PROFILE_READIN_SIZE). Most probabilities of a column
+// are zero, which is stored as byte value 1 (ZERO_PROBABILITY). A packed column stores how
+// many of them are not zero, followed by (residue, value) pairs. Columns with many non-zero
+// probabilities are stored as a DENSE marker followed by all 20 bytes. The remaining three
+// bytes of a column are copied as they are.
+//
+// DBWriter packs profiles if it was opened in compressed mode and compresses the packed
+// columns of an entry with zstd, this is about half the size of zstd on the raw columns. Entries
+// are stored like zstd compressed entries ([unsigned int size][zstd(packed)]\0) and keep their
+// original length in the index. The database is marked with DBTYPE_FLAG, DBReader::getData
+// decompresses and unpacks them into the usual layout. Tools that copy compressed entries as
+// they are keep working.
+
+#include <cstddef>
+#include <cstring>
+
+#include "Debug.h"
+#include "Util.h"
+
+class PackedProfile {
+public:
+    // set in the dbtype of a compressed profile database with packed entries
+    static const int DBTYPE_FLAG = (1 << 30);
+
+    enum {
+        AA_SIZE = 20,       // Sequence::PROFILE_AA_SIZE
+        COLUMN_SIZE = 23,   // Sequence::PROFILE_READIN_SIZE
+        ZERO_PROBABILITY = 1,
+        MAX_SPARSE = 9,     // above this (residue, value) pairs are larger than the dense column
+        DENSE = 0xFF
+    };
+
+    static inline bool isPacked(int dbtype) {
+        return (dbtype & DBTYPE_FLAG) != 0;
+    }
+
+    // upper bound of the packed size of a profile entry of the given length
+    static inline size_t maxPackedSize(size_t length) {
+        return length + (length / COLUMN_SIZE) + 1;
+    }
+
+    static size_t pack(const char *profile, size_t length, char *out) {
+        const unsigned char *in = reinterpret_cast<const unsigned char *>(profile);
+        unsigned char *o = reinterpret_cast<unsigned char *>(out);
+        const size_t columns = length / COLUMN_SIZE;
+        for (size_t i = 0; i < columns; i++) {
+            const unsigned char *column = in + i * COLUMN_SIZE;
+            unsigned int nonZero = 0;
+            for (unsigned int aa = 0; aa < AA_SIZE; aa++) {
+                nonZero += (column[aa] != ZERO_PROBABILITY);
+            }
+            if (nonZero <= MAX_SPARSE) {
+                *(o++) = static_cast<unsigned char>(nonZero);
+                for (unsigned int aa = 0; aa < AA_SIZE; aa++) {
+                    if (column[aa] != ZERO_PROBABILITY) {
+                        *(o++) = static_cast<unsigned char>(aa);
+                        *(o++) = column[aa];
+                    }
+                }
+            } else {
+                *(o++) = DENSE;
+                memcpy(o, column, AA_SIZE);
+                o += AA_SIZE;
+            }
+            memcpy(o, column + AA_SIZE, COLUMN_SIZE - AA_SIZE);
+            o += COLUMN_SIZE - AA_SIZE;
+        }
+        // entries that are not made of whole columns keep their tail
+        const size_t tail = length - columns * COLUMN_SIZE;
+        memcpy(o, in + columns * COLUMN_SIZE, tail);
+        o += tail;
+        return o - reinterpret_cast<unsigned char *>(out);
+    }
+
+    // length is the length of the unpacked entry
+    static void unpack(const char *packed, size_t length, char *profile) {
+        const unsigned char *in = reinterpret_cast<const unsigned char *>(packed);
+        unsigned char *o = reinterpret_cast<unsigned char *>(profile);
+        const size_t columns = length / COLUMN_SIZE;
+        for (size_t i = 0; i < columns; i++) {
+            const unsigned int nonZero = *(in++);
+            if (nonZero == DENSE) {
+                memcpy(o, in, AA_SIZE);
+                in += AA_SIZE;
+            } else {
+                if (nonZero > MAX_SPARSE) {
+                    Debug(Debug::ERROR) << "Invalid packed profile column " << i << ": " << nonZero << " non-zero probabilities\n";
+                    EXIT(EXIT_FAILURE);
+                }
+                memset(o, ZERO_PROBABILITY, AA_SIZE);
+                for (unsigned int j = 0; j < nonZero; j++) {
+                    // a corrupt entry would write past the probabilities of the column
+                    if (in[0] >= AA_SIZE) {
+                        Debug(Debug::ERROR) << "Invalid packed profile column " << i << ": residue " << static_cast<unsigned int>(in[0]) << "\n";
+                        EXIT(EXIT_FAILURE);
+                    }
+                    o[in[0]] = in[1];
+                    in += 2;
+                }
+            }
+            memcpy(o + AA_SIZE, in, COLUMN_SIZE - AA_SIZE);
+            in += COLUMN_SIZE - AA_SIZE;
+            o += COLUMN_SIZE;
+        }
+        memcpy(o, in, length - columns * COLUMN_SIZE);
+    }
+};
+
+#endif
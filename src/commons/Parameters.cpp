@@ -73,6 +73,7 @@ Parameters::Parameters():
         PARAM_ALT_ALIGNMENT(PARAM_ALT_ALIGNMENT_ID,"--alt-ali", "Alternative alignments","Show up to this many alternative alignments",typeid(int), (void *) &altAlignment, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_ALIGN),
         PARAM_GAP_OPEN(PARAM_GAP_OPEN_ID,"--gap-open", "Gap open cost","Gap open cost",typeid(int), (void *) &gapOpen, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_ALIGN|MMseqsParameter::COMMAND_EXPERT),
         PARAM_GAP_EXTEND(PARAM_GAP_EXTEND_ID,"--gap-extend", "Gap extension cost","Gap extension cost",typeid(int), (void *) &gapExtend, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_ALIGN|MMseqsParameter::COMMAND_EXPERT),
+        PARAM_PACKED_ALIGNMENT(PARAM_PACKED_ALIGNMENT_ID, "--packed-aln", "Packed alignment results", "write alignment results as packed binary records (decoded by the alignment result readers, export them as text with convertalis or createtsv)", typeid(bool), (void *) &packedAlignment, "", MMseqsParameter::COMMAND_ALIGN|MMseqsParameter::COMMAND_EXPERT),
         // clustering
         PARAM_CLUSTER_MODE(PARAM_CLUSTER_MODE_ID,"--cluster-mode", "Cluster mode", "0: Setcover, 1: connected component, 2: Greedy clustering by sequence length  3: Greedy clustering by sequence length (low mem)",typeid(int), (void *) &clusteringMode, "[0-3]{1}$", MMseqsParameter::COMMAND_CLUST),
         PARAM_CLUSTER_STEPS(PARAM_CLUSTER_STEPS_ID,"--cluster-steps", "Cascaded clustering steps", "cascaded clustering steps from 1 to -s",typeid(int), (void *) &clusterSteps, "^[1-9]{1}$", MMseqsParameter::COMMAND_CLUST|MMseqsParameter::COMMAND_EXPERT),
@@ -138,6 +139,7 @@ Parameters::Parameters():
         PARAM_HASH_SHIFT(PARAM_HASH_SHIFT_ID, "--hash-shift", "Shift hash", "Shift k-mer hash", typeid(int), (void*) &hashShift, "^[1-9]{1}[0-9]*$", MMseqsParameter::COMMAND_CLUSTLINEAR|MMseqsParameter::COMMAND_EXPERT),
         PARAM_PICK_N_SIMILAR(PARAM_HASH_SHIFT_ID, "--pick-n-sim-kmer", "Add N similar to search", "adds N similar to search", typeid(int), (void*) &pickNbest, "^[1-9]{1}[0-9]*$", MMseqsParameter::COMMAND_CLUSTLINEAR|MMseqsParameter::COMMAND_EXPERT),
         PARAM_ADJUST_KMER_LEN(PARAM_ADJUST_KMER_LEN_ID, "--adjust-kmer-len", "Adjust k-mer length", "adjust k-mer length based on specificity (only for nucleotides)", typeid(bool), (void*) &adjustKmerLength, "", MMseqsParameter::COMMAND_CLUSTLINEAR|MMseqsParameter::COMMAND_EXPERT),
+        PARAM_KMER_TABLE(PARAM_KMER_TABLE_ID, "--kmer-table", "K-mer table", "File to keep the sorted k-mers in. If it exists, only sequences that are new or changed are k-merized and merged into it", typeid(std::string), (void*) &kmerTable, "", MMseqsParameter::COMMAND_CLUSTLINEAR|MMseqsParameter::COMMAND_EXPERT),
 
         // workflow
         PARAM_RUNNER(PARAM_RUNNER_ID, "--mpi-runner", "MPI runner","Use MPI on compute grid with this MPI command (e.g. \"mpirun -np 42\")",typeid(std::string),(void *) &runner, "", MMseqsParameter::COMMAND_COMMON|MMseqsParameter::COMMAND_EXPERT),
@@ -302,6 +304,7 @@ Parameters::Parameters():
     align.push_back(&PARAM_SCORE_BIAS);
     align.push_back(&PARAM_GAP_OPEN);
     align.push_back(&PARAM_GAP_EXTEND);
+    align.push_back(&PARAM_PACKED_ALIGNMENT);
     align.push_back(&PARAM_THREADS);
     align.push_back(&PARAM_COMPRESSED);
     align.push_back(&PARAM_V);
@@ -352,6 +355,7 @@ Parameters::Parameters():
     clust.push_back(&PARAM_CLUSTER_MODE);
     clust.push_back(&PARAM_MAXITERATIONS);
     clust.push_back(&PARAM_SIMILARITYSCORE);
+    clust.push_back(&PARAM_SPLIT_MEMORY_LIMIT);
     clust.push_back(&PARAM_THREADS);
     clust.push_back(&PARAM_COMPRESSED);
     clust.push_back(&PARAM_V);
@@ -797,6 +801,7 @@ Parameters::Parameters():
     kmermatcher.push_back(&PARAM_SPLIT_MEMORY_LIMIT);
     kmermatcher.push_back(&PARAM_INCLUDE_ONLY_EXTENDABLE);
     kmermatcher.push_back(&PARAM_IGNORE_MULTI_KMER);
+    kmermatcher.push_back(&PARAM_KMER_TABLE);
     kmermatcher.push_back(&PARAM_THREADS);
     kmermatcher.push_back(&PARAM_COMPRESSED);
     kmermatcher.push_back(&PARAM_V);
@@ -1789,6 +1794,7 @@ void Parameters::setDefaults() {
     gapExtend = 1;
     addBacktrace = false;
     realign = false;
+    packedAlignment = false;
     clusteringMode = SET_COVER;
     cascaded = true;
     clusterReassignment = 0;
@@ -1969,6 +1975,7 @@ void Parameters::setDefaults() {
     hashShift = 5;
     pickNbest = 1;
     adjustKmerLength = false;
+    kmerTable = "";
     // result2stats
     stat = "";
 
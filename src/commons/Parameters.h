@@ -354,6 +354,7 @@ public:
     bool   realign;                      // realign hit with more conservative score
     int    gapOpen;                      // gap open
     int    gapExtend;                    // gap extend
+    bool   packedAlignment;              // write alignment results as packed binary records
 
     // workflow
     std::string runner;
@@ -457,6 +458,7 @@ public:
     int hashShift;
     int pickNbest;
     int adjustKmerLength;
+    std::string kmerTable;
 
     // indexdb
     int checkCompatible;
@@ -654,6 +656,7 @@ public:
     PARAMETER(PARAM_ALT_ALIGNMENT)
     PARAMETER(PARAM_GAP_OPEN)
     PARAMETER(PARAM_GAP_EXTEND)
+    PARAMETER(PARAM_PACKED_ALIGNMENT)
     std::vector<MMseqsParameter*> align;
 
     // clustering
@@ -734,6 +737,7 @@ public:
     PARAMETER(PARAM_HASH_SHIFT)
     PARAMETER(PARAM_PICK_N_SIMILAR)
     PARAMETER(PARAM_ADJUST_KMER_LEN)
+    PARAMETER(PARAM_KMER_TABLE)
 
     // workflow
     PARAMETER(PARAM_RUNNER)
@@ -991,7 +995,7 @@ public:
     }
 
     static const char* getDbTypeName(int dbtype) {
-        switch (dbtype & 0x7FFFFFFF) {
+        switch (dbtype & 0x3FFFFFFF) {
             case DBTYPE_AMINO_ACIDS: return "Aminoacid";
             case DBTYPE_NUCLEOTIDES: return "Nucleotide";
             case DBTYPE_HMM_PROFILE: return "Profile";
@@ -76,6 +76,7 @@ ProfileStates::~ProfileStates()
     }
     delete [] discProfScores;
     delete [] profiles;
+    free(transposedProfiles);
     delete [] background;
     free(prior);
 }
@@ -194,7 +195,10 @@ int ProfileStates::read(std::string libraryData) {
 
     profiles = new float*[alphSize];
     normalizedProfiles = new float*[alphSize];
-    prior = (float*) mem_align(ALIGN_FLOAT, alphSize * sizeof(float));
+    stateStride = MathUtil::ceilIntDivision(static_cast<unsigned int>(alphSize), static_cast<unsigned int>(VECSIZE_FLOAT)) * VECSIZE_FLOAT;
+    // padded since the state loops in discretize run over whole SIMD vectors
+    prior = (float*) mem_align(ALIGN_FLOAT, stateStride * sizeof(float));
+    memset(prior, 0, stateStride * sizeof(float));
 
     // Read profiles
     size_t k;
@@ -225,6 +229,14 @@ int ProfileStates::read(std::string libraryData) {
     }
 
 
+    transposedProfiles = (float*) mem_align(ALIGN_FLOAT, Sequence::PROFILE_AA_SIZE * stateStride * sizeof(float));
+    memset(transposedProfiles, 0, Sequence::PROFILE_AA_SIZE * stateStride * sizeof(float));
+    for (k = 0; k < alphSize; ++k) {
+        for (size_t a = 0; a < Sequence::PROFILE_AA_SIZE; a++) {
+            transposedProfiles[a * stateStride + k] = profiles[k][a];
+        }
+    }
+
     for (k = 0; k < alphSize; ++k)
     {
         prior[k] /= zPrior;
@@ -305,93 +317,81 @@ float ProfileStates::getScoreNormalization() {
     return exp;
 }
 
+void ProfileStates::scoreStates(const float *profileCol, float *stateScores) {
+    // same operations as score(profileCol, profiles[k]) for eight states at a time
+    for (size_t k = 0; k < stateStride; k += VECSIZE_FLOAT) {
+        simd_float sum = simdf32_setzero(0);
+        for (size_t a = 0; a < Sequence::PROFILE_AA_SIZE; a++) {
+            simd_float state = simdf32_load(&transposedProfiles[a * stateStride + k]);
+            simd_float product = simdf32_mul(state, simdf32_set(profileCol[a]));
+            sum = simdf32_add(sum, simdf32_div(product, simdf32_set(background[a])));
+        }
+        simdf32_store(&stateScores[k], sum);
+    }
+    for (size_t k = 0; k < alphSize; k++) {
+        stateScores[k] = MathUtil::flog2(stateScores[k]);
+    }
+}
+
 void ProfileStates::discretize(const float* sequence, size_t length, std::string &result)
 {
-    
+    // S(profile, c_k) of COLUMN_BLOCK columns, the padding of each row stays zero
+    float* repScore = (float*)mem_align(ALIGN_FLOAT, COLUMN_BLOCK * stateStride * sizeof(float));
+    memset(repScore, 0, COLUMN_BLOCK * stateStride * sizeof(float));
     char closestState = 0;
-    float curDiffScore;
-    float* profileCol;
-    float* repScore = (float*)mem_align(ALIGN_FLOAT, 256*sizeof(float));
-    memset(repScore, 0, sizeof(float)*256);
-    for (size_t i = 0 ; i<length ; i++)
+    for (size_t start = 0; start < length; start += COLUMN_BLOCK)
     {
-        float minDiffScore = FLT_MAX;
-        profileCol = (float*)
-                &sequence[i * Sequence::PROFILE_AA_SIZE];
-
-        float maxScore = -FLT_MIN;
-//        size_t maxScoreIndex = 0;
-	
-	/*for (size_t a = 0 ; a < 20 ; a++)
-        {
-                std::cout<<profileCol[a]<<"\t";
-        }*/
-
-//        for(size_t pos = 0; pos < 20; pos++){
-//            printf("%.3f\t", profileCol[pos]);
-//        }
-//        std::cout << std::endl;
-        // S(profile, c_k)
-        for (size_t k=0;k<alphSize;k++)
-        {
-            repScore[k] = score(profileCol, profiles[k]);
-
-//            for(size_t pos = 0; pos < 20; pos++){
-//                printf("%.3f\t", profiles[k][pos]);
-//            }
-//            std::cout << repScore[k] << std::endl;
-            if (repScore[k]>maxScore)
-            {
-                maxScore = repScore[k];
-//                maxScoreIndex = k;
-            }
+        const size_t columns = std::min(static_cast<size_t>(COLUMN_BLOCK), length - start);
+        for (size_t c = 0; c < columns; c++) {
+            scoreStates(&sequence[(start + c) * Sequence::PROFILE_AA_SIZE], repScore + c * stateStride);
         }
 
         // Find the k that minimizes sum_l prior_l*(S(profile, c_l) - S(c_k,c_l))^2
+        // the columns of a block share the loads of prior and discProfScores
+        float minDiffScore[COLUMN_BLOCK];
+        int minState[COLUMN_BLOCK];
+        for (size_t c = 0; c < COLUMN_BLOCK; c++) {
+            minDiffScore[c] = FLT_MAX;
+            minState[c] = -1;
+        }
         for (size_t k=0;k<alphSize;k++)
         {
-            curDiffScore = 0.0;
-            simd_float curDiffScoreSimd=simdf32_setzero(0);
-            unsigned int ceilAlphSize = MathUtil::ceilIntDivision(static_cast<unsigned int >(alphSize), static_cast<unsigned int >(VECSIZE_FLOAT));
-//            for (size_t l=0;l<alphSize;l++)
-//            {
-//                float diff = repScore[l] - discProfScores[k][l];
-//                tmp += diff*diff;
-//            }
-
-
-            for (size_t l=0;l<ceilAlphSize*VECSIZE_FLOAT;l+=VECSIZE_FLOAT)
+            simd_float curDiffScoreSimd[COLUMN_BLOCK];
+            for (size_t c = 0; c < COLUMN_BLOCK; c++) {
+                curDiffScoreSimd[c] = simdf32_setzero(0);
+            }
+            for (size_t l=0;l<stateStride;l+=VECSIZE_FLOAT)
             {
                 simd_float priorLSimd = simdf32_load(&prior[l]);
-                simd_float repScoreLSimd = simdf32_load(&repScore[l]);
                 simd_float discProfScoresLSimd = simdf32_load(&discProfScores[k][l]);
-                simd_float diff = simdf32_sub(repScoreLSimd, discProfScoresLSimd);
-                simd_float diffSquared = simdf32_mul(diff, diff);
-                simd_float postDiff = simdf32_mul(priorLSimd, diffSquared);
-                curDiffScoreSimd = simdf32_add(curDiffScoreSimd, postDiff);
+                for (size_t c = 0; c < COLUMN_BLOCK; c++) {
+                    simd_float repScoreLSimd = simdf32_load(&repScore[c * stateStride + l]);
+                    simd_float diff = simdf32_sub(repScoreLSimd, discProfScoresLSimd);
+                    simd_float diffSquared = simdf32_mul(diff, diff);
+                    simd_float postDiff = simdf32_mul(priorLSimd, diffSquared);
+                    curDiffScoreSimd[c] = simdf32_add(curDiffScoreSimd[c], postDiff);
+                }
             }
-            float * curDiffScoreSimdFlt = (float*) &curDiffScoreSimd;
-            //std::cout<<k<<":"<<*curDiffScoreSimdFlt<<"\n";
-            /*if (alphSize==255)
-		{
-
-		    for (size_t y = 0; y<21;y++)
-			{
-			std::cout<<k<<" "<<prior[y]<<" "<<repScore[y]<<" "<<discProfScores[k][y]<<" "<<std::endl;
-			}
-		}*/
-            for (size_t l=0;l<VECSIZE_FLOAT;l++){
-                curDiffScore+= curDiffScoreSimdFlt[l];
+            for (size_t c = 0; c < columns; c++) {
+                float * curDiffScoreSimdFlt = (float*) &curDiffScoreSimd[c];
+                float curDiffScore = 0.0;
+                for (size_t l=0;l<VECSIZE_FLOAT;l++){
+                    curDiffScore+= curDiffScoreSimdFlt[l];
+                }
+                if (curDiffScore < minDiffScore[c])
+                {
+                    minDiffScore[c] = curDiffScore;
+                    minState[c] = k;
+                }
             }
-
-            if (curDiffScore < minDiffScore)
-            {
-                minDiffScore = curDiffScore;
-                closestState = k;
+        }
+        for (size_t c = 0; c < columns; c++) {
+            // a column without any finite score keeps the state of the previous column
+            if (minState[c] != -1) {
+                closestState = minState[c];
             }
+            result.push_back(closestState);
         }
-	//std::cout<<"Pos "<<i<<", closest state: "<<(int)closestState<<", max score index: "<<maxScoreIndex<<"\n";
-        result.push_back(closestState);//(maxScoreIndex);//
     }
     free(repScore);
 }
@@ -400,22 +400,17 @@ void ProfileStates::discretize(const float* sequence, size_t length, std::string
 
 void ProfileStates::discretizeCs219(const float* sequence, size_t length, std::string &result)
 {
-//    float curDiffScore;
-    float* profileCol;
-    float* repScore = (float*)mem_align(ALIGN_FLOAT, 256*sizeof(float));
-    memset(repScore, 0, sizeof(float)*256);
+    float* repScore = (float*)mem_align(ALIGN_FLOAT, stateStride * sizeof(float));
     for (size_t i = 0 ; i<length ; i++)
     {
-//        float minDiffScore = FLT_MAX;
-        profileCol = (float*)
-                &sequence[i * Sequence::PROFILE_AA_SIZE];
+        scoreStates(&sequence[i * Sequence::PROFILE_AA_SIZE], repScore);
         // Calculate posterior probabilities given sequence window around 'i'
         double max = -FLT_MAX;
         size_t k_max = 0;
         for (size_t k = 0; k < alphSize; ++k) {
-            repScore[k] = prior[k] * score(profiles[k], profileCol);
-            k_max = (repScore[k] > max ) ? k : k_max;
-            max   = (repScore[k] > max ) ? repScore[k] : max;
+            const float stateScore = prior[k] * repScore[k];
+            k_max = (stateScore > max ) ? k : k_max;
+            max   = (stateScore > max ) ? stateScore : max;
         }
         result.push_back(k_max);
     }
@@ -34,6 +34,8 @@ struct Color {
 
 class ProfileStates {
 public:
+    // number of profile columns discretize compares against the state scores in one pass
+    enum { COLUMN_BLOCK = 4 };
 
     ProfileStates(int alphSize, double * pBack);
     ~ProfileStates();
@@ -119,8 +121,14 @@ private:
     std::vector<std::string> names;
     float* background;
     float score(float* profileA, float* profileB);
+    // log-odds scores of one profile column against all states, stateScores needs stateStride entries
+    void scoreStates(const float *profileCol, float *stateScores);
     size_t alphSize;
+    // alphSize rounded up to the SIMD width
+    size_t stateStride;
     float ** profiles;
+    // transposedProfiles[aa * stateStride + k] = profiles[k][aa], used to score a column against all states at once
+    float * transposedProfiles;
     float ** normalizedProfiles;
     float ** discProfScores;
 };
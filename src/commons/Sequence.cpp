@@ -162,7 +162,7 @@ std::pair<const char *, unsigned int> Sequence::getSpacedPattern(bool spaced, un
     if (pair.second > 0) {
         memcpy(pattern, pair.first, pair.second * sizeof(char));
     }
-    return std::make_pair<const char *, unsigned int>(pattern, static_cast<unsigned int>(pair.second));
+    return std::make_pair<const char *, unsigned int>((const char *)pattern, static_cast<unsigned int>(pair.second));
 #undef CASE
 }
 
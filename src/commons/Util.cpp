@@ -7,6 +7,7 @@
 #include "Parameters.h"
 #include <sys/resource.h>
 #include "itoa.h"
+#include "PackedAlignment.h"
 
 #include <unistd.h>
 #ifdef __APPLE__
@@ -266,6 +267,29 @@ void Util::parseByColumnNumber(char *data, char *key, int position) {
     key[keySize] = '\0';
 }
 
+void Util::parseByColumnNumber(char *data, char *key, size_t keySize, int position, int dbtype) {
+    bool fits;
+    if (Parameters::isEqualDbtype(dbtype, Parameters::DBTYPE_ALIGNMENT_RES) && PackedAlignment::isPacked(data)) {
+        fits = PackedAlignment::columnToText(data, position, key, keySize);
+    } else {
+        char *startPosOfKey = data;
+        for (int i = 0; i < position; ++i) {
+            startPosOfKey = startPosOfKey + Util::skipNoneWhitespace(startPosOfKey);
+            startPosOfKey = startPosOfKey + Util::skipWhitespace(startPosOfKey);
+        }
+        const size_t columnSize = Util::skipNoneWhitespace(startPosOfKey);
+        fits = columnSize < keySize;
+        if (fits) {
+            memcpy(key, startPosOfKey, columnSize);
+            key[columnSize] = '\0';
+        }
+    }
+    if (fits == false) {
+        Debug(Debug::ERROR) << "Column " << (position + 1) << " is longer than " << (keySize - 1) << " characters\n";
+        EXIT(EXIT_FAILURE);
+    }
+}
+
 void Util::parseKey(const char *data, char *key) {
     const char *startPosOfKey = data;
     const char *endPosOfId = data + Util::skipNoneWhitespace(data);
@@ -274,6 +298,14 @@ void Util::parseKey(const char *data, char *key) {
     key[keySize] = '\0';
 }
 
+void Util::parseKey(const char *data, char *key, int dbtype) {
+    if (Parameters::isEqualDbtype(dbtype, Parameters::DBTYPE_ALIGNMENT_RES) && PackedAlignment::isPacked(data)) {
+        Itoa::u32toa_sse2(PackedAlignment::readDbKey(data), key);
+        return;
+    }
+    parseKey(data, key);
+}
+
 std::vector<std::string> Util::split(const std::string &str, const std::string &sep) {
     std::vector<std::string> arr;
 
@@ -250,8 +250,14 @@ public:
 
     static void parseKey(const char *data, char * key);
 
+    // packed alignment records (see PackedAlignment.h) are only decoded if dbtype is an alignment result
+    static void parseKey(const char *data, char * key, int dbtype);
+
     static void parseByColumnNumber(char *data, char * key, int position);
 
+    // key holds keySize bytes, a longer column is an error
+    static void parseByColumnNumber(char *data, char * key, size_t keySize, int position, int dbtype);
+
     static std::string base_name(std::string const & path, std::string const & delims)
     {
         return path.substr(path.find_last_of(delims) + 1);
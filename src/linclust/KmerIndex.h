@@ -17,6 +17,8 @@ private:
     const size_t indexGridResolution = 32768;
     size_t indexGridSize;
     size_t * entryOffsets;
+    // number of stored offsets, the last cell ends at entryCount
+    size_t entryOffsetsCount;
     size_t prevKmerStartRange;
     long long iteratorPos;
     size_t entryOffsetPos;
@@ -62,6 +64,7 @@ public:
         this->entryCount = 0;
         this->indexGridSize = MathUtil::ceilIntDivision( MathUtil::ipow<size_t>(alphabetSize, kmerSize),indexGridResolution);
         this->entryOffsets = new size_t[indexGridSize+1];
+        this->entryOffsetsCount = indexGridSize+1;
         memset(entryOffsets, 0, sizeof(size_t)*(indexGridSize + 1));
         this->prevKmerStartRange = 0;
         this->writingPosition = 0;
@@ -80,24 +83,39 @@ public:
     template <int TYPE>
     KmerEntry getNextEntry(){
         iteratorPos++;
-        while(iteratorPos >= static_cast<long long>(entryOffsets[entryOffsetPos+1])){
+        while(iteratorPos >= static_cast<long long>(getCellEnd(entryOffsetPos))){
             entryOffsetPos++;
         }
-        size_t kmer;
+        return getEntry<TYPE>(entryOffsetPos, iteratorPos);
+    }
+
+    // entries [getCellStart(i), getCellEnd(i)) hold the k-mers of grid cell i sorted by getKmerOffset
+    size_t getCellStart(size_t gridPosition){
+        return (gridPosition < entryOffsetsCount) ? entryOffsets[gridPosition] : entryCount;
+    }
+
+    size_t getCellEnd(size_t gridPosition){
+        return (gridPosition + 1 < entryOffsetsCount) ? entryOffsets[gridPosition + 1] : entryCount;
+    }
+
+    template <int TYPE>
+    unsigned short getKmerOffset(size_t entry){
+        if(TYPE==Parameters::DBTYPE_NUCLEOTIDES){
+            return BIT_CLEAR(entries[entry].kmerOffset, 15);
+        }
+        return entries[entry].kmerOffset;
+    }
 
+    template <int TYPE>
+    KmerEntry getEntry(size_t gridPosition, size_t entry){
+        size_t kmer = gridPosition*indexGridResolution + getKmerOffset<TYPE>(entry);
         if(TYPE==Parameters::DBTYPE_NUCLEOTIDES){
-            bool isReverse = BIT_CHECK(entries[iteratorPos].kmerOffset, 15);
-            kmer = BIT_CLEAR(entries[iteratorPos].kmerOffset, 15);
-            kmer = entryOffsetPos*indexGridResolution + kmer;
+            bool isReverse = BIT_CHECK(entries[entry].kmerOffset, 15);
             kmer = (isReverse) ? kmer :  BIT_SET(kmer, 63);
-        }else{
-//            std::cout << entryOffsetPos <<  "\t" << iteratorPos << "\t" << entryOffsets[entryOffsetPos] <<  "\t" << entries[iteratorPos].kmerOffset << std::endl;
-            kmer= entryOffsetPos*indexGridResolution + static_cast<size_t >(entries[iteratorPos].kmerOffset);
         }
-        return KmerEntry(kmer, entries[iteratorPos].id, entries[iteratorPos].pos, entries[iteratorPos].seqLen);
+        return KmerEntry(kmer, entries[entry].id, entries[entry].pos, entries[entry].seqLen);
     }
 
-
     size_t getGridPosition(size_t kmer){
         return kmer / indexGridResolution;
     }
@@ -149,7 +167,7 @@ public:
         }
         entries[writingPosition].id = id;
         entries[writingPosition].kmerOffset = kmer - kmerStartRange;
-        entries[writingPosition].kmerOffset = (isReverse) ? BIT_SET(15, entries[writingPosition].kmerOffset) :  entries[writingPosition].kmerOffset;
+        entries[writingPosition].kmerOffset = (isReverse) ? BIT_SET(entries[writingPosition].kmerOffset, 15) :  entries[writingPosition].kmerOffset;
         entries[writingPosition].pos = pos;
         entries[writingPosition].seqLen = seqLen;
         writingPosition++;
@@ -175,7 +193,7 @@ public:
     }
 
     KmerIndex(int alphabetSize, int kmerSize, char *entriesData, char *entriesOffetData,
-              size_t entryCount, size_t gridResolution) {
+              size_t entryCount, size_t gridResolution, size_t entryOffsetsCount) {
         this->alphabetSize = alphabetSize;
         this->kmerSize = kmerSize;
         this->isMmaped = true;
@@ -183,11 +201,7 @@ public:
         this->entryCount = entryCount;
         this->indexGridSize = MathUtil::ceilIntDivision( MathUtil::ipow<size_t>(alphabetSize, kmerSize), gridResolution );
         this->entryOffsets = (size_t *) entriesOffetData;
-#if HAVE_POSIX_MADVISE
-        if (posix_madvise (entriesData, entryCount* sizeof(KmerEntryRelative), POSIX_MADV_SEQUENTIAL) != 0){
-            Debug(Debug::ERROR) << "KmerIndex posix_madvise returned an error\n";
-        }
-#endif
+        this->entryOffsetsCount = entryOffsetsCount;
 
         this->prevKmerStartRange = 0;
         this->iteratorPos = -1;
@@ -0,0 +1,283 @@
+#ifndef MMSEQS_KMERTABLE_H
+#define MMSEQS_KMERTABLE_H
+
+// Persisted k-mer table of kmermatcher (--kmer-table).
+//
+// The table holds the selected k-mers of all sequences in the order they have before the
+// grouping step of kmermatcher (k-mer, length, id, position) and the key, length and content
+// hash of every sequence they were extracted from. A later run only k-merizes sequences that
+// are missing from the table (or whose length or content changed), drops k-mers of removed
+// sequences and merges both sorted lists. This gives the same list a run from scratch would sort.
+//
+// The grouped k-mers of every split (rep. sequence, member id and diagonal, sorted by rep.
+// sequence) are stored as well. A new, longer sequence can become the representative of an
+// existing group, so a run with the same grouping parameters and number of splits regroups
+// only the groups that contain the old or new representative of a group that gained or lost
+// k-mers and takes the entries of all other representatives from the table.
+//
+// Layout: Header, sequenceCount x SequenceEntry (sorted by key), kmerCount x KmerPosition,
+// groupSplits x size_t (grouped k-mers per split), grouped KmerPositions of all splits
+
+#include "kmermatcher.h"
+#include "Debug.h"
+#include "FileUtil.h"
+#include "Parameters.h"
+#include "Util.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <queue>
+#include <string>
+#include <vector>
+
+class KmerTable {
+public:
+    static const unsigned int VERSION = 3;
+
+    struct Header {
+        char magic[8];
+        unsigned int version;
+        unsigned int recordSize;
+        unsigned int seqLenSize;
+        unsigned int compact;
+        int dbtype;
+        int kmerSize;
+        int alphabetSize;
+        int kmersPerSequence;
+        float kmersPerSequenceScale;
+        int hashShift;
+        int maskMode;
+        int maskLowerCaseMode;
+        int ignoreMultiKmer;
+        int adjustKmerLength;
+        int maxSeqLen;
+        size_t matrixHash;
+        // everything above has to match for a table to be reused
+        size_t sequenceCount;
+        size_t kmerCount;
+        // grouped k-mers are only reused with the same grouping parameters and number of splits
+        float covThr;
+        int covMode;
+        int includeOnlyExtendable;
+        size_t groupSplits;
+    };
+
+    struct SequenceEntry {
+        unsigned int key;
+        unsigned int length;
+        // Util::hash of the sequence data, an updated sequence can keep its key and length
+        size_t hash;
+    };
+
+    // header describing the k-mers the current parameters would extract
+    template <typename T, bool Compact>
+    static Header createHeader(Parameters &par, int dbtype) {
+        Header header;
+        // zeroed padding keeps the compatibility check a plain memcmp
+        memset(&header, 0, sizeof(Header));
+        memcpy(header.magic, "MMSKTAB", 8);
+        header.version = VERSION;
+        header.recordSize = sizeof(KmerPosition<T, Compact>);
+        header.seqLenSize = sizeof(T);
+        header.compact = Compact;
+        header.dbtype = Parameters::isEqualDbtype(dbtype, Parameters::DBTYPE_NUCLEOTIDES) ? Parameters::DBTYPE_NUCLEOTIDES : Parameters::DBTYPE_AMINO_ACIDS;
+        header.kmerSize = par.kmerSize;
+        header.alphabetSize = par.alphabetSize;
+        header.kmersPerSequence = par.kmersPerSequence;
+        header.kmersPerSequenceScale = par.kmersPerSequenceScale;
+        header.hashShift = par.hashShift;
+        header.maskMode = par.maskMode;
+        header.maskLowerCaseMode = par.maskLowerCaseMode;
+        header.ignoreMultiKmer = par.ignoreMultiKmer;
+        header.adjustKmerLength = par.adjustKmerLength;
+        header.maxSeqLen = par.maxSeqLen;
+        const char *matrix = (header.dbtype == Parameters::DBTYPE_NUCLEOTIDES) ? par.scoringMatrixFile.nucleotides : par.scoringMatrixFile.aminoacids;
+        header.matrixHash = Util::hash(matrix, strlen(matrix));
+        header.covThr = par.covThr;
+        header.covMode = par.covMode;
+        header.includeOnlyExtendable = par.includeOnlyExtendable;
+        return header;
+    }
+
+    // reads the header and sequence list of a table that was created with the expected header,
+    // returns false (and leaves sequences empty) if there is no usable table
+    static bool readSequences(const std::string &file, const Header &expected, std::vector<SequenceEntry> &sequences, Header &header) {
+        sequences.clear();
+        if (FileUtil::fileExists(file.c_str()) == false) {
+            return false;
+        }
+        FILE *handle = FileUtil::openFileOrDie(file.c_str(), "rb", true);
+        bool usable = (fread(&header, sizeof(Header), 1, handle) == 1)
+                      && memcmp(&header, &expected, offsetof(Header, sequenceCount)) == 0;
+        if (usable == false) {
+            fclose(handle);
+            Debug(Debug::WARNING) << "K-mer table " << file << " was created with different parameters and is rebuilt\n";
+            return false;
+        }
+        sequences.resize(header.sequenceCount);
+        if (fread(sequences.data(), sizeof(SequenceEntry), header.sequenceCount, handle) != header.sequenceCount) {
+            Debug(Debug::ERROR) << "Could not read k-mer table " << file << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+        fclose(handle);
+        return true;
+    }
+
+    // streams all k-mers of a table to func in their sorted order
+    template <typename T, bool Compact, typename Function>
+    static void forEachKmer(const std::string &file, Function func) {
+        FILE *handle = FileUtil::openFileOrDie(file.c_str(), "rb", true);
+        Header header;
+        if (fread(&header, sizeof(Header), 1, handle) != 1
+            || fseek(handle, header.sequenceCount * sizeof(SequenceEntry), SEEK_CUR) != 0) {
+            Debug(Debug::ERROR) << "Could not read k-mer table " << file << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+        std::vector<KmerPosition<T, Compact> > buffer(CHUNK_SIZE);
+        size_t remaining = header.kmerCount;
+        while (remaining > 0) {
+            size_t count = (remaining < CHUNK_SIZE) ? remaining : CHUNK_SIZE;
+            if (fread(buffer.data(), sizeof(KmerPosition<T, Compact>), count, handle) != count) {
+                Debug(Debug::ERROR) << "Could not read k-mer table " << file << "\n";
+                EXIT(EXIT_FAILURE);
+            }
+            for (size_t i = 0; i < count; i++) {
+                func(buffer[i]);
+            }
+            remaining -= count;
+        }
+        fclose(handle);
+    }
+
+    // streams the grouped k-mers of split to func in their sorted order, returns their number
+    template <typename T, bool Compact, typename Function>
+    static size_t forEachGroupedKmer(const std::string &file, size_t split, Function func) {
+        FILE *handle = FileUtil::openFileOrDie(file.c_str(), "rb", true);
+        Header header;
+        std::vector<size_t> counts;
+        bool valid = (fread(&header, sizeof(Header), 1, handle) == 1) && split < header.groupSplits
+                     && fseek(handle, header.sequenceCount * sizeof(SequenceEntry) + header.kmerCount * sizeof(KmerPosition<T, Compact>), SEEK_CUR) == 0;
+        if (valid) {
+            counts.resize(header.groupSplits);
+            valid = fread(counts.data(), sizeof(size_t), counts.size(), handle) == counts.size();
+            size_t skip = 0;
+            for (size_t i = 0; valid && i < split; i++) {
+                skip += counts[i];
+            }
+            valid = valid && fseek(handle, skip * sizeof(KmerPosition<T, Compact>), SEEK_CUR) == 0;
+        }
+        if (valid == false) {
+            Debug(Debug::ERROR) << "Could not read grouped k-mers of k-mer table " << file << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+        std::vector<KmerPosition<T, Compact> > buffer(CHUNK_SIZE);
+        size_t remaining = counts[split];
+        while (remaining > 0) {
+            size_t count = (remaining < CHUNK_SIZE) ? remaining : CHUNK_SIZE;
+            if (fread(buffer.data(), sizeof(KmerPosition<T, Compact>), count, handle) != count) {
+                Debug(Debug::ERROR) << "Could not read grouped k-mers of k-mer table " << file << "\n";
+                EXIT(EXIT_FAILURE);
+            }
+            for (size_t i = 0; i < count; i++) {
+                func(buffer[i]);
+            }
+            remaining -= count;
+        }
+        fclose(handle);
+        return counts[split];
+    }
+
+    // writes a table from sorted parts with disjoint k-mers (one per split) and the
+    // grouped k-mers of each split (groupedParts, in split order) into file
+    template <typename T, bool Compact, typename Comparator>
+    static void write(const std::string &file, Header header, const std::vector<SequenceEntry> &sequences,
+                      const std::vector<std::string> &parts, const std::vector<std::string> &groupedParts, Comparator comp) {
+        typedef KmerPosition<T, Compact> Record;
+        std::vector<FILE *> handles;
+        std::vector<std::vector<Record> > buffers(parts.size());
+        std::vector<size_t> bufferPos(parts.size(), 0);
+        std::vector<size_t> bufferSize(parts.size(), 0);
+        header.kmerCount = 0;
+        for (size_t i = 0; i < parts.size(); i++) {
+            header.kmerCount += FileUtil::getFileSize(parts[i]) / sizeof(Record);
+            handles.push_back(FileUtil::openFileOrDie(parts[i].c_str(), "rb", true));
+            buffers[i].resize(CHUNK_SIZE);
+        }
+        header.sequenceCount = sequences.size();
+        header.groupSplits = groupedParts.size();
+
+        // a table is only replaced once it is complete
+        std::string tmpFile = file + ".tmp";
+        FILE *out = FileUtil::openFileOrDie(tmpFile.c_str(), "wb", false);
+        fwrite(&header, sizeof(Header), 1, out);
+        fwrite(sequences.data(), sizeof(SequenceEntry), sequences.size(), out);
+
+        // the smallest head of all parts is written next
+        struct QueueCompare {
+            const std::vector<std::vector<Record> > *buffers;
+            const std::vector<size_t> *bufferPos;
+            Comparator comp;
+            bool operator()(size_t a, size_t b) const {
+                return comp((*buffers)[b][(*bufferPos)[b]], (*buffers)[a][(*bufferPos)[a]]);
+            }
+        };
+        QueueCompare queueCompare = { &buffers, &bufferPos, comp };
+        std::priority_queue<size_t, std::vector<size_t>, QueueCompare> queue(queueCompare);
+        for (size_t i = 0; i < parts.size(); i++) {
+            bufferSize[i] = fread(buffers[i].data(), sizeof(Record), CHUNK_SIZE, handles[i]);
+            if (bufferSize[i] > 0) {
+                queue.push(i);
+            }
+        }
+        std::vector<Record> outBuffer;
+        outBuffer.reserve(CHUNK_SIZE);
+        while (queue.empty() == false) {
+            size_t part = queue.top();
+            queue.pop();
+            outBuffer.push_back(buffers[part][bufferPos[part]]);
+            if (outBuffer.size() == CHUNK_SIZE) {
+                fwrite(outBuffer.data(), sizeof(Record), outBuffer.size(), out);
+                outBuffer.clear();
+            }
+            bufferPos[part]++;
+            if (bufferPos[part] == bufferSize[part]) {
+                bufferPos[part] = 0;
+                bufferSize[part] = fread(buffers[part].data(), sizeof(Record), CHUNK_SIZE, handles[part]);
+            }
+            if (bufferSize[part] > 0) {
+                queue.push(part);
+            }
+        }
+        fwrite(outBuffer.data(), sizeof(Record), outBuffer.size(), out);
+        for (size_t i = 0; i < handles.size(); i++) {
+            fclose(handles[i]);
+        }
+
+        // the grouped k-mers of the splits are already sorted, they are appended one after the other
+        std::vector<size_t> groupedCounts;
+        for (size_t i = 0; i < groupedParts.size(); i++) {
+            groupedCounts.push_back(FileUtil::getFileSize(groupedParts[i]) / sizeof(Record));
+        }
+        fwrite(groupedCounts.data(), sizeof(size_t), groupedCounts.size(), out);
+        outBuffer.resize(CHUNK_SIZE);
+        for (size_t i = 0; i < groupedParts.size(); i++) {
+            FILE *handle = FileUtil::openFileOrDie(groupedParts[i].c_str(), "rb", true);
+            size_t count;
+            while ((count = fread(outBuffer.data(), sizeof(Record), CHUNK_SIZE, handle)) > 0) {
+                fwrite(outBuffer.data(), sizeof(Record), count, out);
+            }
+            fclose(handle);
+        }
+        if (fclose(out) != 0) {
+            Debug(Debug::ERROR) << "Could not write k-mer table " << tmpFile << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+        FileUtil::move(tmpFile.c_str(), file.c_str());
+    }
+
+private:
+    static const size_t CHUNK_SIZE = 1024 * 1024;
+};
+
+#endif
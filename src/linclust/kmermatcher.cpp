@@ -19,6 +19,8 @@
 #include "ExtendedSubstitutionMatrix.h"
 #include "KmerGenerator.h"
 #include "MarkovKmerScore.h"
+#include "KmerTable.h"
+#include "simd.h"
 
 #include <limits>
 #include <string>
@@ -38,8 +40,10 @@
 
 #define RoL(val, numbits) (val << numbits) ^ (val >> (32 - numbits))
 
+static const short unsigned CIRC_HASH_RAND[21] = {0x4567, 0x23c6, 0x9869, 0x4873, 0xdc51, 0x5cff, 0x944a, 0x58ec, 0x1f29, 0x7ccd, 0x58ba, 0xd7ab, 0x41f2, 0x1efb, 0xa9e3, 0xe146, 0x007c, 0x62c2, 0x0854, 0x27f8, 0x231b};
+
 unsigned circ_hash(const int * x, unsigned length, const unsigned rol){
-    short unsigned RAND[21] = {0x4567, 0x23c6, 0x9869, 0x4873, 0xdc51, 0x5cff, 0x944a, 0x58ec, 0x1f29, 0x7ccd, 0x58ba, 0xd7ab, 0x41f2, 0x1efb, 0xa9e3, 0xe146, 0x007c, 0x62c2, 0x0854, 0x27f8, 0x231b};
+    const short unsigned * RAND = CIRC_HASH_RAND;
     short unsigned h = 0x0;
     h = h ^ RAND[x[0]];                  // XOR h and ki
     for (unsigned int i = 1; i < length; ++i){
@@ -51,7 +55,7 @@ unsigned circ_hash(const int * x, unsigned length, const unsigned rol){
 
 // Rolling hash for CRC variant: compute hash value for next key x[0:length-1] from previous hash value hash( x[-1:length-2] ) and x_first = x[-1]
 unsigned circ_hash_next(const int * x, unsigned length, int x_first, short unsigned h, const unsigned rol){
-    short unsigned RAND[21] = {0x4567, 0x23c6, 0x9869, 0x4873, 0xdc51, 0x5cff, 0x944a, 0x58ec, 0x1f29, 0x7ccd, 0x58ba, 0xd7ab, 0x41f2, 0x1efb, 0xa9e3, 0xe146, 0x007c, 0x62c2, 0x0854, 0x27f8, 0x231b};
+    const short unsigned * RAND = CIRC_HASH_RAND;
     h ^= RoL(RAND[x_first], (5*(length-1)) % 16); // undo INITIAL_VALUE and first letter x[0] of old key
     h =  RoL(h, rol); // circularly permute all letters x[1:length-1] to 5 positions to left
     h ^= RAND[x[length-1]]; // add new, last letter of new key x[1:length]
@@ -59,31 +63,105 @@ unsigned circ_hash_next(const int * x, unsigned length, int x_first, short unsig
 }
 #undef RoL
 
+// For 0 < rol < 16 RoL is a plain left shift within the 16 bit hash: a letter is shifted out after
+// CIRC_HASH_TERMS(rol) steps. A hash therefore only depends on the last few letters (circ_hash) or the
+// last few updates (circ_hash_next), which can be computed for many windows at once.
+#define CIRC_HASH_TERMS(rol) ((16 + (rol) - 1) / (rol))
+static const size_t CIRC_HASH_LANES = VECSIZE_INT * 2;
+
+void rollingKmerHashes(const int * x, size_t windows, unsigned length, unsigned rol, unsigned short * hashes, unsigned short * buffer){
+    if (windows == 0) {
+        return;
+    }
+    hashes[0] = circ_hash(x, length, rol);
+    const unsigned int undoShift = (5 * (length - 1)) % 16;
+    if (rol == 0 || rol > 15 || undoShift == 0) {
+        for (size_t p = 1; p < windows; p++) {
+            hashes[p] = circ_hash_next(x + p, length, x[p - 1], hashes[p - 1], rol);
+        }
+        return;
+    }
+    // circ_hash_next is h = (h << rol) ^ update with an update that only depends on the letters
+    // leaving and entering the window
+    for (size_t p = 1; p < windows; p++) {
+        buffer[p] = static_cast<unsigned short>((CIRC_HASH_RAND[x[p - 1]] << (undoShift + rol)) ^ CIRC_HASH_RAND[x[p + length - 1]]);
+    }
+    const size_t terms = CIRC_HASH_TERMS(rol);
+    size_t p = 1;
+    for (; p < windows && p < terms; p++) {
+        hashes[p] = static_cast<unsigned short>((hashes[p - 1] << rol) ^ buffer[p]);
+    }
+    // from here on the hash of the first window is shifted out, each hash is the sum of the last updates
+    for (; p + CIRC_HASH_LANES <= windows; p += CIRC_HASH_LANES) {
+        simd_int h = simdi_loadu((simd_int *) (buffer + p));
+        for (size_t j = 1; j < terms; j++) {
+            h = simdi_xor(h, simdi16_slli(simdi_loadu((simd_int *) (buffer + p - j)), rol * j));
+        }
+        simdi_storeu((simd_int *) (hashes + p), h);
+    }
+    for (; p < windows; p++) {
+        hashes[p] = static_cast<unsigned short>((hashes[p - 1] << rol) ^ buffer[p]);
+    }
+}
+
+void windowKmerHashes(const int * x, size_t windows, unsigned length, unsigned rol, unsigned short * hashes, unsigned short * buffer){
+    if (rol == 0 || rol > 15) {
+        for (size_t p = 0; p < windows; p++) {
+            hashes[p] = circ_hash(x + p, length, rol);
+        }
+        return;
+    }
+    const size_t terms = std::min(static_cast<size_t>(length), static_cast<size_t>(CIRC_HASH_TERMS(rol)));
+    const size_t skip = length - terms;
+    for (size_t q = skip; q < windows + length - 1; q++) {
+        buffer[q] = CIRC_HASH_RAND[x[q]];
+    }
+    size_t p = 0;
+    for (; p + CIRC_HASH_LANES <= windows; p += CIRC_HASH_LANES) {
+        simd_int h = simdi_loadu((simd_int *) (buffer + p + length - 1));
+        for (size_t j = 1; j < terms; j++) {
+            h = simdi_xor(h, simdi16_slli(simdi_loadu((simd_int *) (buffer + p + length - 1 - j)), rol * j));
+        }
+        simdi_storeu((simd_int *) (hashes + p), h);
+    }
+    for (; p < windows; p++) {
+        unsigned short h = buffer[p + length - 1];
+        for (size_t j = 1; j < terms; j++) {
+            h ^= static_cast<unsigned short>(buffer[p + length - 1 - j] << (rol * j));
+        }
+        hashes[p] = h;
+    }
+}
+#undef CIRC_HASH_TERMS
+
 
-template <typename T>
-KmerPosition<T> *initKmerPositionMemory(size_t size) {
-    KmerPosition<T> * hashSeqPair = new(std::nothrow) KmerPosition<T>[size + 1];
+template <typename T, bool Compact>
+KmerPosition<T, Compact> *initKmerPositionMemory(size_t size) {
+    KmerPosition<T, Compact> * hashSeqPair = new(std::nothrow) KmerPosition<T, Compact>[size + 1];
     Util::checkAllocation(hashSeqPair, "Can not allocate memory");
-    size_t pageSize = Util::getPageSize()/sizeof(KmerPosition<T>);
+    size_t pageSize = Util::getPageSize()/sizeof(KmerPosition<T, Compact>);
 
 #pragma omp parallel
     {
 #pragma omp for schedule(dynamic, 1)
         for (size_t page = 0; page < size+1; page += pageSize) {
             size_t readUntil = std::min(size+1, page + pageSize) - page;
-            memset(hashSeqPair+page, 0xFF, sizeof(KmerPosition<T>)* readUntil);
+            memset(hashSeqPair+page, 0xFF, sizeof(KmerPosition<T, Compact>)* readUntil);
         }
     }
     return hashSeqPair;
 }
 
-template <int TYPE, typename T>
-std::pair<size_t, size_t> fillKmerPositionArray(KmerPosition<T> * hashSeqPair, DBReader<unsigned int> &seqDbr,
+template <int TYPE, typename T, bool Compact>
+std::pair<size_t, size_t> fillKmerPositionArray(KmerPosition<T, Compact> * hashSeqPair, DBReader<unsigned int> &seqDbr,
                              Parameters & par, BaseMatrix * subMat,
                              const size_t KMER_SIZE, size_t chooseTopKmer,
                              bool includeIdenticalKmer, size_t splits,
-                             size_t split, size_t pickNBest, bool adjustLength, float chooseTopKmerScale){
+                             size_t split, size_t pickNBest, bool adjustLength, float chooseTopKmerScale,
+                             KmerPartitions * partitions, const char * extractKey){
     size_t offset = 0;
+    // in partition mode all splits are extracted in one pass and scattered into one file per split
+    const bool writePartitions = (partitions != NULL);
     int querySeqType  =  seqDbr.getDbtype();
     size_t longestKmer = KMER_SIZE;
     ProbabilityMatrix *probMatrix = NULL;
@@ -91,45 +169,6 @@ std::pair<size_t, size_t> fillKmerPositionArray(KmerPosition<T> * hashSeqPair, D
         probMatrix = new ProbabilityMatrix(*subMat);
     }
 
-    struct SequencePosition{
-        short score;
-        size_t kmer;
-        unsigned int pos;
-        static bool compareByScore(const SequencePosition &first, const SequencePosition &second){
-            if(first.score < second.score)
-                return true;
-            if(second.score < first.score)
-                return false;
-            if(first.kmer < second.kmer)
-                return true;
-            if(second.kmer < first.kmer)
-                return false;
-            if(first.pos < second.pos)
-                return true;
-            if(second.pos < first.pos)
-                return false;
-            return false;
-        }
-        static bool compareByScoreReverse(const SequencePosition &first, const SequencePosition &second){
-            if(first.score < second.score)
-                return true;
-            if(second.score < first.score)
-                return false;
-
-            size_t firstKmer  = BIT_SET(first.kmer, 63);
-            size_t secondKmer = BIT_SET(second.kmer, 63);
-            if(firstKmer < secondKmer)
-                return true;
-            if(secondKmer < firstKmer)
-                return false;
-            if(first.pos < second.pos)
-                return true;
-            if(second.pos < first.pos)
-                return false;
-            return false;
-        }
-    };
-
     ScoreMatrix two;
     ScoreMatrix three;
     if (TYPE == Parameters::DBTYPE_HMM_PROFILE) {
@@ -155,8 +194,77 @@ std::pair<size_t, size_t> fillKmerPositionArray(KmerPosition<T> * hashSeqPair, D
         char * charSequence = new char[par.maxSeqLen + 1];
         const unsigned int BUFFER_SIZE = 1024;
         size_t bufferPos = 0;
-        KmerPosition<T> * threadKmerBuffer = new KmerPosition<T>[BUFFER_SIZE];
+        KmerPosition<T, Compact> * threadKmerBuffer = new KmerPosition<T, Compact>[BUFFER_SIZE];
+        KmerPosition<T, Compact> * partitionBuffer = NULL;
+        size_t * partitionBufferPos = NULL;
+        const size_t partitionBlockSize = (writePartitions) ? partitions->blockSize : 0;
+        if (writePartitions) {
+            partitionBuffer = new KmerPosition<T, Compact>[splits * partitionBlockSize];
+            partitionBufferPos = new size_t[splits];
+            memset(partitionBufferPos, 0, sizeof(size_t) * splits);
+        }
+        // writes the collected k-mers of a split at a position reserved in its file
+        auto writePartitionBlock = [&](size_t splitIdx) {
+            const size_t fill = partitionBufferPos[splitIdx];
+            const size_t writeOffset = __sync_fetch_and_add(&partitions->kmerCounts[splitIdx], fill);
+            __sync_fetch_and_add(&offset, fill);
+            const char * data = reinterpret_cast<const char *>(partitionBuffer + splitIdx * partitionBlockSize);
+            size_t bytes = sizeof(KmerPosition<T, Compact>) * fill;
+            off_t fileOffset = static_cast<off_t>(sizeof(KmerPosition<T, Compact>) * writeOffset);
+            const int fd = fileno(partitions->files[splitIdx]);
+            while (bytes > 0) {
+                ssize_t written = pwrite(fd, data, bytes, fileOffset);
+                if (written <= 0) {
+                    Debug(Debug::ERROR) << "Could not write k-mer partition of split " << splitIdx << "\n";
+                    EXIT(EXIT_FAILURE);
+                }
+                data += written;
+                bytes -= written;
+                fileOffset += written;
+            }
+            partitionBufferPos[splitIdx] = 0;
+        };
+        // appends one k-mer either to the shared array or to the buffer of its partition
+        auto addKmer = [&](size_t kmer, size_t splitIdx, unsigned int seqId, T pos, T seqLen) {
+            if (writePartitions) {
+                KmerPosition<T, Compact> * buffer = partitionBuffer + splitIdx * partitionBlockSize;
+                size_t & fill = partitionBufferPos[splitIdx];
+                buffer[fill].setKmer(kmer);
+                buffer[fill].id = seqId;
+                buffer[fill].pos = pos;
+                buffer[fill].setSeqLen(seqLen);
+                fill++;
+                if (fill >= partitionBlockSize) {
+                    writePartitionBlock(splitIdx);
+                }
+                return;
+            }
+            if (splitIdx != split) {
+                return;
+            }
+            threadKmerBuffer[bufferPos].setKmer(kmer);
+            threadKmerBuffer[bufferPos].id = seqId;
+            threadKmerBuffer[bufferPos].pos = pos;
+            threadKmerBuffer[bufferPos].setSeqLen(seqLen);
+            bufferPos++;
+            if (bufferPos >= BUFFER_SIZE) {
+                size_t writeOffset = __sync_fetch_and_add(&offset, bufferPos);
+                memcpy(hashSeqPair + writeOffset, threadKmerBuffer, sizeof(KmerPosition<T, Compact>) * bufferPos);
+                bufferPos = 0;
+            }
+        };
         SequencePosition * kmers = new SequencePosition[(pickNBest * (par.maxSeqLen + 1)) + 1];
+        // hashes of all windows of a sequence, for nucleotides also of its reverse complement
+        unsigned short * hashes = new unsigned short[par.maxSeqLen + 1];
+        unsigned short * hashBuffer = new unsigned short[par.maxSeqLen + 1];
+        unsigned short * reverseHashes = NULL;
+        int * reverseSequence = NULL;
+        if (TYPE == Parameters::DBTYPE_NUCLEOTIDES) {
+            reverseHashes = new unsigned short[par.maxSeqLen + 1];
+            reverseSequence = new int[par.maxSeqLen + 1];
+        }
+        RollingKmerIndex rollingIndex(subMat->alphabetSize - 1, KMER_SIZE);
+        const size_t nuclKmerMask = (KMER_SIZE >= 32) ? SIZE_T_MAX : ((static_cast<size_t>(1) << (2 * KMER_SIZE)) - 1);
         int highestSeq[32];
         for(size_t i = 0; i< KMER_SIZE; i++){
             highestSeq[i]=subMat->alphabetSize-1;
@@ -171,6 +279,9 @@ std::pair<size_t, size_t> fillKmerPositionArray(KmerPosition<T> * hashSeqPair, D
 #pragma omp for schedule(dynamic, 10)
             for (size_t id = start; id < (start + bucketSize); id++) {
                 progress.updateProgress();
+                if (extractKey != NULL && extractKey[seqDbr.getDbKey(id)] == false) {
+                    continue;
+                }
                 seq.mapSequence(id, seqDbr.getDbKey(id), seqDbr.getData(id, thread_idx), seqDbr.getSeqLen(id));
                 size_t seqHash =  SIZE_T_MAX;
                 if(includeIdenticalKmer){
@@ -206,130 +317,121 @@ std::pair<size_t, size_t> fillKmerPositionArray(KmerPosition<T> * hashSeqPair, D
 
                 int seqKmerCount = 0;
                 unsigned int seqId = seq.getDbKey();
-                unsigned short prevHash = 0;
-                unsigned int prevFirstRes = 0;
-                if (seq.hasNextKmer()) {
-                    const int *kmer = seq.nextKmer();
-                    prevHash = circ_hash(kmer, KMER_SIZE, par.hashShift);
-                    prevFirstRes = kmer[0];
-                }
-                while (seq.hasNextKmer()) {
-                    int *kmer = (int*) seq.nextKmer();
-                    if(TYPE != Parameters::DBTYPE_NUCLEOTIDES){
-                        prevHash = circ_hash_next(kmer, KMER_SIZE, prevFirstRes, prevHash, par.hashShift);
-                        prevFirstRes = kmer[0];
+                const int xResidue = subMat->aa2int[(int) 'X'];
+                if (TYPE == Parameters::DBTYPE_HMM_PROFILE) {
+                    // the first k-mer is skipped like for the other sequence types
+                    if (seq.hasNextKmer()) {
+                        seq.nextKmer();
                     }
-                    size_t xCount = 0;
-                    for (size_t kpos = 0; kpos < KMER_SIZE; kpos++) {
-                        xCount += (kmer[kpos] == subMat->aa2int[(int) 'X']);
-                    }
-                    if (xCount > 0) {
-                        continue;
-                    }
-                    if(TYPE == Parameters::DBTYPE_NUCLEOTIDES){
-                        int revKmer[32];
-                        NucleotideMatrix * nuclMatrix = (NucleotideMatrix*)subMat;
-                        size_t kmerLen = KMER_SIZE;
-                        int * kmerToHash = kmer;
-                        size_t kmerIdx = Indexer::computeKmerIdx(kmer, kmerLen);
-                        size_t revkmerIdx = Util::revComplement(kmerIdx, kmerLen);
-                        bool pickReverseKmer = (revkmerIdx<kmerIdx);
-                        kmerIdx = (pickReverseKmer) ? revkmerIdx : kmerIdx;
-                        if(pickReverseKmer){
-                            for(int pos = static_cast<int>(adjustedKmerSize)-1; pos > -1; pos--){
-                                revKmer[(adjustedKmerSize - 1) - pos]=nuclMatrix->reverseResidue(kmer[pos]);
-                            }
-                            kmerToHash = revKmer;
+                    while (seq.hasNextKmer()) {
+                        int *kmer = (int*) seq.nextKmer();
+                        size_t xCount = 0;
+                        for (size_t kpos = 0; kpos < KMER_SIZE; kpos++) {
+                            xCount += (kmer[kpos] == xResidue);
                         }
-                        prevHash = circ_hash(kmerToHash, kmerLen, par.hashShift);
-                        if(adjustLength) {
-                            kmerLen = MarkovKmerScore::adjustedLength(kmerToHash, adjustedKmerSize,
-                                                                      (KMER_SIZE - MarkovScores::MARKOV_ORDER) * MarkovScores::MEDIAN_SCORE);
-                            longestKmer = std::max(kmerLen, longestKmer);
-                            kmerIdx = Indexer::computeKmerIdx(kmerToHash, kmerLen);
+                        if (xCount > 0) {
+                            continue;
                         }
-
-//                        std::cout << "\t" << MarkovKmerScore::scoreKmer(kmer, KMER_SIZE) << std::endl;
-//                        float score = MarkovKmerScore::scoreKmer(kmer, KMER_SIZE);
-//                        sum += score;
-//                        std::cout << score << "\t";
-//                        std::cout << len << "\t";
-//                        size_t adjkmerIdx = Indexer::computeKmerIdx(kmer, len);
-//                        Indexer::printKmer(kmerIdx, KMER_SIZE);
-//                        std::cout << "\t";
-//                        Indexer::printKmer(adjkmerIdx, len);
-//                        std::cout << std::endl;
-                        //std::cout << len << std::endl;
-
-
-                        // set signed bit for normal kmers to make the  SIZE_T_MAX logic easier
-                        // reversed kmers do not have a signed bit
-                        size_t kmerRev = (pickReverseKmer) ? BIT_CLEAR(kmerIdx, 63) : BIT_SET(kmerIdx, 63);
-                        (kmers + seqKmerCount)->kmer = kmerRev;
-                        int pos = seq.getCurrentPosition();
-                        (kmers + seqKmerCount)->pos = (pickReverseKmer) ? (seq.L) - pos - kmerLen : pos;
-//                        std::cout << seq.getDbKey() << "\t";
-//                        std::cout << pickReverseKmer << "\t";
-//                        std::cout << seq.L << "\t";sta
-//                        std::cout << pos << "\t";
-//                        std::cout << (kmers + seqKmerCount)->pos << "\t";
-//                        printKmer(kmerIdx, KMER_SIZE);
-//                        std::cout <<  "\t";
-//                         printKmer(kmerRev, KMER_SIZE);
-//                        std::cout <<  "\n";
-                        (kmers + seqKmerCount)->score = prevHash;
-                        seqKmerCount++;
-                    } else if(TYPE == Parameters::DBTYPE_HMM_PROFILE) {
                         std::pair<size_t*, size_t>  scoreMat = generator->generateKmerList(kmer, true);
-//                        std::cout << scoreMat.elementSize << std::endl;
                         for(size_t kmerPos = 0; kmerPos < scoreMat.second && kmerPos < pickNBest; kmerPos++){
                             (kmers + seqKmerCount)->kmer  =  scoreMat.first[kmerPos];
                             (kmers + seqKmerCount)->pos = seq.getCurrentPosition();
                             //TODO
-                            prevHash = circ_hash(kmer, KMER_SIZE, par.hashShift);
-                            (kmers + seqKmerCount)->score = prevHash;
+                            (kmers + seqKmerCount)->score = circ_hash(kmer, KMER_SIZE, par.hashShift);
                             seqKmerCount++;
                         }
+                    }
+                } else {
+                    const int * sequence = seq.int_sequence;
+                    const size_t seqLen = static_cast<size_t>(seq.L);
+                    const size_t windows = (seqLen >= adjustedKmerSize) ? (seqLen - adjustedKmerSize + 1) : 0;
+                    NucleotideMatrix * nuclMatrix = (NucleotideMatrix*)subMat;
+                    if (TYPE == Parameters::DBTYPE_NUCLEOTIDES) {
+                        // the reverse k-mer of the window at p starts at L - p - adjustedKmerSize
+                        for (size_t i = 0; i < seqLen; i++) {
+                            reverseSequence[i] = nuclMatrix->reverseResidue(sequence[seqLen - 1 - i]);
+                        }
+                        windowKmerHashes(sequence, windows, KMER_SIZE, par.hashShift, hashes, hashBuffer);
+                        windowKmerHashes(reverseSequence, windows, KMER_SIZE, par.hashShift, reverseHashes, hashBuffer);
                     } else {
-                        uint64_t kmerIdx = idxer.int2index(kmer, 0, KMER_SIZE);
-                        (kmers + seqKmerCount)->kmer = kmerIdx;
-                        (kmers + seqKmerCount)->pos = seq.getCurrentPosition();
-                        (kmers + seqKmerCount)->score = prevHash;
-                        seqKmerCount++;
+                        rollingKmerHashes(sequence, windows, KMER_SIZE, par.hashShift, hashes, hashBuffer);
                     }
 
-                }
-
-                if (seqKmerCount > 1) {
-                    if(TYPE == Parameters::DBTYPE_NUCLEOTIDES) {
-                        std::sort(kmers, kmers + seqKmerCount, SequencePosition::compareByScoreReverse);
-                    }else{
-                        std::sort(kmers, kmers + seqKmerCount, SequencePosition::compareByScore);
+                    // k-mer indices and the last X are updated with the residue entering each window
+                    long lastX = -1;
+                    size_t kmerIdx = 0;
+                    size_t revKmerIdx = 0;
+                    for (size_t i = 0; windows > 0 && i + 1 < KMER_SIZE; i++) {
+                        lastX = (sequence[i] == xResidue) ? static_cast<long>(i) : lastX;
+                        if (TYPE == Parameters::DBTYPE_NUCLEOTIDES) {
+                            kmerIdx = (kmerIdx << 2) | (sequence[i] & 3);
+                            revKmerIdx = (revKmerIdx >> 2) | (static_cast<size_t>(nuclMatrix->reverseResidue(sequence[i]) & 3) << (2 * (KMER_SIZE - 1)));
+                        }
+                    }
+                    for (size_t p = 0; p < windows; p++) {
+                        const int *kmer = sequence + p;
+                        const int added = kmer[KMER_SIZE - 1];
+                        lastX = (added == xResidue) ? static_cast<long>(p + KMER_SIZE - 1) : lastX;
+                        if (TYPE == Parameters::DBTYPE_NUCLEOTIDES) {
+                            kmerIdx = ((kmerIdx << 2) | (added & 3)) & nuclKmerMask;
+                            revKmerIdx = (revKmerIdx >> 2) | (static_cast<size_t>(nuclMatrix->reverseResidue(added) & 3) << (2 * (KMER_SIZE - 1)));
+                        } else if (rollingIndex.isExact()) {
+                            kmerIdx = (p == 0) ? rollingIndex.index(kmer) : rollingIndex.next(kmerIdx, kmer[-1], added);
+                        }
+                        // the first window only initializes the hash
+                        if (p == 0 || lastX >= static_cast<long>(p)) {
+                            continue;
+                        }
+                        if (TYPE == Parameters::DBTYPE_NUCLEOTIDES) {
+                            size_t kmerLen = KMER_SIZE;
+                            bool pickReverseKmer = (revKmerIdx < kmerIdx);
+                            size_t pickedKmerIdx = (pickReverseKmer) ? revKmerIdx : kmerIdx;
+                            const size_t reverseStart = seqLen - p - adjustedKmerSize;
+                            unsigned short hash = (pickReverseKmer) ? reverseHashes[reverseStart] : hashes[p];
+                            if(adjustLength) {
+                                const int * kmerToHash = (pickReverseKmer) ? (reverseSequence + reverseStart) : kmer;
+                                kmerLen = MarkovKmerScore::adjustedLength(kmerToHash, adjustedKmerSize,
+                                                                          (KMER_SIZE - MarkovScores::MARKOV_ORDER) * MarkovScores::MEDIAN_SCORE);
+                                longestKmer = std::max(kmerLen, longestKmer);
+                                pickedKmerIdx = Indexer::computeKmerIdx(kmerToHash, kmerLen);
+                            }
+                            // set signed bit for normal kmers to make the  SIZE_T_MAX logic easier
+                            // reversed kmers do not have a signed bit
+                            (kmers + seqKmerCount)->kmer = (pickReverseKmer) ? BIT_CLEAR(pickedKmerIdx, 63) : BIT_SET(pickedKmerIdx, 63);
+                            (kmers + seqKmerCount)->pos = (pickReverseKmer) ? (seqLen - p - kmerLen) : p;
+                            (kmers + seqKmerCount)->score = hash;
+                        } else {
+                            (kmers + seqKmerCount)->kmer = (rollingIndex.isExact()) ? kmerIdx : idxer.int2index(kmer, 0, KMER_SIZE);
+                            (kmers + seqKmerCount)->pos = p;
+                            (kmers + seqKmerCount)->score = hashes[p];
+                        }
+                        seqKmerCount++;
                     }
                 }
 
+                // only the k-mers with the lowest hashes are used, they are sorted on demand
+                bool (*compareKmers)(const SequencePosition &, const SequencePosition &) =
+                        (TYPE == Parameters::DBTYPE_NUCLEOTIDES) ? SequencePosition::compareByScoreReverse : SequencePosition::compareByScore;
+
                 // add k-mer to represent the identity
                 //TODO, how to handle this in reverse?
-                if (seqHash%splits == split) {
-                    threadKmerBuffer[bufferPos].kmer = seqHash;
-                    threadKmerBuffer[bufferPos].id = seqId;
-                    threadKmerBuffer[bufferPos].pos = 0;
-                    threadKmerBuffer[bufferPos].seqLen = seq.L;
-                    bufferPos++;
-                    if (bufferPos >= BUFFER_SIZE) {
-                        size_t writeOffset = __sync_fetch_and_add(&offset, bufferPos);
-                        memcpy(hashSeqPair + writeOffset, threadKmerBuffer, sizeof(KmerPosition<T>) * bufferPos);
-                        bufferPos = 0;
-                    }
-                }
+                addKmer(seqHash, kmerSplit<TYPE>(seqHash, splits), seqId, 0, seq.L);
 
                 size_t kmersToConsider = std::min(static_cast<int>(chooseTopKmer - 1 + (chooseTopKmerScale * seq.L)), seqKmerCount);
                 size_t kmersConsidered = 0;
 
                 size_t prevKmer = SIZE_T_MAX;
+                size_t sortedKmers = 0;
+                if (seqKmerCount > 1) {
+                    sortedKmers = sortKmerPrefix(kmers, 0, kmersToConsider + 1, seqKmerCount, compareKmers);
+                }
                 kmers[seqKmerCount].kmer = SIZE_T_MAX;
                 for (size_t topKmer = 0; topKmer < static_cast<size_t>(seqKmerCount) &&
                                          kmersConsidered < kmersToConsider; topKmer++) {
+                    // skipped repeats need more k-mers than selected up front
+                    if (seqKmerCount > 1 && topKmer + 2 > sortedKmers) {
+                        sortedKmers = sortKmerPrefix(kmers, sortedKmers, topKmer + 2, seqKmerCount, compareKmers);
+                    }
 
                     size_t kmerCurr = (kmers + topKmer)->kmer;
                     size_t kmerNext = (kmers + topKmer + 1)->kmer;
@@ -348,21 +450,7 @@ std::pair<size_t, size_t> fillKmerPositionArray(KmerPosition<T> * hashSeqPair, D
                     }
 
                     kmersConsidered++;
-                    size_t splitIdx = kmerCurr % splits;
-                    if (splitIdx != split) {
-                        continue;
-                    }
-
-                    threadKmerBuffer[bufferPos].kmer = (kmers + topKmer)->kmer;
-                    threadKmerBuffer[bufferPos].id = seqId;
-                    threadKmerBuffer[bufferPos].pos = (kmers + topKmer)->pos;
-                    threadKmerBuffer[bufferPos].seqLen = seq.L;
-                    bufferPos++;
-                    if (bufferPos >= BUFFER_SIZE) {
-                        size_t writeOffset = __sync_fetch_and_add(&offset, bufferPos);
-                        memcpy(hashSeqPair + writeOffset, threadKmerBuffer, sizeof(KmerPosition<T>) * bufferPos);
-                        bufferPos = 0;
-                    }
+                    addKmer((kmers + topKmer)->kmer, kmerSplit<TYPE>(kmerCurr, splits), seqId, (kmers + topKmer)->pos, seq.L);
                 }
             }
 #pragma omp barrier
@@ -378,9 +466,22 @@ std::pair<size_t, size_t> fillKmerPositionArray(KmerPosition<T> * hashSeqPair, D
 
         if(bufferPos > 0){
             size_t writeOffset = __sync_fetch_and_add(&offset, bufferPos);
-            memcpy(hashSeqPair+writeOffset, threadKmerBuffer, sizeof(KmerPosition<T>) * bufferPos);
+            memcpy(hashSeqPair+writeOffset, threadKmerBuffer, sizeof(KmerPosition<T, Compact>) * bufferPos);
+        }
+        if (writePartitions) {
+            for (size_t i = 0; i < splits; i++) {
+                if (partitionBufferPos[i] > 0) {
+                    writePartitionBlock(i);
+                }
+            }
+            delete[] partitionBuffer;
+            delete[] partitionBufferPos;
         }
         delete[] kmers;
+        delete[] hashes;
+        delete[] hashBuffer;
+        delete[] reverseHashes;
+        delete[] reverseSequence;
         delete[] charSequence;
         delete[] threadKmerBuffer;
         if (TYPE == Parameters::DBTYPE_HMM_PROFILE) {
@@ -399,10 +500,202 @@ std::pair<size_t, size_t> fillKmerPositionArray(KmerPosition<T> * hashSeqPair, D
     return std::make_pair(offset, longestKmer);
 }
 
-template <typename T>
-KmerPosition<T> * doComputation(size_t totalKmers, size_t split, size_t splits, std::string splitFile,
+// merges the k-mers of the previous k-mer table that fall into split with the sorted new
+// k-mers at the front of hashSeqPair, the result is sorted as if all k-mers were extracted.
+// If touchedGroups is given it holds the (sorted) group k-mers of the new k-mers; the k-mers of groups
+// that lost k-mers of removed sequences are added and the representative of every old group that
+// gained or lost k-mers is marked in dirtyReps
+template <int TYPE, typename T, bool Compact>
+void mergeKmerTable(KmerPosition<T, Compact> *hashSeqPair, size_t newKmers, size_t tableKmers,
+                    size_t split, size_t splits, const KmerTableMerge & tableMerge,
+                    std::vector<size_t> * touchedGroups, std::vector<char> * dirtyReps) {
+    bool (*comp)(const KmerPosition<T, Compact> &, const KmerPosition<T, Compact> &) =
+            (TYPE == Parameters::DBTYPE_NUCLEOTIDES) ? KmerPosition<T, Compact>::compareRepSequenceAndIdAndPosReverse
+                                                     : KmerPosition<T, Compact>::compareRepSequenceAndIdAndPos;
+    // the new k-mers move behind the space of the table k-mers, the write position
+    // never overtakes the unread new k-mers
+    std::copy_backward(hashSeqPair, hashSeqPair + newKmers, hashSeqPair + tableKmers + newKmers);
+    KmerPosition<T, Compact> * newSorted = hashSeqPair + tableKmers;
+    size_t newPos = 0;
+    size_t writePos = 0;
+    size_t readKmers = 0;
+    const std::vector<char> & keepKey = tableMerge.keepKey;
+
+    // old group that is streamed and its longest sequence (the first one if several are equally long)
+    std::vector<size_t> removedGroups;
+    size_t groupKmer = SIZE_T_MAX;
+    unsigned int groupRep = 0;
+    T groupRepLen = 0;
+    bool groupRemoved = false;
+    size_t groupSize = 0;
+    auto finishGroup = [&]() {
+        if (groupSize > 1 && (groupRemoved || std::binary_search(touchedGroups->begin(), touchedGroups->end(), groupKmer))) {
+            (*dirtyReps)[groupRep] = true;
+        }
+        if (groupRemoved) {
+            removedGroups.push_back(groupKmer);
+        }
+    };
+    KmerTable::forEachKmer<T, Compact>(tableMerge.previousTable, [&](const KmerPosition<T, Compact> & kmer) {
+        if (kmerSplit<TYPE>(kmer.getKmer(), splits) != split) {
+            return;
+        }
+        const bool keep = kmer.id < keepKey.size() && keepKey[kmer.id];
+        if (touchedGroups != NULL) {
+            size_t currKmer = (TYPE == Parameters::DBTYPE_NUCLEOTIDES) ? BIT_SET(kmer.getKmer(), 63) : kmer.getKmer();
+            T len = (Compact) ? static_cast<T>(tableMerge.previousLengths[kmer.id]) : kmer.getSeqLen(NULL);
+            if (currKmer != groupKmer) {
+                if (groupSize > 0) {
+                    finishGroup();
+                }
+                groupKmer = currKmer;
+                groupRep = kmer.id;
+                groupRepLen = len;
+                groupRemoved = false;
+                groupSize = 0;
+            } else if (len > groupRepLen) {
+                groupRep = kmer.id;
+                groupRepLen = len;
+            }
+            groupRemoved |= (keep == false);
+            groupSize++;
+        }
+        if (keep == false) {
+            return;
+        }
+        if (readKmers == tableKmers) {
+            readKmers++;
+            return;
+        }
+        // new k-mers go first if they are equal
+        while (newPos < newKmers && comp(kmer, newSorted[newPos]) == false) {
+            hashSeqPair[writePos++] = newSorted[newPos++];
+        }
+        hashSeqPair[writePos++] = kmer;
+        readKmers++;
+    });
+    if (readKmers != tableKmers) {
+        Debug(Debug::ERROR) << "K-mer table " << tableMerge.previousTable << " changed while reading it\n";
+        EXIT(EXIT_FAILURE);
+    }
+    while (newPos < newKmers) {
+        hashSeqPair[writePos++] = newSorted[newPos++];
+    }
+    if (touchedGroups != NULL) {
+        if (groupSize > 0) {
+            finishGroup();
+        }
+        std::vector<size_t> newGroups;
+        newGroups.swap(*touchedGroups);
+        std::set_union(newGroups.begin(), newGroups.end(), removedGroups.begin(), removedGroups.end(),
+                       std::back_inserter(*touchedGroups));
+    }
+}
+
+template <int TYPE, typename T, bool Compact>
+size_t findLongestInGroup(KmerPosition<T, Compact> *hashSeqPair, size_t groupStart, const T * seqLens);
+
+// groups the merged k-mers of an updated k-mer table again where the previous grouped k-mers of split
+// can not be reused: the representatives of all groups that gained or lost k-mers are marked in
+// dirtyReps, the groups that contain a marked sequence are grouped again and their entries with a
+// marked representative are merged with the previous entries of all other representatives.
+// Returns the number of grouped k-mers at the front of hashSeqPair, sorted by rep. sequence
+template <int TYPE, typename T, bool Compact>
+size_t regroupKmerTable(KmerPosition<T, Compact> *hashSeqPair, size_t kmerCount, size_t splitKmerCount, size_t split,
+                        const KmerTableMerge & tableMerge, const std::vector<size_t> & touchedGroups,
+                        std::vector<char> & dirtyReps, Parameters & par, const T * seqLens) {
+    bool (*comp)(const KmerPosition<T, Compact> &, const KmerPosition<T, Compact> &) =
+            (TYPE == Parameters::DBTYPE_NUCLEOTIDES) ? KmerPosition<T, Compact>::compareRepSequenceAndIdAndDiagReverse
+                                                     : KmerPosition<T, Compact>::compareRepSequenceAndIdAndDiag;
+    // groups of equal k-mers in [groupStart, groupEnd)
+    auto groupEnd = [&](size_t groupStart) {
+        size_t groupKmer = (TYPE == Parameters::DBTYPE_NUCLEOTIDES) ? BIT_SET(hashSeqPair[groupStart].getKmer(), 63) : hashSeqPair[groupStart].getKmer();
+        size_t end = groupStart + 1;
+        while (end < kmerCount) {
+            size_t kmer = (TYPE == Parameters::DBTYPE_NUCLEOTIDES) ? BIT_SET(hashSeqPair[end].getKmer(), 63) : hashSeqPair[end].getKmer();
+            if (kmer != groupKmer) {
+                break;
+            }
+            end++;
+        }
+        return end;
+    };
+
+    // the new representatives of the groups that gained or lost k-mers
+    size_t touchedPos = 0;
+    for (size_t groupStart = 0; groupStart < kmerCount && touchedPos < touchedGroups.size();) {
+        size_t end = groupEnd(groupStart);
+        size_t groupKmer = (TYPE == Parameters::DBTYPE_NUCLEOTIDES) ? BIT_SET(hashSeqPair[groupStart].getKmer(), 63) : hashSeqPair[groupStart].getKmer();
+        while (touchedPos < touchedGroups.size() && touchedGroups[touchedPos] < groupKmer) {
+            touchedPos++;
+        }
+        if (end - groupStart > 1 && touchedPos < touchedGroups.size() && touchedGroups[touchedPos] == groupKmer) {
+            dirtyReps[hashSeqPair[findLongestInGroup<TYPE>(hashSeqPair, groupStart, seqLens)].id] = true;
+        }
+        groupStart = end;
+    }
+
+    // groups with a marked member move to the front and are grouped again
+    size_t regroupKmers = 0;
+    for (size_t groupStart = 0; groupStart < kmerCount;) {
+        size_t end = groupEnd(groupStart);
+        bool dirty = false;
+        for (size_t i = groupStart; i < end && dirty == false; i++) {
+            dirty = dirtyReps[hashSeqPair[i].id];
+        }
+        if (dirty) {
+            for (size_t i = groupStart; i < end; i++) {
+                hashSeqPair[regroupKmers++] = hashSeqPair[i];
+            }
+        }
+        groupStart = end;
+    }
+    memset(hashSeqPair + regroupKmers, 0xFF, sizeof(KmerPosition<T, Compact>));
+    size_t regrouped = 0;
+    if (regroupKmers > 0) {
+        size_t groupedKmers = assignGroup<TYPE, T, Compact>(hashSeqPair, regroupKmers, par.includeOnlyExtendable, par.covMode, par.covThr, seqLens);
+        for (size_t i = 0; i < groupedKmers; i++) {
+            size_t rep = (TYPE == Parameters::DBTYPE_NUCLEOTIDES) ? BIT_CLEAR(hashSeqPair[i].getKmer(), 63) : hashSeqPair[i].getKmer();
+            if (dirtyReps[rep]) {
+                hashSeqPair[regrouped++] = hashSeqPair[i];
+            }
+        }
+        omptl::sort(hashSeqPair, hashSeqPair + regrouped, comp);
+    }
+    Debug(Debug::INFO) << "Grouped " << regroupKmers << " of " << kmerCount << " k-mers again ";
+
+    // the new entries move to the end of the array and are merged with the previous entries of
+    // all other representatives, the write position never overtakes the unread new entries
+    std::copy_backward(hashSeqPair, hashSeqPair + regrouped, hashSeqPair + splitKmerCount);
+    KmerPosition<T, Compact> * regroupedSorted = hashSeqPair + (splitKmerCount - regrouped);
+    size_t newPos = 0;
+    size_t writePos = 0;
+    KmerTable::forEachGroupedKmer<T, Compact>(tableMerge.previousTable, split, [&](const KmerPosition<T, Compact> & kmer) {
+        size_t rep = (TYPE == Parameters::DBTYPE_NUCLEOTIDES) ? BIT_CLEAR(kmer.getKmer(), 63) : kmer.getKmer();
+        if (rep < dirtyReps.size() && dirtyReps[rep]) {
+            return;
+        }
+        while (newPos < regrouped && comp(regroupedSorted[newPos], kmer)) {
+            hashSeqPair[writePos++] = regroupedSorted[newPos++];
+        }
+        if (writePos == splitKmerCount - regrouped + newPos) {
+            Debug(Debug::ERROR) << "Grouped k-mers of k-mer table " << tableMerge.previousTable << " do not fit the merged k-mers\n";
+            EXIT(EXIT_FAILURE);
+        }
+        hashSeqPair[writePos++] = kmer;
+    });
+    while (newPos < regrouped) {
+        hashSeqPair[writePos++] = regroupedSorted[newPos++];
+    }
+    memset(hashSeqPair + writePos, 0xFF, sizeof(KmerPosition<T, Compact>));
+    return writePos;
+}
+
+template <typename T, bool Compact>
+KmerPosition<T, Compact> * doComputation(size_t totalKmers, size_t split, size_t splits, std::string splitFile,
                              DBReader<unsigned int> & seqDbr, Parameters & par, BaseMatrix  * subMat,
-                             size_t KMER_SIZE, size_t chooseTopKmer, bool adjustLength, float chooseTopKmerScale) {
+                             size_t KMER_SIZE, size_t chooseTopKmer, bool adjustLength, float chooseTopKmerScale,
+                             std::string partitionFile, const T * seqLens, const KmerTableMerge * tableMerge) {
 
     Debug(Debug::INFO) << "Generate k-mers list for " << (split+1) <<" split\n";
 
@@ -415,18 +708,38 @@ KmerPosition<T> * doComputation(size_t totalKmers, size_t split, size_t splits,
             memoryLimit = static_cast<size_t>(Util::getTotalSystemMemory() * 0.9);
         }
         // we do not really know how much memory is needed. So this is our best choice
-        splitKmerCount = (memoryLimit / sizeof(KmerPosition<T>));
+        splitKmerCount = (memoryLimit / sizeof(KmerPosition<T, Compact>));
     }
 
-    KmerPosition<T> * hashSeqPair = initKmerPositionMemory<T>(splitKmerCount);
+    // an update of a k-mer table only k-merizes new sequences and merges the table k-mers in after sorting
+    const bool mergeTable = (tableMerge != NULL && tableMerge->previousTable.empty() == false);
+    const size_t tableKmers = (mergeTable) ? tableMerge->splitKmerCounts[split] : 0;
+    const char * extractKey = (mergeTable) ? tableMerge->extractKey.data() : NULL;
+
+    KmerPosition<T, Compact> * hashSeqPair;
     size_t elementsToSort;
-    if(Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)){
-        std::pair<size_t, size_t > ret = fillKmerPositionArray<Parameters::DBTYPE_NUCLEOTIDES, T>(hashSeqPair, seqDbr, par, subMat, KMER_SIZE, chooseTopKmer, true, splits, split, 1, adjustLength, chooseTopKmerScale);
+    if(partitionFile.empty() == false){
+        // k-mers of this split were already extracted by extractKmerPartitions
+        size_t partitionSize = FileUtil::getFileSize(partitionFile);
+        elementsToSort = partitionSize / sizeof(KmerPosition<T, Compact>);
+        splitKmerCount = std::max(splitKmerCount, elementsToSort + tableKmers + 1);
+        hashSeqPair = initKmerPositionMemory<T, Compact>(splitKmerCount);
+        FILE * handle = FileUtil::openFileOrDie(partitionFile.c_str(), "rb", true);
+        if(fread(hashSeqPair, sizeof(KmerPosition<T, Compact>), elementsToSort, handle) != elementsToSort){
+            Debug(Debug::ERROR) << "Could not read k-mer partition " << partitionFile << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+        fclose(handle);
+        FileUtil::remove(partitionFile.c_str());
+    }else if(Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)){
+        hashSeqPair = initKmerPositionMemory<T, Compact>(splitKmerCount);
+        std::pair<size_t, size_t > ret = fillKmerPositionArray<Parameters::DBTYPE_NUCLEOTIDES, T, Compact>(hashSeqPair, seqDbr, par, subMat, KMER_SIZE, chooseTopKmer, true, splits, split, 1, adjustLength, chooseTopKmerScale, NULL, extractKey);
         elementsToSort = ret.first;
         KMER_SIZE = ret.second;
         Debug(Debug::INFO) << "\nAdjusted k-mer length " << KMER_SIZE << "\n";
     }else{
-        std::pair<size_t, size_t > ret = fillKmerPositionArray<Parameters::DBTYPE_AMINO_ACIDS, T>(hashSeqPair, seqDbr, par, subMat, KMER_SIZE, chooseTopKmer, true, splits, split, 1, false, chooseTopKmerScale);
+        hashSeqPair = initKmerPositionMemory<T, Compact>(splitKmerCount);
+        std::pair<size_t, size_t > ret = fillKmerPositionArray<Parameters::DBTYPE_AMINO_ACIDS, T, Compact>(hashSeqPair, seqDbr, par, subMat, KMER_SIZE, chooseTopKmer, true, splits, split, 1, false, chooseTopKmerScale, NULL, extractKey);
         elementsToSort = ret.first;
     }
     if(splits == 1){
@@ -436,12 +749,50 @@ KmerPosition<T> * doComputation(size_t totalKmers, size_t split, size_t splits,
     Debug(Debug::INFO) << "Sort kmer ";
     Timer timer;
     if(Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)) {
-        omptl::sort(hashSeqPair, hashSeqPair + elementsToSort, KmerPosition<T>::compareRepSequenceAndIdAndPosReverse);
+        omptl::sort(hashSeqPair, hashSeqPair + elementsToSort, KmerPosition<T, Compact>::compareRepSequenceAndIdAndPosReverse);
     }else{
-        omptl::sort(hashSeqPair, hashSeqPair + elementsToSort, KmerPosition<T>::compareRepSequenceAndIdAndPos);
+        omptl::sort(hashSeqPair, hashSeqPair + elementsToSort, KmerPosition<T, Compact>::compareRepSequenceAndIdAndPos);
     }
     Debug(Debug::INFO) << timer.lap() << "\n";
 
+    // the grouped k-mers of the previous table are updated, this needs the groups that gained or lost k-mers
+    const bool reuseGroups = (mergeTable && tableMerge->reuseGroups);
+    std::vector<size_t> touchedGroups;
+    std::vector<char> dirtyReps;
+    if(reuseGroups){
+        dirtyReps.assign(tableMerge->keepKey.size(), false);
+        const bool isNucleotide = Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES);
+        for(size_t i = 0; i < elementsToSort; i++){
+            size_t kmer = (isNucleotide) ? BIT_SET(hashSeqPair[i].getKmer(), 63) : hashSeqPair[i].getKmer();
+            if(touchedGroups.empty() || touchedGroups.back() != kmer){
+                touchedGroups.push_back(kmer);
+            }
+        }
+    }
+    if(mergeTable && (tableKmers > 0 || reuseGroups)){
+        Debug(Debug::INFO) << "Merge " << tableKmers << " k-mers of k-mer table ";
+        timer.reset();
+        if(Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)) {
+            mergeKmerTable<Parameters::DBTYPE_NUCLEOTIDES, T, Compact>(hashSeqPair, elementsToSort, tableKmers, split, splits, *tableMerge,
+                                                                       (reuseGroups) ? &touchedGroups : NULL, &dirtyReps);
+        }else{
+            mergeKmerTable<Parameters::DBTYPE_AMINO_ACIDS, T, Compact>(hashSeqPair, elementsToSort, tableKmers, split, splits, *tableMerge,
+                                                                       (reuseGroups) ? &touchedGroups : NULL, &dirtyReps);
+        }
+        elementsToSort += tableKmers;
+        Debug(Debug::INFO) << timer.lap() << "\n";
+    }
+    if(tableMerge != NULL){
+        // the grouping below overwrites the k-mers, the sorted list is kept for the new k-mer table
+        std::string partFile = tableMerge->partPrefix + SSTR(split);
+        FILE * handle = FileUtil::openFileOrDie(partFile.c_str(), "wb", false);
+        size_t written = fwrite(hashSeqPair, sizeof(KmerPosition<T, Compact>), elementsToSort, handle);
+        if(fclose(handle) != 0 || written != elementsToSort){
+            Debug(Debug::ERROR) << "Could not write k-mer table part " << partFile << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+    }
+
 //    {
 //        Indexer indexer(subMat->alphabetSize, KMER_SIZE);
 //        for(size_t i = 0; i < elementsToSort; i++){
@@ -452,21 +803,30 @@ KmerPosition<T> * doComputation(size_t totalKmers, size_t split, size_t splits,
     //kx::radix_sort(hashSeqPair, hashSeqPair + elementsToSort, KmerComparision());
 
     // assign rep. sequence to same kmer members
-    // The longest sequence is the first since we sorted by kmer, seq.Len and id
+    // The longest sequence is picked within each group of the same kmer
     size_t writePos;
-    if(Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)){
-        writePos = assignGroup<Parameters::DBTYPE_NUCLEOTIDES, T>(hashSeqPair, splitKmerCount, par.includeOnlyExtendable, par.covMode, par.covThr);
+    if(reuseGroups){
+        timer.reset();
+        if(Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)){
+            writePos = regroupKmerTable<Parameters::DBTYPE_NUCLEOTIDES, T, Compact>(hashSeqPair, elementsToSort, splitKmerCount, split, *tableMerge, touchedGroups, dirtyReps, par, seqLens);
+        }else{
+            writePos = regroupKmerTable<Parameters::DBTYPE_AMINO_ACIDS, T, Compact>(hashSeqPair, elementsToSort, splitKmerCount, split, *tableMerge, touchedGroups, dirtyReps, par, seqLens);
+        }
     }else{
-        writePos = assignGroup<Parameters::DBTYPE_AMINO_ACIDS, T>(hashSeqPair, splitKmerCount, par.includeOnlyExtendable, par.covMode, par.covThr);
-    }
+        if(Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)){
+            writePos = assignGroup<Parameters::DBTYPE_NUCLEOTIDES, T, Compact>(hashSeqPair, splitKmerCount, par.includeOnlyExtendable, par.covMode, par.covThr, seqLens);
+        }else{
+            writePos = assignGroup<Parameters::DBTYPE_AMINO_ACIDS, T, Compact>(hashSeqPair, splitKmerCount, par.includeOnlyExtendable, par.covMode, par.covThr, seqLens);
+        }
 
-    // sort by rep. sequence (stored in kmer) and sequence id
-    Debug(Debug::INFO) << "Sort by rep. sequence ";
-    timer.reset();
-    if(Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)){
-        omptl::sort(hashSeqPair, hashSeqPair + writePos, KmerPosition<T>::compareRepSequenceAndIdAndDiagReverse);
-    }else{
-        omptl::sort(hashSeqPair, hashSeqPair + writePos, KmerPosition<T>::compareRepSequenceAndIdAndDiag);
+        // sort by rep. sequence (stored in kmer) and sequence id
+        Debug(Debug::INFO) << "Sort by rep. sequence ";
+        timer.reset();
+        if(Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)){
+            omptl::sort(hashSeqPair, hashSeqPair + writePos, KmerPosition<T, Compact>::compareRepSequenceAndIdAndDiagReverse);
+        }else{
+            omptl::sort(hashSeqPair, hashSeqPair + writePos, KmerPosition<T, Compact>::compareRepSequenceAndIdAndDiag);
+        }
     }
     //kx::radix_sort(hashSeqPair, hashSeqPair + elementsToSort, SequenceComparision());
 //    for(size_t i = 0; i < writePos; i++){
@@ -474,11 +834,22 @@ KmerPosition<T> * doComputation(size_t totalKmers, size_t split, size_t splits,
 //    }
     Debug(Debug::INFO) << timer.lap() << "\n";
 
+    if(tableMerge != NULL){
+        // the grouped k-mers are kept for the next update of the k-mer table
+        std::string groupedFile = tableMerge->groupedPrefix + SSTR(split);
+        FILE * handle = FileUtil::openFileOrDie(groupedFile.c_str(), "wb", false);
+        size_t written = fwrite(hashSeqPair, sizeof(KmerPosition<T, Compact>), writePos, handle);
+        if(fclose(handle) != 0 || written != writePos){
+            Debug(Debug::ERROR) << "Could not write k-mer table part " << groupedFile << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+    }
+
     if(splits > 1){
         if(Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)){
-            writeKmersToDisk<Parameters::DBTYPE_NUCLEOTIDES, KmerEntryRev, T>(splitFile, hashSeqPair, writePos + 1);
+            writeKmersToDisk<Parameters::DBTYPE_NUCLEOTIDES, KmerEntryRev, T, Compact>(splitFile, hashSeqPair, writePos + 1);
         }else{
-            writeKmersToDisk<Parameters::DBTYPE_AMINO_ACIDS, KmerEntry, T>(splitFile, hashSeqPair, writePos + 1);
+            writeKmersToDisk<Parameters::DBTYPE_AMINO_ACIDS, KmerEntry, T, Compact>(splitFile, hashSeqPair, writePos + 1);
         }
         delete [] hashSeqPair;
         hashSeqPair = NULL;
@@ -486,31 +857,67 @@ KmerPosition<T> * doComputation(size_t totalKmers, size_t split, size_t splits,
     return hashSeqPair;
 }
 
-template <int TYPE, typename T>
-size_t assignGroup(KmerPosition<T> *hashSeqPair, size_t splitKmerCount, bool includeOnlyExtendable, int covMode, float covThr) {
+// index of the longest sequence in the group of equal k-mers that starts at groupStart,
+// the first one (smallest id and position) if several are equally long
+template <int TYPE, typename T, bool Compact>
+size_t findLongestInGroup(KmerPosition<T, Compact> *hashSeqPair, size_t groupStart, const T * seqLens) {
+    // the default layout is already sorted by decreasing length within a group
+    if(Compact == false){
+        return groupStart;
+    }
+    size_t groupKmer = hashSeqPair[groupStart].getKmer();
+    if(TYPE == Parameters::DBTYPE_NUCLEOTIDES){
+        groupKmer = BIT_SET(groupKmer, 63);
+    }
+    size_t longest = groupStart;
+    if(groupKmer == SIZE_T_MAX){
+        return longest;
+    }
+    T longestLen = hashSeqPair[groupStart].getSeqLen(seqLens);
+    for(size_t i = groupStart + 1; ; i++){
+        size_t kmer = hashSeqPair[i].getKmer();
+        if(TYPE == Parameters::DBTYPE_NUCLEOTIDES){
+            kmer = BIT_SET(kmer, 63);
+        }
+        if(kmer != groupKmer){
+            break;
+        }
+        T len = hashSeqPair[i].getSeqLen(seqLens);
+        if(len > longestLen){
+            longest = i;
+            longestLen = len;
+        }
+    }
+    return longest;
+}
+
+template <int TYPE, typename T, bool Compact>
+size_t assignGroup(KmerPosition<T, Compact> *hashSeqPair, size_t splitKmerCount, bool includeOnlyExtendable, int covMode, float covThr,
+                   const T * seqLens) {
     size_t writePos=0;
-    size_t prevHash = hashSeqPair[0].kmer;
-    size_t repSeqId = hashSeqPair[0].id;
+    size_t prevHash = hashSeqPair[0].getKmer();
+    size_t repIdx = findLongestInGroup<TYPE>(hashSeqPair, 0, seqLens);
+    size_t repSeqId = hashSeqPair[repIdx].id;
     if(TYPE == Parameters::DBTYPE_NUCLEOTIDES){
-        bool isReverse = (BIT_CHECK(hashSeqPair[0].kmer, 63) == false);
+        bool isReverse = (BIT_CHECK(hashSeqPair[repIdx].getKmer(), 63) == false);
         repSeqId = (isReverse) ? BIT_CLEAR(repSeqId, 63) : BIT_SET(repSeqId, 63);
         prevHash = BIT_SET(prevHash, 63);
     }
     size_t prevHashStart = 0;
     size_t prevSetSize = 0;
-    T queryLen=hashSeqPair[0].seqLen;
+    T queryLen=hashSeqPair[repIdx].getSeqLen(seqLens);
     bool repIsReverse = false;
-    T repSeq_i_pos = hashSeqPair[0].pos;
+    T repSeq_i_pos = hashSeqPair[repIdx].pos;
     for (size_t elementIdx = 0; elementIdx < splitKmerCount+1; elementIdx++) {
-        size_t currKmer = hashSeqPair[elementIdx].kmer;
+        size_t currKmer = hashSeqPair[elementIdx].getKmer();
         if(TYPE == Parameters::DBTYPE_NUCLEOTIDES){
             currKmer = BIT_SET(currKmer, 63);
         }
         if (prevHash != currKmer) {
             for (size_t i = prevHashStart; i < elementIdx; i++) {
-                size_t kmer = hashSeqPair[i].kmer;
+                size_t kmer = hashSeqPair[i].getKmer();
                 if(TYPE == Parameters::DBTYPE_NUCLEOTIDES) {
-                    kmer = BIT_SET(hashSeqPair[i].kmer, 63);
+                    kmer = BIT_SET(hashSeqPair[i].getKmer(), 63);
                 }
                 size_t rId = (kmer != SIZE_T_MAX) ? ((prevSetSize == 1) ? SIZE_T_MAX : repSeqId) : SIZE_T_MAX;
                 // remove singletones from set
@@ -522,7 +929,7 @@ size_t assignGroup(KmerPosition<T> *hashSeqPair, size_t splitKmerCount, bool inc
                         //  10 Same here, we can revert query to match the not inverted target
                         //  11 Both are reverted so no problem!
                         //  So we need just 1 bit of information to encode all four states
-                        bool targetIsReverse = (BIT_CHECK(hashSeqPair[i].kmer, 63) == false);
+                        bool targetIsReverse = (BIT_CHECK(hashSeqPair[i].getKmer(), 63) == false);
                         bool queryNeedsToBeRev = false;
                         // we now need 2 byte of information (00),(01),(10),(11)
                         // we need to flip the coordinates of the query
@@ -539,13 +946,13 @@ size_t assignGroup(KmerPosition<T> *hashSeqPair, size_t splitKmerCount, bool inc
                             // we just need to offset the position to the forward strand
                         }else if (repIsReverse == true && targetIsReverse == true){
                             queryPos = (queryLen - 1) - repSeq_i_pos;
-                            targetPos = (hashSeqPair[i].seqLen - 1) - hashSeqPair[i].pos;
+                            targetPos = (hashSeqPair[i].getSeqLen(seqLens) - 1) - hashSeqPair[i].pos;
                             queryNeedsToBeRev = false;
                             // query is not revers but target k-mer is reverse
                             // instead of reverting the target, we revert the query and offset the the query/target position
                         }else if (repIsReverse == false && targetIsReverse == true){
                             queryPos = (queryLen - 1) - repSeq_i_pos;
-                            targetPos = (hashSeqPair[i].seqLen - 1) - hashSeqPair[i].pos;
+                            targetPos = (hashSeqPair[i].getSeqLen(seqLens) - 1) - hashSeqPair[i].pos;
                             queryNeedsToBeRev = true;
                             // both are forward, everything is good here
                         }else{
@@ -559,36 +966,36 @@ size_t assignGroup(KmerPosition<T> *hashSeqPair, size_t splitKmerCount, bool inc
 //                    std::cout << diagonal << "\t" << repSeq_i_pos << "\t" << hashSeqPair[i].pos << std::endl;
 
 
-                    bool canBeExtended = diagonal < 0 || (diagonal > (queryLen - hashSeqPair[i].seqLen));
+                    bool canBeExtended = diagonal < 0 || (diagonal > (queryLen - hashSeqPair[i].getSeqLen(seqLens)));
                     bool canBecovered = Util::canBeCovered(covThr, covMode,
                                                            static_cast<float>(queryLen),
-                                                           static_cast<float>(hashSeqPair[i].seqLen));
+                                                           static_cast<float>(hashSeqPair[i].getSeqLen(seqLens)));
                     if((includeOnlyExtendable == false && canBecovered) || (canBeExtended && includeOnlyExtendable ==true )){
-                        hashSeqPair[writePos].kmer = rId;
+                        hashSeqPair[writePos].setKmer(rId);
                         hashSeqPair[writePos].pos = diagonal;
-                        hashSeqPair[writePos].seqLen = hashSeqPair[i].seqLen;
+                        hashSeqPair[writePos].setSeqLen(hashSeqPair[i].getSeqLen(seqLens));
                         hashSeqPair[writePos].id = hashSeqPair[i].id;
                         writePos++;
                     }
                 }
-//                hashSeqPair[i].kmer = SIZE_T_MAX;
-                hashSeqPair[i].kmer = (i != writePos - 1) ? SIZE_T_MAX : hashSeqPair[i].kmer;
+                hashSeqPair[i].setKmer((i != writePos - 1) ? SIZE_T_MAX : hashSeqPair[i].getKmer());
             }
             prevSetSize = 0;
             prevHashStart = elementIdx;
-            repSeqId = hashSeqPair[elementIdx].id;
+            repIdx = findLongestInGroup<TYPE>(hashSeqPair, elementIdx, seqLens);
+            repSeqId = hashSeqPair[repIdx].id;
             if(TYPE == Parameters::DBTYPE_NUCLEOTIDES){
-                repIsReverse = (BIT_CHECK(hashSeqPair[elementIdx].kmer, 63) == 0);
+                repIsReverse = (BIT_CHECK(hashSeqPair[repIdx].getKmer(), 63) == 0);
                 repSeqId = (repIsReverse) ? repSeqId : BIT_SET(repSeqId, 63);
             }
-            queryLen = hashSeqPair[elementIdx].seqLen;
-            repSeq_i_pos = hashSeqPair[elementIdx].pos;
+            queryLen = hashSeqPair[repIdx].getSeqLen(seqLens);
+            repSeq_i_pos = hashSeqPair[repIdx].pos;
         }
-        if (hashSeqPair[elementIdx].kmer == SIZE_T_MAX) {
+        if (hashSeqPair[elementIdx].getKmer() == SIZE_T_MAX) {
             break;
         }
         prevSetSize++;
-        prevHash = hashSeqPair[elementIdx].kmer;
+        prevHash = hashSeqPair[elementIdx].getKmer();
         if(TYPE == Parameters::DBTYPE_NUCLEOTIDES){
             prevHash = BIT_SET(prevHash, 63);
         }
@@ -597,10 +1004,10 @@ size_t assignGroup(KmerPosition<T> *hashSeqPair, size_t splitKmerCount, bool inc
     return writePos;
 }
 
-template size_t assignGroup<0, short>(KmerPosition<short> *kmers, size_t splitKmerCount, bool includeOnlyExtendable, int covMode, float covThr);
-template size_t assignGroup<0, int>(KmerPosition<int> *kmers, size_t splitKmerCount, bool includeOnlyExtendable, int covMode, float covThr);
-template size_t assignGroup<1, short>(KmerPosition<short> *kmers, size_t splitKmerCount, bool includeOnlyExtendable, int covMode, float covThr);
-template size_t assignGroup<1, int>(KmerPosition<int> *kmers, size_t splitKmerCount, bool includeOnlyExtendable, int covMode, float covThr);
+template size_t assignGroup<0, short, false>(KmerPosition<short> *kmers, size_t splitKmerCount, bool includeOnlyExtendable, int covMode, float covThr, const short * seqLens);
+template size_t assignGroup<0, int, false>(KmerPosition<int> *kmers, size_t splitKmerCount, bool includeOnlyExtendable, int covMode, float covThr, const int * seqLens);
+template size_t assignGroup<1, short, false>(KmerPosition<short> *kmers, size_t splitKmerCount, bool includeOnlyExtendable, int covMode, float covThr, const short * seqLens);
+template size_t assignGroup<1, int, false>(KmerPosition<int> *kmers, size_t splitKmerCount, bool includeOnlyExtendable, int covMode, float covThr, const int * seqLens);
 
 void setLinearFilterDefault(Parameters *p) {
     p->spacedKmer = false;
@@ -622,12 +1029,50 @@ size_t computeKmerCount(DBReader<unsigned int> &reader, size_t KMER_SIZE, size_t
     }
     return totalKmers;
 }
-template <typename T>
+template <typename T, bool Compact>
 size_t computeMemoryNeededLinearfilter(size_t totalKmer) {
-    return sizeof(KmerPosition<T>) * totalKmer;
+    return sizeof(KmerPosition<T, Compact>) * totalKmer;
 }
 
-template <typename T>
+// extracts the k-mers of all splits in one pass over the database and scatters them by hash
+// into one partition file per split, so that each split does not have to re-read the database
+template <typename T, bool Compact>
+std::vector<std::string> extractKmerPartitions(size_t splits, size_t memoryLimit, DBReader<unsigned int> & seqDbr, Parameters & par,
+                                               BaseMatrix * subMat, size_t KMER_SIZE, size_t chooseTopKmer,
+                                               bool adjustLength, float chooseTopKmerScale, const char * extractKey) {
+    Debug(Debug::INFO) << "Generate k-mers list for all " << splits << " splits\n";
+    std::vector<std::string> partitionFiles;
+    KmerPartitions partitions;
+    for(size_t split = 0; split < splits; split++){
+        partitionFiles.push_back(par.db2 + "_partition_" + SSTR(split));
+        partitions.files.push_back(FileUtil::openFileOrDie(partitionFiles.back().c_str(), "wb", false));
+    }
+    partitions.kmerCounts.assign(splits, 0);
+    // the blocks of all threads and splits are held at the same time, they have to fit into
+    // the memory limit like the k-mers of one split (which are only allocated afterwards)
+    const size_t maxBlockSize = 16 * 1024;
+    partitions.blockSize = memoryLimit / (static_cast<size_t>(par.threads) * splits * sizeof(KmerPosition<T, Compact>));
+    partitions.blockSize = std::max(static_cast<size_t>(1), std::min(partitions.blockSize, maxBlockSize));
+    size_t kmerCount;
+    if(Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)){
+        std::pair<size_t, size_t > ret = fillKmerPositionArray<Parameters::DBTYPE_NUCLEOTIDES, T, Compact>(NULL, seqDbr, par, subMat, KMER_SIZE, chooseTopKmer, true, splits, 0, 1, adjustLength, chooseTopKmerScale, &partitions, extractKey);
+        kmerCount = ret.first;
+        Debug(Debug::INFO) << "\nAdjusted k-mer length " << ret.second << "\n";
+    }else{
+        std::pair<size_t, size_t > ret = fillKmerPositionArray<Parameters::DBTYPE_AMINO_ACIDS, T, Compact>(NULL, seqDbr, par, subMat, KMER_SIZE, chooseTopKmer, true, splits, 0, 1, false, chooseTopKmerScale, &partitions, extractKey);
+        kmerCount = ret.first;
+    }
+    for(size_t split = 0; split < splits; split++){
+        if(fclose(partitions.files[split]) != 0){
+            Debug(Debug::ERROR) << "Could not write k-mer partition " << partitionFiles[split] << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+    }
+    Debug(Debug::INFO) << "Wrote " << kmerCount << " k-mers into " << splits << " partitions\n";
+    return partitionFiles;
+}
+
+template <typename T, bool Compact>
 int kmermatcherInner(Parameters& par, DBReader<unsigned int>& seqDbr) {
 
     int querySeqType = seqDbr.getDbtype();
@@ -657,7 +1102,7 @@ int kmermatcherInner(Parameters& par, DBReader<unsigned int>& seqDbr) {
     }
     Debug(Debug::INFO) << "\n";
     size_t totalKmers = computeKmerCount(seqDbr, KMER_SIZE, chooseTopKmer, chooseTopKmerScale);
-    size_t totalSizeNeeded = computeMemoryNeededLinearfilter<T>(totalKmers);
+    size_t totalSizeNeeded = computeMemoryNeededLinearfilter<T, Compact>(totalKmers);
     Debug(Debug::INFO) << "Estimated memory consumption " << totalSizeNeeded/1024/1024 << " MB\n";
     // compute splits
     size_t splits = static_cast<size_t>(std::ceil(static_cast<float>(totalSizeNeeded) / memoryLimit));
@@ -670,7 +1115,96 @@ int kmermatcherInner(Parameters& par, DBReader<unsigned int>& seqDbr) {
         Debug(Debug::INFO) << "Process file into " << splits << " parts\n";
     }
     std::vector<std::string> splitFiles;
-    KmerPosition<T> *hashSeqPair = NULL;
+    KmerPosition<T, Compact> *hashSeqPair = NULL;
+
+    // the compact layout looks up the sequence length by key
+    std::vector<T> seqLens;
+    if(Compact){
+        seqLens.resize(seqDbr.getLastKey() + 1, 0);
+        for(size_t id = 0; id < seqDbr.getSize(); id++){
+            seqLens[seqDbr.getDbKey(id)] = static_cast<T>(std::min(seqDbr.getSeqLen(id), static_cast<size_t>(par.maxSeqLen)));
+        }
+    }
+    const T * seqLensPtr = (Compact) ? seqLens.data() : NULL;
+
+    // with a k-mer table only sequences that are missing from it are k-merized
+    KmerTableMerge tableMerge;
+    KmerTableMerge * tableMergePtr = NULL;
+    KmerTable::Header tableHeader = KmerTable::createHeader<T, Compact>(par, querySeqType);
+    std::vector<KmerTable::SequenceEntry> tableSequences;
+    if(par.kmerTable.empty() == false){
+        tableMergePtr = &tableMerge;
+        tableMerge.partPrefix = par.db2 + "_kmertable_";
+        tableMerge.groupedPrefix = par.db2 + "_kmertable_grouped_";
+        std::vector<size_t> sequenceHashes(seqDbr.getSize());
+#pragma omp parallel
+        {
+            unsigned int thread_idx = 0;
+#ifdef OPENMP
+            thread_idx = (unsigned int) omp_get_thread_num();
+#endif
+#pragma omp for schedule(static)
+            for(size_t id = 0; id < seqDbr.getSize(); id++){
+                sequenceHashes[id] = Util::hash(seqDbr.getData(id, thread_idx), seqDbr.getSeqLen(id));
+            }
+        }
+        KmerTable::Header previousHeader;
+        if(KmerTable::readSequences(par.kmerTable, tableHeader, tableSequences, previousHeader)){
+            tableMerge.previousTable = par.kmerTable;
+            tableMerge.reuseGroups = previousHeader.groupSplits == splits && previousHeader.covThr == tableHeader.covThr
+                                     && previousHeader.covMode == tableHeader.covMode
+                                     && previousHeader.includeOnlyExtendable == tableHeader.includeOnlyExtendable;
+            size_t maxKey = seqDbr.getLastKey();
+            for(size_t i = 0; i < tableSequences.size(); i++){
+                maxKey = std::max(maxKey, static_cast<size_t>(tableSequences[i].key));
+            }
+            std::vector<const KmerTable::SequenceEntry *> tableEntry(maxKey + 1, NULL);
+            tableMerge.previousLengths.assign(maxKey + 1, 0);
+            for(size_t i = 0; i < tableSequences.size(); i++){
+                tableEntry[tableSequences[i].key] = &tableSequences[i];
+                tableMerge.previousLengths[tableSequences[i].key] = std::min(tableSequences[i].length, static_cast<unsigned int>(par.maxSeqLen));
+            }
+            tableMerge.extractKey.assign(seqDbr.getLastKey() + 1, true);
+            tableMerge.keepKey.assign(maxKey + 1, false);
+            size_t keptSequences = 0;
+            for(size_t id = 0; id < seqDbr.getSize(); id++){
+                unsigned int key = seqDbr.getDbKey(id);
+                // a sequence is reused if its key, length and content are unchanged
+                const KmerTable::SequenceEntry * entry = tableEntry[key];
+                if(entry != NULL && entry->length == static_cast<unsigned int>(seqDbr.getSeqLen(id))
+                   && entry->hash == sequenceHashes[id]){
+                    tableMerge.keepKey[key] = true;
+                    tableMerge.extractKey[key] = false;
+                    keptSequences++;
+                }
+            }
+            Debug(Debug::INFO) << "K-mer table contains " << keptSequences << " of " << seqDbr.getSize() << " sequences\n";
+            if(tableMerge.reuseGroups == false){
+                Debug(Debug::INFO) << "Grouped k-mers of the k-mer table were created with different grouping parameters or splits and are grouped again\n";
+            }
+        }
+        tableSequences.clear();
+        for(size_t id = 0; id < seqDbr.getSize(); id++){
+            KmerTable::SequenceEntry entry;
+            entry.key = seqDbr.getDbKey(id);
+            entry.length = static_cast<unsigned int>(seqDbr.getSeqLen(id));
+            entry.hash = sequenceHashes[id];
+            tableSequences.push_back(entry);
+        }
+        std::sort(tableSequences.begin(), tableSequences.end(),
+                  [](const KmerTable::SequenceEntry & a, const KmerTable::SequenceEntry & b) { return a.key < b.key; });
+    }
+    if(tableMerge.previousTable.empty() == false){
+        const bool isNucleotide = Parameters::isEqualDbtype(querySeqType, Parameters::DBTYPE_NUCLEOTIDES);
+        tableMerge.splitKmerCounts.assign(splits, 0);
+        KmerTable::forEachKmer<T, Compact>(tableMerge.previousTable, [&](const KmerPosition<T, Compact> & kmer) {
+            if(kmer.id < tableMerge.keepKey.size() && tableMerge.keepKey[kmer.id]){
+                size_t split = (isNucleotide) ? kmerSplit<Parameters::DBTYPE_NUCLEOTIDES>(kmer.getKmer(), splits)
+                                              : kmerSplit<Parameters::DBTYPE_AMINO_ACIDS>(kmer.getKmer(), splits);
+                tableMerge.splitKmerCounts[split]++;
+            }
+        });
+    }
 
     size_t mpiRank = 0;
 #ifdef HAVE_MPI
@@ -693,7 +1227,7 @@ int kmermatcherInner(Parameters& par, DBReader<unsigned int>& seqDbr) {
 
     for(size_t split = fromSplit; split < fromSplit+splitCount; split++) {
         std::string splitFileName = par.db2 + "_split_" +SSTR(split);
-        hashSeqPair = doComputation<T>(totalKmers, split, splits, splitFileName, seqDbr, par, subMat, KMER_SIZE, chooseTopKmer, par.adjustKmerLength, chooseTopKmerScale);
+        hashSeqPair = doComputation<T, Compact>(totalKmers, split, splits, splitFileName, seqDbr, par, subMat, KMER_SIZE, chooseTopKmer, par.adjustKmerLength, chooseTopKmerScale, "", seqLensPtr);
     }
     MPI_Barrier(MPI_COMM_WORLD);
     if(mpiRank == 0){
@@ -703,22 +1237,56 @@ int kmermatcherInner(Parameters& par, DBReader<unsigned int>& seqDbr) {
         }
     }
 #else
+    std::vector<std::string> partitionFiles;
+    if(splits > 1){
+        bool allDone = true;
+        for(size_t split = 0; split < splits; split++) {
+            std::string splitFileNameDone = par.db2 + "_split_" + SSTR(split) + ".done";
+            allDone &= FileUtil::fileExists(splitFileNameDone.c_str());
+        }
+        if(allDone == false){
+            const char * extractKey = (tableMerge.previousTable.empty() == false) ? tableMerge.extractKey.data() : NULL;
+            partitionFiles = extractKmerPartitions<T, Compact>(splits, memoryLimit, seqDbr, par, subMat, KMER_SIZE, chooseTopKmer, par.adjustKmerLength, chooseTopKmerScale, extractKey);
+        }
+    }
     for(size_t split = 0; split < splits; split++) {
         std::string splitFileName = par.db2 + "_split_" +SSTR(split);
 
         std::string splitFileNameDone = splitFileName + ".done";
         if(FileUtil::fileExists(splitFileNameDone.c_str()) == false){
-            hashSeqPair = doComputation<T>(totalKmers, split, splits, splitFileName, seqDbr, par, subMat, KMER_SIZE, chooseTopKmer, par.adjustKmerLength, chooseTopKmerScale);
+            std::string partitionFile = partitionFiles.empty() ? "" : partitionFiles[split];
+            hashSeqPair = doComputation<T, Compact>(totalKmers, split, splits, splitFileName, seqDbr, par, subMat, KMER_SIZE, chooseTopKmer, par.adjustKmerLength, chooseTopKmerScale, partitionFile, seqLensPtr, tableMergePtr);
+        } else if(partitionFiles.empty() == false){
+            FileUtil::remove(partitionFiles[split].c_str());
         }
 
         splitFiles.push_back(splitFileName);
     }
+    if(tableMergePtr != NULL){
+        Timer timer;
+        std::vector<std::string> parts;
+        std::vector<std::string> groupedParts;
+        for(size_t split = 0; split < splits; split++) {
+            parts.push_back(tableMerge.partPrefix + SSTR(split));
+            groupedParts.push_back(tableMerge.groupedPrefix + SSTR(split));
+        }
+        if(Parameters::isEqualDbtype(querySeqType, Parameters::DBTYPE_NUCLEOTIDES)) {
+            KmerTable::write<T, Compact>(par.kmerTable, tableHeader, tableSequences, parts, groupedParts, KmerPosition<T, Compact>::compareRepSequenceAndIdAndPosReverse);
+        }else{
+            KmerTable::write<T, Compact>(par.kmerTable, tableHeader, tableSequences, parts, groupedParts, KmerPosition<T, Compact>::compareRepSequenceAndIdAndPos);
+        }
+        for(size_t split = 0; split < splits; split++) {
+            FileUtil::remove(parts[split].c_str());
+            FileUtil::remove(groupedParts[split].c_str());
+        }
+        Debug(Debug::INFO) << "Time for writing k-mer table: " << timer.lap() << "\n";
+    }
 #endif
     if(mpiRank == 0){
         std::vector<char> repSequence(seqDbr.getLastKey()+1);
         std::fill(repSequence.begin(), repSequence.end(), false);
         // write result
-        DBWriter dbw(par.db2.c_str(), par.db2Index.c_str(), 1, par.compressed,
+        DBWriter dbw(par.db2.c_str(), par.db2Index.c_str(), par.threads, par.compressed,
                      (Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)) ? Parameters::DBTYPE_PREFILTER_REV_RES : Parameters::DBTYPE_PREFILTER_RES );
         dbw.open();
 
@@ -726,9 +1294,9 @@ int kmermatcherInner(Parameters& par, DBReader<unsigned int>& seqDbr) {
         if(splits > 1) {
             seqDbr.unmapData();
             if(Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)) {
-                mergeKmerFilesAndOutput<Parameters::DBTYPE_NUCLEOTIDES, KmerEntryRev>(dbw, splitFiles, repSequence);
+                mergeKmerFilesAndOutput<Parameters::DBTYPE_NUCLEOTIDES, KmerEntryRev>(dbw, splitFiles, repSequence, par.threads);
             }else{
-                mergeKmerFilesAndOutput<Parameters::DBTYPE_AMINO_ACIDS, KmerEntry>(dbw, splitFiles, repSequence);
+                mergeKmerFilesAndOutput<Parameters::DBTYPE_AMINO_ACIDS, KmerEntry>(dbw, splitFiles, repSequence, par.threads);
             }
             for(size_t i = 0; i < splitFiles.size(); i++){
                 FileUtil::remove(splitFiles[i].c_str());
@@ -777,12 +1345,34 @@ int kmermatcherInner(Parameters& par, DBReader<unsigned int>& seqDbr) {
     return EXIT_SUCCESS;
 }
 
+// the compact k-mer record can be used if all k-mer indices and the sequence hash k-mer fit into its 47 bits
+bool kmersFitCompactLayout(Parameters & par, int seqType) {
+    const bool isNucleotide = Parameters::isEqualDbtype(seqType, Parameters::DBTYPE_NUCLEOTIDES);
+    const size_t alphabetSize = (isNucleotide) ? 5 : static_cast<size_t>(par.alphabetSize);
+    const size_t kmerLen = (isNucleotide && par.adjustKmerLength) ? std::min(par.kmerSize + 5, 23) : par.kmerSize;
+    const size_t limit = KmerPosition<short, true>::MAX_KMER - UINT_MAX;
+    size_t highestKmer = 1;
+    for (size_t i = 0; i < kmerLen; i++) {
+        highestKmer *= alphabetSize;
+        if (highestKmer >= limit) {
+            return false;
+        }
+    }
+    return true;
+}
+
 int kmermatcher(int argc, const char **argv, const Command &command) {
     MMseqsMPI::init(argc, argv);
 
     Parameters &par = Parameters::getInstance();
     setLinearFilterDefault(&par);
     par.parseParameters(argc, argv, command, true, 0, MMseqsParameter::COMMAND_CLUSTLINEAR);
+#ifdef HAVE_MPI
+    if (par.kmerTable.empty() == false) {
+        Debug(Debug::ERROR) << "--kmer-table is not supported with MPI\n";
+        EXIT(EXIT_FAILURE);
+    }
+#endif
 
     DBReader<unsigned int> seqDbr(par.db1.c_str(), par.db1Index.c_str(), par.threads,
                                   DBReader<unsigned int>::USE_INDEX | DBReader<unsigned int>::USE_DATA);
@@ -794,11 +1384,14 @@ int kmermatcher(int argc, const char **argv, const Command &command) {
     par.printParameters(command.cmd, argc, argv, *params);
     Debug(Debug::INFO) << "Database size: " << seqDbr.getSize() << " type: " << seqDbr.getDbTypeName() << "\n";
 
-    if (seqDbr.getMaxSeqLen() < SHRT_MAX) {
-        kmermatcherInner<short>(par, seqDbr);
+    if (seqDbr.getMaxSeqLen() < SHRT_MAX && kmersFitCompactLayout(par, querySeqType)) {
+        kmermatcherInner<short, true>(par, seqDbr);
+    }
+    else if (seqDbr.getMaxSeqLen() < SHRT_MAX) {
+        kmermatcherInner<short, false>(par, seqDbr);
     }
     else {
-        kmermatcherInner<int>(par, seqDbr);
+        kmermatcherInner<int, false>(par, seqDbr);
     }
 
     seqDbr.close();
@@ -806,20 +1399,20 @@ int kmermatcher(int argc, const char **argv, const Command &command) {
     return EXIT_SUCCESS;
 }
 
-template <int TYPE, typename T>
+template <int TYPE, typename T, bool Compact>
 void writeKmerMatcherResult(DBWriter & dbw,
-                            KmerPosition<T> *hashSeqPair, size_t totalKmers,
+                            KmerPosition<T, Compact> *hashSeqPair, size_t totalKmers,
                             std::vector<char> &repSequence, size_t threads) {
     std::vector<size_t> threadOffsets;
     size_t splitSize = totalKmers/threads;
     threadOffsets.push_back(0);
     for(size_t thread = 1; thread < threads; thread++){
-        size_t kmer = hashSeqPair[thread*splitSize].kmer;
+        size_t kmer = hashSeqPair[thread*splitSize].getKmer();
         size_t repSeqId = static_cast<size_t>(kmer);
         repSeqId=BIT_SET(repSeqId, 63);
         bool wasSet = false;
         for(size_t pos = thread*splitSize; pos < totalKmers; pos++){
-            size_t currSeqId = hashSeqPair[pos].kmer;
+            size_t currSeqId = hashSeqPair[pos].getKmer();
             currSeqId=BIT_SET(currSeqId, 63);
             if(repSeqId != currSeqId){
                 wasSet = true;
@@ -841,8 +1434,8 @@ void writeKmerMatcherResult(DBWriter & dbw,
         unsigned int writeSets = 0;
         size_t kmerPos=0;
         size_t repSeqId = SIZE_T_MAX;
-        for(kmerPos = threadOffsets[thread]; kmerPos < threadOffsets[thread+1] && hashSeqPair[kmerPos].kmer != SIZE_T_MAX; kmerPos++){
-            size_t currKmer = hashSeqPair[kmerPos].kmer;
+        for(kmerPos = threadOffsets[thread]; kmerPos < threadOffsets[thread+1] && hashSeqPair[kmerPos].getKmer() != SIZE_T_MAX; kmerPos++){
+            size_t currKmer = hashSeqPair[kmerPos].getKmer();
             int reverMask = 0;
             if(TYPE == Parameters::DBTYPE_NUCLEOTIDES){
                 reverMask  = BIT_CHECK(currKmer, 63)==false;
@@ -881,8 +1474,8 @@ void writeKmerMatcherResult(DBWriter & dbw,
             while(lastTargetId != targetId
                   && kmerPos+kmerOffset < threadOffsets[thread+1]
                   && hashSeqPair[kmerPos+kmerOffset].id == targetId
-                  && ((TYPE ==Parameters::DBTYPE_NUCLEOTIDES)? BIT_CLEAR(hashSeqPair[kmerPos+kmerOffset].kmer, 63):
-                      hashSeqPair[kmerPos+kmerOffset].kmer) == repSeqId){
+                  && ((TYPE ==Parameters::DBTYPE_NUCLEOTIDES)? BIT_CLEAR(hashSeqPair[kmerPos+kmerOffset].getKmer(), 63):
+                      hashSeqPair[kmerPos+kmerOffset].getKmer()) == repSeqId){
 
                  if(prevDiagonal == hashSeqPair[kmerPos+kmerOffset].pos){
                      diagonalCnt++;
@@ -893,7 +1486,7 @@ void writeKmerMatcherResult(DBWriter & dbw,
                      diagonal = hashSeqPair[kmerPos+kmerOffset].pos;
                      maxDiagonal = diagonalCnt;
                      if(TYPE == Parameters::DBTYPE_NUCLEOTIDES){
-                         bestReverMask = BIT_CHECK(hashSeqPair[kmerPos+kmerOffset].kmer, 63) == false;
+                         bestReverMask = BIT_CHECK(hashSeqPair[kmerPos+kmerOffset].getKmer(), 63) == false;
                      }
                  }
                 prevDiagonal = hashSeqPair[kmerPos+kmerOffset].pos;
@@ -948,37 +1541,15 @@ size_t queueNextEntry(KmerPositionQueue &queue, int file, size_t offsetPos, T *e
 }
 
 template <int TYPE, typename T>
-void mergeKmerFilesAndOutput(DBWriter & dbw,
-                             std::vector<std::string> tmpFiles,
-                             std::vector<char> &repSequence) {
-    Debug(Debug::INFO) << "Merge splits ... ";
-
-    const int fileCnt = tmpFiles.size();
-    FILE ** files       = new FILE*[fileCnt];
-    T **entries = new T*[fileCnt];
-    size_t * entrySizes = new size_t[fileCnt];
-    size_t * offsetPos  = new size_t[fileCnt];
-    size_t * dataSizes  = new size_t[fileCnt];
-    // init structures
-    for(size_t file = 0; file < tmpFiles.size(); file++){
-        files[file] = FileUtil::openFileOrDie(tmpFiles[file].c_str(),"r",true);
-        size_t dataSize;
-        entries[file]    = (T*)FileUtil::mmapFile(files[file], &dataSize);
-#if HAVE_POSIX_MADVISE
-        if (posix_madvise (entries[file], dataSize, POSIX_MADV_SEQUENTIAL) != 0){
-            Debug(Debug::ERROR) << "posix_madvise returned an error for file " << tmpFiles[file] << "\n";
-        }
-#endif
-        dataSizes[file]  = dataSize;
-        entrySizes[file] = dataSize/sizeof(T);
-    }
+void mergeKmerRange(DBWriter & dbw, T **entries, size_t *offsetPos, size_t *entrySizes, int fileCnt,
+                    std::vector<char> &repSequence, unsigned int thread) {
     KmerPositionQueue queue;
     // read one entry for each file
     for(int file = 0; file < fileCnt; file++ ){
-        offsetPos[file] = queueNextEntry<TYPE,T>(queue, file, 0, entries[file], entrySizes[file]);
+        offsetPos[file] = queueNextEntry<TYPE,T>(queue, file, offsetPos[file], entries[file], entrySizes[file]);
     }
     std::string prefResultsOutString;
-    prefResultsOutString.reserve(100000000);
+    prefResultsOutString.reserve(1000000);
     char buffer[100];
     FileKmerPosition res;
     bool hasRepSeq =  repSequence.size()>0;
@@ -1009,7 +1580,7 @@ void mergeKmerFilesAndOutput(DBWriter & dbw,
         if(res.id == UINT_MAX) {
             offsetPos[res.file] = queueNextEntry<TYPE,T>(queue, res.file, offsetPos[res.file],
                                                          entries[res.file], entrySizes[res.file]);
-            dbw.writeData(prefResultsOutString.c_str(), prefResultsOutString.length(), res.repSeq, 0);
+            dbw.writeData(prefResultsOutString.c_str(), prefResultsOutString.length(), res.repSeq, thread);
             if(hasRepSeq){
                 repSequence[res.repSeq]=true;
             }
@@ -1081,9 +1652,103 @@ void mergeKmerFilesAndOutput(DBWriter & dbw,
         int len = QueryMatcher::prefilterHitToBuffer(buffer, h);
         prefResultsOutString.append(buffer, len);
     }
+}
+
+template <int TYPE, typename T>
+void mergeKmerFilesAndOutput(DBWriter & dbw,
+                             std::vector<std::string> tmpFiles,
+                             std::vector<char> &repSequence,
+                             unsigned int threads) {
+    Debug(Debug::INFO) << "Merge splits ... ";
+
+    const int fileCnt = tmpFiles.size();
+    FILE ** files       = new FILE*[fileCnt];
+    T **entries = new T*[fileCnt];
+    size_t * entrySizes = new size_t[fileCnt];
+    size_t * dataSizes  = new size_t[fileCnt];
+    // init structures
+    for(size_t file = 0; file < tmpFiles.size(); file++){
+        files[file] = FileUtil::openFileOrDie(tmpFiles[file].c_str(),"r",true);
+        size_t dataSize = FileUtil::getFileSize(tmpFiles[file]);
+        entries[file] = NULL;
+        if(dataSize > 0){
+            entries[file] = (T*)FileUtil::mmapFile(files[file], &dataSize);
+#if HAVE_POSIX_MADVISE
+            if (posix_madvise (entries[file], dataSize, POSIX_MADV_SEQUENTIAL) != 0){
+                Debug(Debug::ERROR) << "posix_madvise returned an error for file " << tmpFiles[file] << "\n";
+            }
+#endif
+        }
+        dataSizes[file]  = dataSize;
+        entrySizes[file] = dataSize/sizeof(T);
+    }
+
+    // every file is a list of rep. sequence groups sorted by the rep. sequence id
+    std::vector<std::vector<size_t> > groupStarts(fileCnt);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(threads)
+    for(int file = 0; file < fileCnt; file++){
+        size_t pos = 0;
+        while(pos + 1 < entrySizes[file]){
+            groupStarts[file].push_back(pos);
+            while(entries[file][pos].seqId != UINT_MAX){
+                pos++;
+            }
+            pos++;
+        }
+    }
+
+    // split the rep. sequence id space at sampled group keys, so that every range is merged independently
+    const size_t rangeCnt = (threads > 1) ? threads * 4 : 1;
+    std::vector<size_t> splitters;
+    size_t groupCnt = 0;
+    for(int file = 0; file < fileCnt; file++){
+        groupCnt += groupStarts[file].size();
+    }
+    const size_t sampleStride = std::max(static_cast<size_t>(1), groupCnt / (rangeCnt * 64));
+    for(int file = 0; file < fileCnt; file++){
+        for(size_t group = 0; group < groupStarts[file].size(); group += sampleStride){
+            splitters.push_back(entries[file][groupStarts[file][group]].seqId);
+        }
+    }
+    std::sort(splitters.begin(), splitters.end());
+    std::vector<size_t> rangeBounds(1, 0);
+    for(size_t range = 1; range < rangeCnt && splitters.empty() == false; range++){
+        size_t key = splitters[(splitters.size() * range) / rangeCnt];
+        if(key > rangeBounds.back()){
+            rangeBounds.push_back(key);
+        }
+    }
+    rangeBounds.push_back(SIZE_T_MAX);
+
+#pragma omp parallel num_threads(threads)
+    {
+        unsigned int thread_idx = 0;
+#ifdef OPENMP
+        thread_idx = static_cast<unsigned int>(omp_get_thread_num());
+#endif
+        size_t * offsetPos = new size_t[fileCnt];
+        size_t * rangeEnds = new size_t[fileCnt];
+#pragma omp for schedule(dynamic, 1)
+        for(size_t range = 0; range < rangeBounds.size() - 1; range++){
+            for(int file = 0; file < fileCnt; file++){
+                const std::vector<size_t> & starts = groupStarts[file];
+                const T * fileEntries = entries[file];
+                size_t first = std::lower_bound(starts.begin(), starts.end(), rangeBounds[range],
+                                                [fileEntries](size_t pos, size_t key) { return fileEntries[pos].seqId < key; }) - starts.begin();
+                size_t last = std::lower_bound(starts.begin() + first, starts.end(), rangeBounds[range + 1],
+                                               [fileEntries](size_t pos, size_t key) { return fileEntries[pos].seqId < key; }) - starts.begin();
+                offsetPos[file] = (first < starts.size()) ? starts[first] : entrySizes[file];
+                rangeEnds[file] = (last < starts.size()) ? starts[last] : entrySizes[file];
+            }
+            mergeKmerRange<TYPE, T>(dbw, entries, offsetPos, rangeEnds, fileCnt, repSequence, thread_idx);
+        }
+        delete [] offsetPos;
+        delete [] rangeEnds;
+    }
+
     for(size_t file = 0; file < tmpFiles.size(); file++) {
         fclose(files[file]);
-        if(munmap((void*)entries[file], dataSizes[file]) < 0){
+        if(entries[file] != NULL && munmap((void*)entries[file], dataSizes[file]) < 0){
             Debug(Debug::ERROR) << "Failed to munmap memory dataSize=" << dataSizes[file] <<"\n";
             EXIT(EXIT_FAILURE);
         }
@@ -1091,15 +1756,14 @@ void mergeKmerFilesAndOutput(DBWriter & dbw,
 
 
     delete [] dataSizes;
-    delete [] offsetPos;
     delete [] entries;
     delete [] entrySizes;
     delete [] files;
 }
 
 
-template <int TYPE, typename T, typename seqLenType>
-void writeKmersToDisk(std::string tmpFile, KmerPosition<seqLenType> *hashSeqPair, size_t totalKmers) {
+template <int TYPE, typename T, typename seqLenType, bool Compact>
+void writeKmersToDisk(std::string tmpFile, KmerPosition<seqLenType, Compact> *hashSeqPair, size_t totalKmers) {
     size_t repSeqId = SIZE_T_MAX;
     size_t lastTargetId = SIZE_T_MAX;
     seqLenType lastDiagonal=0;
@@ -1114,8 +1778,8 @@ void writeKmersToDisk(std::string tmpFile, KmerPosition<seqLenType> *hashSeqPair
     T nullEntry;
     nullEntry.seqId=UINT_MAX;
     nullEntry.diagonal=0;
-    for(size_t kmerPos = 0; kmerPos < totalKmers && hashSeqPair[kmerPos].kmer != SIZE_T_MAX; kmerPos++){
-        size_t currKmer=hashSeqPair[kmerPos].kmer;
+    for(size_t kmerPos = 0; kmerPos < totalKmers && hashSeqPair[kmerPos].getKmer() != SIZE_T_MAX; kmerPos++){
+        size_t currKmer=hashSeqPair[kmerPos].getKmer();
         if(TYPE == Parameters::DBTYPE_NUCLEOTIDES){
             currKmer = BIT_CLEAR(currKmer, 63);
         }
@@ -1134,7 +1798,7 @@ void writeKmersToDisk(std::string tmpFile, KmerPosition<seqLenType> *hashSeqPair
             writeBuffer[bufferPos].score = 0;
             writeBuffer[bufferPos].diagonal = 0;
             if(TYPE == Parameters::DBTYPE_NUCLEOTIDES){
-                bool isReverse = BIT_CHECK(hashSeqPair[kmerPos].kmer, 63)==false;
+                bool isReverse = BIT_CHECK(hashSeqPair[kmerPos].getKmer(), 63)==false;
                 writeBuffer[bufferPos].setReverse(isReverse);
             }
             bufferPos++;
@@ -1150,12 +1814,12 @@ void writeKmersToDisk(std::string tmpFile, KmerPosition<seqLenType> *hashSeqPair
             lastTargetId = hashSeqPair[kmerPos].id;
             lastDiagonal = hashSeqPair[kmerPos].pos;
             if(TYPE == Parameters::DBTYPE_NUCLEOTIDES){
-                bool isReverse  = BIT_CHECK(hashSeqPair[kmerPos].kmer, 63)==false;
+                bool isReverse  = BIT_CHECK(hashSeqPair[kmerPos].getKmer(), 63)==false;
                 forward += isReverse == false;
                 reverse += isReverse == true;
             }
             kmerPos++;
-        }while(targetId == hashSeqPair[kmerPos].id && hashSeqPair[kmerPos].pos == diagonal && kmerPos < totalKmers && hashSeqPair[kmerPos].kmer != SIZE_T_MAX);
+        }while(targetId == hashSeqPair[kmerPos].id && hashSeqPair[kmerPos].pos == diagonal && kmerPos < totalKmers && hashSeqPair[kmerPos].getKmer() != SIZE_T_MAX);
         kmerPos--;
 
         elemenetCnt++;
@@ -1221,7 +1885,9 @@ template std::pair<size_t, size_t>  fillKmerPositionArray<0, short>(KmerPosition
                                                              bool includeIdenticalKmer, size_t splits, size_t split,
                                                              size_t pickNBest,
                                                              bool adjustKmerLength,
-                                                             float chooseTopKmerScale);
+                                                             float chooseTopKmerScale,
+                                                             KmerPartitions * partitions,
+                                                             const char * extractKey);
 template std::pair<size_t, size_t>  fillKmerPositionArray<1, short>(KmerPosition<short> * hashSeqPair,
                                                              DBReader<unsigned int> &seqDbr,
                                                              Parameters & par, BaseMatrix * subMat,
@@ -1229,7 +1895,9 @@ template std::pair<size_t, size_t>  fillKmerPositionArray<1, short>(KmerPosition
                                                              bool includeIdenticalKmer, size_t splits, size_t split,
                                                              size_t pickNBest,
                                                              bool adjustKmerLength,
-                                                             float chooseTopKmerScale);
+                                                             float chooseTopKmerScale,
+                                                             KmerPartitions * partitions,
+                                                             const char * extractKey);
 template std::pair<size_t, size_t>  fillKmerPositionArray<2, short>(KmerPosition<short> * hashSeqPair,
                                                              DBReader<unsigned int> &seqDbr,
                                                              Parameters & par, BaseMatrix * subMat,
@@ -1237,7 +1905,9 @@ template std::pair<size_t, size_t>  fillKmerPositionArray<2, short>(KmerPosition
                                                              bool includeIdenticalKmer, size_t splits, size_t split,
                                                              size_t pickNBest,
                                                              bool adjustKmerLength,
-                                                             float chooseTopKmerScale);
+                                                             float chooseTopKmerScale,
+                                                             KmerPartitions * partitions,
+                                                             const char * extractKey);
 template std::pair<size_t, size_t>  fillKmerPositionArray<0, int>(KmerPosition<int> * hashSeqPair,
                                                              DBReader<unsigned int> &seqDbr,
                                                              Parameters & par, BaseMatrix * subMat,
@@ -1245,7 +1915,9 @@ template std::pair<size_t, size_t>  fillKmerPositionArray<0, int>(KmerPosition<i
                                                              bool includeIdenticalKmer, size_t splits, size_t split,
                                                              size_t pickNBest,
                                                              bool adjustKmerLength,
-                                                             float chooseTopKmerScale);
+                                                             float chooseTopKmerScale,
+                                                             KmerPartitions * partitions,
+                                                             const char * extractKey);
 template std::pair<size_t, size_t>  fillKmerPositionArray<1, int>(KmerPosition <int>* hashSeqPair,
                                                              DBReader<unsigned int> &seqDbr,
                                                              Parameters & par, BaseMatrix * subMat,
@@ -1253,7 +1925,9 @@ template std::pair<size_t, size_t>  fillKmerPositionArray<1, int>(KmerPosition <
                                                              bool includeIdenticalKmer, size_t splits, size_t split,
                                                              size_t pickNBest,
                                                              bool adjustKmerLength,
-                                                             float chooseTopKmerScale);
+                                                             float chooseTopKmerScale,
+                                                             KmerPartitions * partitions,
+                                                             const char * extractKey);
 template std::pair<size_t, size_t>  fillKmerPositionArray<2, int>(KmerPosition< int> * hashSeqPair,
                                                              DBReader<unsigned int> &seqDbr,
                                                              Parameters & par, BaseMatrix * subMat,
@@ -1261,7 +1935,9 @@ template std::pair<size_t, size_t>  fillKmerPositionArray<2, int>(KmerPosition<
                                                              bool includeIdenticalKmer, size_t splits, size_t split,
                                                              size_t pickNBest,
                                                              bool adjustKmerLength,
-                                                             float chooseTopKmerScale);
+                                                             float chooseTopKmerScale,
+                                                             KmerPartitions * partitions,
+                                                             const char * extractKey);
 
 template KmerPosition<short> *initKmerPositionMemory(size_t size);
 template KmerPosition<int> *initKmerPositionMemory(size_t size);
@@ -1,5 +1,7 @@
 #ifndef MMSEQS_KMERMATCHER_H
 #define MMSEQS_KMERMATCHER_H
+#include <algorithm>
+#include <cmath>
 #include <queue>
 #include "DBWriter.h"
 #include "Util.h"
@@ -7,13 +9,30 @@
 #include "Parameters.h"
 #include "BaseMatrix.h"
 
-template <typename T>
+template <typename T, bool Compact = false>
 struct __attribute__((__packed__))KmerPosition {
     size_t kmer;
     unsigned int id;
     T seqLen;
     T pos;
 
+    // accessors shared with the compact layout
+    size_t getKmer() const {
+        return kmer;
+    }
+
+    void setKmer(size_t value) {
+        kmer = value;
+    }
+
+    T getSeqLen(const T *) const {
+        return seqLen;
+    }
+
+    void setSeqLen(T value) {
+        seqLen = value;
+    }
+
     static bool compareRepSequenceAndIdAndPos(const KmerPosition<T> &first, const KmerPosition<T> &second){
         if(first.kmer < second.kmer )
             return true;
@@ -91,7 +110,98 @@ struct __attribute__((__packed__))KmerPosition {
     }
 };
 
+// 12 byte k-mer record (with T = short) for databases whose k-mers fit into 47 bits.
+// The k-mer (or rep. sequence id after assignGroup) is stored in 48 bits, the reverse
+// flag of nucleotide k-mers (bit 63) moves to bit 47. The sequence length is not stored,
+// it is looked up by id. Records with the same k-mer are therefore not sorted by length,
+// assignGroup searches the longest sequence of each group instead.
+template <typename T>
+struct __attribute__((__packed__))KmerPosition<T, true> {
+    unsigned int kmerLow;
+    unsigned short kmerHigh;
+    unsigned int id;
+    T pos;
+
+    static const size_t KMER_BITS = 48;
+    static const size_t MAX_RAW = (1ULL << KMER_BITS) - 1;
+    static const size_t REVERSE_BIT = KMER_BITS - 1;
+
+    // k-mers have to be smaller than this to be stored in the compact record
+    static const size_t MAX_KMER = (1ULL << REVERSE_BIT) - 1;
+
+    size_t getRaw() const {
+        return (static_cast<size_t>(kmerHigh) << 32) | kmerLow;
+    }
+
+    size_t getKmer() const {
+        size_t raw = getRaw();
+        if (raw == MAX_RAW) {
+            return static_cast<size_t>(-1);
+        }
+        return BIT_CHECK(raw, REVERSE_BIT) ? BIT_SET(BIT_CLEAR(raw, REVERSE_BIT), 63) : raw;
+    }
+
+    void setKmer(size_t value) {
+        size_t raw = MAX_RAW;
+        if (value != static_cast<size_t>(-1)) {
+            raw = BIT_CLEAR(value, 63) & MAX_KMER;
+            raw = BIT_CHECK(value, 63) ? BIT_SET(raw, REVERSE_BIT) : raw;
+        }
+        kmerLow = static_cast<unsigned int>(raw);
+        kmerHigh = static_cast<unsigned short>(raw >> 32);
+    }
+
+    T getSeqLen(const T * seqLens) const {
+        // unused records are filled with 0xFF
+        return (id == UINT_MAX) ? -1 : seqLens[id];
+    }
+
+    void setSeqLen(T) {}
+
+    static bool compareRepSequenceAndIdAndPos(const KmerPosition<T, true> &first, const KmerPosition<T, true> &second){
+        size_t firstKmer  = first.getRaw();
+        size_t secondKmer = second.getRaw();
+        if(firstKmer < secondKmer)
+            return true;
+        if(secondKmer < firstKmer)
+            return false;
+        if(first.id < second.id)
+            return true;
+        if(second.id < first.id)
+            return false;
+        if(first.pos < second.pos)
+            return true;
+        if(second.pos < first.pos)
+            return false;
+        return false;
+    }
+
+    static bool compareRepSequenceAndIdAndPosReverse(const KmerPosition<T, true> &first, const KmerPosition<T, true> &second){
+        size_t firstKmer  = BIT_SET(first.getRaw(), REVERSE_BIT);
+        size_t secondKmer = BIT_SET(second.getRaw(), REVERSE_BIT);
+        if(firstKmer < secondKmer)
+            return true;
+        if(secondKmer < firstKmer)
+            return false;
+        if(first.id < second.id)
+            return true;
+        if(second.id < first.id)
+            return false;
+        if(first.pos < second.pos)
+            return true;
+        if(second.pos < first.pos)
+            return false;
+        return false;
+    }
+
+    static bool compareRepSequenceAndIdAndDiag(const KmerPosition<T, true> &first, const KmerPosition<T, true> &second){
+        return compareRepSequenceAndIdAndPos(first, second);
+    }
 
+    static bool compareRepSequenceAndIdAndDiagReverse(const KmerPosition<T, true> &first, const KmerPosition<T, true> &second){
+        return compareRepSequenceAndIdAndPosReverse(first, second);
+    }
+};
 
 struct __attribute__((__packed__)) KmerEntry {
     unsigned int seqId;
@@ -153,11 +263,134 @@ public:
 };
 
 
-template  <int TYPE, typename T>
-size_t assignGroup(KmerPosition<T> *kmers, size_t splitKmerCount, bool includeOnlyExtendable, int covMode, float covThr);
+// hash (score), k-mer index and position of one k-mer of a sequence
+struct SequencePosition{
+    short score;
+    size_t kmer;
+    unsigned int pos;
+    static bool compareByScore(const SequencePosition &first, const SequencePosition &second){
+        if(first.score < second.score)
+            return true;
+        if(second.score < first.score)
+            return false;
+        if(first.kmer < second.kmer)
+            return true;
+        if(second.kmer < first.kmer)
+            return false;
+        if(first.pos < second.pos)
+            return true;
+        if(second.pos < first.pos)
+            return false;
+        return false;
+    }
+    static bool compareByScoreReverse(const SequencePosition &first, const SequencePosition &second){
+        if(first.score < second.score)
+            return true;
+        if(second.score < first.score)
+            return false;
+
+        size_t firstKmer  = BIT_SET(first.kmer, 63);
+        size_t secondKmer = BIT_SET(second.kmer, 63);
+        if(firstKmer < secondKmer)
+            return true;
+        if(secondKmer < firstKmer)
+            return false;
+        if(first.pos < second.pos)
+            return true;
+        if(second.pos < first.pos)
+            return false;
+        return false;
+    }
+};
+
+// Sorts the smallest elements of kmers[0, total) to the front until at least the first needed ones
+// are in their final order and returns the new length of the sorted prefix. The prefix grows
+// geometrically, so extending it step by step stays linear in total.
+template <typename Comparator>
+size_t sortKmerPrefix(SequencePosition *kmers, size_t sorted, size_t needed, size_t total, Comparator comp) {
+    if (needed <= sorted || sorted >= total) {
+        return sorted;
+    }
+    needed = std::min(total, std::max(needed, 2 * sorted));
+    if (needed < total) {
+        std::nth_element(kmers + sorted, kmers + needed, kmers + total, comp);
+    }
+    std::sort(kmers + sorted, kmers + needed, comp);
+    return needed;
+}
+
+// Slides the index of Indexer::int2index (residue i weighted with alphabetSize^i) over a sequence.
+// The leaving residue is removed by an exact division, computed as a shift and a multiplication
+// with the inverse of the odd part of the alphabet size modulo 2^64.
+class RollingKmerIndex {
+public:
+    RollingKmerIndex(size_t alphabetSize, size_t kmerSize) : alphabetSize(alphabetSize), kmerSize(kmerSize) {
+        shift = 0;
+        size_t odd = alphabetSize;
+        while ((odd & 1) == 0) {
+            odd >>= 1;
+            shift++;
+        }
+        // each Newton step doubles the number of correct bits, odd * odd = 1 mod 8
+        inverse = odd;
+        for (int i = 0; i < 5; i++) {
+            inverse *= 2 - odd * inverse;
+        }
+        highestPower = 1;
+        for (size_t i = 1; i < kmerSize; i++) {
+            highestPower *= alphabetSize;
+        }
+        // the shift drops the upper bits, even alphabet sizes need indices that never overflow
+        // (residues go up to alphabetSize for X)
+        exact = (shift == 0) || (pow(static_cast<double>(alphabetSize), static_cast<double>(kmerSize + 1)) < 9.0e18);
+    }
+
+    bool isExact() const {
+        return exact;
+    }
+
+    size_t index(const int *kmer) const {
+        size_t idx = 0;
+        size_t power = 1;
+        for (size_t i = 0; i < kmerSize; i++) {
+            idx += kmer[i] * power;
+            power *= alphabetSize;
+        }
+        return idx;
+    }
+
+    // index of the next window, given the residue that leaves and the residue that enters it
+    size_t next(size_t idx, int removed, int added) const {
+        return ((idx - removed) >> shift) * inverse + added * highestPower;
+    }
+
+private:
+    size_t alphabetSize;
+    size_t kmerSize;
+    size_t highestPower;
+    size_t inverse;
+    unsigned int shift;
+    bool exact;
+};
+
+// split of a k-mer, forward and reverse complement k-mers of nucleotides end up in the same split.
+// The identity k-mer of a sequence (seqHash) goes through the same function. The baseline used
+// seqHash % splits for it, which differs for nucleotides if splits is not a power of two. Both
+// rules send equal identity k-mers to the same split, and identity k-mers lie above every real
+// k-mer, so the groups and the clustering do not change. A single rule lets a stored k-mer
+// table (KmerTable.h) be split without knowing which of its k-mers are identity k-mers.
+template <int TYPE>
+inline size_t kmerSplit(size_t kmer, size_t splits) {
+    return ((TYPE == Parameters::DBTYPE_NUCLEOTIDES) ? BIT_SET(kmer, 63) : kmer) % splits;
+}
+
+template  <int TYPE, typename T, bool Compact>
+size_t assignGroup(KmerPosition<T, Compact> *kmers, size_t splitKmerCount, bool includeOnlyExtendable, int covMode, float covThr,
+                   const T * seqLens = NULL);
 
 template <int TYPE, typename T>
-void mergeKmerFilesAndOutput(DBWriter & dbw, std::vector<std::string> tmpFiles, std::vector<char> &repSequence);
+void mergeKmerFilesAndOutput(DBWriter & dbw, std::vector<std::string> tmpFiles, std::vector<char> &repSequence,
+                             unsigned int threads = 1);
 
 typedef std::priority_queue<FileKmerPosition, std::vector<FileKmerPosition>, CompareResultBySeqId> KmerPositionQueue;
 
@@ -166,28 +399,61 @@ size_t queueNextEntry(KmerPositionQueue &queue, int file, size_t offsetPos, T *e
 
 void setKmerLengthAndAlphabet(Parameters &parameters, size_t aaDbSize, int seqType);
 
-template <int TYPE, typename T, typename seqLenType>
-void writeKmersToDisk(std::string tmpFile, KmerPosition<seqLenType> *kmers, size_t totalKmers);
+template <int TYPE, typename T, typename seqLenType, bool Compact>
+void writeKmersToDisk(std::string tmpFile, KmerPosition<seqLenType, Compact> *kmers, size_t totalKmers);
 
-template <int TYPE, typename T>
-void writeKmerMatcherResult(DBWriter & dbw, KmerPosition<T> *hashSeqPair, size_t totalKmers,
+template <int TYPE, typename T, bool Compact>
+void writeKmerMatcherResult(DBWriter & dbw, KmerPosition<T, Compact> *hashSeqPair, size_t totalKmers,
                             std::vector<char> &repSequence, size_t threads);
 
-template <typename T>
-KmerPosition<T> * doComputation(size_t totalKmers, size_t split, size_t splits, std::string splitFile,
+// state of a run that updates a persisted k-mer table (--kmer-table), see KmerTable.h
+struct KmerTableMerge {
+    KmerTableMerge() : reuseGroups(false) {}
+    // table of the previous run, empty if all sequences are k-merized
+    std::string previousTable;
+    // the grouped k-mers of the previous table are updated instead of grouping all k-mers again
+    bool reuseGroups;
+    // lengths (at most --max-seq-len) of the sequences of the previous table by key
+    std::vector<unsigned int> previousLengths;
+    // keys that are k-merized and keys whose k-mers are taken from the previous table
+    std::vector<char> extractKey;
+    std::vector<char> keepKey;
+    // number of k-mers taken from the previous table for each split
+    std::vector<size_t> splitKmerCounts;
+    // each split writes its sorted k-mers to partPrefix + split and its grouped k-mers to groupedPrefix + split
+    std::string partPrefix;
+    std::string groupedPrefix;
+};
+
+template <typename T, bool Compact>
+KmerPosition<T, Compact> * doComputation(size_t totalKmers, size_t split, size_t splits, std::string splitFile,
                              DBReader<unsigned int> & seqDbr, Parameters & par, BaseMatrix  * subMat,
-                             size_t KMER_SIZE, size_t chooseTopKmer, float chooseTopKmerScale = 0.0);
-template <typename T>
-KmerPosition<T> *initKmerPositionMemory(size_t size);
+                             size_t KMER_SIZE, size_t chooseTopKmer, bool adjustLength, float chooseTopKmerScale = 0.0,
+                             std::string partitionFile = "", const T * seqLens = NULL,
+                             const KmerTableMerge * tableMerge = NULL);
+template <typename T, bool Compact = false>
+KmerPosition<T, Compact> *initKmerPositionMemory(size_t size);
+
+// partition files that fillKmerPositionArray fills when it extracts the k-mers of all splits in one pass.
+// Each thread collects blocks of blockSize k-mers per split, reserves the position of a full block in
+// the file of its split and writes it there, so threads do not wait for each other
+struct KmerPartitions {
+    // one file per split
+    std::vector<FILE *> files;
+    // k-mers reserved in each file
+    std::vector<size_t> kmerCounts;
+    size_t blockSize;
+};
 
-template <int TYPE, typename T>
-std::pair<size_t, size_t>  fillKmerPositionArray(KmerPosition<T> * hashSeqPair, DBReader<unsigned int> &seqDbr,
+template <int TYPE, typename T, bool Compact = false>
+std::pair<size_t, size_t>  fillKmerPositionArray(KmerPosition<T, Compact> * hashSeqPair, DBReader<unsigned int> &seqDbr,
                              Parameters & par, BaseMatrix * subMat,
                              const size_t KMER_SIZE, size_t chooseTopKmer,
                              bool includeIdenticalKmer, size_t splits, size_t split, size_t pickNBest,
-                             bool adjustLength, float chooseTopKmerScale = 0.0);
+                             bool adjustLength, float chooseTopKmerScale = 0.0,
+                             KmerPartitions * partitions = NULL, const char * extractKey = NULL);
 
-template <typename T>
+template <typename T, bool Compact = false>
 size_t computeMemoryNeededLinearfilter(size_t totalKmer);
 
 size_t computeKmerCount(DBReader<unsigned int> &reader, size_t KMER_SIZE, size_t chooseTopKmer,
@@ -201,6 +467,13 @@ unsigned circ_hash(const int * x, unsigned length, const unsigned rol);
 
 unsigned circ_hash_next(const int * x, unsigned length, int x_first, short unsigned h, const unsigned rol);
 
+// circ_hash of the first window of x followed by circ_hash_next for the following ones,
+// hashes has to hold windows entries and buffer windows + length
+void rollingKmerHashes(const int * x, size_t windows, unsigned length, unsigned rol, unsigned short * hashes, unsigned short * buffer);
+
+// circ_hash of each window x[p, p + length) on its own, same buffer requirements as above
+void windowKmerHashes(const int * x, size_t windows, unsigned length, unsigned rol, unsigned short * hashes, unsigned short * buffer);
+
 
 
 #undef SIZE_T_MAX
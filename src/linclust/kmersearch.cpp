@@ -17,6 +17,10 @@
 
 #include "omptl/omptl_algorithm"
 
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
 #ifndef SIZE_T_MAX
 #define SIZE_T_MAX ((size_t) -1)
 #endif
@@ -248,10 +252,12 @@ int kmersearch(int argc, const char **argv, const Command &command) {
     for (size_t split = 0; split < splits; split++) {
         tidxdbr.remapData();
         char *entriesData = tidxdbr.getDataUncompressed(tidxdbr.getId(PrefilteringIndexReader::ENTRIES));
-        char *entriesOffsetsData = tidxdbr.getDataUncompressed(tidxdbr.getId(PrefilteringIndexReader::ENTRIESOFFSETS));
+        size_t entriesOffsetsId = tidxdbr.getId(PrefilteringIndexReader::ENTRIESOFFSETS);
+        char *entriesOffsetsData = tidxdbr.getDataUncompressed(entriesOffsetsId);
+        size_t entriesOffsetsCount = tidxdbr.getEntryLen(entriesOffsetsId) / sizeof(size_t);
         int64_t entriesNum = *((int64_t *) tidxdbr.getDataUncompressed(tidxdbr.getId(PrefilteringIndexReader::ENTRIESNUM)));
         int64_t entriesGridSize = *((int64_t *) tidxdbr.getDataUncompressed(tidxdbr.getId(PrefilteringIndexReader::ENTRIESGRIDSIZE)));
-        KmerIndex kmerIndex(par.alphabetSize, adjustedKmerSize, entriesData, entriesOffsetsData, entriesNum, entriesGridSize);
+        KmerIndex kmerIndex(par.alphabetSize, adjustedKmerSize, entriesData, entriesOffsetsData, entriesNum, entriesGridSize, entriesOffsetsCount);
 //        kmerIndex.printIndex<Parameters::DBTYPE_NUCLEOTIDES>(subMat);
         std::pair<std::string, std::string> tmpFiles;
         if (splits > 1) {
@@ -321,130 +327,132 @@ int kmersearch(int argc, const char **argv, const Command &command) {
     }
     return EXIT_SUCCESS;
 }
-template  <int TYPE>
-std::pair<KmerPosition<short> *,size_t > KmerSearch::searchInIndex( KmerPosition<short> *kmers, size_t kmersSize, KmerIndex &kmerIndex) {
-    Timer timer;
-
-    kmerIndex.reset();
-    KmerIndex::KmerEntry currTargetKmer;
-    bool isDone = false;
-    if(kmerIndex.hasNextEntry()){
-        if(TYPE == Parameters::DBTYPE_NUCLEOTIDES) {
-            currTargetKmer = kmerIndex.getNextEntry<Parameters::DBTYPE_NUCLEOTIDES>();
+template <int TYPE>
+void KmerSearch::writeHit(KmerPosition<short> *hit, const KmerPosition<short> &query, const KmerIndex::KmerEntry &target) {
+    if(TYPE == Parameters::DBTYPE_NUCLEOTIDES){
+        //  00 No problem here both are forward
+        //  01 We can revert the query of target, lets invert the query.
+        //  10 Same here, we can revert query to match the not inverted target
+        //  11 Both are reverted so no problem!
+        //  So we need just 1 bit of information to encode all four states
+        bool targetIsReverse = (BIT_CHECK(query.kmer, 63) == false);
+        bool repIsReverse = (BIT_CHECK(target.kmer, 63) == false);
+        bool queryNeedsToBeRev = false;
+        // we now need 2 byte of information (00),(01),(10),(11)
+        // we need to flip the coordinates of the query
+        short queryPos=0;
+        short targetPos=0;
+        // revert kmer in query hits normal kmer in target
+        // we need revert the query
+        if (repIsReverse == true && targetIsReverse == false){
+            queryPos = target.pos;
+            targetPos = query.pos;
+            queryNeedsToBeRev = true;
+            // both k-mers were extracted on the reverse strand
+            // this is equal to both are extract on the forward strand
+            // we just need to offset the position to the forward strand
+        }else if (repIsReverse == true && targetIsReverse == true){
+            queryPos = (target.seqLen - 1) - target.pos;
+            targetPos = (query.seqLen - 1) - query.pos;
+            queryNeedsToBeRev = false;
+            // query is not revers but target k-mer is reverse
+            // instead of reverting the target, we revert the query and offset the the query/target position
+        }else if (repIsReverse == false && targetIsReverse == true){
+            queryPos = (target.seqLen - 1) - target.pos;
+            targetPos = (query.seqLen - 1) - query.pos;
+            queryNeedsToBeRev = true;
+            // both are forward, everything is good here
         }else{
-            currTargetKmer = kmerIndex.getNextEntry<Parameters::DBTYPE_AMINO_ACIDS>();
+            queryPos = target.pos;
+            targetPos =  query.pos;
+            queryNeedsToBeRev = false;
         }
+        hit->pos = queryPos - targetPos;
+        hit->kmer = (queryNeedsToBeRev) ? BIT_CLEAR(static_cast<size_t >(target.id), 63) : BIT_SET(static_cast<size_t >(target.id), 63);
     }else{
-        isDone = true;
+        // i - j
+        hit->kmer = target.id;
+        hit->pos = target.pos - query.pos;
     }
+    hit->id = query.id;
+    hit->seqLen = query.seqLen;
+}
 
-    size_t kmerPos = 0;
-    size_t writePos = 0;
-    // this is IO bound, optimisation does not make much sense here.
-    size_t queryKmer;
-    size_t targetKmer;
-
-    while(isDone == false){
-        KmerPosition<short> * currQueryKmer = &kmers[kmerPos];
-        if(TYPE == Parameters::DBTYPE_NUCLEOTIDES) {
-            queryKmer = BIT_SET(currQueryKmer->kmer, 63);
-            targetKmer = BIT_SET(currTargetKmer.kmer, 63);
-        }else{
-            queryKmer = currQueryKmer->kmer;
-            targetKmer = currTargetKmer.kmer;
+// Writes the hits of kmers[start, end) to kmers[start, start + hits) and returns the number of hits.
+// Each query k-mer hits the first index entry of its k-mer. The grid offsets give the cell of a k-mer,
+// within a cell the search gallops from the entry of the previous query k-mer. Dense query k-mers
+// take short steps, sparse ones skip most of the index without touching it.
+template <int TYPE>
+static size_t searchKmerRange(KmerPosition<short> *kmers, size_t start, size_t end, KmerIndex &kmerIndex) {
+    const size_t gridResolution = kmerIndex.getGridResolution();
+    size_t writePos = start;
+    size_t currCell = SIZE_T_MAX;
+    size_t cellEnd = 0;
+    size_t entryPos = 0;
+    for (size_t kmerPos = start; kmerPos < end; kmerPos++) {
+        const KmerPosition<short> query = kmers[kmerPos];
+        const size_t kmer = (TYPE == Parameters::DBTYPE_NUCLEOTIDES) ? BIT_CLEAR(query.kmer, 63) : query.kmer;
+        const size_t cell = kmer / gridResolution;
+        const unsigned short offset = static_cast<unsigned short>(kmer - cell * gridResolution);
+        if (cell != currCell) {
+            currCell = cell;
+            entryPos = kmerIndex.getCellStart(cell);
+            cellEnd = kmerIndex.getCellEnd(cell);
         }
-
-        if(queryKmer < targetKmer){
-            while(queryKmer < targetKmer) {
-                if (kmerPos + 1 < kmersSize) {
-                    kmerPos++;
-                } else {
-                    isDone = true;
-                    break;
-                }
-                KmerPosition<short> * currQueryKmer = &kmers[kmerPos];
-                if(TYPE == Parameters::DBTYPE_NUCLEOTIDES) {
-                    queryKmer = BIT_SET(currQueryKmer->kmer, 63);
-                }else{
-                    queryKmer = currQueryKmer->kmer;
-                }
-            }
-        }else if(targetKmer < queryKmer){
-            while(targetKmer < queryKmer){
-                if(kmerIndex.hasNextEntry()) {
-                    if(TYPE == Parameters::DBTYPE_NUCLEOTIDES) {
-                        currTargetKmer = kmerIndex.getNextEntry<Parameters::DBTYPE_NUCLEOTIDES>();
-                    }else{
-                        currTargetKmer = kmerIndex.getNextEntry<Parameters::DBTYPE_AMINO_ACIDS>();
-                    }
-                    if(TYPE == Parameters::DBTYPE_NUCLEOTIDES) {
-                        targetKmer = BIT_SET(currTargetKmer.kmer, 63);
-                    }else{
-                        targetKmer = currTargetKmer.kmer;
-                    }
-                    //TODO remap logic to speed things up
-                }else{
-                    isDone = true;
-                    break;
-                }
+        if (entryPos < cellEnd && kmerIndex.getKmerOffset<TYPE>(entryPos) < offset) {
+            // invariant: entry lo is smaller, entry hi (or the cell end) is not
+            size_t lo = entryPos;
+            size_t step = 1;
+            size_t hi = lo + step;
+            while (hi < cellEnd && kmerIndex.getKmerOffset<TYPE>(hi) < offset) {
+                lo = hi;
+                step *= 2;
+                hi = lo + step;
             }
-        }else{
-            if(TYPE == Parameters::DBTYPE_NUCLEOTIDES){
-                //  00 No problem here both are forward
-                //  01 We can revert the query of target, lets invert the query.
-                //  10 Same here, we can revert query to match the not inverted target
-                //  11 Both are reverted so no problem!
-                //  So we need just 1 bit of information to encode all four states
-                bool targetIsReverse = (BIT_CHECK(currQueryKmer->kmer, 63) == false);
-                bool repIsReverse = (BIT_CHECK(currTargetKmer.kmer, 63) == false);
-                bool queryNeedsToBeRev = false;
-                // we now need 2 byte of information (00),(01),(10),(11)
-                // we need to flip the coordinates of the query
-                short queryPos=0;
-                short targetPos=0;
-                // revert kmer in query hits normal kmer in target
-                // we need revert the query
-                if (repIsReverse == true && targetIsReverse == false){
-                    queryPos = currTargetKmer.pos;
-                    targetPos = currQueryKmer->pos;
-                    queryNeedsToBeRev = true;
-                    // both k-mers were extracted on the reverse strand
-                    // this is equal to both are extract on the forward strand
-                    // we just need to offset the position to the forward strand
-                }else if (repIsReverse == true && targetIsReverse == true){
-                    queryPos = (currTargetKmer.seqLen - 1) - currTargetKmer.pos;
-                    targetPos = (currQueryKmer->seqLen - 1) - currQueryKmer->pos;
-                    queryNeedsToBeRev = false;
-                    // query is not revers but target k-mer is reverse
-                    // instead of reverting the target, we revert the query and offset the the query/target position
-                }else if (repIsReverse == false && targetIsReverse == true){
-                    queryPos = (currTargetKmer.seqLen - 1) - currTargetKmer.pos;
-                    targetPos = (currQueryKmer->seqLen - 1) - currQueryKmer->pos;
-                    queryNeedsToBeRev = true;
-                    // both are forward, everything is good here
-                }else{
-                    queryPos = currTargetKmer.pos;
-                    targetPos =  currQueryKmer->pos;
-                    queryNeedsToBeRev = false;
+            hi = std::min(hi, cellEnd);
+            while (lo + 1 < hi) {
+                const size_t mid = lo + (hi - lo) / 2;
+                if (kmerIndex.getKmerOffset<TYPE>(mid) < offset) {
+                    lo = mid;
+                } else {
+                    hi = mid;
                 }
-                (kmers+writePos)->pos = queryPos - targetPos;
-                size_t id = (queryNeedsToBeRev) ? BIT_CLEAR(static_cast<size_t >(currTargetKmer.id), 63) : BIT_SET(static_cast<size_t >(currTargetKmer.id), 63);
-                (kmers+writePos)->kmer = id;
-            }else{
-                // i - j
-                (kmers+writePos)->kmer= currTargetKmer.id;
-//                std::cout << currTargetKmer.pos - currQueryKmer->pos << "\t" << currTargetKmer.pos << "\t" << currQueryKmer->pos << std::endl;
-                (kmers+writePos)->pos = currTargetKmer.pos - currQueryKmer->pos;
             }
-            (kmers+writePos)->id = currQueryKmer->id;
-            (kmers+writePos)->seqLen = currQueryKmer->seqLen;
-
+            entryPos = hi;
+        }
+        if (entryPos < cellEnd && kmerIndex.getKmerOffset<TYPE>(entryPos) == offset) {
+            KmerSearch::writeHit<TYPE>(kmers + writePos, query, kmerIndex.getEntry<TYPE>(cell, entryPos));
             writePos++;
-            if(kmerPos+1<kmersSize){
-                kmerPos++;
-            }
         }
     }
+    return writePos - start;
+}
+
+template  <int TYPE>
+std::pair<KmerPosition<short> *,size_t > KmerSearch::searchInIndex( KmerPosition<short> *kmers, size_t kmersSize, KmerIndex &kmerIndex) {
+    Timer timer;
+
+    // each query k-mer is looked up on its own, so the sorted query k-mers are split into one range per thread
+    int threads = 1;
+#ifdef OPENMP
+    threads = omp_get_max_threads();
+#endif
+    const size_t ranges = std::max(static_cast<size_t>(1), std::min(static_cast<size_t>(threads), kmersSize / 4096));
+    std::vector<size_t> rangeHits(ranges, 0);
+#pragma omp parallel for schedule(static, 1) num_threads(threads)
+    for (size_t range = 0; range < ranges; range++) {
+        const size_t start = (kmersSize * range) / ranges;
+        const size_t end = (kmersSize * (range + 1)) / ranges;
+        rangeHits[range] = searchKmerRange<TYPE>(kmers, start, end, kmerIndex);
+    }
+    size_t writePos = 0;
+    for (size_t range = 0; range < ranges; range++) {
+        const size_t start = (kmersSize * range) / ranges;
+        if (writePos != start) {
+            memmove(kmers + writePos, kmers + start, rangeHits[range] * sizeof(KmerPosition<short>));
+        }
+        writePos += rangeHits[range];
+    }
     Debug(Debug::INFO) << "Time to find k-mers: " << timer.lap() << "\n";
     timer.reset();
     if(TYPE == Parameters::DBTYPE_NUCLEOTIDES) {
@@ -457,6 +465,8 @@ std::pair<KmerPosition<short> *,size_t > KmerSearch::searchInIndex( KmerPosition
     return std::make_pair(kmers, writePos);
 }
 
+template void KmerSearch::writeHit<0>(KmerPosition<short> *hit, const KmerPosition<short> &query, const KmerIndex::KmerEntry &target);
+template void KmerSearch::writeHit<1>(KmerPosition<short> *hit, const KmerPosition<short> &query, const KmerIndex::KmerEntry &target);
 template std::pair<KmerPosition<short> *,size_t > KmerSearch::searchInIndex<0>( KmerPosition<short> *kmers, size_t kmersSize, KmerIndex &kmerIndex);
 template std::pair<KmerPosition<short> *,size_t > KmerSearch::searchInIndex<1>( KmerPosition<short> *kmers, size_t kmersSize, KmerIndex &kmerIndex);
 
@@ -17,6 +17,10 @@ public:
     template  <int TYPE>
     static void writeResult(DBWriter & dbw, KmerPosition<short> *kmers, size_t kmerCount);
 
+    // turns a query k-mer and the index entry it hit into a (target id, diagonal) result
+    template  <int TYPE>
+    static void writeHit(KmerPosition<short> *hit, const KmerPosition<short> &query, const KmerIndex::KmerEntry &target);
+
 
     struct ExtractKmerAndSortResult{
         ExtractKmerAndSortResult(size_t kmerCount, KmerPosition<short> * kmers, size_t adjustedKmer)
@@ -1,46 +1,95 @@
 #include "Aggregation.h"
 #include "Util.h"
 #include "Debug.h"
+#include "Matcher.h"
+#include "PackedAlignment.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
 
 #ifdef OPENMP
 #include <omp.h>
 #endif
 
 Aggregation::Aggregation(const std::string &targetDbName, const std::string &resultDbName,
-                         const std::string &outputDbName, unsigned int threads, unsigned int compressed)
-        : resultDbName(resultDbName), outputDbName(outputDbName), threads(threads), compressed(compressed) {
-    std::string sizeDbName = targetDbName + "_member_to_set";
-    std::string sizeDbIndex = targetDbName + "_member_to_set.index";
-    targetSetReader = new DBReader<unsigned int>(sizeDbName.c_str(), sizeDbIndex.c_str(), threads, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
-    targetSetReader->open(DBReader<unsigned int>::NOSORT);
+                         const std::string &outputDbName, size_t valueColumn, unsigned int threads, unsigned int compressed)
+        : resultDbName(resultDbName), outputDbName(outputDbName), valueColumn(valueColumn), threads(threads), compressed(compressed) {
+    std::string setDbName = targetDbName + "_member_to_set";
+    std::string setDbIndex = targetDbName + "_member_to_set.index";
+    DBReader<unsigned int> targetSetReader(setDbName.c_str(), setDbIndex.c_str(), 1, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
+    targetSetReader.open(DBReader<unsigned int>::NOSORT);
+    // member keys are dense, the set of a member is then a single lookup
+    memberToSet.resize(targetSetReader.getSize() > 0 ? targetSetReader.getLastKey() + 1 : 0, UINT_MAX);
+    for (size_t i = 0; i < targetSetReader.getSize(); ++i) {
+        memberToSet[targetSetReader.getDbKey(i)] = Util::fast_atoi<unsigned int>(targetSetReader.getData(i, 0));
+    }
+    targetSetReader.close();
 }
 
-Aggregation::~Aggregation() {
-    targetSetReader->close();
-    delete targetSetReader;
-}
+Aggregation::~Aggregation() {}
 
-// build a map with the value in [target column] field as a key and the rest of the line, cut in fields, as values
-void Aggregation::buildMap(char *data, int thread_idx, std::map<unsigned int, std::vector<std::vector<std::string>>> &dataToAggregate) {
+// parses the target key, its set and the value column of every line of a result entry
+void Aggregation::parseEntries(char *data, std::vector<AggregationEntry> &entries, bool alignmentInput) {
     while (*data != '\0') {
         char *current = data;
+        AggregationEntry entry;
+        entry.line = current;
+        entry.packed = alignmentInput && PackedAlignment::isPacked(current);
+        if (entry.packed) {
+            // the fields of a packed record are read directly, the line is only rendered for the output
+            PackedAlignment::Record rec;
+            data = const_cast<char *>(PackedAlignment::readRecord(current, rec));
+            entry.length = data - current - 1;
+            entry.targetKey = rec.dbKey;
+            entry.setKey = (entry.targetKey < memberToSet.size()) ? memberToSet[entry.targetKey] : UINT_MAX;
+            if (entry.setKey == UINT_MAX) {
+                Debug(Debug::ERROR) << "Invalid target database key " << entry.targetKey << ".\n";
+                EXIT(EXIT_FAILURE);
+            }
+            if (valueColumn > 9) {
+                Debug(Debug::ERROR) << "Result of target " << entry.targetKey << " has less than " << (valueColumn + 1) << " numeric columns.\n";
+                EXIT(EXIT_FAILURE);
+            }
+            entry.value = PackedAlignment::columnValue(rec, valueColumn);
+            entries.push_back(entry);
+            continue;
+        }
+
         data = Util::skipLine(data);
-        size_t length = data - current;
-        std::string line(current, length - 1);
-        if (line.empty() == true) {
+        size_t length = data - current - 1;
+        if (length == 0) {
             continue;
         }
 
-        std::vector<std::string> columns = Util::split(line, "\t");
-        unsigned int targetKey = Util::fast_atoi<unsigned int>(columns[0].c_str());
-        size_t setId = targetSetReader->getId(targetKey);
-        if (setId == UINT_MAX) {
-            Debug(Debug::ERROR) << "Invalid target database key " << columns[0] << ".\n";
+        entry.length = length;
+        entry.targetKey = Util::fast_atoi<unsigned int>(current);
+        entry.setKey = (entry.targetKey < memberToSet.size()) ? memberToSet[entry.targetKey] : UINT_MAX;
+        if (entry.setKey == UINT_MAX) {
+            Debug(Debug::ERROR) << "Invalid target database key " << entry.targetKey << ".\n";
             EXIT(EXIT_FAILURE);
         }
-        char *data = targetSetReader->getData(setId, thread_idx);
-        unsigned int setKey = Util::fast_atoi<unsigned int>(data);
-        dataToAggregate[setKey].push_back(columns);
+        const char *column = current;
+        for (size_t i = 0; i < valueColumn && column != NULL; ++i) {
+            column = static_cast<const char *>(memchr(column, '\t', current + length - column));
+            column = (column != NULL) ? column + 1 : NULL;
+        }
+        if (column == NULL) {
+            Debug(Debug::ERROR) << "Result of target " << entry.targetKey << " has less than " << (valueColumn + 1) << " columns.\n";
+            EXIT(EXIT_FAILURE);
+        }
+        entry.value = strtod(column, NULL);
+        entries.push_back(entry);
+    }
+}
+
+void Aggregation::appendText(const AggregationEntry &entry, std::string &out) {
+    if (entry.packed) {
+        Matcher::packedRecordToText(entry.line, out);
+        out.erase(out.size() - 1);
+    } else {
+        out.append(entry.line, entry.length);
     }
 }
 
@@ -48,6 +97,8 @@ int Aggregation::run() {
     std::string inputDBIndex = resultDbName + ".index";
     DBReader<unsigned int> reader(resultDbName.c_str(), inputDBIndex.c_str(), threads, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
     reader.open(DBReader<unsigned int>::LINEAR_ACCCESS);
+    // only alignment results can contain packed records
+    const bool alignmentInput = Parameters::isEqualDbtype(reader.getDbtype(), Parameters::DBTYPE_ALIGNMENT_RES);
 
     std::string outputDBIndex = outputDbName + ".index";
     DBWriter writer(outputDbName.c_str(), outputDBIndex.c_str(), threads, compressed, Parameters::DBTYPE_ALIGNMENT_RES);
@@ -63,22 +114,27 @@ int Aggregation::run() {
         std::string buffer;
         buffer.reserve(10 * 1024);
 
-        std::map<unsigned int, std::vector<std::vector<std::string>>> dataToMerge;
+        std::vector<AggregationEntry> entries;
 #pragma omp for
         for (size_t i = 0; i < reader.getSize(); i++) {
             progress.updateProgress();
-            dataToMerge.clear();
+            entries.clear();
 
             unsigned int key = reader.getDbKey(i);
-            buildMap(reader.getData(i, thread_idx), thread_idx, dataToMerge);
+            char *data = reader.getData(i, thread_idx);
+            parseEntries(data, entries, alignmentInput);
+            // sets are aggregated in key order, the hits of a set keep their order
+            std::stable_sort(entries.begin(), entries.end(), AggregationEntry::compareBySet);
             prepareInput(key, thread_idx);
-            
-            for (std::map<unsigned int, std::vector<std::vector<std::string>>>::const_iterator it = dataToMerge.begin();
-                 it != dataToMerge.end(); ++it) {
-                unsigned int targetKey = it->first;
-                std::vector<std::vector<std::string>> columns = it->second;
-                buffer.append(aggregateEntry(columns, key, targetKey, thread_idx));
+
+            for (size_t start = 0; start < entries.size();) {
+                size_t end = start + 1;
+                while (end < entries.size() && entries[end].setKey == entries[start].setKey) {
+                    end++;
+                }
+                aggregateEntry(&entries[start], end - start, key, entries[start].setKey, thread_idx, buffer);
                 buffer.append("\n");
+                start = end;
             }
             writer.writeData(buffer.c_str(), buffer.length(), key, thread_idx);
             buffer.clear();
@@ -4,28 +4,50 @@
 #include "DBReader.h"
 #include "DBWriter.h"
 
+#include <string>
 #include <vector>
-#include <map>
+
+// a result line of the input DB, line points into the data of the result DB and is not copied
+struct AggregationEntry {
+    const char *line;
+    size_t length;          // without the newline
+    bool packed;            // line is a packed alignment record, see appendText
+    unsigned int targetKey; // first column
+    unsigned int setKey;    // set of the target
+    double value;           // column selected by the aggregation, parsed once
+
+    static bool compareBySet(const AggregationEntry &first, const AggregationEntry &second) {
+        return first.setKey < second.setKey;
+    }
+};
 
 class Aggregation {
 public:
     Aggregation(const std::string &targetDbName, const std::string &resultDbName, const std::string &outputDbName,
-                unsigned int threads, unsigned int compressed);
+                size_t valueColumn, unsigned int threads, unsigned int compressed);
 
     virtual ~Aggregation();
 
     int run();
     virtual void prepareInput(unsigned int querySetKey, unsigned int thread_idx) = 0;
-    virtual std::string aggregateEntry(std::vector<std::vector<std::string>> &dataToAggregate, unsigned int querySetKey, unsigned int targetSetKey, unsigned int thread_idx) = 0;
+    // appends the aggregation of all entries of one target set (in the order of the result) to output
+    virtual void aggregateEntry(const AggregationEntry *entries, size_t count, unsigned int querySetKey,
+                                unsigned int targetSetKey, unsigned int thread_idx, std::string &output) = 0;
 
 protected:
     std::string resultDbName;
     std::string outputDbName;
-    DBReader<unsigned int> *targetSetReader;
+    size_t valueColumn;
     unsigned int threads;
     unsigned int compressed;
 
-    void buildMap(char *data, int thread_idx, std::map<unsigned int, std::vector<std::vector<std::string>>> &dataToAggregate);
+    // set key of every target member, indexed by member key
+    std::vector<unsigned int> memberToSet;
+
+    void parseEntries(char *data, std::vector<AggregationEntry> &entries, bool alignmentInput);
+
+    // appends the line of an entry as text (without the newline), packed records are rendered
+    static void appendText(const AggregationEntry &entry, std::string &out);
 };
 
 #endif
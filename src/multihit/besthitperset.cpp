@@ -3,6 +3,8 @@
 #include "Aggregation.h"
 #include "Util.h"
 
+#include <cstring>
+
 #ifdef OPENMP
 #include <omp.h>
 #endif
@@ -11,7 +13,7 @@ class BestHitBySetFilter : public Aggregation {
 public :
     BestHitBySetFilter(const std::string &targetDbName, const std::string &resultDbName,
                        const std::string &outputDbName, bool simpleBestHitMode, unsigned int threads, unsigned int compressed) :
-            Aggregation(targetDbName, resultDbName, outputDbName, threads, compressed), simpleBestHitMode(simpleBestHitMode) {
+            Aggregation(targetDbName, resultDbName, outputDbName, 3, threads, compressed), simpleBestHitMode(simpleBestHitMode) {
         std::string sizeDbName = targetDbName + "_set_size";
         std::string sizeDbIndex = targetDbName + "_set_size.index";
         targetSizeReader = new DBReader<unsigned int>(sizeDbName.c_str(), sizeDbIndex.c_str(), threads, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
@@ -26,7 +28,7 @@ public :
 
     void prepareInput(unsigned int, unsigned int) {}
 
-    std::string aggregateEntry(std::vector<std::vector<std::string>> &dataToAggregate, unsigned int, unsigned int targetSetKey, unsigned int thread_idx)  {
+    void aggregateEntry(const AggregationEntry *entries, size_t count, unsigned int, unsigned int targetSetKey, unsigned int thread_idx, std::string &output) {
         double bestScore = -DBL_MAX;
         double secondBestScore = -DBL_MAX;
         double bestEval = DBL_MAX;
@@ -35,7 +37,7 @@ public :
         double logCorrectedPval = 0;
 
         // Look for the lowest p-value and retain only this line
-        // dataToAggregate = [nbrTargetGene][Field of result]
+        // the value of an entry is its e-value
         size_t targetId = targetSizeReader->getId(targetSetKey);
         if (targetId == UINT_MAX) {
             Debug(Debug::ERROR) << "Invalid target size database key " << targetSetKey << ".\n";
@@ -44,9 +46,9 @@ public :
         char *data = targetSizeReader->getData(targetId, thread_idx);
         unsigned int nbrGenes = Util::fast_atoi<unsigned int>(data);
 
-        std::vector<std::string> *bestEntry = NULL;
-        for (size_t i = 0; i < dataToAggregate.size(); i++) {
-            double eval = strtod(dataToAggregate[i][3].c_str(), NULL);
+        const AggregationEntry *bestEntry = NULL;
+        for (size_t i = 0; i < count; i++) {
+            double eval = entries[i].value;
             double pval = eval/nbrGenes;
             //prevent log(0)
             if (pval == 0) {
@@ -55,17 +57,17 @@ public :
             double score = -log(pval);
 
             //if only one hit use simple best hit
-            if(simpleBestHitMode ||dataToAggregate.size() < 2) {
+            if(simpleBestHitMode || count < 2) {
                 if(bestEval > eval){
                     bestEval = eval;
-                    bestEntry = &dataToAggregate[i];
+                    bestEntry = &entries[i];
                 }
             }
             else {
                 if (score >= bestScore) {
                     secondBestScore = bestScore;
                     bestScore = score;
-                    bestEntry = &dataToAggregate[i];
+                    bestEntry = &entries[i];
                 } 
                 else if (score > secondBestScore) {
                     secondBestScore = score;
@@ -74,7 +76,7 @@ public :
         }
 
 
-        if (simpleBestHitMode ||dataToAggregate.size() < 2) {
+        if (simpleBestHitMode || count < 2) {
             if(bestEval == 0) {
                 logCorrectedPval = log(DBL_MIN)-logBestHitCalibration;
             }
@@ -91,27 +93,33 @@ public :
         }
 
         if (bestEntry == NULL) {
-            return "";
+            return;
         }
 
-        std::string buffer;
-        buffer.reserve(1024);
-
-        // Aggregate the full line into string
-        for (size_t i = 0; i < bestEntry->size(); ++i) {
-            if (i == 1) {
-                char tmpBuf[15];
-                sprintf(tmpBuf, "%.3E", logCorrectedPval);
-                buffer.append(tmpBuf);
-            } else {
-                buffer.append(bestEntry->at(i));
-            }
-            if (i != (bestEntry->size() - 1)) {
-                buffer.append(1, '\t');
-            }
+        // copy the line with the corrected p-value as second column
+        const char *line = bestEntry->line;
+        size_t length = bestEntry->length;
+        std::string packedLine;
+        if (bestEntry->packed) {
+            appendText(*bestEntry, packedLine);
+            line = packedLine.c_str();
+            length = packedLine.size();
+        }
+        const char *lineEnd = line + length;
+        const char *secondColumn = static_cast<const char *>(memchr(line, '\t', length));
+        if (secondColumn == NULL) {
+            output.append(line, length);
+            return;
+        }
+        secondColumn++;
+        output.append(line, secondColumn - line);
+        char tmpBuf[32];
+        int written = snprintf(tmpBuf, sizeof(tmpBuf), "%.3E", logCorrectedPval);
+        output.append(tmpBuf, written);
+        const char *thirdColumn = static_cast<const char *>(memchr(secondColumn, '\t', lineEnd - secondColumn));
+        if (thirdColumn != NULL) {
+            output.append(thirdColumn, lineEnd - thirdColumn);
         }
-
-        return buffer;
     }
 
 private:
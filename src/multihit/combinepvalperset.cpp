@@ -30,7 +30,7 @@ class PvalueAggregator : public Aggregation {
 public:
     PvalueAggregator(std::string queryDbName, std::string targetDbName, const std::string &resultDbName,
                      const std::string &outputDbName, float alpha, unsigned int threads, unsigned int compressed, int aggregationMode) :
-            Aggregation(targetDbName, resultDbName, outputDbName, threads, compressed), alpha(alpha), aggregationMode(aggregationMode) {
+            Aggregation(targetDbName, resultDbName, outputDbName, 1, threads, compressed), alpha(alpha), aggregationMode(aggregationMode) {
 
         std::string sizeDBName = queryDbName + "_set_size";
         std::string sizeDBIndex = queryDbName + "_set_size.index";
@@ -82,13 +82,12 @@ public:
     }
 
     //Get all result of a single Query Set VS a Single Target Set and return the multiple-match p-value for it
-    std::string aggregateEntry(std::vector<std::vector<std::string> > &dataToAggregate, unsigned int querySetKey,
-                               unsigned int targetSetKey, unsigned int thread_idx) {
+    void aggregateEntry(const AggregationEntry *entries, size_t count, unsigned int querySetKey,
+                        unsigned int targetSetKey, unsigned int thread_idx, std::string &buffer) {
         
         const size_t numTargetSets = targetSizeReader->getSize();  
         double updatedPval;
 
-        std::string buffer;
         char keyBuffer[255];
         char *tmpBuff = Itoa::u32toa_sse2(targetSetKey, keyBuffer);
         buffer.append(keyBuffer, tmpBuff - keyBuffer - 1);
@@ -102,14 +101,14 @@ public:
             //multihit edge case p0 = 0
             if (pvalThreshold == 0.0) {
                 buffer.append(SSTR(numTargetSets));
-                return buffer;
+                return;
             }
 
             size_t k = 0;
             double r = 0;
             const double logPvalThr = log(pvalThreshold);
-            for (size_t i = 0; i < dataToAggregate.size(); ++i) {
-                double logPvalue = std::strtod(dataToAggregate[i][1].c_str(), NULL);
+            for (size_t i = 0; i < count; ++i) {
+                double logPvalue = entries[i].value;
                 if (logPvalue < logPvalThr) {
                     k++;
                     r -= logPvalue - logPvalThr;
@@ -118,12 +117,12 @@ public:
             //multihit edge case r = 0
             if (r == 0) {
                 buffer.append(SSTR(numTargetSets));
-                return buffer;
+                return;
             }
 
             if (std::isinf(r)) {
                 buffer.append("0");
-                return buffer;
+                return;
             }        
 
             const double expMinusR = exp(-r);
@@ -131,7 +130,7 @@ public:
             //multihit edge case p0 = 1
             if (pvalThreshold == 1.0) {
                 buffer.append(SSTR(expMinusR * numTargetSets));
-                return buffer;
+                return;
             }
 
 
@@ -147,8 +146,8 @@ public:
         else if(aggregationMode == Parameters::AGGREGATION_MODE_MIN_PVAL){
             unsigned int orfCount = Util::fast_atoi<unsigned int>(querySizeReader->getDataByDBKey(querySetKey, thread_idx));
             double minLogPval = 0;
-            for (size_t i = 0; i < dataToAggregate.size(); ++i) { 
-                double currentLogPval = std::strtod(dataToAggregate[i][1].c_str(), NULL);
+            for (size_t i = 0; i < count; ++i) { 
+                double currentLogPval = entries[i].value;
                 if (currentLogPval < minLogPval) {
                     minLogPval = currentLogPval;
                 };
@@ -159,8 +158,8 @@ public:
         //2) the P-value for the product-of-P-values
         else if (aggregationMode == Parameters::AGGREGATION_MODE_PRODUCT)    {
             double  sumLogPval= 0;
-            for (size_t i = 0; i < dataToAggregate.size(); ++i) {
-                double logPvalue = std::strtod(dataToAggregate[i][1].c_str(), NULL);
+            for (size_t i = 0; i < count; ++i) {
+                double logPvalue = entries[i].value;
                 sumLogPval += logPvalue;
             }
             updatedPval = exp(sumLogPval);   
@@ -171,8 +170,8 @@ public:
             unsigned int orfCount = Util::fast_atoi<unsigned int>(querySizeReader->getDataByDBKey(querySetKey, thread_idx));
             double logPvalThreshold = log(alpha / (orfCount + 1));
             double sumLogPval = 0;
-            for (size_t i = 0; i < dataToAggregate.size(); ++i) {
-                double logPvalue = std::strtod(dataToAggregate[i][1].c_str(), NULL);
+            for (size_t i = 0; i < count; ++i) {
+                double logPvalue = entries[i].value;
                 if (logPvalue < logPvalThreshold) {
                     sumLogPval += logPvalue;
                 }
@@ -188,7 +187,6 @@ public:
         }
         double updatedEval = updatedPval * numTargetSets;
         buffer.append(SSTR(updatedEval));
-        return buffer;
     }
 
 private:
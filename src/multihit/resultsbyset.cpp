@@ -1,6 +1,7 @@
 #include "Debug.h"
 #include "Parameters.h"
 #include "Aggregation.h"
+#include "Util.h"
 
 #include <algorithm>
 
@@ -56,7 +57,7 @@ public:
     SetSummaryAggregator(const std::string &queryDbName, const std::string &targetDbName,
                          const std::string &resultDbName, const std::string &outputDbName, bool shortOutput,
                          float alpha, unsigned int threads, unsigned int compressed)
-            : Aggregation(targetDbName, resultDbName, outputDbName, threads, compressed), alpha(alpha), shortOutput(shortOutput) {
+            : Aggregation(targetDbName, resultDbName, outputDbName, 3, threads, compressed), alpha(alpha), shortOutput(shortOutput) {
         std::string data = queryDbName + "_set_size";
         std::string index = queryDbName + "_set_size.index";
         querySizeReader = new DBReader<unsigned int>(data.c_str(), index.c_str(), threads, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
@@ -87,8 +88,8 @@ public:
 
     void prepareInput(unsigned int, unsigned int) {}
 
-    std::string aggregateEntry(std::vector<std::vector<std::string> > &dataToAggregate, unsigned int querySetKey,
-                               unsigned int targetSetKey, unsigned int thread_idx) {
+    void aggregateEntry(const AggregationEntry *entries, size_t count, unsigned int querySetKey,
+                        unsigned int targetSetKey, unsigned int thread_idx, std::string &buffer) {
         double targetGeneCount = std::strtod(targetSizeReader->getDataByDBKey(targetSetKey, thread_idx), NULL);
         double pvalThreshold = this->alpha / targetGeneCount;
         std::vector<std::pair<long, long>> genesPositions;
@@ -98,26 +99,36 @@ public:
         std::string genesID;
         std::string positionsStr;
         unsigned int nbrGoodEvals = 0;
-        for (std::vector<std::vector<std::string>>::const_iterator it = dataToAggregate.begin();
-             it != dataToAggregate.end(); ++it) {
-            double Pval = std::strtod((*it)[3].c_str(), NULL);
+        const char *columns[255];
+        std::string packedLine;
+        for (size_t i = 0; i < count; ++i) {
+            double Pval = entries[i].value;
             if (Pval >= pvalThreshold) {
                 continue;
             }
 
-            unsigned long start = static_cast<unsigned long>(std::stol((*it)[8]));
-            unsigned long stop = static_cast<unsigned long>(std::stol((*it)[10]));
+            if (entries[i].packed) {
+                packedLine.clear();
+                appendText(entries[i], packedLine);
+                Util::getWordsOfLine(packedLine.c_str(), columns, 255);
+            } else {
+                Util::getWordsOfLine(entries[i].line, columns, 255);
+            }
+            unsigned long start = static_cast<unsigned long>(strtol(columns[8], NULL, 10));
+            unsigned long stop = static_cast<unsigned long>(strtol(columns[10], NULL, 10));
             genesPositions.emplace_back(std::make_pair(start, stop));
             hitsUnderThreshold++;
 
             if (shortOutput) {
                 continue;
             }
-            meanEval += log10(std::strtod((*it)[3].c_str(), NULL));
-            eVals += (*it)[3] + ",";
-            genesID += (*it)[0] + ",";
+            meanEval += log10(Pval);
+            eVals.append(columns[3], Util::skipNoneWhitespace(columns[3]));
+            eVals += ",";
+            genesID.append(columns[0], Util::skipNoneWhitespace(columns[0]));
+            genesID += ",";
             positionsStr += std::to_string(start) + "," + std::to_string(stop) + ",";
-            if (std::strtod((*it)[3].c_str(), NULL) < 1e-10) {
+            if (Pval < 1e-10) {
                 nbrGoodEvals++;
             }
         }
@@ -128,7 +139,6 @@ public:
         double genomeSize = (targetSourceReader->getSeqLen(targetSourceReader->getId(targetSetKey)));
         double rate = ((double) hitsUnderThreshold) / genomeSize;
 
-        std::string buffer;
         if (hitsUnderThreshold > 1) {
             std::vector<long> interGeneSpaces;
             for (size_t i = 0; i < hitsUnderThreshold - 1; i++) {
@@ -200,7 +210,6 @@ public:
             buffer.append("\t");
             buffer.append(eVals);
         }
-        return buffer;
     }
 
 private:
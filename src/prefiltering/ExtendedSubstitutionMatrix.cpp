@@ -4,68 +4,96 @@
 #include "simd.h"
 
 
-#include <iostream>
-#include <iterator>
 #include <cmath>
+#include <climits>
 #include <cstdlib>
+#include <cstring>
 
 #ifdef OPENMP
 #include <omp.h>
 #endif
 
-struct sort_by_score {
-    bool operator()(const std::pair<short,unsigned int> &left, const std::pair<short,unsigned int> &right) const {
-        return left.first > right.first;
-    }
-};
-
 ScoreMatrix ExtendedSubstitutionMatrix::calcScoreMatrix(const BaseMatrix& matrix, const size_t kmerSize){
     short ** subMatrix = matrix.subMatrix;
     const size_t alphabetSize = matrix.alphabetSize;
     size_t size = pow(alphabetSize, kmerSize);
     size_t row_size = size / MAX_ALIGN_INT;
     row_size = (row_size + 1) * MAX_ALIGN_INT; // for SIMD memory alignment
-    // create permutation
-    std::vector<std::vector<int> > input(buildInput(kmerSize,alphabetSize));
-    
+
     // score matrix is O(size^2). 64 is added for SSE
     short * score = (short *) mem_align(MAX_ALIGN_INT, (size * (row_size)) * sizeof(short));
     // index matrix is O(size^2). 64 is added for SSE
     unsigned int * index = (unsigned int *)mem_align(MAX_ALIGN_INT, (size * (row_size)) * sizeof(unsigned int));
 
+    // all k-mers in lexicographic order (first residue changes slowest) and their index
+    std::vector<int> kmers(size * kmerSize);
+    std::vector<unsigned int> kmerIndex(size);
+    Indexer indexer((int) alphabetSize, (int) kmerSize);
+    for (size_t i = 0; i < size; i++) {
+        size_t rest = i;
+        for (size_t pos = kmerSize; pos > 0; pos--) {
+            kmers[i * kmerSize + pos - 1] = rest % alphabetSize;
+            rest /= alphabetSize;
+        }
+        kmerIndex[i] = indexer.int2index(&kmers[i * kmerSize]);
+    }
+
+    // k-mer scores lie within kmerSize times the score range of the substitution matrix
+    int minScore = SHRT_MAX;
+    int maxScore = SHRT_MIN;
+    for (size_t a = 0; a < alphabetSize; a++) {
+        for (size_t b = 0; b < alphabetSize; b++) {
+            minScore = std::min(minScore, static_cast<int>(subMatrix[a][b]));
+            maxScore = std::max(maxScore, static_cast<int>(subMatrix[a][b]));
+        }
+    }
+    const int highestScore = kmerSize * maxScore;
+    const size_t buckets = kmerSize * (maxScore - minScore) + 1;
 
-    std::vector<std::vector<int> > permutation;
-    std::vector<int> outputTemp;
-    createCartesianProduct(permutation, outputTemp, input.begin(), input.end());
 #pragma omp parallel
 {
-    std::pair<short,unsigned int> * tmpScoreMatrix = new std::pair<short, unsigned int> [size];
-    Indexer indexer( (int) alphabetSize, (int) kmerSize);
+    short *rowScore = new short[size];
+    unsigned int *bucketStart = new unsigned int[buckets + 1];
     // fill matrix
 #pragma omp for schedule(static)
-    for(size_t i = 0; i < permutation.size(); i++) {
-        const unsigned int i_index=indexer.int2index(&permutation[i][0]);
-        
-        for(size_t j = 0; j < permutation.size(); j++) {
-            const unsigned int j_index=indexer.int2index(&permutation[j][0]);
-            const short score=calcScore(&permutation[i][0],&permutation[j][0],kmerSize,subMatrix);
-            tmpScoreMatrix[j].first  = score;
-            tmpScoreMatrix[j].second = j_index;
+    for(size_t i = 0; i < size; i++) {
+        // extend the scores of all prefixes by one residue at a time, this keeps the lexicographic order
+        rowScore[0] = 0;
+        size_t prefixes = 1;
+        for (size_t pos = 0; pos < kmerSize; pos++) {
+            const short *subRow = subMatrix[kmers[i * kmerSize + pos]];
+            for (size_t prefix = prefixes; prefix > 0; prefix--) {
+                const short prefixScore = rowScore[prefix - 1];
+                short *extended = rowScore + (prefix - 1) * alphabetSize;
+                for (size_t aa = 0; aa < alphabetSize; aa++) {
+                    extended[aa] = prefixScore + subRow[aa];
+                }
+            }
+            prefixes *= alphabetSize;
+        }
+        memset(bucketStart, 0, (buckets + 1) * sizeof(unsigned int));
+        for(size_t j = 0; j < size; j++) {
+            bucketStart[highestScore - rowScore[j] + 1]++;
         }
-        std::stable_sort (tmpScoreMatrix, tmpScoreMatrix + size, sort_by_score());
-        for (size_t z = 0; z < size; z++) {
-            score[(i_index * row_size) + z] = tmpScoreMatrix[z].first;
-            index[(i_index * row_size) + z] = tmpScoreMatrix[z].second;
+        for (size_t bucket = 1; bucket <= buckets; bucket++) {
+            bucketStart[bucket] += bucketStart[bucket - 1];
+        }
+        // counting sort by decreasing score keeps k-mers with equal score in lexicographic order
+        short *scoreRow = score + kmerIndex[i] * row_size;
+        unsigned int *indexRow = index + kmerIndex[i] * row_size;
+        for (size_t j = 0; j < size; j++) {
+            const unsigned int pos = bucketStart[highestScore - rowScore[j]]++;
+            scoreRow[pos] = rowScore[j];
+            indexRow[pos] = kmerIndex[j];
         }
         for (size_t z = size; z < row_size; z++) {
-            score[(i_index * row_size) + z] = -255;
-            index[(i_index * row_size) + z] = 0;
+            scoreRow[z] = -255;
+            indexRow[z] = 0;
         }
     }
-    delete [] tmpScoreMatrix;
+    delete [] bucketStart;
+    delete [] rowScore;
 }
-    outputTemp.clear();
-    permutation.clear();
 
     return ScoreMatrix(score, index, size, row_size);
 }
@@ -82,50 +110,3 @@ short ExtendedSubstitutionMatrix::calcScore(int * i_seq,int * j_seq,size_t seq_s
     }
     return score;
 }
-
-// Creates the input
-std::vector<std::vector<int> > ExtendedSubstitutionMatrix::buildInput(size_t dimension,size_t range) {
-    std::vector<std::vector<int> >  dimension_vector;
-    
-    for(size_t i = 0; i < dimension; i++) {
-        std::vector<int> range_vector;
-        for(size_t j = 0; j < range; j++) {
-            range_vector.push_back(j);
-        }
-        dimension_vector.push_back(range_vector);
-    }
-    return dimension_vector;
-}
-
-// recursive algorithm to to produce cart. prod.
-// At any given moment, "me" points to some Vi in the middle of the
-// input data set.
-//   for int i in *me:
-//      add i to current result
-//      recurse on next "me"
-//
-void ExtendedSubstitutionMatrix::createCartesianProduct(
-                                                        std::vector<std::vector<int> > & output,  // final result
-                                                        std::vector<int>&  current_result,   // current result
-                                                        std::vector<std::vector<int> >::const_iterator current_input, // current input
-                                                        std::vector<std::vector<int> >::const_iterator end) // final input
-{
-    if(current_input == end) {
-        // terminal condition of the recursion. We no longer have
-        // any input vectors to manipulate. Add the current result (rvi)
-        // to the total set of results (rvvvi).
-        output.push_back(current_result);
-        return;
-    }
-    
-    // need an easy name for my vector-of-ints
-    const std::vector<int>& mevi = *current_input;
-    for(std::vector<int>::const_iterator it = mevi.begin();it != mevi.end();it++) {
-        current_result.push_back(*it);  // add ME
-        createCartesianProduct(output, current_result, current_input+1, end);
-        current_result.pop_back(); // clean current result off for next round
-    }
-}
-
-
-
@@ -55,7 +55,7 @@ Prefiltering::Prefiltering(const std::string &queryDB,
     sameQTDB = isSameQTDB();
 
     // init the substitution matrices
-    switch (querySeqType & 0x7FFFFFFF) {
+    switch (querySeqType & 0x3FFFFFFF) {
         case Parameters::DBTYPE_NUCLEOTIDES:
             kmerSubMat = getSubstitutionMatrix(scoringMatrixFile, alphabetSize, 1.0, false, true);
             ungappedSubMat = kmerSubMat;
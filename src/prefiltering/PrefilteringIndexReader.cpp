@@ -6,7 +6,8 @@
 #include "IndexBuilder.h"
 #include "Parameters.h"
 
-const char*  PrefilteringIndexReader::CURRENT_VERSION = "16";
+// 17: reverse strand flag of linsearch index entries is stored in bit 15 of the k-mer offset
+const char*  PrefilteringIndexReader::CURRENT_VERSION = "17";
 unsigned int PrefilteringIndexReader::VERSION = 0;
 unsigned int PrefilteringIndexReader::META = 1;
 unsigned int PrefilteringIndexReader::SCOREMATRIXNAME = 2;
@@ -11,61 +11,233 @@
 #include <fstream>
 #include <algorithm>
 #include <cassert>
-
-int **makeMatrix(size_t maxNodes) {
-    Debug(Debug::INFO) << "Making matrix ...";
-    size_t dimension = maxNodes * 2;
-    int **M = new int*[dimension];
-    int k = (int)(MathUtil::flog2(dimension)) + 1;
-    for (size_t i = 0; i < dimension; ++i) {
-        M[i] = new int[k]();
+#include <cstdint>
+#include <cstring>
+#include <sys/stat.h>
+
+// layout of a serialized taxonomy, all arrays follow the header aligned to 8 bytes:
+// taxonNodes, D, E, L, H, HEnd, M, block
+struct SerializedTaxonomyHeader {
+    char magic[8];
+    size_t version;
+    size_t maxNodes;
+    size_t maxTaxID;
+    size_t mColumns;
+    size_t blockSize;
+    // size and content hash of the names, nodes and merged dmp files it was built from
+    int64_t sourceSize[3];
+    uint64_t sourceHash[3];
+};
+static const char SERIALIZED_TAXONOMY_MAGIC[8] = "MMSTAX";
+static const size_t SERIALIZED_TAXONOMY_VERSION = 4;
+
+static void statSources(const std::string &namesFile, const std::string &nodesFile, const std::string &mergedFile,
+                        SerializedTaxonomyHeader &header) {
+    const std::string *files[3] = { &namesFile, &nodesFile, &mergedFile };
+    for (size_t i = 0; i < 3; ++i) {
+        struct stat st;
+        header.sourceSize[i] = (stat(files[i]->c_str(), &st) == 0) ? st.st_size : -1;
     }
-    Debug(Debug::INFO) << " Done\n";
-    return M;
 }
 
-void deleteMatrix(int** M, size_t maxNodes) {
-    for (size_t i = 0; i < (maxNodes * 2); ++i) {
-        delete[] M[i];
+// FNV-1a over the content, copies and restored backups keep their hash while the modification time changes
+static void hashSources(const std::string &namesFile, const std::string &nodesFile, const std::string &mergedFile,
+                        SerializedTaxonomyHeader &header) {
+    const std::string *files[3] = { &namesFile, &nodesFile, &mergedFile };
+    std::vector<unsigned char> buffer(1024 * 1024);
+    for (size_t i = 0; i < 3; ++i) {
+        header.sourceHash[i] = 0;
+        FILE *handle = fopen(files[i]->c_str(), "rb");
+        if (handle == NULL) {
+            continue;
+        }
+        uint64_t hash = 14695981039346656037ULL;
+        size_t read;
+        while ((read = fread(buffer.data(), 1, buffer.size(), handle)) > 0) {
+            for (size_t pos = 0; pos < read; ++pos) {
+                hash = (hash ^ buffer[pos]) * 1099511628211ULL;
+            }
+        }
+        fclose(handle);
+        header.sourceHash[i] = hash;
     }
-    delete[] M;
 }
 
+static size_t alignSerialized(size_t offset) {
+    return (offset + 7) & ~static_cast<size_t>(7);
+}
 
 NcbiTaxonomy::NcbiTaxonomy(const std::string &namesFile,  const std::string &nodesFile,
-                           const std::string &mergedFile) {
+                           const std::string &mergedFile) : mappedData(NULL), mappedSize(0) {
     InitLevels();
 
     loadNodes(nodesFile);
     loadMerged(mergedFile);
     loadNames(namesFile);
 
-    maxNodes = taxonNodes.size();
+    maxNodes = nodeStorage.size();
 
-    E.reserve(maxNodes * 2);
-    L.reserve(maxNodes * 2);
+    EStorage.reserve(maxNodes * 2);
+    LStorage.reserve(maxNodes * 2);
 
-    H = new int[maxNodes];
-    std::fill(H, H + maxNodes, 0);
+    HStorage.resize(maxNodes, 0);
+    HEndStorage.resize(maxNodes, 0);
 
-    std::vector< std::vector<TaxID> > children(taxonNodes.size());
-    for (std::vector<TaxonNode>::iterator it = taxonNodes.begin(); it != taxonNodes.end(); ++it) {
+    std::vector< std::vector<TaxID> > children(maxNodes);
+    for (std::vector<TaxonNode>::iterator it = nodeStorage.begin(); it != nodeStorage.end(); ++it) {
         if (it->parentTaxId != it->taxId) {
             children[nodeId(it->parentTaxId)].push_back(it->taxId);
         }
     }
 
     elh(children, 1, 0);
-    E.resize(maxNodes * 2, 0);
-    L.resize(maxNodes * 2, 0);
+    EStorage.resize(maxNodes * 2, 0);
+    LStorage.resize(maxNodes * 2, 0);
 
-    M = makeMatrix(maxNodes);
+    mColumns = (size_t)(MathUtil::flog2(maxNodes * 2)) + 1;
+    MStorage.resize(maxNodes * 2 * mColumns, 0);
+    setPointers();
     InitRangeMinimumQuery();
 }
 
+NcbiTaxonomy::NcbiTaxonomy(const char *data, size_t dataSize) : mappedData(NULL), mappedSize(0) {
+    InitLevels();
+    if (isSerialized(data, dataSize) == false) {
+        Debug(Debug::ERROR) << "Invalid serialized taxonomy\n";
+        EXIT(EXIT_FAILURE);
+    }
+    const SerializedTaxonomyHeader *header = reinterpret_cast<const SerializedTaxonomyHeader *>(data);
+    maxNodes = header->maxNodes;
+    maxTaxID = header->maxTaxID;
+    mColumns = header->mColumns;
+    blockSize = header->blockSize;
+
+    size_t offset = alignSerialized(sizeof(SerializedTaxonomyHeader));
+    taxonNodes = reinterpret_cast<const TaxonNode *>(data + offset);
+    offset = alignSerialized(offset + maxNodes * sizeof(TaxonNode));
+    D = reinterpret_cast<const int *>(data + offset);
+    offset = alignSerialized(offset + (maxTaxID + 1) * sizeof(int));
+    E = reinterpret_cast<const int *>(data + offset);
+    offset = alignSerialized(offset + maxNodes * 2 * sizeof(int));
+    L = reinterpret_cast<const int *>(data + offset);
+    offset = alignSerialized(offset + maxNodes * 2 * sizeof(int));
+    H = reinterpret_cast<const int *>(data + offset);
+    offset = alignSerialized(offset + maxNodes * sizeof(int));
+    HEnd = reinterpret_cast<const int *>(data + offset);
+    offset = alignSerialized(offset + maxNodes * sizeof(int));
+    M = reinterpret_cast<const int *>(data + offset);
+    offset = alignSerialized(offset + maxNodes * 2 * mColumns * sizeof(int));
+    block = data + offset;
+}
+
 NcbiTaxonomy::~NcbiTaxonomy() {
-    delete[] H;
-    deleteMatrix(M, maxNodes);
+    if (mappedData != NULL) {
+        FileUtil::munmapData(mappedData, mappedSize);
+    }
+}
+
+void NcbiTaxonomy::setPointers() {
+    taxonNodes = nodeStorage.data();
+    D = DStorage.data();
+    maxTaxID = DStorage.size() - 1;
+    E = EStorage.data();
+    L = LStorage.data();
+    H = HStorage.data();
+    HEnd = HEndStorage.data();
+    M = MStorage.data();
+    block = blockStorage.data();
+    blockSize = blockStorage.size();
+}
+
+bool NcbiTaxonomy::isSerialized(const char *data, size_t dataSize) {
+    if (dataSize < sizeof(SerializedTaxonomyHeader)) {
+        return false;
+    }
+    const SerializedTaxonomyHeader *header = reinterpret_cast<const SerializedTaxonomyHeader *>(data);
+    if (memcmp(header->magic, SERIALIZED_TAXONOMY_MAGIC, sizeof(SERIALIZED_TAXONOMY_MAGIC)) != 0
+        || header->version != SERIALIZED_TAXONOMY_VERSION) {
+        return false;
+    }
+    size_t offset = alignSerialized(sizeof(SerializedTaxonomyHeader));
+    offset = alignSerialized(offset + header->maxNodes * sizeof(TaxonNode));
+    offset = alignSerialized(offset + (header->maxTaxID + 1) * sizeof(int));
+    offset = alignSerialized(offset + header->maxNodes * 2 * sizeof(int));
+    offset = alignSerialized(offset + header->maxNodes * 2 * sizeof(int));
+    offset = alignSerialized(offset + header->maxNodes * sizeof(int));
+    offset = alignSerialized(offset + header->maxNodes * sizeof(int));
+    offset = alignSerialized(offset + header->maxNodes * 2 * header->mColumns * sizeof(int));
+    return offset + header->blockSize == dataSize;
+}
+
+static void writeSerialized(FILE *handle, const void *data, size_t size, size_t *offset) {
+    const char padding[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    if (fwrite(data, 1, size, handle) != size) {
+        Debug(Debug::ERROR) << "Could not write serialized taxonomy\n";
+        EXIT(EXIT_FAILURE);
+    }
+    *offset += size;
+    size_t aligned = alignSerialized(*offset);
+    if (aligned != *offset && fwrite(padding, 1, aligned - *offset, handle) != aligned - *offset) {
+        Debug(Debug::ERROR) << "Could not write serialized taxonomy\n";
+        EXIT(EXIT_FAILURE);
+    }
+    *offset = aligned;
+}
+
+bool NcbiTaxonomy::isSerializedFrom(const char *data, const std::string &namesFile,
+                                    const std::string &nodesFile, const std::string &mergedFile) {
+    const SerializedTaxonomyHeader *header = reinterpret_cast<const SerializedTaxonomyHeader *>(data);
+    SerializedTaxonomyHeader current;
+    statSources(namesFile, nodesFile, mergedFile, current);
+    if (memcmp(header->sourceSize, current.sourceSize, sizeof(current.sourceSize)) != 0) {
+        return false;
+    }
+    // only files of the same size are read
+    hashSources(namesFile, nodesFile, mergedFile, current);
+    return memcmp(header->sourceHash, current.sourceHash, sizeof(current.sourceHash)) == 0;
+}
+
+void NcbiTaxonomy::serialize(const std::string &file, const std::string &namesFile,
+                             const std::string &nodesFile, const std::string &mergedFile) const {
+    SerializedTaxonomyHeader header;
+    memset(&header, 0, sizeof(SerializedTaxonomyHeader));
+    statSources(namesFile, nodesFile, mergedFile, header);
+    hashSources(namesFile, nodesFile, mergedFile, header);
+    memcpy(header.magic, SERIALIZED_TAXONOMY_MAGIC, sizeof(SERIALIZED_TAXONOMY_MAGIC));
+    header.version = SERIALIZED_TAXONOMY_VERSION;
+    header.maxNodes = maxNodes;
+    header.maxTaxID = maxTaxID;
+    header.mColumns = mColumns;
+    header.blockSize = blockSize;
+
+    // a taxonomy is only replaced once it is complete
+    std::string tmpFile = file + ".tmp";
+    FILE *handle = FileUtil::openFileOrDie(tmpFile.c_str(), "wb", false);
+    size_t offset = 0;
+    writeSerialized(handle, &header, sizeof(SerializedTaxonomyHeader), &offset);
+    // TaxonNode has padding after parentTaxId, the nodes are copied field by field into zeroed memory
+    // so that the file does not contain uninitialised bytes
+    std::vector<char> nodeData(maxNodes * sizeof(TaxonNode), 0);
+    for (size_t i = 0; i < maxNodes; ++i) {
+        TaxonNode *node = reinterpret_cast<TaxonNode *>(&nodeData[i * sizeof(TaxonNode)]);
+        node->id = taxonNodes[i].id;
+        node->taxId = taxonNodes[i].taxId;
+        node->parentTaxId = taxonNodes[i].parentTaxId;
+        node->rankIdx = taxonNodes[i].rankIdx;
+        node->nameIdx = taxonNodes[i].nameIdx;
+    }
+    writeSerialized(handle, nodeData.data(), nodeData.size(), &offset);
+    writeSerialized(handle, D, (maxTaxID + 1) * sizeof(int), &offset);
+    writeSerialized(handle, E, maxNodes * 2 * sizeof(int), &offset);
+    writeSerialized(handle, L, maxNodes * 2 * sizeof(int), &offset);
+    writeSerialized(handle, H, maxNodes * sizeof(int), &offset);
+    writeSerialized(handle, HEnd, maxNodes * sizeof(int), &offset);
+    writeSerialized(handle, M, maxNodes * 2 * mColumns * sizeof(int), &offset);
+    if (fwrite(block, 1, blockSize, handle) != blockSize || fclose(handle) != 0) {
+        Debug(Debug::ERROR) << "Could not write serialized taxonomy " << tmpFile << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    FileUtil::move(tmpFile.c_str(), file.c_str());
 }
 
 void NcbiTaxonomy::InitLevels() {
@@ -132,8 +304,11 @@ size_t NcbiTaxonomy::loadNodes(const std::string &nodesFile) {
     }
 
     std::map<TaxID, int> Dm; // temporary map TaxID -> internal ID;
+    std::map<std::string, size_t> rankIdx; // ranks are shared by many nodes
     int maxTaxID = 0;
     int currentId = 0;
+    // offset 0 is the empty string of nodes without name
+    blockStorage.assign(1, '\0');
     std::string line;
     while (std::getline(ss, line)) {
         std::vector<std::string> result = splitByDelimiter(line, "\t|\t", 3);
@@ -142,28 +317,39 @@ size_t NcbiTaxonomy::loadNodes(const std::string &nodesFile) {
         if (taxId > maxTaxID) {
             maxTaxID = taxId;
         }
-        taxonNodes.emplace_back(currentId, taxId, parentTaxId, result[2]);
+        std::map<std::string, size_t>::iterator rank = rankIdx.find(result[2]);
+        if (rank == rankIdx.end()) {
+            rank = rankIdx.emplace(result[2], addString(result[2])).first;
+        }
+        nodeStorage.emplace_back(currentId, taxId, parentTaxId, rank->second);
         Dm.emplace(taxId, currentId);
         ++currentId;
     }
 
-    D.clear();
-    D.resize(maxTaxID + 1, -1);
+    DStorage.clear();
+    DStorage.resize(maxTaxID + 1, -1);
     for (std::map<TaxID, int>::iterator it = Dm.begin(); it != Dm.end(); ++it) {
         assert(it->first <= maxTaxID);
-        D[it->first] = it->second;
+        DStorage[it->first] = it->second;
     }
+    setPointers();
 
     // Loop over taxonNodes and check all parents exist
-    for (std::vector<TaxonNode>::iterator it = taxonNodes.begin(); it != taxonNodes.end(); ++it) {
+    for (std::vector<TaxonNode>::iterator it = nodeStorage.begin(); it != nodeStorage.end(); ++it) {
         if (!nodeExists(it->parentTaxId)) {
             Debug(Debug::ERROR) << "Inconsistent nodes.dmp taxonomy file! Cannot find parent taxon with ID " << it->parentTaxId << "!\n";
             EXIT(EXIT_FAILURE);
         }
     }
 
-    Debug(Debug::INFO) << " Done, got " << taxonNodes.size() << " nodes\n";
-    return taxonNodes.size();
+    Debug(Debug::INFO) << " Done, got " << nodeStorage.size() << " nodes\n";
+    return nodeStorage.size();
+}
+
+size_t NcbiTaxonomy::addString(const std::string &str) {
+    size_t offset = blockStorage.size();
+    blockStorage.append(str.c_str(), str.size() + 1);
+    return offset;
 }
 
 std::pair<int, std::string> parseName(const std::string &line) {
@@ -194,7 +380,7 @@ void NcbiTaxonomy::loadNames(const std::string &namesFile) {
             Debug(Debug::ERROR) << "loadNames: Taxon " << entry.first << " not present in nodes file!\n";
             EXIT(EXIT_FAILURE);
         }
-        taxonNodes[nodeId(entry.first)].name = entry.second;
+        nodeStorage[nodeId(entry.first)].nameIdx = addString(entry.second);
     }
     Debug(Debug::INFO) << " Done\n";
 }
@@ -204,35 +390,36 @@ void NcbiTaxonomy::elh(std::vector< std::vector<TaxID> > const & children, TaxID
     assert (taxId > 0);
     int id = nodeId(taxId);
 
-    if (H[id] == 0) {
-        H[id] = E.size();
+    if (HStorage[id] == 0) {
+        HStorage[id] = EStorage.size();
     }
 
-    E.emplace_back(id);
-    L.emplace_back(level);
+    EStorage.emplace_back(id);
+    LStorage.emplace_back(level);
 
     for (std::vector<TaxID>::const_iterator child_it = children[id].begin(); child_it != children[id].end(); ++child_it) {
         elh(children, *child_it, level + 1);
     }
-    E.emplace_back(nodeId(taxonNodes[id].parentTaxId));
-    L.emplace_back(level - 1);
+    HEndStorage[id] = EStorage.size();
+    EStorage.emplace_back(nodeId(nodeStorage[id].parentTaxId));
+    LStorage.emplace_back(level - 1);
 }
 
 void NcbiTaxonomy::InitRangeMinimumQuery() {
     Debug(Debug::INFO) << "Init RMQ ...";
 
     for (unsigned int i = 0; i < (maxNodes * 2); ++i) {
-        M[i][0] = i;
+        MStorage[i * mColumns] = i;
     }
 
     for (unsigned int j = 1; (1ul << j) <= (maxNodes * 2); ++j) {
         for (unsigned int i = 0; (i + (1ul << j) - 1) < (maxNodes * 2); ++i) {
-            int A = M[i][j - 1];
-            int B = M[i + (1ul << (j - 1))][j - 1];
+            int A = MStorage[i * mColumns + j - 1];
+            int B = MStorage[(i + (1ul << (j - 1))) * mColumns + j - 1];
             if (L[A] < L[B]) {
-                M[i][j] = A;
+                MStorage[i * mColumns + j] = A;
             } else {
-                M[i][j] = B;
+                MStorage[i * mColumns + j] = B;
             }
         }
     }
@@ -242,8 +429,8 @@ void NcbiTaxonomy::InitRangeMinimumQuery() {
 int NcbiTaxonomy::RangeMinimumQuery(int i, int j) const {
     assert(j >= i);
     int k = (int)MathUtil::flog2(j - i + 1);
-    int A = M[i][k];
-    int B = M[j - MathUtil::ipow<int>(2, k) + 1][k];
+    int A = M[i * mColumns + k];
+    int B = M[(j - MathUtil::ipow<int>(2, k) + 1) * mColumns + k];
     if (L[A] <= L[B]) {
         return A;
     }
@@ -290,7 +477,10 @@ bool NcbiTaxonomy::IsAncestor(TaxID ancestor, TaxID child) {
         return false;
     }
 
-    return lcaHelper(nodeId(child), nodeId(ancestor)) == nodeId(ancestor);
+    // the subtree of a node is a contiguous range of the Euler tour
+    const int childPos = H[nodeId(child)];
+    const int ancestorId = nodeId(ancestor);
+    return H[ancestorId] <= childPos && childPos < HEnd[ancestorId];
 }
 
 
@@ -311,16 +501,27 @@ TaxonNode const * NcbiTaxonomy::LCA(const std::vector<TaxID>& taxa) const {
         ++it;
     }
     if (it == taxa.end()) { return NULL; }
+    // the LCA of all taxa is the shallowest node between their first and last Euler tour position,
+    // a single RMQ instead of one per taxon
     int red = nodeId(*it++);
+    int minPos = H[red];
+    int maxPos = H[red];
     for (; it != taxa.end(); ++it) {
         if (nodeExists(*it)) {
-            red = lcaHelper(red, nodeId(*it));
+            const int id = nodeId(*it);
+            // like lcaHelper the first node of the nodes file absorbs everything
+            red = (red == 0 || id == 0) ? 0 : red;
+            minPos = std::min(minPos, H[id]);
+            maxPos = std::max(maxPos, H[id]);
         } else {
             Debug(Debug::WARNING) << "No node for taxID " << *it << ", ignoring it.\n";
         }
     }
+    if (red != 0 && minPos != maxPos) {
+        red = E[RangeMinimumQuery(minPos, maxPos)];
+    }
 
-    assert(red >= 0 && static_cast<unsigned int>(red) < taxonNodes.size());
+    assert(red >= 0 && static_cast<unsigned int>(red) < maxNodes);
 
     return &(taxonNodes[red]);
 }
@@ -332,11 +533,12 @@ std::vector<std::string> NcbiTaxonomy::AtRanks(TaxonNode const *node, const std:
     std::map<std::string, std::string> allRanks = AllRanks(node);
     // map does not include "no rank" nor "no_rank"
     int baseRankIndex = -1;
-    if (sortedLevels.find(node->rank) != sortedLevels.end()) {
+    std::map<std::string, int>::const_iterator level = sortedLevels.find(getString(node->rankIdx));
+    if (level != sortedLevels.end()) {
         // found rank in map:
-        baseRankIndex = sortedLevels.at(node->rank);
+        baseRankIndex = level->second;
     }
-    std::string baseRank = "uc_" + node->name;
+    std::string baseRank = std::string("uc_") + getString(node->nameIdx);
     for (std::vector<std::string>::const_iterator it = levels.begin(); it != levels.end(); ++it) {
         std::map<std::string, std::string>::iterator jt = allRanks.find(*it);
         if (jt != allRanks.end()) {
@@ -375,9 +577,9 @@ std::string NcbiTaxonomy::taxLineage(TaxonNode const *node) {
     } while (node->parentTaxId != node->taxId);
 
     for (int i = taxLineageVec.size() - 1; i >= 0; --i) {
-        taxLineage += getShortRank(taxLineageVec[i]->rank);
+        taxLineage += getShortRank(getString(taxLineageVec[i]->rankIdx));
         taxLineage += '_';
-        taxLineage += taxLineageVec[i]->name;
+        taxLineage += getString(taxLineageVec[i]->nameIdx);
         if (i > 0) {
             taxLineage += ";";
         }
@@ -394,7 +596,7 @@ int NcbiTaxonomy::nodeId(TaxID taxonId) const {
 }
 
 bool NcbiTaxonomy::nodeExists(TaxID taxonId) const {
-    return D[taxonId] != -1;
+    return taxonId >= 0 && taxonId <= maxTaxID && D[taxonId] != -1;
 }
 
 TaxonNode const * NcbiTaxonomy::taxonNode(TaxID taxonId, bool fail) const {
@@ -407,13 +609,14 @@ TaxonNode const * NcbiTaxonomy::taxonNode(TaxID taxonId, bool fail) const {
 std::map<std::string, std::string> NcbiTaxonomy::AllRanks(TaxonNode const *node) const {
     std::map<std::string, std::string> result;
     while (true) {
+        std::string rank = getString(node->rankIdx);
         if (node->taxId == 1) {
-            result.emplace(node->rank, node->name);
+            result.emplace(rank, getString(node->nameIdx));
             return result;
         }
 
-        if ((node->rank != "no_rank") && (node->rank != "no rank")) {
-            result.emplace(node->rank, node->name);
+        if ((rank != "no_rank") && (rank != "no rank")) {
+            result.emplace(rank, getString(node->nameIdx));
         }
 
         node = taxonNode(node->parentTaxId);
@@ -439,38 +642,36 @@ size_t NcbiTaxonomy::loadMerged(const std::string &mergedFile) {
 
         unsigned int oldId = (unsigned int)strtoul(result[0].c_str(), NULL, 10);
         unsigned int mergedId = (unsigned int)strtoul(result[1].c_str(), NULL, 10);
-        if (!nodeExists(oldId) && nodeExists(mergedId)) {
-            D[oldId] = D[mergedId];
+        const bool oldExists = oldId < DStorage.size() && DStorage[oldId] != -1;
+        const bool mergedExists = mergedId < DStorage.size() && DStorage[mergedId] != -1;
+        if (!oldExists && mergedExists) {
+            if (oldId >= DStorage.size()) {
+                DStorage.resize(oldId + 1, -1);
+            }
+            DStorage[oldId] = DStorage[mergedId];
             ++count;
         }
     }
+    setPointers();
     Debug(Debug::INFO) << " Done, added " << count << " merged nodes.\n";
     return count;
 }
 
-std::unordered_map<TaxID, TaxonCounts> NcbiTaxonomy::getCladeCounts(std::unordered_map<TaxID, unsigned int>& taxonCounts) const {
+std::vector<unsigned int> NcbiTaxonomy::getCladeCounts(const std::vector<unsigned int> &taxonCounts) const {
     Debug(Debug::INFO) << "Calculating clade counts ... ";
-    std::unordered_map<TaxID, TaxonCounts> cladeCounts;
-
-    for (std::unordered_map<TaxID, unsigned int>::const_iterator it = taxonCounts.begin(); it != taxonCounts.end(); ++it) {
-        cladeCounts[it->first].taxCount = it->second;
-        cladeCounts[it->first].cladeCount += it->second;
-        if (nodeExists(it->first)) {
-            TaxonNode const* taxon = taxonNode(it->first);
-            while (taxon->parentTaxId != taxon->taxId && nodeExists(taxon->parentTaxId)) {
-                taxon = taxonNode(taxon->parentTaxId);
-                cladeCounts[taxon->taxId].cladeCount += it->second;
-            }
+    std::vector<unsigned int> cladeCounts(taxonCounts);
+    // a node is first visited after its parent in the Euler tour,
+    // so going backwards over first visits adds every clade before its parent is added
+    for (size_t i = maxNodes * 2; i > 0; --i) {
+        const int node = E[i - 1];
+        if (H[node] != static_cast<int>(i - 1) || cladeCounts[node] == 0) {
+            continue;
         }
-    }
-
-    for (const TaxonNode& tn : taxonNodes) {
-        if (tn.parentTaxId != tn.taxId && cladeCounts.count(tn.taxId)) {
-            std::unordered_map<TaxID, TaxonCounts>::iterator itp = cladeCounts.find(tn.parentTaxId);
-            itp->second.children.push_back(tn.taxId);
+        const TaxonNode &tn = taxonNodes[node];
+        if (tn.parentTaxId != tn.taxId) {
+            cladeCounts[D[tn.parentTaxId]] += cladeCounts[node];
         }
     }
-
     Debug(Debug::INFO) << " Done\n";
     return cladeCounts;
 }
@@ -480,6 +681,7 @@ NcbiTaxonomy * NcbiTaxonomy::openTaxonomy(std::string &database){
     std::string nodesFile = database + "_nodes.dmp";
     std::string namesFile = database + "_names.dmp";
     std::string mergedFile = database + "_merged.dmp";
+    bool hasDmp = true;
     if (FileUtil::fileExists(nodesFile.c_str())
         && FileUtil::fileExists(namesFile.c_str())
         && FileUtil::fileExists(mergedFile.c_str())) {
@@ -490,6 +692,32 @@ NcbiTaxonomy * NcbiTaxonomy::openTaxonomy(std::string &database){
         namesFile = "names.dmp";
         mergedFile = "merged.dmp";
     } else {
+        hasDmp = false;
+    }
+
+    std::string binFile = database + "_taxonomy";
+    if (FileUtil::fileExists(binFile.c_str())) {
+        FILE *handle = FileUtil::openFileOrDie(binFile.c_str(), "r", true);
+        size_t dataSize = 0;
+        void *data = FileUtil::mmapFile(handle, &dataSize);
+        fclose(handle);
+        const char *serialized = static_cast<const char *>(data);
+        if (isSerialized(serialized, dataSize) == false) {
+            Debug(Debug::WARNING) << "Taxonomy " << binFile << " is outdated or corrupted and is ignored\n";
+        } else if (hasDmp && isSerializedFrom(serialized, namesFile, nodesFile, mergedFile) == false) {
+            // edited or replaced dmp files (e.g. a custom taxonomy) take precedence
+            Debug(Debug::WARNING) << "Taxonomy " << binFile << " was not built from the current "
+                                  << nodesFile << ", " << namesFile << " and " << mergedFile
+                                  << ". They are parsed instead, run createbintaxonomy to update it\n";
+        } else {
+            NcbiTaxonomy *taxonomy = new NcbiTaxonomy(serialized, dataSize);
+            taxonomy->mappedData = data;
+            taxonomy->mappedSize = dataSize;
+            return taxonomy;
+        }
+        FileUtil::munmapData(data, dataSize);
+    }
+    if (hasDmp == false) {
         Debug(Debug::ERROR) << "names.dmp, nodes.dmp, merged.dmp from NCBI taxdump could not be found!\n";
         EXIT(EXIT_FAILURE);
     }
@@ -13,29 +13,35 @@
 
 typedef int TaxID;
 
+// rank and name are offsets into the string block of the taxonomy (NcbiTaxonomy::getString)
 struct TaxonNode {
     int id;
     TaxID taxId;
     TaxID parentTaxId;
-    std::string rank;
-    std::string name;
+    size_t rankIdx;
+    size_t nameIdx;
 
-    TaxonNode(int id, TaxID taxId, TaxID parentTaxId, const std::string& rank)
-            : id(id), taxId(taxId), parentTaxId(parentTaxId), rank(rank), name("") {};
-};
-
-struct TaxonCounts {
-    unsigned int taxCount;       // number of reads/sequences matching to taxa
-    unsigned int cladeCount;     // number of reads/sequences matching to taxa or its children
-    std::vector<TaxID> children; // list of children
+    TaxonNode(int id, TaxID taxId, TaxID parentTaxId, size_t rankIdx)
+            : id(id), taxId(taxId), parentTaxId(parentTaxId), rankIdx(rankIdx), nameIdx(0) {};
 };
 
 class NcbiTaxonomy {
 public:
     NcbiTaxonomy(const std::string &namesFile,  const std::string &nodesFile,
                  const std::string &mergedFile);
+    // uses a taxonomy written by serialize, data has to stay valid while the taxonomy is used
+    NcbiTaxonomy(const char *data, size_t dataSize);
     ~NcbiTaxonomy();
 
+    // writes nodes, names, Euler tour and RMQ table in the layout the second constructor maps,
+    // together with the size and content hash of the dmp files the taxonomy was parsed from
+    void serialize(const std::string &file, const std::string &namesFile,
+                   const std::string &nodesFile, const std::string &mergedFile) const;
+    static bool isSerialized(const char *data, size_t dataSize);
+    // false if the dmp files changed since the serialized taxonomy was written
+    static bool isSerializedFrom(const char *data, const std::string &namesFile,
+                                 const std::string &nodesFile, const std::string &mergedFile);
+
     TaxonNode const * LCA(const std::vector<TaxID>& taxa) const;
     TaxID LCA(TaxID taxonA, TaxID taxonB) const;
     std::vector<std::string> AtRanks(TaxonNode const * node, const std::vector<std::string> &levels) const;
@@ -44,8 +50,17 @@ public:
 
     bool IsAncestor(TaxID ancestor, TaxID child);
     TaxonNode const* taxonNode(TaxID taxonId, bool fail = true) const;
-    //std::unordered_map<TaxID, unsigned int> getCladeCounts(std::unordered_map<TaxID, unsigned int>& taxonCounts, TaxID taxon = 1) const;
-    std::unordered_map<TaxID, TaxonCounts> getCladeCounts(std::unordered_map<TaxID, unsigned int>& taxonCounts) const;
+    TaxonNode const* taxonNodeById(int id) const {
+        return &taxonNodes[id];
+    }
+    size_t nodeCount() const {
+        return maxNodes;
+    }
+    const char *getString(size_t blockIdx) const {
+        return block + blockIdx;
+    }
+    // sums the counts of each node (indexed by TaxonNode::id) up to the root
+    std::vector<unsigned int> getCladeCounts(const std::vector<unsigned int> &taxonCounts) const;
 
     static NcbiTaxonomy * openTaxonomy(std::string & database);
 private:
@@ -54,7 +69,9 @@ private:
     size_t loadMerged(const std::string &mergedFile);
     void loadNames(const std::string &namesFile);
     void elh(std::vector< std::vector<TaxID> > const & children, int node, int level);
+    size_t addString(const std::string &str);
     void InitRangeMinimumQuery();
+    void setPointers();
     int nodeId(TaxID taxId) const;
     bool nodeExists(TaxID taxId) const;
 
@@ -62,13 +79,32 @@ private:
     int lcaHelper(int i, int j) const;
     char getShortRank(const std::string& rank) const;
 
-    std::vector<TaxonNode> taxonNodes;
-    std::vector<int> D; // maps from taxID to node ID in taxonNodes
-    std::vector<int> E; // for Euler tour sequence (size 2N-1)
-    std::vector<int> L; // Level of nodes in tour sequence (size 2N-1)
-    int* H;
-    int **M;
+    // all arrays either point into the storage vectors or into the data of a serialized taxonomy
+    const TaxonNode *taxonNodes;
     size_t maxNodes;
+    const int *D; // maps from taxID to node ID in taxonNodes
+    TaxID maxTaxID;
+    const int *E; // for Euler tour sequence (size 2N-1)
+    const int *L; // Level of nodes in tour sequence (size 2N-1)
+    const int *H; // first position of a node in the Euler tour
+    const int *HEnd; // position after the subtree of a node in the Euler tour
+    const int *M; // sparse table of the RMQ, row i starts at i * mColumns
+    size_t mColumns;
+    const char *block; // zero terminated ranks and names
+    size_t blockSize;
+
+    std::vector<TaxonNode> nodeStorage;
+    std::vector<int> DStorage;
+    std::vector<int> EStorage;
+    std::vector<int> LStorage;
+    std::vector<int> HStorage;
+    std::vector<int> HEndStorage;
+    std::vector<int> MStorage;
+    std::string blockStorage;
+
+    // set if the taxonomy was mapped by openTaxonomy
+    void *mappedData;
+    size_t mappedSize;
 
     std::map<std::string, int> sortedLevels;
     std::map<std::string, char> shortRank;
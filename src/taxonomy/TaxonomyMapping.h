@@ -0,0 +1,57 @@
+#ifndef MMSEQS_TAXONOMYMAPPING_H
+#define MMSEQS_TAXONOMYMAPPING_H
+
+#include "NcbiTaxonomy.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// Maps database keys to taxon IDs as given by a <db>_mapping file. Database keys are mostly
+// contiguous, so the lookup is a dense array indexed by key. Very sparse keys fall back
+// to a binary search. If a key is listed more than once, the first taxon is used.
+class TaxonomyMapping {
+public:
+    enum { NOT_FOUND = -1 };
+
+    explicit TaxonomyMapping(const std::string &mappingFile) {
+        std::vector<std::pair<unsigned int, unsigned int> > mapping;
+        bool isSorted = Util::readMapping(mappingFile, mapping);
+        if (isSorted == false) {
+            std::stable_sort(mapping.begin(), mapping.end(), compareByKey);
+        }
+        const size_t maxKey = mapping.empty() ? 0 : mapping.back().first;
+        // the dense array may use at most twice the memory of the sorted pairs
+        if (mapping.empty() == false && maxKey < 4 * mapping.size()) {
+            dense.resize(maxKey + 1, static_cast<TaxID>(NOT_FOUND));
+            for (size_t i = mapping.size(); i > 0; i--) {
+                dense[mapping[i - 1].first] = static_cast<TaxID>(mapping[i - 1].second);
+            }
+        } else {
+            sparse.swap(mapping);
+        }
+    }
+
+    TaxID lookup(unsigned int key) const {
+        if (dense.empty() == false) {
+            return (key < dense.size()) ? dense[key] : static_cast<TaxID>(NOT_FOUND);
+        }
+        std::vector<std::pair<unsigned int, unsigned int> >::const_iterator it =
+                std::lower_bound(sparse.begin(), sparse.end(), std::make_pair(key, 0u), compareByKey);
+        if (it == sparse.end() || it->first != key) {
+            return NOT_FOUND;
+        }
+        return static_cast<TaxID>(it->second);
+    }
+
+private:
+    std::vector<TaxID> dense;
+    std::vector<std::pair<unsigned int, unsigned int> > sparse;
+
+    static bool compareByKey(const std::pair<unsigned int, unsigned int> &lhs, const std::pair<unsigned int, unsigned int> &rhs) {
+        return lhs.first < rhs.first;
+    }
+};
+
+#endif
@@ -1,39 +1,35 @@
 #include "NcbiTaxonomy.h"
+#include "TaxonomyMapping.h"
 #include "Parameters.h"
 #include "DBWriter.h"
 #include "FileUtil.h"
 #include "Debug.h"
 #include "Util.h"
+#include "Matcher.h"
+#include "PackedAlignment.h"
 #include <algorithm>
 
 #ifdef OPENMP
 #include <omp.h>
 #endif
 
-
-static bool compareToFirstInt(const std::pair<unsigned int, unsigned int>& lhs, const std::pair<unsigned int, unsigned int>&  rhs){
-    return (lhs.first <= rhs.first);
-}
-
 int addtaxonomy(int argc, const char **argv, const Command& command) {
     Parameters& par = Parameters::getInstance();
     par.parseParameters(argc, argv, command, true, 0, 0);
 
     NcbiTaxonomy * t = NcbiTaxonomy::openTaxonomy(par.db1);
 
-    std::vector< std::pair<unsigned int, unsigned int> > mapping;
     if(FileUtil::fileExists(std::string(par.db1 + "_mapping").c_str()) == false){
         Debug(Debug::ERROR) << par.db1 + "_mapping" << " does not exist. Please create the taxonomy mapping!\n";
         EXIT(EXIT_FAILURE);
     }
-    bool isSorted = Util::readMapping( par.db1 + "_mapping", mapping);
-    if(isSorted == false){
-        std::stable_sort(mapping.begin(), mapping.end(), compareToFirstInt);
-    }
+    TaxonomyMapping mapping(par.db1 + "_mapping");
     std::vector<std::string> ranks = Util::split(par.lcaRanks, ":");
 
     DBReader<unsigned int> reader(par.db2.c_str(), par.db2Index.c_str(), par.threads, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
     reader.open(DBReader<unsigned int>::LINEAR_ACCCESS);
+    // only alignment results can contain packed records
+    const bool alignmentInput = Parameters::isEqualDbtype(reader.getDbtype(), Parameters::DBTYPE_ALIGNMENT_RES);
 
     DBWriter writer(par.db3.c_str(), par.db3Index.c_str(), par.threads, par.compressed, reader.getDbtype());
     writer.open();
@@ -63,14 +59,11 @@ int addtaxonomy(int argc, const char **argv, const Command& command) {
             if (length == 1) {
                 continue;
             }
-            std::pair<unsigned int, unsigned int> val;
-            std::vector< std::pair<unsigned int, unsigned int> >::iterator mappingIt;
+            TaxID taxon = TaxonomyMapping::NOT_FOUND;
             if(par.pickIdFrom == Parameters::EXTRACT_QUERY){
-                val.first = key;
-                mappingIt = std::upper_bound(mapping.begin(), mapping.end(), val, compareToFirstInt);
+                taxon = mapping.lookup(key);
             }
 
-            std::vector<int> taxa;
             while (*data != '\0') {
                 const size_t columns = Util::getWordsOfLine(data, entry, 255);
                 if (columns == 0) {
@@ -79,27 +72,31 @@ int addtaxonomy(int argc, const char **argv, const Command& command) {
                     continue;
                 }
                 if(par.pickIdFrom == Parameters::EXTRACT_TARGET){
-                    unsigned int id = Util::fast_atoi<unsigned int>(entry[0]);
-                    val.first = id;
-                    mappingIt = std::upper_bound(mapping.begin(), mapping.end(), val, compareToFirstInt);
+                    unsigned int id = (alignmentInput && PackedAlignment::isPacked(data)) ? PackedAlignment::readDbKey(data) : Util::fast_atoi<unsigned int>(entry[0]);
+                    taxon = mapping.lookup(id);
                 }
-                if (mappingIt->first != val.first) {
+                if (taxon == TaxonomyMapping::NOT_FOUND) {
                     taxonNotFound++;
 //                    Debug(Debug::WARNING) << "No taxon mapping provided for id " << id << "\n";
                     data = Util::skipLine(data);
                     continue;
                 }
-                unsigned int taxon = mappingIt->second;
                 TaxonNode const * node = t->taxonNode(taxon, false);
                 if(node == NULL){
                     deletedNodes++;
                     data = Util::skipLine(data);
                     continue;
                 }
-                char * nextData = Util::skipLine(data);
-                size_t dataSize = nextData - data;
-                resultData.append(data, dataSize-1);
-                resultData += '\t' + SSTR(node->taxId) + '\t' + node->rank + '\t' + node->name;
+                if (alignmentInput && PackedAlignment::isPacked(data)) {
+                    // taxonomy columns are text, write the record as text as well
+                    Matcher::packedRecordToText(data, resultData);
+                    resultData.erase(resultData.size() - 1);
+                } else {
+                    char * nextData = Util::skipLine(data);
+                    size_t dataSize = nextData - data;
+                    resultData.append(data, dataSize-1);
+                }
+                resultData += '\t' + SSTR(node->taxId) + '\t' + t->getString(node->rankIdx) + '\t' + t->getString(node->nameIdx);
                 if (!ranks.empty()) {
                     std::string lcaRanks = Util::implode(t->AtRanks(node, ranks), ':');
                     resultData += '\t' + lcaRanks;
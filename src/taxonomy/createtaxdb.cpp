@@ -45,3 +45,17 @@ int createtaxdb(int argc, const char **argv, const Command& command) {
 
     return EXIT_SUCCESS;
 }
+
+int createbintaxonomy(int argc, const char **argv, const Command& command) {
+    Parameters& par = Parameters::getInstance();
+    par.parseParameters(argc, argv, command, true, 0, 0);
+
+    // always parse the dmp files, an existing binary taxonomy might be outdated
+    const std::string namesFile = par.db1 + "_names.dmp";
+    const std::string nodesFile = par.db1 + "_nodes.dmp";
+    const std::string mergedFile = par.db1 + "_merged.dmp";
+    NcbiTaxonomy taxonomy(namesFile, nodesFile, mergedFile);
+    taxonomy.serialize(par.db1 + "_taxonomy", namesFile, nodesFile, mergedFile);
+
+    return EXIT_SUCCESS;
+}
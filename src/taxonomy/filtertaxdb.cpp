@@ -4,6 +4,7 @@
 #include "FileUtil.h"
 #include "Debug.h"
 #include "Util.h"
+#include "PackedAlignment.h"
 #include "TaxonomyExpression.h"
 
 #ifdef OPENMP
@@ -18,6 +19,8 @@ int filtertaxdb(int argc, const char **argv, const Command& command) {
     
     DBReader<unsigned int> reader(par.db2.c_str(), par.db2Index.c_str(), par.threads, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
     reader.open(DBReader<unsigned int>::LINEAR_ACCCESS);
+    // only alignment results can contain packed records
+    const bool alignmentInput = Parameters::isEqualDbtype(reader.getDbtype(), Parameters::DBTYPE_ALIGNMENT_RES);
 
     DBWriter writer(par.db3.c_str(), par.db3Index.c_str(), par.threads, par.compressed, reader.getDbtype());
     writer.open();
@@ -62,7 +65,7 @@ int filtertaxdb(int argc, const char **argv, const Command& command) {
                     goto next;
                 }
 
-                taxon = Util::fast_atoi<unsigned int>(entry[0]);
+                taxon = (alignmentInput && PackedAlignment::isPacked(data)) ? PackedAlignment::readDbKey(data) : Util::fast_atoi<unsigned int>(entry[0]);
                 writer.writeStart(thread_idx);
 
                 isAncestor = (taxonomyExpression.isAncestorOf(*t, taxon) != -1);
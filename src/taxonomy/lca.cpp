@@ -1,36 +1,32 @@
 #include "NcbiTaxonomy.h"
+#include "TaxonomyMapping.h"
 #include "Parameters.h"
 #include "DBWriter.h"
 #include "FileUtil.h"
 #include "Debug.h"
 #include "Util.h"
+#include "PackedAlignment.h"
 #include <algorithm>
 
 #ifdef OPENMP
 #include <omp.h>
 #endif
 
-static bool compareToFirstInt(const std::pair<unsigned int, unsigned int>& lhs, const std::pair<unsigned int, unsigned int>&  rhs){
-    return (lhs.first <= rhs.first);
-}
-
 int lca(int argc, const char **argv, const Command& command) {
     Parameters& par = Parameters::getInstance();
     par.parseParameters(argc, argv, command, true, 0, 0);
     NcbiTaxonomy * t = NcbiTaxonomy::openTaxonomy(par.db1);
 
-    std::vector<std::pair<unsigned int, unsigned int>> mapping;
     if(FileUtil::fileExists(std::string(par.db1 + "_mapping").c_str()) == false){
         Debug(Debug::ERROR) << par.db1 + "_mapping" << " does not exist. Please create the taxonomy mapping!\n";
         EXIT(EXIT_FAILURE);
     }
-    bool isSorted = Util::readMapping( par.db1 + "_mapping", mapping);
-    if(isSorted == false){
-        std::stable_sort(mapping.begin(), mapping.end(), compareToFirstInt);
-    }
+    TaxonomyMapping mapping(par.db1 + "_mapping");
 
     DBReader<unsigned int> reader(par.db2.c_str(), par.db2Index.c_str(), par.threads, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
     reader.open(DBReader<unsigned int>::LINEAR_ACCCESS);
+    // only alignment results can contain packed records
+    const bool alignmentInput = Parameters::isEqualDbtype(reader.getDbtype(), Parameters::DBTYPE_ALIGNMENT_RES);
 
     DBWriter writer(par.db3.c_str(), par.db3Index.c_str(), par.threads, par.compressed, Parameters::DBTYPE_TAXONOMICAL_RESULT);
     writer.open();
@@ -56,6 +52,7 @@ int lca(int argc, const char **argv, const Command& command) {
         char buffer[1024];
         std::string resultData;
         resultData.reserve(4096);
+        std::vector<int> taxa;
         unsigned int thread_idx = 0;
 
 #ifdef OPENMP
@@ -70,30 +67,25 @@ int lca(int argc, const char **argv, const Command& command) {
             char *data = reader.getData(i, thread_idx);
             size_t length = reader.getEntryLen(i);
 
-            std::vector<int> taxa;
+            taxa.clear();
             while (*data != '\0') {
                 TaxID taxon;
                 unsigned int id;
-                std::pair<unsigned int, unsigned int> val;
-                std::vector<std::pair<unsigned int, unsigned int>>::iterator mappingIt;
                 const size_t columns = Util::getWordsOfLine(data, entry, 255);
                 if (columns == 0) {
                     Debug(Debug::WARNING) << "Empty entry: " << i << "!";
                     goto next;
                 }
 
-                id = Util::fast_atoi<unsigned int>(entry[0]);
-                val.first = id;
-                mappingIt = std::upper_bound(mapping.begin(), mapping.end(), val, compareToFirstInt);
-
-                if (mappingIt == mapping.end() || mappingIt->first != val.first) {
+                id = (alignmentInput && PackedAlignment::isPacked(data)) ? PackedAlignment::readDbKey(data) : Util::fast_atoi<unsigned int>(entry[0]);
+                taxon = mapping.lookup(id);
+                if (taxon == TaxonomyMapping::NOT_FOUND) {
                     // TODO: Check which taxa were not found
                     taxonNotFound += 1;
                     data = Util::skipLine(data);
                     continue;
                 }
                 found++;
-                taxon = mappingIt->second;
 
                 // remove blacklisted taxa
                 for (size_t j = 0; j < taxaBlacklistSize; ++j) {
@@ -124,7 +116,7 @@ int lca(int argc, const char **argv, const Command& command) {
             }
 
 
-            resultData = SSTR(node->taxId) + '\t' + node->rank + '\t' + node->name;
+            resultData = SSTR(node->taxId) + '\t' + t->getString(node->rankIdx) + '\t' + t->getString(node->nameIdx);
             if (!ranks.empty()) {
                 std::string lcaRanks = Util::implode(t->AtRanks(node, ranks), ';');
                 resultData += '\t' + lcaRanks;
@@ -7,65 +7,38 @@
 #include "krona_prelude.html.h"
 
 #include <algorithm>
-#include <unordered_map>
 
 #ifdef OPENMP
 #include <omp.h>
 #endif
 
-static bool compareToFirstInt(const std::pair<unsigned int, unsigned int>& lhs, const std::pair<unsigned int, unsigned int>&  rhs){
-    return (lhs.first <= rhs.first);
+// reads per node and per clade with the children (having reads) of each node, all indexed by node id
+struct CladeCounts {
+    std::vector<unsigned int> taxCounts;
+    std::vector<unsigned int> cladeCounts;
+    std::vector<size_t> childOffsets; // children of node i are children[childOffsets[i]] to children[childOffsets[i + 1] - 1]
+    std::vector<int> children;
+};
+
+static std::vector<int> sortedChildren(const CladeCounts &counts, int node) {
+    std::vector<int> children(counts.children.begin() + counts.childOffsets[node], counts.children.begin() + counts.childOffsets[node + 1]);
+    std::sort(children.begin(), children.end(), [&](int a, int b) { return counts.cladeCounts[a] > counts.cladeCounts[b]; });
+    return children;
 }
 
-template<typename K, typename V>
-V at(const std::unordered_map<K, V>& map, K key, V default_value = V()) {
-    typename std::unordered_map<K, V>::const_iterator it = map.find(key);
-    if (it == map.end()) {
-        return default_value;
-    } else {
-        return it->second;
-    }
-}
-
-unsigned int cladeCountVal(const std::unordered_map<TaxID, TaxonCounts>& map, TaxID key) {
-    typename std::unordered_map<TaxID, TaxonCounts>::const_iterator it = map.find(key);
-    if (it == map.end()) {
-        return 0;
-    } else {
-        return it->second.cladeCount;
+void taxReport(FILE* FP, const NcbiTaxonomy& taxDB, const CladeCounts &counts, unsigned long totalReads, int node, int depth = 0) {
+    unsigned int cladeCount = counts.cladeCounts[node];
+    if (cladeCount == 0) {
+        return;
     }
-}
-
-
-void taxReport(FILE* FP, const NcbiTaxonomy& taxDB, const std::unordered_map<TaxID, TaxonCounts> & cladeCounts,unsigned long totalReads,TaxID taxID = 0, int depth = 0) {
-    std::unordered_map<TaxID, TaxonCounts>::const_iterator it = cladeCounts.find(taxID);
-    unsigned int cladeCount = it == cladeCounts.end()? 0 : it->second.cladeCount;
-    unsigned int taxCount = it == cladeCounts.end()? 0 : it->second.taxCount;
-    if (taxID == 0) {
-        if (cladeCount > 0) {
-            fprintf(FP, "%.4f\t%i\t%i\tno rank\t0\tunclassified\n",
-                    100 * cladeCount / double(totalReads),
-                    cladeCount, taxCount);
-        }
-        taxReport(FP, taxDB, cladeCounts, totalReads, 1);
-    } else {
-        if (cladeCount == 0) {
-            return;
-        }
-        const TaxonNode* taxon = taxDB.taxonNode(taxID);
-        fprintf(FP, "%.4f\t%i\t%i\t%s\t%i\t%s%s\n",
-                100*cladeCount/double(totalReads), cladeCount, taxCount,
-                taxon->rank.c_str(), taxID, std::string(2*depth, ' ').c_str(), taxon->name.c_str());
-
-        std::vector<TaxID> children = it->second.children;
-        std::sort(children.begin(), children.end(), [&](int a, int b) { return cladeCountVal(cladeCounts, a) > cladeCountVal(cladeCounts,b); });
-        for (TaxID childTaxId : children) {
-            if (cladeCounts.count(childTaxId)) {
-                taxReport(FP, taxDB, cladeCounts, totalReads, childTaxId, depth + 1);
-            } else {
-                break;
-            }
-        }
+    const TaxonNode* taxon = taxDB.taxonNodeById(node);
+    fprintf(FP, "%.4f\t%i\t%i\t%s\t%i\t%s%s\n",
+            100*cladeCount/double(totalReads), cladeCount, counts.taxCounts[node],
+            taxDB.getString(taxon->rankIdx), taxon->taxId, std::string(2*depth, ' ').c_str(), taxDB.getString(taxon->nameIdx));
+
+    std::vector<int> children = sortedChildren(counts, node);
+    for (size_t i = 0; i < children.size(); ++i) {
+        taxReport(FP, taxDB, counts, totalReads, children[i], depth + 1);
     }
 }
 
@@ -97,36 +70,19 @@ std::string escapeAttribute(const std::string& data) {
     return buffer;
 }
 
-void kronaReport(FILE* FP, const NcbiTaxonomy& taxDB, const std::unordered_map<TaxID, TaxonCounts> & cladeCounts,unsigned long totalReads,TaxID taxID = 0, int depth = 0) {
-    std::unordered_map<TaxID, TaxonCounts>::const_iterator it = cladeCounts.find(taxID);
-    unsigned int cladeCount = it == cladeCounts.end()? 0 : it->second.cladeCount;
-//    unsigned int taxCount = it == cladeCounts.end()? 0 : it->second.taxCount;
+void kronaReport(FILE* FP, const NcbiTaxonomy& taxDB, const CladeCounts &counts, int node) {
+    unsigned int cladeCount = counts.cladeCounts[node];
     if (cladeCount == 0) {
         return;
     }
-    if (taxID == 0) {
-        if (cladeCount > 0) {
-            fprintf(FP, "<node name=\"unclassified\"><magnitude><val>%d</val></magnitude></node>", cladeCount);
-        }
-        kronaReport(FP, taxDB, cladeCounts, totalReads, 1);
-    } else {
-        if (cladeCount == 0) {
-            return;
-        }
-        const TaxonNode* taxon = taxDB.taxonNode(taxID);
-        std::string escapedName = escapeAttribute(taxon->name);
-        fprintf(FP, "<node name=\"%s\"><magnitude><val>%d</val></magnitude>", escapedName.c_str(), cladeCount);
-        std::vector<TaxID> children = it->second.children;
-        std::sort(children.begin(), children.end(), [&](int a, int b) { return cladeCountVal(cladeCounts, a) > cladeCountVal(cladeCounts,b); });
-        for (TaxID childTaxId : children) {
-            if (cladeCounts.count(childTaxId)) {
-                kronaReport(FP, taxDB, cladeCounts, totalReads, childTaxId, depth + 1);
-            } else {
-                break;
-            }
-        }
-        fprintf(FP, "</node>");
+    const TaxonNode* taxon = taxDB.taxonNodeById(node);
+    std::string escapedName = escapeAttribute(taxDB.getString(taxon->nameIdx));
+    fprintf(FP, "<node name=\"%s\"><magnitude><val>%d</val></magnitude>", escapedName.c_str(), cladeCount);
+    std::vector<int> children = sortedChildren(counts, node);
+    for (size_t i = 0; i < children.size(); ++i) {
+        kronaReport(FP, taxDB, counts, children[i]);
     }
+    fprintf(FP, "</node>");
 }
 
 int taxonomyreport(int argc, const char **argv, const Command& command) {
@@ -136,17 +92,12 @@ int taxonomyreport(int argc, const char **argv, const Command& command) {
     // 1. Read taxonomy
     NcbiTaxonomy * taxDB = NcbiTaxonomy::openTaxonomy(par.db1);
 
-    std::vector<std::pair<unsigned int, unsigned int>> mapping;
     if(FileUtil::fileExists(std::string(par.db1 + "_mapping").c_str()) == false){
         Debug(Debug::ERROR) << par.db1 + "_mapping" << " does not exist. Please create the taxonomy mapping!\n";
         EXIT(EXIT_FAILURE);
     }
-    bool isSorted = Util::readMapping( par.db1 + "_mapping", mapping);
-    if(isSorted == false){
-        std::stable_sort(mapping.begin(), mapping.end(), compareToFirstInt);
-    }
 
-    DBReader<unsigned int> reader(par.db2.c_str(), par.db2Index.c_str(), 1, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
+    DBReader<unsigned int> reader(par.db2.c_str(), par.db2Index.c_str(), par.threads, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
     reader.open(DBReader<unsigned int>::LINEAR_ACCCESS);
 
     // TODO: Better way to get file specified by param3?
@@ -157,20 +108,22 @@ int taxonomyreport(int argc, const char **argv, const Command& command) {
     Debug::Progress progress(reader.getSize());
     Debug(Debug::INFO) << "Reading LCA results\n";
 
-
-    std::unordered_map<TaxID, unsigned int> taxCounts;
-
-//  Currentlly not parallel
-//    #pragma omp parallel
+    // every thread counts into its own array, they are summed up afterwards
+    const size_t nodeCount = taxDB->nodeCount();
+    std::vector<std::vector<unsigned int> > threadCounts(par.threads);
+    size_t unclassified = 0;
+    size_t taxonNotFound = 0;
+#pragma omp parallel
     {
         const char *entry[255];
-        //char buffer[1024];
         unsigned int thread_idx = 0;
 #ifdef OPENMP
         thread_idx = (unsigned int) omp_get_thread_num();
 #endif
+        std::vector<unsigned int> &localCounts = threadCounts[thread_idx];
+        localCounts.resize(nodeCount, 0);
 
-//        #pragma omp for schedule(dynamic, 10) reduction (+:taxonNotFound, found)
+#pragma omp for schedule(dynamic, 1000) reduction (+:unclassified, taxonNotFound)
         for (size_t i = 0; i < reader.getSize(); ++i) {
             progress.updateProgress();
 
@@ -179,28 +132,84 @@ int taxonomyreport(int argc, const char **argv, const Command& command) {
             const size_t columns = Util::getWordsOfLine(data, entry, 255);
             if (columns == 0) {
                 Debug(Debug::WARNING) << "Empty entry: " << i << "!";
-            } else {
-                int taxon = Util::fast_atoi<int>(entry[0]);
-                ++taxCounts[taxon];
-                //__sync_fetch_and_add(&(offsets[kmerIdx]), 1);
+                continue;
             }
+            TaxID taxon = Util::fast_atoi<int>(entry[0]);
+            if (taxon == 0) {
+                unclassified++;
+                continue;
+            }
+            const TaxonNode *node = taxDB->taxonNode(taxon, false);
+            if (node == NULL) {
+                taxonNotFound++;
+                continue;
+            }
+            localCounts[node->id]++;
         }
-    };
+    }
+
+    CladeCounts counts;
+    counts.taxCounts.resize(nodeCount, 0);
+    size_t taxaCount = (unclassified > 0) ? 1 : 0;
+#pragma omp parallel for schedule(static) reduction (+:taxaCount)
+    for (size_t i = 0; i < nodeCount; ++i) {
+        unsigned int count = 0;
+        for (size_t j = 0; j < threadCounts.size(); ++j) {
+            count += threadCounts[j].empty() ? 0 : threadCounts[j][i];
+        }
+        counts.taxCounts[i] = count;
+        taxaCount += (count > 0);
+    }
+    threadCounts.clear();
     Debug(Debug::INFO) << "\n";
-    Debug(Debug::INFO) << "Found " << taxCounts.size() << " different taxa for " << reader.getSize() << " different reads.\n";
-    Debug(Debug::INFO) << taxCounts.at(0) << " reads are unclassified.\n";
+    Debug(Debug::INFO) << "Found " << taxaCount << " different taxa for " << reader.getSize() << " different reads.\n";
+    Debug(Debug::INFO) << unclassified << " reads are unclassified.\n";
+    if (taxonNotFound > 0) {
+        Debug(Debug::WARNING) << taxonNotFound << " reads are assigned to taxa missing from the taxonomy.\n";
+    }
 
-    std::unordered_map<TaxID, TaxonCounts> cladeCounts = taxDB->getCladeCounts(taxCounts);
+    counts.cladeCounts = taxDB->getCladeCounts(counts.taxCounts);
+    counts.childOffsets.resize(nodeCount + 1, 0);
+    for (size_t i = 0; i < nodeCount; ++i) {
+        const TaxonNode *node = taxDB->taxonNodeById(i);
+        if (counts.cladeCounts[i] > 0 && node->parentTaxId != node->taxId) {
+            counts.childOffsets[taxDB->taxonNode(node->parentTaxId)->id + 1]++;
+        }
+    }
+    for (size_t i = 0; i < nodeCount; ++i) {
+        counts.childOffsets[i + 1] += counts.childOffsets[i];
+    }
+    counts.children.resize(counts.childOffsets[nodeCount]);
+    std::vector<size_t> fill(counts.childOffsets.begin(), counts.childOffsets.end() - 1);
+    for (size_t i = 0; i < nodeCount; ++i) {
+        const TaxonNode *node = taxDB->taxonNodeById(i);
+        if (counts.cladeCounts[i] > 0 && node->parentTaxId != node->taxId) {
+            counts.children[fill[taxDB->taxonNode(node->parentTaxId)->id]++] = i;
+        }
+    }
+
+    const TaxonNode *root = taxDB->taxonNode(1, false);
     if (par.reportMode == 0) {
-        taxReport(resultFP, *taxDB, cladeCounts, reader.getSize());
+        if (unclassified > 0) {
+            fprintf(resultFP, "%.4f\t%zu\t%zu\tno rank\t0\tunclassified\n",
+                    100 * unclassified / double(reader.getSize()), unclassified, unclassified);
+        }
+        if (root != NULL) {
+            taxReport(resultFP, *taxDB, counts, reader.getSize(), root->id);
+        }
     } else {
         fwrite(krona_prelude_html, krona_prelude_html_len, sizeof(char), resultFP);
         fprintf(resultFP, "<node name=\"all\"><magnitude><val>%zu</val></magnitude>", reader.getSize());
-        kronaReport(resultFP, *taxDB, cladeCounts, reader.getSize());
+        if (unclassified > 0) {
+            fprintf(resultFP, "<node name=\"unclassified\"><magnitude><val>%zu</val></magnitude></node>", unclassified);
+        }
+        if (root != NULL) {
+            kronaReport(resultFP, *taxDB, counts, root->id);
+        }
         fprintf(resultFP, "</node></krona></div></body></html>");
     }
+    fclose(resultFP);
     delete taxDB;
     reader.close();
     return EXIT_SUCCESS;
 }
-
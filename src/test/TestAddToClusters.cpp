@@ -0,0 +1,143 @@
+// Adds sequences to an existing clustering with addtoclusters and compares the updated clustering
+// and the sequences left to cluster with the former swapdb/filterdb/mergedbs pipeline of
+// update_clustering.sh on the keys of a sequence DB (e.g. created from examples/QUERY.fasta).
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+
+#include "Command.h"
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "Matcher.h"
+#include "Parameters.h"
+#include "Util.h"
+
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+const char* binary_name = "test_addtoclusters";
+
+extern std::vector<Command> baseCommands;
+
+static int runModule(const char *name, std::vector<const char *> args) {
+    for (size_t i = 0; i < baseCommands.size(); i++) {
+        if (strcmp(baseCommands[i].cmd, name) == 0) {
+            return baseCommands[i].commandFunction(args.size(), args.data(), baseCommands[i]);
+        }
+    }
+    std::cout << "Unknown module " << name << std::endl;
+    return EXIT_FAILURE;
+}
+
+// members of every cluster in key order, the two pipelines append new members in a different order
+static std::vector<std::pair<unsigned int, std::vector<unsigned int> > > readClusters(const std::string &name) {
+    DBReader<unsigned int> reader(name.c_str(), (name + ".index").c_str(), 1, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
+    reader.open(DBReader<unsigned int>::SORT_BY_ID);
+    std::vector<std::pair<unsigned int, std::vector<unsigned int> > > clusters;
+    char keyBuffer[255];
+    for (size_t i = 0; i < reader.getSize(); i++) {
+        std::vector<unsigned int> members;
+        char *data = reader.getData(i, 0);
+        while (*data != '\0') {
+            Util::parseKey(data, keyBuffer);
+            members.push_back(Util::fast_atoi<unsigned int>(keyBuffer));
+            data = Util::skipLine(data);
+        }
+        std::sort(members.begin(), members.end());
+        clusters.push_back(std::make_pair(reader.getDbKey(i), members));
+    }
+    reader.close();
+    return clusters;
+}
+
+int main (int argc, const char * argv[]) {
+    if (argc < 2) {
+        std::cout << "Usage: " << binary_name << " <sequenceDB>" << std::endl;
+        return 1;
+    }
+#ifdef OPENMP
+    omp_set_num_threads(4);
+#endif
+    srand(1);
+    const std::string seqDb = argv[1];
+    DBReader<unsigned int> seqReader(seqDb.c_str(), (seqDb + ".index").c_str(), 1, DBReader<unsigned int>::USE_INDEX);
+    seqReader.open(DBReader<unsigned int>::NOSORT);
+
+    // every second sequence is part of the old clustering, three old sequences form a cluster
+    std::vector<unsigned int> representatives;
+    DBWriter cluWriter("test_addtoclusters_clu", "test_addtoclusters_clu.index", 1, Parameters::WRITER_ASCII_MODE, Parameters::DBTYPE_CLUSTER_RES);
+    cluWriter.open();
+    std::string members;
+    for (size_t i = 0; i < seqReader.getSize(); i += 2) {
+        if (members.empty()) {
+            representatives.push_back(seqReader.getDbKey(i));
+        }
+        members.append(SSTR(seqReader.getDbKey(i))).append(1, '\n');
+        if ((i / 2) % 3 == 2 || i + 2 >= seqReader.getSize()) {
+            cluWriter.writeData(members.c_str(), members.length(), representatives.back(), 0);
+            members.clear();
+        }
+    }
+    cluWriter.close(true);
+
+    // the search of clusterupdate accepts one hit per new sequence, a third of them has none
+    DBWriter hitWriter("test_addtoclusters_hits", "test_addtoclusters_hits.index", 1, Parameters::WRITER_ASCII_MODE, Parameters::DBTYPE_ALIGNMENT_RES);
+    hitWriter.open();
+    char buffer[1024];
+    size_t noHitCount = 0;
+    for (size_t i = 1; i < seqReader.getSize(); i += 2) {
+        hitWriter.writeStart(0);
+        if (rand() % 3 != 0) {
+            Matcher::result_t hit(representatives[rand() % representatives.size()], 60, 1.0, 1.0, 0.9, 1e-20, 100, 0, 99, 100, 0, 99, 100, "");
+            hitWriter.writeAdd(buffer, Matcher::resultToBuffer(buffer, hit, false, false), 0);
+        } else {
+            noHitCount++;
+        }
+        hitWriter.writeEnd(seqReader.getDbKey(i), 0);
+    }
+    hitWriter.close(true);
+
+    int status = runModule("addtoclusters", {"test_addtoclusters_hits", "test_addtoclusters_clu", seqDb.c_str(),
+                                             "test_addtoclusters_updated", "test_addtoclusters_noHit"});
+    status |= runModule("swapdb", {"test_addtoclusters_hits", "test_addtoclusters_swapped_all"});
+    status |= runModule("filterdb", {"test_addtoclusters_swapped_all", "test_addtoclusters_swapped", "--trim-to-one-column"});
+    status |= runModule("mergedbs", {"test_addtoclusters_clu", "test_addtoclusters_merged", "test_addtoclusters_clu", "test_addtoclusters_swapped"});
+    if (status != EXIT_SUCCESS) {
+        std::cout << "Module failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    bool sameClusters = readClusters("test_addtoclusters_updated") == readClusters("test_addtoclusters_merged");
+    std::cout << "Updated clustering: " << (sameClusters ? "same" : "different") << std::endl;
+
+    // the pipeline extracted the sequences with an empty hit list (awk '$3==1' on the index)
+    DBReader<unsigned int> hitReader("test_addtoclusters_hits", "test_addtoclusters_hits.index", 1, DBReader<unsigned int>::USE_INDEX);
+    hitReader.open(DBReader<unsigned int>::SORT_BY_ID);
+    DBReader<unsigned int> noHitReader("test_addtoclusters_noHit", "test_addtoclusters_noHit.index", 1, DBReader<unsigned int>::USE_INDEX);
+    noHitReader.open(DBReader<unsigned int>::SORT_BY_ID);
+    std::vector<unsigned int> expectedNoHit;
+    for (size_t i = 0; i < hitReader.getSize(); i++) {
+        if (hitReader.getEntryLen(i) == 1) {
+            expectedNoHit.push_back(hitReader.getDbKey(i));
+        }
+    }
+    bool sameNoHit = expectedNoHit.size() == noHitCount && expectedNoHit.size() == noHitReader.getSize();
+    for (size_t i = 0; sameNoHit && i < noHitReader.getSize(); i++) {
+        const unsigned int key = noHitReader.getDbKey(i);
+        const size_t seqId = seqReader.getId(key);
+        sameNoHit &= (key == expectedNoHit[i]) && seqId != UINT_MAX
+                     && noHitReader.getOffset(i) == seqReader.getOffset(seqId)
+                     && noHitReader.getEntryLen(i) == seqReader.getEntryLen(seqId);
+    }
+    std::cout << "Sequences without hit: " << noHitReader.getSize() << " " << (sameNoHit ? "same" : "different") << std::endl;
+    noHitReader.close();
+    hitReader.close();
+    seqReader.close();
+
+    return (sameClusters && sameNoHit) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -30,6 +30,11 @@ int main (int, const char**) {
                                    3, 15, 22, 4, 18, 354, "MMMMMIIMMMMDDMMMMMM");
     size_t len = Matcher::resultToBuffer(buffer, result, true, false);
     std::cout << std::string(buffer, len) << std::endl;
+    len = Matcher::resultToPackedBuffer(buffer, result, true);
+    Matcher::result_t packedResult = Matcher::parseAlignmentRecord(buffer, true);
+    std::cout << "Packed: " << len << " bytes" << std::endl;
+    len = Matcher::resultToBuffer(buffer, packedResult, true, false);
+    std::cout << std::string(buffer, len) << std::endl;
 
     SubstitutionMatrix subMat("blosum62.out", 2.0, -0.0f);
     std::cout << "Subustitution matrix:\n";
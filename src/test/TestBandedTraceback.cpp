@@ -0,0 +1,125 @@
+// Aligns random related sequence pairs with SmithWaterman::ssw_align once with the full direction
+// matrix of banded_sw and once with the checkpointed trace back (threshold lowered to 0, so every
+// CIGAR is traced back from checkpoints) and compares scores, positions and CIGARs.
+#include <iostream>
+#include <string>
+#include <cstdlib>
+
+#include "Sequence.h"
+#include "SubstitutionMatrix.h"
+#include "StripedSmithWaterman.h"
+#include "EvalueComputation.h"
+#include "Parameters.h"
+
+const char* binary_name = "test_bandedtraceback";
+
+static const char *residues = "ACDEFGHIKLMNPQRSTVWY";
+
+static std::string randomSequence(size_t length) {
+    std::string seq;
+    for (size_t i = 0; i < length; i++) {
+        seq.push_back(residues[rand() % 20]);
+    }
+    return seq;
+}
+
+// substitutions and insertions/deletions of up to maxIndel residues, so banded_sw has to widen its band
+static std::string mutate(const std::string &seq, int substitutionRate, int indelRate, int maxIndel) {
+    std::string result;
+    for (size_t i = 0; i < seq.size(); i++) {
+        const int r = rand() % 100;
+        if (r < indelRate / 2) {
+            i += rand() % maxIndel;
+            continue;
+        }
+        if (r < indelRate) {
+            result.append(randomSequence(1 + rand() % maxIndel));
+        }
+        result.push_back((rand() % 100 < substitutionRate) ? residues[rand() % 20] : seq[i]);
+    }
+    return result;
+}
+
+static bool sameAlignment(const s_align &full, const s_align &checkpointed) {
+    if (full.score1 != checkpointed.score1 || full.qStartPos1 != checkpointed.qStartPos1 || full.qEndPos1 != checkpointed.qEndPos1
+        || full.dbStartPos1 != checkpointed.dbStartPos1 || full.dbEndPos1 != checkpointed.dbEndPos1
+        || full.cigarLen != checkpointed.cigarLen || (full.cigar == NULL) != (checkpointed.cigar == NULL)) {
+        return false;
+    }
+    for (int32_t c = 0; c < full.cigarLen; c++) {
+        if (full.cigar[c] != checkpointed.cigar[c]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main (int, const char**) {
+    srand(1);
+    Parameters &par = Parameters::getInstance();
+    SubstitutionMatrix subMat(par.scoringMatrixFile.aminoacids, 2.0, 0.0);
+    int8_t *tinySubMat = new int8_t[subMat.alphabetSize * subMat.alphabetSize];
+    for (int i = 0; i < subMat.alphabetSize; i++) {
+        for (int j = 0; j < subMat.alphabetSize; j++) {
+            tinySubMat[i * subMat.alphabetSize + j] = (int8_t) subMat.subMatrix[i][j];
+        }
+    }
+    const int gapOpen = 11;
+    const int gapExtend = 1;
+    EvalueComputation evaluer(100000, &subMat, gapOpen, gapExtend);
+    const size_t maxLen = 10000;
+    Sequence query(maxLen, Parameters::DBTYPE_AMINO_ACIDS, &subMat, 6, false, false);
+    Sequence target(maxLen, Parameters::DBTYPE_AMINO_ACIDS, &subMat, 6, false, false);
+
+    size_t pairs = 0;
+    size_t withCigar = 0;
+    size_t mismatches = 0;
+    for (int biasCorrection = 0; biasCorrection < 2; biasCorrection++) {
+        SmithWaterman full(maxLen, subMat.alphabetSize, biasCorrection);
+        SmithWaterman checkpointed(maxLen, subMat.alphabetSize, biasCorrection);
+        checkpointed.setMaxDirectionSize(0);
+        for (size_t pair = 0; pair < 300; pair++) {
+            // short queries have a single checkpoint block, long ones many
+            const size_t length = (pair % 3 == 0) ? 10 + rand() % 90 : 100 + rand() % 3000;
+            const std::string querySeq = randomSequence(length);
+            std::string targetSeq;
+            switch (pair % 4) {
+                case 0:
+                    targetSeq = mutate(querySeq, 10, 2, 5);
+                    break;
+                case 1:
+                    targetSeq = mutate(querySeq, 40, 6, 30);
+                    break;
+                case 2:
+                    // local hit inside unrelated flanks
+                    targetSeq = randomSequence(rand() % 200) + mutate(querySeq.substr(length / 4, length / 2), 25, 4, 10) + randomSequence(rand() % 200);
+                    break;
+                default:
+                    targetSeq = randomSequence(50 + rand() % 1000);
+                    break;
+            }
+            if (targetSeq.size() >= maxLen) {
+                targetSeq.resize(maxLen - 1);
+            }
+            query.mapSequence(0, 0, querySeq.c_str(), querySeq.size());
+            target.mapSequence(1, 1, targetSeq.c_str(), targetSeq.size());
+            full.ssw_init(&query, tinySubMat, &subMat, subMat.alphabetSize, 2);
+            checkpointed.ssw_init(&query, tinySubMat, &subMat, subMat.alphabetSize, 2);
+            s_align fullAlignment = full.ssw_align(target.int_sequence, target.L, gapOpen, gapExtend, 2, 10000, &evaluer, 0, 0.0, query.L / 2);
+            s_align checkpointedAlignment = checkpointed.ssw_align(target.int_sequence, target.L, gapOpen, gapExtend, 2, 10000, &evaluer, 0, 0.0, query.L / 2);
+            pairs++;
+            withCigar += (fullAlignment.cigar != NULL);
+            if (sameAlignment(fullAlignment, checkpointedAlignment) == false) {
+                mismatches++;
+                std::cout << "Pair " << pair << " (query length " << query.L << ", target length " << target.L << "): score "
+                          << fullAlignment.score1 << " vs " << checkpointedAlignment.score1 << ", CIGAR length "
+                          << fullAlignment.cigarLen << " vs " << checkpointedAlignment.cigarLen << std::endl;
+            }
+            delete [] fullAlignment.cigar;
+            delete [] checkpointedAlignment.cigar;
+        }
+    }
+    std::cout << "Pairs: " << pairs << " with CIGAR: " << withCigar << " mismatches: " << mismatches << std::endl;
+    delete [] tinySubMat;
+    return (mismatches == 0 && withCigar > 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,109 @@
+// Clusters a random asymmetric alignment graph with clust once in memory and once symmetrised
+// on disk (tiny --split-memory-limit) and compares the clusterings of all cluster modes.
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+#include "Command.h"
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "Matcher.h"
+#include "Parameters.h"
+#include "Util.h"
+
+const char* binary_name = "test_clusteringexternal";
+
+extern std::vector<Command> baseCommands;
+
+static int runModule(const char *name, std::vector<const char *> args) {
+    for (size_t i = 0; i < baseCommands.size(); i++) {
+        if (strcmp(baseCommands[i].cmd, name) == 0) {
+            // parameters keep their values between runs, but each run may set them again
+            for (size_t parIdx = 0; parIdx < baseCommands[i].params->size(); parIdx++) {
+                baseCommands[i].params->at(parIdx)->wasSet = false;
+            }
+            return baseCommands[i].commandFunction(args.size(), args.data(), baseCommands[i]);
+        }
+    }
+    std::cout << "Unknown module " << name << std::endl;
+    return EXIT_FAILURE;
+}
+
+static bool compareDatabases(const std::string &first, const std::string &second) {
+    DBReader<unsigned int> firstReader(first.c_str(), (first + ".index").c_str(), 1, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
+    firstReader.open(DBReader<unsigned int>::NOSORT);
+    DBReader<unsigned int> secondReader(second.c_str(), (second + ".index").c_str(), 1, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
+    secondReader.open(DBReader<unsigned int>::NOSORT);
+    bool same = firstReader.getSize() == secondReader.getSize();
+    for (size_t i = 0; same && i < firstReader.getSize(); i++) {
+        const char *secondData = secondReader.getDataByDBKey(firstReader.getDbKey(i), 0);
+        same &= secondData != NULL && strcmp(firstReader.getData(i, 0), secondData) == 0;
+    }
+    firstReader.close();
+    secondReader.close();
+    return same;
+}
+
+int main (int, const char**) {
+    srand(1);
+    const size_t dbSize = 3000;
+    const char *residues = "ACDEFGHIKLMNPQRSTVWY";
+    DBWriter seqWriter("test_clustext_seq", "test_clustext_seq.index", 1, Parameters::WRITER_ASCII_MODE, Parameters::DBTYPE_AMINO_ACIDS);
+    seqWriter.open();
+    std::vector<unsigned int> seqLens;
+    for (size_t i = 0; i < dbSize; i++) {
+        std::string seq;
+        seqLens.push_back(50 + rand() % 200);
+        for (size_t pos = 0; pos < seqLens.back(); pos++) {
+            seq.push_back(residues[rand() % 20]);
+        }
+        seq.push_back('\n');
+        seqWriter.writeData(seq.c_str(), seq.size(), i, 0);
+    }
+    seqWriter.close(true);
+
+    // every set starts with its own sequence, most connections only go in one direction
+    DBWriter alnWriter("test_clustext_aln", "test_clustext_aln.index", 1, Parameters::WRITER_ASCII_MODE, Parameters::DBTYPE_ALIGNMENT_RES);
+    alnWriter.open();
+    char buffer[1024];
+    for (size_t i = 0; i < dbSize; i++) {
+        alnWriter.writeStart(0);
+        Matcher::result_t self(i, 500, 1.0, 1.0, 1.0, 1e-100, seqLens[i], 0, seqLens[i] - 1, seqLens[i], 0, seqLens[i] - 1, seqLens[i], "");
+        alnWriter.writeAdd(buffer, Matcher::resultToBuffer(buffer, self, false, false), 0);
+        const size_t hits = rand() % 12;
+        for (size_t hit = 0; hit < hits; hit++) {
+            // neighbours are close by, so clusters overlap
+            const unsigned int target = (i + 1 + rand() % 50) % dbSize;
+            Matcher::result_t res(target, 50 + rand() % 400, 0.9, 0.9, 0.5 + (rand() % 500) / 1000.0f, 1e-10,
+                                  seqLens[i], 0, seqLens[i] - 1, seqLens[i], 0, seqLens[target] - 1, seqLens[target], "");
+            alnWriter.writeAdd(buffer, Matcher::resultToBuffer(buffer, res, false, false), 0);
+        }
+        // a few hub sequences are hit by many sets, their buckets are assembled in several rounds
+        if (i % 4 == 0 && i % 16 > 0) {
+            const unsigned int hub = i % 16;
+            Matcher::result_t res(hub, 100, 0.9, 0.9, 0.6, 1e-10,
+                                  seqLens[i], 0, seqLens[i] - 1, seqLens[i], 0, seqLens[hub] - 1, seqLens[hub], "");
+            alnWriter.writeAdd(buffer, Matcher::resultToBuffer(buffer, res, false, false), 0);
+        }
+        alnWriter.writeEnd(i, 0);
+    }
+    alnWriter.close(true);
+
+    bool success = true;
+    const char *modes[] = {"0", "1", "2"};
+    for (size_t mode = 0; mode < sizeof(modes) / sizeof(char *); mode++) {
+        const std::string memory = std::string("test_clustext_memory_") + modes[mode];
+        const std::string disk = std::string("test_clustext_disk_") + modes[mode];
+        int status = runModule("clust", {"test_clustext_seq", "test_clustext_aln", memory.c_str(), "--cluster-mode", modes[mode],
+                                      "--split-memory-limit", "0", "--threads", "4"});
+        status |= runModule("clust", {"test_clustext_seq", "test_clustext_aln", disk.c_str(), "--cluster-mode", modes[mode],
+                                      "--split-memory-limit", "2K", "--threads", "4"});
+        const bool same = status == EXIT_SUCCESS && compareDatabases(memory, disk);
+        std::cout << "Cluster mode " << modes[mode] << ": " << (same ? "same" : "different") << std::endl;
+        success &= same;
+    }
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
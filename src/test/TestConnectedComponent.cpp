@@ -0,0 +1,162 @@
+// Clusters a random alignment graph with clust --cluster-mode 1 (union-find, level-parallel depth check)
+// and compares the clustering with the former breadth first search from every unassigned representative.
+// The graph has one component large enough for the level-parallel search, chains that the depth limit
+// splits up and many small components.
+#include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <queue>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+
+#include "Command.h"
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "Matcher.h"
+#include "Parameters.h"
+#include "Util.h"
+
+const char* binary_name = "test_connectedcomponent";
+
+extern std::vector<Command> baseCommands;
+
+static int runModule(const char *name, std::vector<const char *> args) {
+    for (size_t i = 0; i < baseCommands.size(); i++) {
+        if (strcmp(baseCommands[i].cmd, name) == 0) {
+            // parameters keep their values between runs, but each run may set them again
+            for (size_t parIdx = 0; parIdx < baseCommands[i].params->size(); parIdx++) {
+                baseCommands[i].params->at(parIdx)->wasSet = false;
+            }
+            return baseCommands[i].commandFunction(args.size(), args.data(), baseCommands[i]);
+        }
+    }
+    std::cout << "Unknown module " << name << std::endl;
+    return EXIT_FAILURE;
+}
+
+typedef std::map<unsigned int, std::vector<unsigned int> > Clustering;
+
+static Clustering readClusters(const std::string &name) {
+    DBReader<unsigned int> reader(name.c_str(), (name + ".index").c_str(), 1, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
+    reader.open(DBReader<unsigned int>::NOSORT);
+    Clustering clusters;
+    char keyBuffer[255];
+    for (size_t i = 0; i < reader.getSize(); i++) {
+        std::vector<unsigned int> &members = clusters[reader.getDbKey(i)];
+        char *data = reader.getData(i, 0);
+        while (*data != '\0') {
+            Util::parseKey(data, keyBuffer);
+            members.push_back(Util::fast_atoi<unsigned int>(keyBuffer));
+            data = Util::skipLine(data);
+        }
+        std::sort(members.begin(), members.end());
+    }
+    reader.close();
+    return clusters;
+}
+
+// connected component mode before the union-find: representatives in order of decreasing set size
+// (ties by decreasing key) start a breadth first search unless they were already assigned
+static Clustering referenceClusters(const std::vector<std::set<unsigned int> > &sets, int maxiterations) {
+    const size_t dbSize = sets.size();
+    std::vector<std::pair<size_t, unsigned int> > order;
+    for (size_t i = 0; i < dbSize; i++) {
+        order.push_back(std::make_pair(sets[i].size(), i));
+    }
+    std::sort(order.begin(), order.end());
+    std::vector<unsigned int> assignedcluster(dbSize, UINT_MAX);
+    for (size_t pos = dbSize; pos > 0; pos--) {
+        const unsigned int representative = order[pos - 1].second;
+        if (assignedcluster[representative] != UINT_MAX) {
+            continue;
+        }
+        assignedcluster[representative] = representative;
+        std::queue<std::pair<unsigned int, int> > queue;
+        queue.push(std::make_pair(representative, 0));
+        while (queue.empty() == false) {
+            const unsigned int currentid = queue.front().first;
+            const int iterationcutoff = queue.front().second;
+            queue.pop();
+            assignedcluster[currentid] = representative;
+            for (std::set<unsigned int>::const_iterator it = sets[currentid].begin(); it != sets[currentid].end(); ++it) {
+                if (assignedcluster[*it] == UINT_MAX && iterationcutoff < maxiterations) {
+                    queue.push(std::make_pair(*it, iterationcutoff + 1));
+                }
+                assignedcluster[*it] = representative;
+            }
+        }
+    }
+    Clustering clusters;
+    for (size_t i = 0; i < dbSize; i++) {
+        clusters[assignedcluster[i]].push_back(i);
+    }
+    return clusters;
+}
+
+int main (int, const char**) {
+    srand(1);
+    const size_t largeComponent = 120000;
+    const size_t chainLength = 100;
+    const size_t chainEnd = largeComponent + 100 * chainLength;
+    const size_t dbSize = chainEnd + 20000;
+
+    // hits only go in one direction, clust adds the missing connections
+    std::vector<std::set<unsigned int> > hits(dbSize);
+    for (size_t i = 0; i < dbSize; i++) {
+        hits[i].insert(i);
+    }
+    for (size_t i = 1; i < largeComponent; i++) {
+        hits[i].insert(rand() % i);
+        hits[rand() % largeComponent].insert(i);
+    }
+    for (size_t i = largeComponent; i < chainEnd; i++) {
+        if ((i - largeComponent) % chainLength != chainLength - 1) {
+            hits[i].insert(i + 1);
+        }
+    }
+    for (size_t start = chainEnd; start < dbSize;) {
+        const size_t groupSize = std::min(dbSize - start, static_cast<size_t>(2 + rand() % 20));
+        for (size_t hit = 0; hit < groupSize * 2; hit++) {
+            hits[start + rand() % groupSize].insert(start + rand() % groupSize);
+        }
+        start += groupSize;
+    }
+
+    DBWriter seqWriter("test_cc_seq", "test_cc_seq.index", 1, Parameters::WRITER_ASCII_MODE, Parameters::DBTYPE_AMINO_ACIDS);
+    seqWriter.open();
+    DBWriter alnWriter("test_cc_aln", "test_cc_aln.index", 1, Parameters::WRITER_ASCII_MODE, Parameters::DBTYPE_ALIGNMENT_RES);
+    alnWriter.open();
+    std::vector<std::set<unsigned int> > sets(dbSize);
+    char buffer[1024];
+    for (size_t i = 0; i < dbSize; i++) {
+        seqWriter.writeData("MKV\n", 4, i, 0);
+        alnWriter.writeStart(0);
+        for (std::set<unsigned int>::const_iterator it = hits[i].begin(); it != hits[i].end(); ++it) {
+            Matcher::result_t res(*it, 100, 0.9, 0.9, 0.9, 1e-10, 3, 0, 2, 3, 0, 2, 3, "");
+            alnWriter.writeAdd(buffer, Matcher::resultToBuffer(buffer, res, false, false), 0);
+            sets[i].insert(*it);
+            sets[*it].insert(i);
+        }
+        alnWriter.writeEnd(i, 0);
+    }
+    alnWriter.close(true);
+    seqWriter.close(true);
+
+    bool success = true;
+    // the large component is complete within 1000 and 40 steps, the chains and the large component not within 3
+    const char *depths[] = {"1000", "40", "3"};
+    for (size_t d = 0; d < sizeof(depths) / sizeof(char *); d++) {
+        const std::string result = std::string("test_cc_clu_") + depths[d];
+        const int status = runModule("clust", {"test_cc_seq", "test_cc_aln", result.c_str(), "--cluster-mode", "1",
+                                               "--max-iterations", depths[d], "--threads", "4"});
+        const Clustering expected = referenceClusters(sets, atoi(depths[d]));
+        const bool same = status == EXIT_SUCCESS && readClusters(result) == expected;
+        std::cout << "Max depth " << depths[d] << ": " << expected.size() << " clusters " << (same ? "same" : "different") << std::endl;
+        success &= same;
+    }
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,222 @@
+// Compares the k-mers that linclust extracts with fillKmerPositionArray with the former
+// per k-mer scalar hashing and full sort on the sequences of a database
+#include "kmermatcher.h"
+#include "Sequence.h"
+#include "Indexer.h"
+#include "SubstitutionMatrix.h"
+#include "ReducedMatrix.h"
+#include "NucleotideMatrix.h"
+#include "DBReader.h"
+#include "Parameters.h"
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <sys/time.h>
+
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+#ifndef SIZE_T_MAX
+#define SIZE_T_MAX ((size_t) -1)
+#endif
+
+const char* binary_name = "test_kmerhashselection";
+
+static bool compareKmerIdPos(const KmerPosition<short> &first, const KmerPosition<short> &second) {
+    if (first.kmer != second.kmer) {
+        return first.kmer < second.kmer;
+    }
+    if (first.id != second.id) {
+        return first.id < second.id;
+    }
+    if (first.pos != second.pos) {
+        return first.pos < second.pos;
+    }
+    return first.seqLen < second.seqLen;
+}
+
+static void addKmer(std::vector<KmerPosition<short> > &out, size_t kmer, unsigned int id, short pos, short seqLen) {
+    KmerPosition<short> kmerPos;
+    kmerPos.kmer = kmer;
+    kmerPos.id = id;
+    kmerPos.pos = pos;
+    kmerPos.seqLen = seqLen;
+    out.push_back(kmerPos);
+}
+
+// the selection of fillKmerPositionArray before the k-mer windows were hashed in bulk,
+// without --adjust-kmer-len (MarkovKmerScore.h can only be included by kmermatcher.cpp)
+template <int TYPE>
+static void referenceKmers(DBReader<unsigned int> &reader, Parameters &par, BaseMatrix *subMat, const size_t KMER_SIZE,
+                           size_t chooseTopKmer, std::vector<KmerPosition<short> > &out) {
+    Sequence seq(par.maxSeqLen, reader.getDbtype(), subMat, KMER_SIZE, false, false);
+    Indexer idxer(subMat->alphabetSize - 1, KMER_SIZE);
+    SequencePosition *kmers = new SequencePosition[par.maxSeqLen + 1];
+    int highestSeq[32];
+    for (size_t i = 0; i < KMER_SIZE; i++) {
+        highestSeq[i] = subMat->alphabetSize - 1;
+    }
+    size_t highestPossibleIndex = idxer.int2index(highestSeq);
+    const int xResidue = subMat->aa2int[(int) 'X'];
+    for (size_t id = 0; id < reader.getSize(); id++) {
+        seq.mapSequence(id, reader.getDbKey(id), reader.getData(id, 0), reader.getSeqLen(id));
+        size_t seqHash = highestPossibleIndex + static_cast<unsigned int>(Util::hash(seq.int_sequence, seq.L));
+        int seqKmerCount = 0;
+        unsigned short prevHash = 0;
+        unsigned int prevFirstRes = 0;
+        if (seq.hasNextKmer()) {
+            const int *kmer = seq.nextKmer();
+            prevHash = circ_hash(kmer, KMER_SIZE, par.hashShift);
+            prevFirstRes = kmer[0];
+        }
+        while (seq.hasNextKmer()) {
+            const int *kmer = seq.nextKmer();
+            if (TYPE != Parameters::DBTYPE_NUCLEOTIDES) {
+                prevHash = circ_hash_next(kmer, KMER_SIZE, prevFirstRes, prevHash, par.hashShift);
+                prevFirstRes = kmer[0];
+            }
+            size_t xCount = 0;
+            for (size_t kpos = 0; kpos < KMER_SIZE; kpos++) {
+                xCount += (kmer[kpos] == xResidue);
+            }
+            if (xCount > 0) {
+                continue;
+            }
+            if (TYPE == Parameters::DBTYPE_NUCLEOTIDES) {
+                int revKmer[32];
+                NucleotideMatrix *nuclMatrix = (NucleotideMatrix *) subMat;
+                size_t kmerLen = KMER_SIZE;
+                const int *kmerToHash = kmer;
+                size_t kmerIdx = Indexer::computeKmerIdx(kmer, kmerLen);
+                size_t revkmerIdx = Util::revComplement(kmerIdx, kmerLen);
+                bool pickReverseKmer = (revkmerIdx < kmerIdx);
+                kmerIdx = (pickReverseKmer) ? revkmerIdx : kmerIdx;
+                if (pickReverseKmer) {
+                    for (int pos = static_cast<int>(KMER_SIZE) - 1; pos > -1; pos--) {
+                        revKmer[(KMER_SIZE - 1) - pos] = nuclMatrix->reverseResidue(kmer[pos]);
+                    }
+                    kmerToHash = revKmer;
+                }
+                prevHash = circ_hash(kmerToHash, kmerLen, par.hashShift);
+                kmers[seqKmerCount].kmer = (pickReverseKmer) ? BIT_CLEAR(kmerIdx, 63) : BIT_SET(kmerIdx, 63);
+                int pos = seq.getCurrentPosition();
+                kmers[seqKmerCount].pos = (pickReverseKmer) ? (seq.L) - pos - kmerLen : pos;
+            } else {
+                kmers[seqKmerCount].kmer = idxer.int2index(kmer, 0, KMER_SIZE);
+                kmers[seqKmerCount].pos = seq.getCurrentPosition();
+            }
+            kmers[seqKmerCount].score = prevHash;
+            seqKmerCount++;
+        }
+        if (seqKmerCount > 1) {
+            if (TYPE == Parameters::DBTYPE_NUCLEOTIDES) {
+                std::sort(kmers, kmers + seqKmerCount, SequencePosition::compareByScoreReverse);
+            } else {
+                std::sort(kmers, kmers + seqKmerCount, SequencePosition::compareByScore);
+            }
+        }
+        addKmer(out, seqHash, seq.getDbKey(), 0, seq.L);
+
+        size_t kmersToConsider = std::min(static_cast<int>(chooseTopKmer - 1 + (par.kmersPerSequenceScale * seq.L)), seqKmerCount);
+        size_t kmersConsidered = 0;
+        size_t prevKmer = SIZE_T_MAX;
+        kmers[seqKmerCount].kmer = SIZE_T_MAX;
+        for (size_t topKmer = 0; topKmer < static_cast<size_t>(seqKmerCount) && kmersConsidered < kmersToConsider; topKmer++) {
+            size_t kmerCurr = kmers[topKmer].kmer;
+            size_t kmerNext = kmers[topKmer + 1].kmer;
+            if (TYPE == Parameters::DBTYPE_NUCLEOTIDES) {
+                kmerCurr = BIT_SET(kmerCurr, 63);
+                kmerNext = BIT_SET(kmerNext, 63);
+            }
+            bool repeatedKmer = (kmerCurr == kmerNext || kmerCurr == prevKmer);
+            prevKmer = kmerCurr;
+            if (par.ignoreMultiKmer > 0 && repeatedKmer) {
+                continue;
+            }
+            kmersConsidered++;
+            addKmer(out, kmers[topKmer].kmer, seq.getDbKey(), kmers[topKmer].pos, seq.L);
+        }
+    }
+    delete[] kmers;
+}
+
+template <int TYPE>
+static bool compareSelection(DBReader<unsigned int> &reader, Parameters &par, BaseMatrix *subMat, const size_t kmerSize) {
+    const size_t chooseTopKmer = par.kmersPerSequence;
+    size_t maxKmers = 0;
+    for (size_t i = 0; i < reader.getSize(); i++) {
+        maxKmers += reader.getSeqLen(i) + 1;
+    }
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    std::vector<KmerPosition<short> > expected;
+    referenceKmers<TYPE>(reader, par, subMat, kmerSize, chooseTopKmer, expected);
+    gettimeofday(&end, NULL);
+    double oldTime = (end.tv_sec - start.tv_sec) + 1e-6 * (end.tv_usec - start.tv_usec);
+
+    KmerPosition<short> *hashSeqPair = new KmerPosition<short>[maxKmers];
+    gettimeofday(&start, NULL);
+    std::pair<size_t, size_t> ret = fillKmerPositionArray<TYPE, short, false>(hashSeqPair, reader, par, subMat, kmerSize, chooseTopKmer,
+                                                                             true, 1, 0, 1, false, par.kmersPerSequenceScale, NULL, NULL);
+    gettimeofday(&end, NULL);
+    double newTime = (end.tv_sec - start.tv_sec) + 1e-6 * (end.tv_usec - start.tv_usec);
+    std::vector<KmerPosition<short> > selected(hashSeqPair, hashSeqPair + ret.first);
+    delete[] hashSeqPair;
+
+    // threads append their k-mers in any order
+    std::sort(expected.begin(), expected.end(), compareKmerIdPos);
+    std::sort(selected.begin(), selected.end(), compareKmerIdPos);
+    size_t mismatches = (expected.size() > selected.size()) ? expected.size() - selected.size() : selected.size() - expected.size();
+    for (size_t i = 0; i < std::min(expected.size(), selected.size()); i++) {
+        mismatches += (compareKmerIdPos(expected[i], selected[i]) || compareKmerIdPos(selected[i], expected[i]));
+    }
+    std::cout << "Selected k-mers:         " << selected.size() << std::endl;
+    std::cout << "Scalar and sort:         " << oldTime << "s" << std::endl;
+    std::cout << "fillKmerPositionArray:   " << newTime << "s" << std::endl;
+    std::cout << "Mismatches:              " << mismatches << std::endl;
+    return mismatches == 0;
+}
+
+int main (int argc, const char * argv[]) {
+    if (argc < 2) {
+        std::cout << "Usage: " << binary_name << " <sequenceDB> [kmerSize] [alphabetSize]" << std::endl;
+        return 1;
+    }
+#ifdef OPENMP
+    omp_set_num_threads(1);
+#endif
+    Parameters& par = Parameters::getInstance();
+    par.maskMode = 0;
+    par.ignoreMultiKmer = true;
+
+    DBReader<unsigned int> reader(argv[1], (std::string(argv[1]) + ".index").c_str(), 1, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
+    reader.open(DBReader<unsigned int>::NOSORT);
+    par.maxSeqLen = 0;
+    for (size_t i = 0; i < reader.getSize(); i++) {
+        par.maxSeqLen = std::max(par.maxSeqLen, reader.getSeqLen(i));
+    }
+
+    bool success = true;
+    if (Parameters::isEqualDbtype(reader.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)) {
+        const size_t kmerSize = (argc > 2) ? atoi(argv[2]) : 15;
+        NucleotideMatrix subMat(par.scoringMatrixFile.nucleotides, 1.0, 0.0);
+        success &= compareSelection<Parameters::DBTYPE_NUCLEOTIDES>(reader, par, &subMat, kmerSize);
+    } else {
+        const size_t kmerSize = (argc > 2) ? atoi(argv[2]) : 14;
+        const int alphabetSize = (argc > 3) ? atoi(argv[3]) : 13;
+        // same matrices as kmermatcher
+        BaseMatrix *subMat;
+        if (alphabetSize == 21) {
+            subMat = new SubstitutionMatrix(par.scoringMatrixFile.aminoacids, 2.0, 0.0);
+        } else {
+            SubstitutionMatrix sMat(par.scoringMatrixFile.aminoacids, 8.0, -0.2f);
+            subMat = new ReducedMatrix(sMat.probMatrix, sMat.subMatrixPseudoCounts, sMat.aa2int, sMat.int2aa, sMat.alphabetSize, alphabetSize, 2.0);
+        }
+        success &= compareSelection<Parameters::DBTYPE_AMINO_ACIDS>(reader, par, subMat, kmerSize);
+        delete subMat;
+    }
+    reader.close();
+    return success ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+// Looks up random query k-mers in a linsearch index with KmerSearch::searchInIndex (grid cells,
+// galloping search and one query range per thread) and compares the hits with a linear scan
+// over all index entries.
+#include <iostream>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstdlib>
+
+#include "Indexer.h"
+#include "kmersearch.h"
+#include "KmerIndex.h"
+#include "LinsearchIndexReader.h"
+#include "PrefilteringIndexReader.h"
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "Parameters.h"
+#include "MathUtil.h"
+
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+const char* binary_name = "test_kmerindexsearch";
+
+static bool compareHit(const KmerPosition<short> &first, const KmerPosition<short> &second) {
+    if (first.kmer != second.kmer) {
+        return first.kmer < second.kmer;
+    }
+    if (first.id != second.id) {
+        return first.id < second.id;
+    }
+    if (first.pos != second.pos) {
+        return first.pos < second.pos;
+    }
+    return first.seqLen < second.seqLen;
+}
+
+static KmerPosition<short> randomKmer(size_t kmer, bool isNucleotide) {
+    KmerPosition<short> kmerPos;
+    kmerPos.kmer = kmer;
+    if (isNucleotide && (rand() % 2) == 0) {
+        kmerPos.kmer = BIT_SET(kmerPos.kmer, 63);
+    }
+    kmerPos.id = rand() % 100000;
+    kmerPos.seqLen = 100 + rand() % 200;
+    kmerPos.pos = rand() % kmerPos.seqLen;
+    return kmerPos;
+}
+
+template <int TYPE>
+static bool compareSearch(int alphabetSize, int kmerSize, size_t indexKmers, size_t queryKmers) {
+    const bool isNucleotide = (TYPE == Parameters::DBTYPE_NUCLEOTIDES);
+    const size_t kmerSpace = MathUtil::ipow<size_t>(alphabetSize - 1, kmerSize);
+
+    // index entries are sorted by k-mer like the output of kmerindexdb
+    std::vector<KmerPosition<short> > entries;
+    for (size_t i = 0; i < indexKmers; i++) {
+        entries.push_back(randomKmer(rand() % kmerSpace, isNucleotide));
+    }
+    std::sort(entries.begin(), entries.end(), isNucleotide ? KmerPosition<short>::compareRepSequenceAndIdAndPosReverse
+                                                           : KmerPosition<short>::compareRepSequenceAndIdAndPos);
+    const std::string indexDB = "test_kmerindexsearch_idx";
+    DBWriter writer(indexDB.c_str(), (indexDB + ".index").c_str(), 1, Parameters::WRITER_ASCII_MODE, Parameters::DBTYPE_INDEX_DB);
+    writer.open();
+    LinsearchIndexReader::writeIndex<TYPE>(writer, entries.data(), entries.size(), alphabetSize, kmerSize);
+    writer.close();
+
+    DBReader<unsigned int> reader(indexDB.c_str(), (indexDB + ".index").c_str(), 1, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
+    reader.open(DBReader<unsigned int>::NOSORT);
+    char *entriesData = reader.getDataUncompressed(reader.getId(PrefilteringIndexReader::ENTRIES));
+    size_t entriesOffsetsId = reader.getId(PrefilteringIndexReader::ENTRIESOFFSETS);
+    char *entriesOffsetsData = reader.getDataUncompressed(entriesOffsetsId);
+    size_t entriesOffsetsCount = reader.getEntryLen(entriesOffsetsId) / sizeof(size_t);
+    int64_t entriesNum = *((int64_t *) reader.getDataUncompressed(reader.getId(PrefilteringIndexReader::ENTRIESNUM)));
+    int64_t entriesGridSize = *((int64_t *) reader.getDataUncompressed(reader.getId(PrefilteringIndexReader::ENTRIESGRIDSIZE)));
+    KmerIndex kmerIndex(alphabetSize - 1, kmerSize, entriesData, entriesOffsetsData, entriesNum, entriesGridSize, entriesOffsetsCount);
+
+    // linear scan: a query k-mer hits the first index entry of its k-mer
+    std::map<size_t, KmerIndex::KmerEntry> firstEntry;
+    kmerIndex.reset();
+    while (kmerIndex.hasNextEntry()) {
+        KmerIndex::KmerEntry entry = kmerIndex.getNextEntry<TYPE>();
+        const size_t kmer = isNucleotide ? BIT_CLEAR(entry.kmer, 63) : entry.kmer;
+        if (firstEntry.find(kmer) == firstEntry.end()) {
+            firstEntry[kmer] = entry;
+        }
+    }
+
+    // half of the query k-mers are taken from the index, the others are random
+    std::vector<KmerPosition<short> > queries;
+    for (size_t i = 0; i < queryKmers; i++) {
+        const size_t kmer = (i % 2 == 0) ? BIT_CLEAR(entries[rand() % entries.size()].kmer, 63) : rand() % kmerSpace;
+        queries.push_back(randomKmer(kmer, isNucleotide));
+    }
+    std::sort(queries.begin(), queries.end(), isNucleotide ? KmerPosition<short>::compareRepSequenceAndIdAndPosReverse
+                                                           : KmerPosition<short>::compareRepSequenceAndIdAndPos);
+    std::vector<KmerPosition<short> > expected;
+    for (size_t i = 0; i < queries.size(); i++) {
+        const size_t kmer = isNucleotide ? BIT_CLEAR(queries[i].kmer, 63) : queries[i].kmer;
+        std::map<size_t, KmerIndex::KmerEntry>::const_iterator it = firstEntry.find(kmer);
+        if (it != firstEntry.end()) {
+            KmerPosition<short> hit;
+            KmerSearch::writeHit<TYPE>(&hit, queries[i], it->second);
+            expected.push_back(hit);
+        }
+    }
+    std::sort(expected.begin(), expected.end(), compareHit);
+
+    bool success = true;
+    const int threadCounts[] = {1, 4, 7};
+    for (size_t t = 0; t < sizeof(threadCounts) / sizeof(int); t++) {
+#ifdef OPENMP
+        omp_set_num_threads(threadCounts[t]);
+#endif
+        std::vector<KmerPosition<short> > kmers(queries);
+        std::pair<KmerPosition<short> *, size_t> result = KmerSearch::searchInIndex<TYPE>(kmers.data(), kmers.size(), kmerIndex);
+        std::vector<KmerPosition<short> > hits(result.first, result.first + result.second);
+        std::sort(hits.begin(), hits.end(), compareHit);
+        size_t mismatches = (hits.size() > expected.size()) ? hits.size() - expected.size() : expected.size() - hits.size();
+        for (size_t i = 0; i < std::min(hits.size(), expected.size()); i++) {
+            mismatches += (compareHit(hits[i], expected[i]) || compareHit(expected[i], hits[i]));
+        }
+        std::cout << (isNucleotide ? "nucleotide" : "amino acid") << " threads " << threadCounts[t]
+                  << ": hits " << hits.size() << " expected " << expected.size()
+                  << " mismatches " << mismatches << std::endl;
+        success &= (mismatches == 0);
+    }
+    reader.close();
+    return success;
+}
+
+int main (int, const char**) {
+    srand(1);
+    bool success = true;
+    // more query k-mers than 4096 per thread, so the queries are split into several ranges
+    success &= compareSearch<Parameters::DBTYPE_AMINO_ACIDS>(14, 6, 300000, 60000);
+    success &= compareSearch<Parameters::DBTYPE_NUCLEOTIDES>(5, 11, 300000, 60000);
+    // dense index: one grid cell, many k-mers occur several times (the writer holds at most one cell)
+    success &= compareSearch<Parameters::DBTYPE_AMINO_ACIDS>(14, 4, 30000, 30000);
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
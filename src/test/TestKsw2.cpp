@@ -19,6 +19,11 @@
 #include <NucleotideMatrix.h>
 #include <Sequence.h>
 #include <BandedNucleotideAligner.h>
+#include <Timer.h>
+#include <WavefrontAligner.h>
+#include <Util.h>
+#include <Parameters.h>
+#include <vector>
 
 const char* binary_name = "test_ksw2";
 
@@ -305,6 +310,131 @@ void align(const char * qSeqAscii, uint8_t *qseq, uint8_t *qseqrev, const int qL
 }
 
 
+// throughput of the ksw_extz2 kernels per instruction set, results have to match the SSE kernel
+void benchmarkIsa(int len, int cnt, int band, int flag) {
+    const int8_t a = 2, b = -3;
+    int8_t mat[25] = { a,b,b,b,0, b,a,b,b,0, b,b,a,b,0, b,b,b,a,0, 0,0,0,0,0 };
+    uint8_t code[256];
+    memset(code, 4, 256);
+    code['A'] = 0; code['C'] = 1; code['G'] = 2; code['T'] = 3;
+
+    std::vector<std::pair<std::string, std::string>> pairs;
+    for (int i = 0; i < cnt; i++) {
+        char *query = generate_random_sequence(len);
+        char *target = generate_mutated_sequence(query, len, 0.05, 0.02, 32);
+        std::string q(query, len), t(target, len);
+        for (int j = 0; j < len; j++) {
+            q[j] = code[(uint8_t) q[j]];
+            t[j] = code[(uint8_t) t[j]];
+        }
+        pairs.emplace_back(q, t);
+        free(query);
+        free(target);
+    }
+
+    const char *isaNames[] = { "SSE", "AVX2", "AVX512" };
+    std::vector<std::string> reference;
+    for (int isa = KSW_ISA_SSE; isa <= ksw_extz2_best_isa(); isa++) {
+        Timer timer;
+        std::vector<std::string> results;
+        for (size_t i = 0; i < pairs.size(); i++) {
+            ksw_extz_t ez;
+            memset(&ez, 0, sizeof(ksw_extz_t));
+            ksw_extz2_isa(isa, 0, len, (const uint8_t*) pairs[i].first.c_str(), len, (const uint8_t*) pairs[i].second.c_str(),
+                          5, mat, 5, 1, band, 40, flag, &ez);
+            std::string res = SSTR(ez.score) + " " + SSTR(ez.max) + " " + SSTR(ez.max_q) + " " + SSTR(ez.max_t) + " ";
+            for (int c = 0; c < ez.n_cigar; c++) {
+                res += SSTR(ez.cigar[c] >> 4) + "MID"[ez.cigar[c] & 0xf];
+            }
+            results.push_back(res);
+            free(ez.cigar);
+        }
+        double seconds = timer.getTimediff();
+        size_t mismatches = 0;
+        if (isa == KSW_ISA_SSE) {
+            reference = results;
+        } else {
+            for (size_t i = 0; i < results.size(); i++) {
+                mismatches += (results[i] != reference[i]);
+            }
+        }
+        printf("%s\tlen=%d\tband=%d\tflag=%d\t%.1f aln/s\t%.1f Mcells/s\tmismatches=%zu\n", isaNames[isa], len, band, flag,
+               cnt / seconds, (static_cast<double>(cnt) * len * ((band < 0) ? len : 2 * band + 1)) / seconds / 1e6, mismatches);
+    }
+}
+
+// the wavefront extension has to find the same score as ksw2 and a CIGAR that scores max
+// wildcardRate replaces residues of query and target by N, which ksw2 scores as 0 against anything
+// returns the number of extensions with a wrong score or CIGAR
+size_t compareWavefront(int len, int cnt, double mutationRate, double indelRate, double wildcardRate = 0.0) {
+    const int8_t a = 2, b = -3;
+    const int gapo = 5, gape = 2;
+    int8_t mat[25] = { a,b,b,b,b, b,a,b,b,b, b,b,a,b,b, b,b,b,a,b, b,b,b,b,b };
+    uint8_t code[256];
+    memset(code, 4, 256);
+    code['A'] = 0; code['C'] = 1; code['G'] = 2; code['T'] = 3;
+    WavefrontAligner wavefront(mat, 5, gapo, gape, 40);
+
+    size_t fallbacks = 0, scoreMismatches = 0, cigarErrors = 0;
+    double kswTime = 0, wfaTime = 0;
+    for (int i = 0; i < cnt; i++) {
+        char *query = generate_random_sequence(len);
+        char *target = generate_mutated_sequence(query, len, mutationRate, indelRate, 8);
+        int tlen = strlen(target);
+        for (int j = 0; j < len; j++) {
+            query[j] = (wildcardRate > 0 && ((double)rand() / (double)RAND_MAX) < wildcardRate) ? 'N' : query[j];
+        }
+        for (int j = 0; j < tlen; j++) {
+            target[j] = (wildcardRate > 0 && ((double)rand() / (double)RAND_MAX) < wildcardRate) ? 'N' : target[j];
+        }
+        std::vector<uint8_t> q(len), t(tlen);
+        for (int j = 0; j < len; j++) {
+            q[j] = code[(uint8_t) query[j]];
+        }
+        for (int j = 0; j < tlen; j++) {
+            t[j] = code[(uint8_t) target[j]];
+        }
+        free(query);
+        free(target);
+
+        ksw_extz_t ez;
+        memset(&ez, 0, sizeof(ksw_extz_t));
+        Timer timer;
+        ksw_extz2_simd(0, len, q.data(), tlen, t.data(), 5, mat, gapo, gape, 64, 40, KSW_EZ_EXTZ_ONLY, &ez);
+        kswTime += timer.getTimediff();
+
+        ksw_extz_t wf;
+        memset(&wf, 0, sizeof(ksw_extz_t));
+        timer.reset();
+        bool success = wavefront.extend(len, q.data(), tlen, t.data(), false, &wf);
+        wfaTime += timer.getTimediff();
+        if (success == false) {
+            fallbacks++;
+        } else {
+            scoreMismatches += (wf.max != ez.max);
+            int score = 0, qPos = 0, tPos = 0;
+            for (int c = 0; c < wf.n_cigar; c++) {
+                int op = wf.cigar[c] & 0xf;
+                int opLen = wf.cigar[c] >> 4;
+                if (op == 0) {
+                    for (int j = 0; j < opLen; j++, qPos++, tPos++) {
+                        score += (q[qPos] == 4 || t[tPos] == 4) ? 0 : mat[q[qPos] * 5 + t[tPos]];
+                    }
+                } else {
+                    score -= gapo + gape * opLen;
+                    (op == 1) ? (qPos += opLen) : (tPos += opLen);
+                }
+            }
+            cigarErrors += (score != (int) wf.max || qPos != wf.max_q + 1 || tPos != wf.max_t + 1);
+        }
+        free(ez.cigar);
+        free(wf.cigar);
+    }
+    printf("WFA\tlen=%d\tmut=%.3f\tindel=%.3f\twildcard=%.4f\tksw2=%.1f aln/s\twfa=%.1f aln/s\tfallbacks=%zu\tscoreMismatches=%zu\tcigarErrors=%zu\n",
+           len, mutationRate, indelRate, wildcardRate, cnt / kswTime, cnt / wfaTime, fallbacks, scoreMismatches, cigarErrors);
+    return scoreMismatches + cigarErrors;
+}
+
 int main (int, const char**) {
     int64_t i;
     struct params p;
@@ -315,6 +445,25 @@ int main (int, const char**) {
     p.d = 0.1;
     p.pa = p.pb = NULL;
 
+    benchmarkIsa(10000, 200, 64, KSW_EZ_EXTZ_ONLY);
+    benchmarkIsa(10000, 200, 64, KSW_EZ_EXTZ_ONLY | KSW_EZ_SCORE_ONLY);
+    benchmarkIsa(10000, 50, 512, KSW_EZ_EXTZ_ONLY);
+    benchmarkIsa(2000, 20, -1, 0);
+
+    size_t wavefrontErrors = 0;
+    wavefrontErrors += compareWavefront(150, 10000, 0.02, 0.005);
+    wavefrontErrors += compareWavefront(1000, 1000, 0.01, 0.002);
+    wavefrontErrors += compareWavefront(10000, 100, 0.01, 0.002);
+    wavefrontErrors += compareWavefront(1000, 1000, 0.05, 0.01);
+    wavefrontErrors += compareWavefront(1000, 1000, 0.15, 0.05);
+    wavefrontErrors += compareWavefront(150, 10000, 0.02, 0.005, 0.001);
+    wavefrontErrors += compareWavefront(1000, 1000, 0.01, 0.002, 0.0005);
+    // transitions scored differently from transversions have to be left to ksw2
+    const int8_t transitionMat[25] = { 2,-3,-1,-3,-3, -3,2,-3,-1,-3, -1,-3,2,-3,-3, -3,-1,-3,2,-3, -3,-3,-3,-3,-3 };
+    WavefrontAligner nonUniform(transitionMat, 5, 5, 2, 40);
+    printf("WFA	non-uniform matrix usable=%d\n", nonUniform.isUsable());
+    wavefrontErrors += nonUniform.isUsable();
+
 
 //    fprintf(stderr, "len\t%" PRId64 "\ncnt\t%" PRId64 "\nx\t%f\nd\t%f\n", p.len, p.cnt, p.x, p.d);
 
@@ -331,7 +480,8 @@ int main (int, const char**) {
 //    std::string target =     "AAAAATCCGGAACAGTTTCAATCCCACTGATCGATGCTCTCTACACCATGCAAAAAA";
 //    short diagonal = 15-14;
 
-    NucleotideMatrix subMat("blosum62.out", 2.0, -0.0f);
+    Parameters &par = Parameters::getInstance();
+    NucleotideMatrix subMat(par.scoringMatrixFile.nucleotides, 1.0, 0.0);
     BandedNucleotideAligner aligner((BaseMatrix*)&subMat, 10000,  5, 1);
     EvalueComputation evalueComputation(100000, &subMat, 7, 1);
     
@@ -491,5 +641,5 @@ int main (int, const char**) {
 
     delete queryObj;
     delete targetObj;
-    return 0;
+    return (wavefrontErrors > 0) ? 1 : 0;
 }
@@ -0,0 +1,121 @@
+// Runs the same alignment results once as text and once as packed records
+// (--packed-aln) through sortresult and result2msa and compares the outputs.
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+
+#include "Command.h"
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "Matcher.h"
+#include "PackedAlignment.h"
+#include "Parameters.h"
+#include "Util.h"
+
+const char* binary_name = "test_packedalignment";
+
+extern std::vector<Command> baseCommands;
+
+static int runModule(const char *name, std::vector<const char *> args) {
+    for (size_t i = 0; i < baseCommands.size(); i++) {
+        if (strcmp(baseCommands[i].cmd, name) == 0) {
+            return baseCommands[i].commandFunction(args.size(), args.data(), baseCommands[i]);
+        }
+    }
+    std::cout << "Unknown module " << name << std::endl;
+    return EXIT_FAILURE;
+}
+
+static void writeSequences(const std::string &name, const std::vector<std::string> &sequences) {
+    DBWriter seqWriter(name.c_str(), (name + ".index").c_str(), 1, Parameters::WRITER_ASCII_MODE, Parameters::DBTYPE_AMINO_ACIDS);
+    seqWriter.open();
+    DBWriter headerWriter((name + "_h").c_str(), (name + "_h.index").c_str(), 1, Parameters::WRITER_ASCII_MODE, Parameters::DBTYPE_GENERIC_DB);
+    headerWriter.open();
+    for (size_t i = 0; i < sequences.size(); i++) {
+        std::string seq = sequences[i] + "\n";
+        seqWriter.writeData(seq.c_str(), seq.size(), i, 0);
+        std::string header = "seq" + SSTR(i) + "\n";
+        headerWriter.writeData(header.c_str(), header.size(), i, 0);
+    }
+    seqWriter.close(true);
+    headerWriter.close(true);
+}
+
+static void writeResults(const std::string &name, const std::vector<std::vector<Matcher::result_t> > &results, bool packed) {
+    DBWriter writer(name.c_str(), (name + ".index").c_str(), 1, Parameters::WRITER_ASCII_MODE, Parameters::DBTYPE_ALIGNMENT_RES);
+    writer.open();
+    char buffer[1024];
+    for (size_t i = 0; i < results.size(); i++) {
+        writer.writeStart(0);
+        for (size_t j = 0; j < results[i].size(); j++) {
+            size_t len = packed ? Matcher::resultToPackedBuffer(buffer, results[i][j], true)
+                                : Matcher::resultToBuffer(buffer, results[i][j], true, true);
+            writer.writeAdd(buffer, len, 0);
+        }
+        writer.writeEnd(i, 0);
+    }
+    writer.close(true);
+}
+
+static bool compareDatabases(const std::string &text, const std::string &packed, bool expectPacked) {
+    DBReader<unsigned int> textReader(text.c_str(), (text + ".index").c_str(), 1, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
+    textReader.open(DBReader<unsigned int>::NOSORT);
+    DBReader<unsigned int> packedReader(packed.c_str(), (packed + ".index").c_str(), 1, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
+    packedReader.open(DBReader<unsigned int>::NOSORT);
+    bool same = textReader.getSize() == packedReader.getSize();
+    for (size_t i = 0; same && i < textReader.getSize(); i++) {
+        const char *textData = textReader.getData(i, 0);
+        const char *packedData = packedReader.getDataByDBKey(textReader.getDbKey(i), 0);
+        std::string rendered;
+        while (packedData != NULL && *packedData != '\0') {
+            same &= (PackedAlignment::isPacked(packedData) == expectPacked);
+            if (expectPacked) {
+                Matcher::packedRecordToText(packedData, rendered);
+            } else {
+                const char *next = Util::skipLine((char *) packedData);
+                rendered.append(packedData, next - packedData);
+            }
+            packedData = Util::skipLine((char *) packedData);
+        }
+        same &= (rendered == textData);
+    }
+    textReader.close();
+    packedReader.close();
+    return same;
+}
+
+int main (int, const char**) {
+    std::vector<std::string> sequences;
+    sequences.push_back("MKVLAAGIVALLLAAGCSSHKEEPTQAW");
+    sequences.push_back("MKVLAAGIVALLLAAGCSSHKEEPTQAW");
+    sequences.push_back("MKVLSAGIVALLLAAGCSSHKEEPSQAW");
+    sequences.push_back("MKVLAAGIVAGCSSHKEEPTQAW");
+    sequences.push_back("MRVLAAGLVALLIAAGCSTHKDEPTQAWLL");
+    writeSequences("test_packedaln_seq", sequences);
+
+    // hits are out of order, sortresult has to reorder them
+    std::vector<std::vector<Matcher::result_t> > results(1);
+    results[0].push_back(Matcher::result_t(3, 30, 0.82, 1.0, 1.0, 2.5e-8, 23, 0, 27, 28, 0, 22, 23, Matcher::uncompressAlignment("10M5I13M")));
+    results[0].push_back(Matcher::result_t(4, 48, 1.0, 0.93, 0.75, 1.2e-14, 28, 0, 27, 28, 0, 27, 30, Matcher::uncompressAlignment("28M")));
+    results[0].push_back(Matcher::result_t(0, 60, 1.0, 1.0, 1.0, 3.1e-19, 28, 0, 27, 28, 0, 27, 28, Matcher::uncompressAlignment("28M")));
+    results[0].push_back(Matcher::result_t(2, 52, 1.0, 1.0, 0.875, 4.4e-16, 28, 0, 27, 28, 0, 27, 28, Matcher::uncompressAlignment("28M")));
+    results[0].push_back(Matcher::result_t(1, 60, 1.0, 1.0, 1.0, 3.1e-19, 28, 0, 27, 28, 0, 27, 28, Matcher::uncompressAlignment("28M")));
+    writeResults("test_packedaln_text", results, false);
+    writeResults("test_packedaln_packed", results, true);
+
+    bool success = true;
+    int status = runModule("sortresult", {"test_packedaln_text", "test_packedaln_text_sorted"});
+    status |= runModule("sortresult", {"test_packedaln_packed", "test_packedaln_packed_sorted"});
+    bool sorted = status == EXIT_SUCCESS && compareDatabases("test_packedaln_text_sorted", "test_packedaln_packed_sorted", true);
+    std::cout << "sortresult: " << (sorted ? "same" : "different") << std::endl;
+    success &= sorted;
+
+    status = runModule("result2msa", {"test_packedaln_seq", "test_packedaln_seq", "test_packedaln_text", "test_packedaln_text_msa"});
+    status |= runModule("result2msa", {"test_packedaln_seq", "test_packedaln_seq", "test_packedaln_packed", "test_packedaln_packed_msa"});
+    bool msa = status == EXIT_SUCCESS && compareDatabases("test_packedaln_text_msa", "test_packedaln_packed_msa", false);
+    std::cout << "result2msa: " << (msa ? "same" : "different") << std::endl;
+    success &= msa;
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,100 @@
+// Packs and unpacks profile entries with PackedProfile (dense, sparse and all-zero columns, empty
+// entries and entries that are not made of whole columns) and writes them to a compressed profile
+// database with DBWriter, DBReader has to return the original entries.
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "PackedProfile.h"
+#include "Parameters.h"
+
+const char* binary_name = "test_packedprofile";
+
+// column with nonZero probabilities that are not ZERO_PROBABILITY, followed by the query residue,
+// the consensus residue and the neff byte
+static void appendColumn(std::string &profile, unsigned int nonZero) {
+    const size_t start = profile.size();
+    profile.append(PackedProfile::AA_SIZE, static_cast<char>(PackedProfile::ZERO_PROBABILITY));
+    for (unsigned int i = 0; i < nonZero; i++) {
+        profile[start + rand() % PackedProfile::AA_SIZE] = static_cast<char>(2 + rand() % 254);
+    }
+    for (unsigned int i = PackedProfile::AA_SIZE; i < PackedProfile::COLUMN_SIZE; i++) {
+        profile.push_back(static_cast<char>(rand() % 256));
+    }
+}
+
+static std::vector<std::string> createProfiles() {
+    std::vector<std::string> profiles;
+    // empty entry
+    profiles.push_back("");
+    // all probabilities zero, dense and the largest sparse column
+    std::string profile;
+    appendColumn(profile, 0);
+    appendColumn(profile, PackedProfile::AA_SIZE * 4);
+    appendColumn(profile, PackedProfile::MAX_SPARSE);
+    profiles.push_back(profile);
+    // not made of whole columns, the tail is copied as it is
+    profiles.push_back(profile + "AB");
+    profiles.push_back("XYZ");
+    for (size_t i = 0; i < 200; i++) {
+        profile.clear();
+        const size_t columns = 1 + rand() % 500;
+        for (size_t col = 0; col < columns; col++) {
+            appendColumn(profile, (rand() % 4 == 0) ? rand() % (PackedProfile::AA_SIZE + 1) : rand() % 4);
+        }
+        profiles.push_back(profile);
+    }
+    return profiles;
+}
+
+int main (int, const char**) {
+    srand(1);
+    const std::vector<std::string> profiles = createProfiles();
+
+    size_t roundTripErrors = 0;
+    size_t rawSize = 0;
+    size_t packedSize = 0;
+    for (size_t i = 0; i < profiles.size(); i++) {
+        const std::string &profile = profiles[i];
+        std::vector<char> packed(PackedProfile::maxPackedSize(profile.size()));
+        const size_t packedLength = PackedProfile::pack(profile.c_str(), profile.size(), packed.data());
+        std::vector<char> unpacked(profile.size() + 1);
+        PackedProfile::unpack(packed.data(), profile.size(), unpacked.data());
+        if (packedLength > packed.size() || memcmp(unpacked.data(), profile.c_str(), profile.size()) != 0) {
+            std::cout << "Entry " << i << " (length " << profile.size() << ") differs after unpacking" << std::endl;
+            roundTripErrors++;
+        }
+        rawSize += profile.size();
+        packedSize += packedLength;
+    }
+    std::cout << "Round trip: " << profiles.size() << " entries, " << rawSize << " bytes packed to " << packedSize
+              << ", errors: " << roundTripErrors << std::endl;
+
+    DBWriter writer("test_packedprofile", "test_packedprofile.index", 1, Parameters::WRITER_COMPRESSED_MODE, Parameters::DBTYPE_HMM_PROFILE);
+    writer.open();
+    for (size_t i = 0; i < profiles.size(); i++) {
+        writer.writeData(profiles[i].c_str(), profiles[i].size(), i, 0);
+    }
+    writer.close();
+
+    DBReader<unsigned int> reader("test_packedprofile", "test_packedprofile.index", 1, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
+    reader.open(DBReader<unsigned int>::NOSORT);
+    size_t dbErrors = (PackedProfile::isPacked(reader.getDbtype()) && reader.getSize() == profiles.size()) ? 0 : 1;
+    for (size_t i = 0; dbErrors == 0 && i < reader.getSize(); i++) {
+        const unsigned int key = reader.getDbKey(i);
+        const std::string &profile = profiles[key];
+        const char *data = reader.getData(i, 0);
+        if (reader.getEntryLen(i) != profile.size() + 1 || memcmp(data, profile.c_str(), profile.size()) != 0 || data[profile.size()] != '\0') {
+            std::cout << "Entry " << key << " (length " << profile.size() << ") differs in the database" << std::endl;
+            dbErrors++;
+        }
+    }
+    std::cout << "Database: " << reader.getSize() << " entries, errors: " << dbErrors << std::endl;
+    reader.close();
+
+    return (roundTripErrors == 0 && dbErrors == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
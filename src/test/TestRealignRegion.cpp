@@ -0,0 +1,93 @@
+// Aligns random related sequence pairs with Matcher::getSWResult against the full target and realigns
+// them with Matcher::getSWResultInRegion restricted to a target region that contains the full hit.
+// Scores, positions, coverages, sequence identities and backtraces have to be the same.
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <climits>
+
+#include "Sequence.h"
+#include "SubstitutionMatrix.h"
+#include "Matcher.h"
+#include "EvalueComputation.h"
+#include "Parameters.h"
+
+const char* binary_name = "test_realignregion";
+
+static const char *residues = "ACDEFGHIKLMNPQRSTVWY";
+
+static std::string randomSequence(size_t length) {
+    std::string seq;
+    for (size_t i = 0; i < length; i++) {
+        seq.push_back(residues[rand() % 20]);
+    }
+    return seq;
+}
+
+static std::string mutate(const std::string &seq, int substitutionRate, int indelRate, int maxIndel) {
+    std::string result;
+    for (size_t i = 0; i < seq.size(); i++) {
+        const int r = rand() % 100;
+        if (r < indelRate / 2) {
+            i += rand() % maxIndel;
+            continue;
+        }
+        if (r < indelRate) {
+            result.append(randomSequence(1 + rand() % maxIndel));
+        }
+        result.push_back((rand() % 100 < substitutionRate) ? residues[rand() % 20] : seq[i]);
+    }
+    return result;
+}
+
+static bool sameResult(const Matcher::result_t &full, const Matcher::result_t &region) {
+    return full.dbKey == region.dbKey && full.score == region.score && full.eval == region.eval
+           && full.qcov == region.qcov && full.dbcov == region.dbcov && full.seqId == region.seqId
+           && full.alnLength == region.alnLength && full.qStartPos == region.qStartPos && full.qEndPos == region.qEndPos
+           && full.qLen == region.qLen && full.dbStartPos == region.dbStartPos && full.dbEndPos == region.dbEndPos
+           && full.dbLen == region.dbLen && full.backtrace == region.backtrace;
+}
+
+int main (int, const char**) {
+    srand(1);
+    Parameters &par = Parameters::getInstance();
+    SubstitutionMatrix subMat(par.scoringMatrixFile.aminoacids, 2.0, 0.0);
+    EvalueComputation evaluer(100000, &subMat, par.gapOpen, par.gapExtend);
+    const size_t maxLen = 10000;
+    Sequence query(maxLen, Parameters::DBTYPE_AMINO_ACIDS, &subMat, 6, false, false);
+    Sequence target(maxLen, Parameters::DBTYPE_AMINO_ACIDS, &subMat, 6, false, false);
+    Matcher matcher(Parameters::DBTYPE_AMINO_ACIDS, maxLen, &subMat, &evaluer, true, par.gapOpen, par.gapExtend);
+
+    const unsigned int modes[] = {Matcher::SCORE_COV, Matcher::SCORE_COV_SEQID};
+    size_t pairs = 0;
+    size_t hits = 0;
+    size_t mismatches = 0;
+    for (size_t mode = 0; mode < sizeof(modes) / sizeof(unsigned int); mode++) {
+        for (size_t pair = 0; pair < 300; pair++) {
+            const size_t length = 50 + rand() % 800;
+            const std::string querySeq = randomSequence(length);
+            // local hit inside unrelated flanks, the realignment only needs to look at the hit and some padding
+            const std::string targetSeq = randomSequence(rand() % 500) + mutate(querySeq, 10 + rand() % 30, 4, 8) + randomSequence(rand() % 500);
+            query.mapSequence(0, 0, querySeq.c_str(), querySeq.size());
+            target.mapSequence(1, 1, targetSeq.c_str(), targetSeq.size());
+            matcher.initQuery(&query);
+            Matcher::result_t full = matcher.getSWResult(&target, INT_MAX, false, 0, 0.0, 10000, modes[mode], 0, false);
+            pairs++;
+            if (full.dbStartPos < 0 || full.dbEndPos < 0) {
+                continue;
+            }
+            hits++;
+            const int padding = (pair % 3 == 0) ? 0 : rand() % 100;
+            Matcher::result_t region = matcher.getSWResultInRegion(&target, full.dbStartPos - padding, full.dbEndPos + padding,
+                                                                   0, 0.0, 10000, modes[mode], 0);
+            if (sameResult(full, region) == false) {
+                mismatches++;
+                std::cout << "Mode " << modes[mode] << " pair " << pair << ": score " << full.score << " vs " << region.score
+                          << ", target " << full.dbStartPos << "-" << full.dbEndPos << " vs " << region.dbStartPos << "-" << region.dbEndPos
+                          << ", seqId " << full.seqId << " vs " << region.seqId << ", dbcov " << full.dbcov << " vs " << region.dbcov << std::endl;
+            }
+        }
+    }
+    std::cout << "Pairs: " << pairs << " hits: " << hits << " mismatches: " << mismatches << std::endl;
+    return (mismatches == 0 && hits > 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,123 @@
+#include "Debug.h"
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "Util.h"
+#include "Parameters.h"
+#include "itoa.h"
+
+#include <algorithm>
+#include <climits>
+
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+// Adds every new sequence of a search result (new sequences against the representatives of
+// a clustering) as member to the cluster of its best hit. Sequences without a hit are written
+// as subset of the sequence DB, they have to be clustered on their own.
+int addtoclusters(int argc, const char **argv, const Command &command) {
+    Parameters &par = Parameters::getInstance();
+    par.parseParameters(argc, argv, command, true, 0, 0);
+
+    DBReader<unsigned int> hitReader(par.db1.c_str(), par.db1Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX | DBReader<unsigned int>::USE_DATA);
+    hitReader.open(DBReader<unsigned int>::NOSORT);
+
+    DBReader<unsigned int> cluReader(par.db2.c_str(), par.db2Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX | DBReader<unsigned int>::USE_DATA);
+    cluReader.open(DBReader<unsigned int>::NOSORT);
+
+    // (cluster id, hit id) of every new sequence with a hit, the hit id keeps members in key order
+    const size_t hitSize = hitReader.getSize();
+    std::vector<std::pair<unsigned int, unsigned int> > assignment(hitSize);
+    Debug::Progress progress(hitSize);
+    // hits to a key that is not a cluster of the old clustering, e.g. a search against the wrong DB
+    size_t unknownTargetCount = 0;
+#pragma omp parallel
+    {
+        int thread_idx = 0;
+#ifdef OPENMP
+        thread_idx = omp_get_thread_num();
+#endif
+        char keyBuffer[255];
+#pragma omp for schedule(dynamic, 100) reduction(+: unknownTargetCount)
+        for (size_t i = 0; i < hitSize; i++) {
+            progress.updateProgress();
+            const char *data = hitReader.getData(i, thread_idx);
+            unsigned int cluId = UINT_MAX;
+            if (*data != '\0') {
+                Util::parseKey(data, keyBuffer, hitReader.getDbtype());
+                const unsigned int targetKey = Util::fast_atoi<unsigned int>(keyBuffer);
+                cluId = cluReader.getId(targetKey);
+                if (cluId == UINT_MAX) {
+                    Debug(Debug::ERROR) << "Hit " << targetKey << " of sequence " << hitReader.getDbKey(i) << " is not a cluster in " << par.db2 << "\n";
+                    unknownTargetCount++;
+                }
+            }
+            assignment[i] = std::make_pair(cluId, static_cast<unsigned int>(i));
+        }
+    }
+    if (unknownTargetCount > 0) {
+        Debug(Debug::ERROR) << unknownTargetCount << " sequences hit a representative that is not in the clustering\n";
+        EXIT(EXIT_FAILURE);
+    }
+    // sequences without hit end up at the back
+    std::sort(assignment.begin(), assignment.end());
+
+    Debug(Debug::INFO) << "Writing updated clustering\n";
+    DBWriter cluWriter(par.db4.c_str(), par.db4Index.c_str(), par.threads, par.compressed, Parameters::DBTYPE_CLUSTER_RES);
+    cluWriter.open();
+    progress.reset(cluReader.getSize());
+#pragma omp parallel
+    {
+        int thread_idx = 0;
+#ifdef OPENMP
+        thread_idx = omp_get_thread_num();
+#endif
+        std::string result;
+        result.reserve(1024 * 1024);
+        char buffer[32];
+#pragma omp for schedule(dynamic, 100)
+        for (size_t i = 0; i < cluReader.getSize(); i++) {
+            progress.updateProgress();
+            const char *data = cluReader.getData(i, thread_idx);
+            result.append(data);
+            std::vector<std::pair<unsigned int, unsigned int> >::const_iterator it =
+                    std::lower_bound(assignment.begin(), assignment.end(), std::make_pair(static_cast<unsigned int>(i), 0u));
+            for (; it != assignment.end() && it->first == i; ++it) {
+                char *end = Itoa::u32toa_sse2(hitReader.getDbKey(it->second), buffer);
+                *(end - 1) = '\n';
+                result.append(buffer, end - buffer);
+            }
+            cluWriter.writeData(result.c_str(), result.length(), cluReader.getDbKey(i), thread_idx);
+            result.clear();
+        }
+    }
+    cluWriter.close();
+
+    DBReader<unsigned int> seqReader(par.db3.c_str(), par.db3Index.c_str(), 1, DBReader<unsigned int>::USE_INDEX);
+    seqReader.open(DBReader<unsigned int>::NOSORT);
+    DBWriter seqWriter(par.db5.c_str(), par.db5Index.c_str(), 1, 0, Parameters::DBTYPE_OMIT_FILE);
+    seqWriter.open();
+    std::vector<std::pair<unsigned int, unsigned int> >::const_iterator it =
+            std::lower_bound(assignment.begin(), assignment.end(), std::make_pair(UINT_MAX, 0u));
+    const size_t noHitCount = assignment.end() - it;
+    for (; it != assignment.end(); ++it) {
+        const unsigned int key = hitReader.getDbKey(it->second);
+        const size_t id = seqReader.getId(key);
+        if (id >= UINT_MAX) {
+            Debug(Debug::WARNING) << "Key " << key << " not found in database\n";
+            continue;
+        }
+        seqWriter.writeIndexEntry(key, seqReader.getOffset(id), seqReader.getEntryLen(id), 0);
+    }
+    seqWriter.close(true);
+    DBReader<unsigned int>::softlinkDb(par.db3, par.db5, DBFiles::DATA);
+    DBWriter::writeDbtypeFile(par.db5.c_str(), seqReader.getDbtype(), seqReader.isCompressed());
+    DBReader<unsigned int>::softlinkDb(par.db3, par.db5, DBFiles::SEQUENCE_ANCILLARY);
+    Debug(Debug::INFO) << (hitSize - noHitCount) << " sequences added to existing clusters, "
+                       << noHitCount << " sequences without hit\n";
+
+    seqReader.close();
+    cluReader.close();
+    hitReader.close();
+    return EXIT_SUCCESS;
+}
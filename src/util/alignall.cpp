@@ -72,7 +72,7 @@ int alignall(int argc, const char **argv, const Command &command) {
 
                 results.clear();
                 while (*data != '\0') {
-                    Util::parseKey(data, buffer);
+                    Util::parseKey(data, buffer, dbr_res.getDbtype());
                     const unsigned int key = (unsigned int) strtoul(buffer, NULL, 10);
                     results.push_back(key);
                     data = Util::skipLine(data);
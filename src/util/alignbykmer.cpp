@@ -216,7 +216,7 @@ int alignbykmer(int argc, const char **argv, const Command &command) {
 
                 while (*data != '\0') {
                     // DB key of the db sequence
-                    Util::parseKey(data, dbKeyBuffer);
+                    Util::parseKey(data, dbKeyBuffer, dbr_res.getDbtype());
                     const unsigned int dbKey = (unsigned int) strtoul(dbKeyBuffer, NULL, 10);
                     unsigned int targetId = tdbr->getId(dbKey);
                     char *targetSeq = tdbr->getData(targetId, thread_idx);
@@ -283,7 +283,7 @@ int convertalignments(int argc, const char **argv, const Command &command) {
             char *data = alnDbr.getData(i, 0);
             while (*data != '\0') {
                 char dbKeyBuffer[255 + 1];
-                Util::parseKey(data, dbKeyBuffer);
+                Util::parseKey(data, dbKeyBuffer, alnDbr.getDbtype());
                 const unsigned int dbKey = (unsigned int) strtoul(dbKeyBuffer, NULL, 10);
                 if (headerWritten[dbKey] == false) {
                     headerWritten[dbKey] = true;
@@ -584,7 +584,7 @@ int convertalignments(int argc, const char **argv, const Command &command) {
                                         result.append(SSTR(taxon));
                                         break;
                                     case Parameters::OUTFMT_TAXNAME:
-                                        result.append((taxonNode != NULL) ? taxonNode->name : "unclassified");
+                                        result.append((taxonNode != NULL) ? t->getString(taxonNode->nameIdx) : "unclassified");
                                         break;
                                     case Parameters::OUTFMT_TAXLIN:
                                         result.append((taxonNode != NULL) ? t->taxLineage(taxonNode) : "unclassified");
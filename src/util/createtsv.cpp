@@ -3,6 +3,8 @@
 #include "DBWriter.h"
 #include "Debug.h"
 #include "Util.h"
+#include "Matcher.h"
+#include "PackedAlignment.h"
 #include "IndexReader.h"
 #include "FileUtil.h"
 
@@ -67,6 +69,8 @@ int createtsv(int argc, const char **argv, const Command &command) {
     writer.open();
 
     const size_t targetColumn = (par.targetTsvColumn == 0) ? SIZE_T_MAX :  par.targetTsvColumn - 1;
+    // only alignment results can contain packed records
+    const bool alignmentInput = Parameters::isEqualDbtype(reader->getDbtype(), Parameters::DBTYPE_ALIGNMENT_RES);
 #pragma omp parallel
     {
         unsigned int thread_idx = 0;
@@ -104,8 +108,25 @@ int createtsv(int argc, const char **argv, const Command &command) {
 
             char *data = reader->getData(i, thread_idx);
             while (*data != '\0') {
-                if(targetColumn != SIZE_T_MAX){
-                    size_t foundElements = Util::getWordsOfLine(data, columnPointer, 255);
+                char *nextLine = Util::skipLine(data);
+                char *line = data;
+                const bool packed = alignmentInput && PackedAlignment::isPacked(data);
+                PackedAlignment::Record rec;
+                if (packed) {
+                    PackedAlignment::readRecord(data, rec);
+                    if (targetColumn != SIZE_T_MAX) {
+                        if (targetColumn >= PackedAlignment::columnCount(data)) {
+                            Debug(Debug::WARNING) << "Not enough columns!" << "\n";
+                            data = nextLine;
+                            continue;
+                        }
+                        if (PackedAlignment::columnToText(rec, targetColumn, dbKey, par.maxSeqLen + 1) == false) {
+                            Debug(Debug::ERROR) << "Column " << (targetColumn + 1) << " is longer than " << par.maxSeqLen << " characters\n";
+                            EXIT(EXIT_FAILURE);
+                        }
+                    }
+                } else if(targetColumn != SIZE_T_MAX){
+                    size_t foundElements = Util::getWordsOfLine(line, columnPointer, 255);
                     if (foundElements < targetColumn) {
                         Debug(Debug::WARNING) << "Not enough columns!" << "\n";
                         continue;
@@ -150,9 +171,14 @@ int createtsv(int argc, const char **argv, const Command &command) {
                     offset = strlen(dbKey);
                 }
 
-                char *nextLine = Util::skipLine(data);
-                outputBuffer.append(data + offset, (nextLine - (data + offset)) - 1);
-                outputBuffer.append("\n");
+                if (packed) {
+                    // the key column is already written as target accession
+                    Matcher::packedRecordToText(rec, outputBuffer, targetColumn != 0);
+                } else {
+                    char *lineEnd = Util::skipLine(line);
+                    outputBuffer.append(line + offset, (lineEnd - (line + offset)) - 1);
+                    outputBuffer.append("\n");
+                }
                 data = nextLine;
                 entryIndex++;
             }
@@ -2,6 +2,7 @@
 #include "DBReader.h"
 #include "DBWriter.h"
 #include "Util.h"
+#include "PackedAlignment.h"
 #include "Debug.h"
 #include "filterdb.h"
 #include "FileUtil.h"
@@ -190,6 +191,8 @@ ffindexFilter::~ffindexFilter() {
 int ffindexFilter::runFilter(){
 	const size_t LINE_BUFFER_SIZE = 1000000;
     Debug::Progress progress(dataDb->getSize());
+    // only alignment results can contain packed records
+    const bool alignmentInput = Parameters::isEqualDbtype(dataDb->getDbtype(), Parameters::DBTYPE_ALIGNMENT_RES);
 
 #pragma omp parallel
 	{
@@ -222,7 +225,7 @@ int ffindexFilter::runFilter(){
 			while (*data != '\0') {
                 if (shouldAddSelfMatch) {
                     char dbKeyBuffer[255 + 1];
-                    Util::parseKey(data, dbKeyBuffer);
+                    Util::parseKey(data, dbKeyBuffer, dataDb->getDbtype());
                     const unsigned int curKey = (unsigned int) strtoul(dbKeyBuffer, NULL, 10);
                     addSelfMatch = (queryKey == curKey);
                 }
@@ -235,7 +238,9 @@ int ffindexFilter::runFilter(){
 
                 counter++;
                 size_t foundElements = 1;
-                if (mode != GET_FIRST_LINES) {
+                if (mode != GET_FIRST_LINES && alignmentInput && PackedAlignment::isPacked(lineBuffer)) {
+                    Util::parseByColumnNumber(lineBuffer, columnValue, LINE_BUFFER_SIZE, column - 1, dataDb->getDbtype());
+                } else if (mode != GET_FIRST_LINES) {
                     foundElements = Util::getWordsOfLine(lineBuffer, columnPointer, column + 1);
                     if(foundElements < column  ){
                         Debug(Debug::ERROR) << "Column=" << column << " does not exist in line " << lineBuffer << "\n";
@@ -4,6 +4,8 @@
 #include "DBReader.h"
 #include "Debug.h"
 #include "Util.h"
+#include "Matcher.h"
+#include "PackedAlignment.h"
 
 
 int result2flat(int argc, const char **argv, const Command &command) {
@@ -21,6 +23,8 @@ int result2flat(int argc, const char **argv, const Command &command) {
     DBReader<unsigned int> dbr_data(par.db3.c_str(), par.db3Index.c_str(),  1, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
     dbr_data.open(DBReader<unsigned int>::LINEAR_ACCCESS);
 
+    // only alignment results can contain packed records
+    const bool alignmentInput = Parameters::isEqualDbtype(dbr_data.getDbtype(), Parameters::DBTYPE_ALIGNMENT_RES);
     FILE *fastaFP = fopen(par.db4.c_str(), "w");
 
     char header_start[] = {'>'};
@@ -53,12 +57,22 @@ int result2flat(int argc, const char **argv, const Command &command) {
         // write data
         char *data = dbr_data.getData(i, 0);
         while (*data != '\0') {
-            // dbKeyBuffer can contain sequence
-            Util::parseKey(data, dbKeyBuffer);
-            const unsigned int dbKey = (unsigned int) strtoul(dbKeyBuffer, NULL, 10);
+            const bool packed = alignmentInput && PackedAlignment::isPacked(data);
+            PackedAlignment::Record rec;
+            unsigned int dbKey;
+            if (packed) {
+                PackedAlignment::readRecord(data, rec);
+                dbKey = rec.dbKey;
+            } else {
+                // dbKeyBuffer can contain sequence
+                Util::parseKey(data, dbKeyBuffer);
+                dbKey = (unsigned int) strtoul(dbKeyBuffer, NULL, 10);
+            }
             char *header_data = targetdb_header.getDataByDBKey(dbKey, 0);
             std::string dataStr;
-            if (par.useHeader == true && header_data != NULL && dbr_data.getDbtype() == -1)
+            if (packed) {
+                Matcher::packedRecordToText(rec, dataStr);
+            } else if (par.useHeader == true && header_data != NULL && dbr_data.getDbtype() == -1)
             {
                 dataStr = Util::parseFastaHeader(header_data);
                 char *endLenData = Util::skipLine(data);
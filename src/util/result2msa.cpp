@@ -14,6 +14,7 @@
 #include "CompressedA3M.h"
 #include "Debug.h"
 #include "Util.h"
+#include "PackedAlignment.h"
 
 #ifdef OPENMP
 #include <omp.h>
@@ -93,6 +94,8 @@ int result2msa(Parameters &par, const std::string &resultData, const std::string
     Debug(Debug::INFO) << "Target database size: " << tDbr->getSize() << " type: " << tDbr->getDbTypeName() << "\n";
 
     const bool isFiltering = par.filterMsa != 0;
+    // only alignment results can contain packed records
+    const bool alignmentInput = Parameters::isEqualDbtype(resultReader.getDbtype(), Parameters::DBTYPE_ALIGNMENT_RES);
     Debug::Progress progress(dbSize-dbFrom);
 
 #pragma omp parallel
@@ -145,7 +148,7 @@ int result2msa(Parameters &par, const std::string &resultData, const std::string
             std::vector<Sequence *> seqSet;
             while (*results != '\0') {
                 char dbKey[255 + 1];
-                Util::parseKey(results, dbKey);
+                Util::parseKey(results, dbKey, resultReader.getDbtype());
                 const unsigned int key = (unsigned int) strtoul(dbKey, NULL, 10);
                 // in the same database case, we have the query repeated
                 if ((key == queryKey && sameDatabase == true)) {
@@ -153,7 +156,8 @@ int result2msa(Parameters &par, const std::string &resultData, const std::string
                     continue;
                 }
 
-                const size_t columns = Util::getWordsOfLine(results, entry, 255);
+                const size_t columns = (alignmentInput && PackedAlignment::isPacked(results)) ? PackedAlignment::columnCount(results)
+                                                                                        : Util::getWordsOfLine(results, entry, 255);
                 if (columns > Matcher::ALN_RES_WITH_OUT_BT_COL_CNT) {
                     Matcher::result_t res = Matcher::parseAlignmentRecord(results);
                     alnResults.push_back(res);
@@ -12,6 +12,7 @@
 #include "CompressedA3M.h"
 #include "Debug.h"
 #include "Util.h"
+#include "PackedAlignment.h"
 #include "ProfileStates.h"
 #include "MathUtil.h"
 #include "SubstitutionMatrix.h"
@@ -64,6 +65,8 @@ int computeProfileProfile(Parameters &par,const std::string &outpath,
 
         const char *entry[255];
         Debug::Progress progress(dbSize-dbFrom);
+        // only alignment results can contain packed records
+        const bool alignmentInput = Parameters::isEqualDbtype(resultReader->getDbtype(), Parameters::DBTYPE_ALIGNMENT_RES);
 
 #pragma omp for schedule(dynamic, 10)
         for (size_t id = dbFrom; id < (dbFrom + dbSize); id++) {
@@ -76,8 +79,9 @@ int computeProfileProfile(Parameters &par,const std::string &outpath,
             char dbKey[255 + 1];
             // Get the sequence from the queryDB
             unsigned int queryKey = resultReader->getDbKey(id);
-            char *queryData = qDbr->getDataByDBKey(queryKey, thread_idx);
-            queryProfile.mapSequence(id, queryKey, queryData, resultReader->getSeqLen(queryKey));
+            size_t queryId = qDbr->getId(queryKey);
+            char *queryData = qDbr->getData(queryId, thread_idx);
+            queryProfile.mapSequence(id, queryKey, queryData, qDbr->getSeqLen(queryId));
             const float * qProfile =  queryProfile.getProfile();
 	    /*
             const size_t profile_row_size = queryProfile.profile_row_size;
@@ -100,13 +104,14 @@ int computeProfileProfile(Parameters &par,const std::string &outpath,
             
             memset(outProfile, 0, queryProfile.L * Sequence::PROFILE_AA_SIZE * sizeof(float));
             while (*results != '\0') {
-                Util::parseKey(results, dbKey);
+                Util::parseKey(results, dbKey, resultReader->getDbtype());
                 const unsigned int key = (unsigned int) strtoul(dbKey, NULL, 10);
                 double evalue = 0.0;
-                const size_t columns = Util::getWordsOfLine(results, entry, 255);
+                const bool packed = alignmentInput && PackedAlignment::isPacked(results);
+                const size_t columns = packed ? PackedAlignment::columnCount(results) : Util::getWordsOfLine(results, entry, 255);
                 // its an aln result
                 if (columns > Matcher::ALN_RES_WITH_OUT_BT_COL_CNT) {
-                    evalue = strtod(entry[3], NULL);
+                    evalue = packed ? Matcher::parseAlignmentRecord(results).eval : strtod(entry[3], NULL);
                 }else{
                     Debug(Debug::ERROR) << "Alignment must contain the alignment information. Compute the alignment with option -a.\n";
                     EXIT(EXIT_FAILURE);
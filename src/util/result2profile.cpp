@@ -5,6 +5,7 @@
 #include "DBWriter.h"
 #include "Debug.h"
 #include "Util.h"
+#include "PackedAlignment.h"
 #include "FileUtil.h"
 #include "tantan.h"
 #include "IndexReader.h"
@@ -97,6 +98,8 @@ int result2profile(DBReader<unsigned int> &resultReader, Parameters &par, const
 
     const bool isFiltering = par.filterMsa != 0;
     int xAmioAcid = subMat.aa2int[(int) 'X'];
+    // only alignment results can contain packed records
+    const bool alignmentInput = Parameters::isEqualDbtype(resultReader.getDbtype(), Parameters::DBTYPE_ALIGNMENT_RES);
     Debug::Progress progress(dbSize);
 #pragma omp parallel num_threads(localThreads)
     {
@@ -136,7 +139,7 @@ int result2profile(DBReader<unsigned int> &resultReader, Parameters &par, const
 
             char *data = resultReader.getData(id, thread_idx);
             while (*data != '\0') {
-                Util::parseKey(data, dbKey);
+                Util::parseKey(data, dbKey, resultReader.getDbtype());
                 const unsigned int key = (unsigned int) strtoul(dbKey, NULL, 10);
                 // in the same database case, we have the query repeated
                 if ((key == queryKey && sameDatabase == true)) {
@@ -144,10 +147,18 @@ int result2profile(DBReader<unsigned int> &resultReader, Parameters &par, const
                     continue;
                 }
 
-                const size_t columns = Util::getWordsOfLine(data, entry, 255);
+                size_t columns;
                 float evalue = 0.0;
-                if (columns >= 4) {
-                    evalue = strtod(entry[3], NULL);
+                if (alignmentInput && PackedAlignment::isPacked(data)) {
+                    PackedAlignment::Record record;
+                    PackedAlignment::readRecord(data, record);
+                    columns = PackedAlignment::columnCount(data);
+                    evalue = record.eval;
+                } else {
+                    columns = Util::getWordsOfLine(data, entry, 255);
+                    if (columns >= 4) {
+                        evalue = strtod(entry[3], NULL);
+                    }
                 }
                 bool hasInclusionEval = (evalue < par.evalProfile);
                 if (hasInclusionEval && columns > Matcher::ALN_RES_WITH_OUT_BT_COL_CNT) {
@@ -2,6 +2,7 @@
 #include "DBReader.h"
 #include "DBWriter.h"
 #include "Util.h"
+#include "PackedAlignment.h"
 
 #ifdef OPENMP
 #include <omp.h>
@@ -17,6 +18,8 @@ int result2rbh(int argc, const char **argv, const Command &command) {
     DBWriter dbw(par.db2.c_str(), par.db2Index.c_str(), par.threads, par.compressed, resultReader.getDbtype());
     dbw.open();
     Debug::Progress progress(resultReader.getSize());
+    // only alignment results can contain packed records
+    const bool alignmentInput = Parameters::isEqualDbtype(resultReader.getDbtype(), Parameters::DBTYPE_ALIGNMENT_RES);
 
 #pragma omp parallel
     {
@@ -42,8 +45,15 @@ int result2rbh(int argc, const char **argv, const Command &command) {
 
             // go over A->B direction (getting bestAtoBbitScore):
             while (*results != '\0') {
-                Util::getWordsOfLine(results, entry, 255);
-                int currAlnScore = Util::fast_atoi<int>(entry[1]);
+                int currAlnScore;
+                if (alignmentInput && PackedAlignment::isPacked(results)) {
+                    PackedAlignment::Record rec;
+                    PackedAlignment::readRecord(results, rec);
+                    currAlnScore = rec.score;
+                } else {
+                    Util::getWordsOfLine(results, entry, 255);
+                    currAlnScore = Util::fast_atoi<int>(entry[1]);
+                }
                 if (bestAtoBbitScore == 0) {
                     // first iteration is an A->B line - update bestAtoBbitScore
                     bestAtoBbitScore = currAlnScore;
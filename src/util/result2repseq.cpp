@@ -39,7 +39,7 @@ int result2repseq(int argc, const char **argv, const Command &command) {
                 continue;
             }
 
-            Util::parseKey(results, dbKey);
+            Util::parseKey(results, dbKey, resultReader.getDbtype());
             const unsigned int key = (unsigned int) strtoul(dbKey, NULL, 10);
             const size_t edgeId = seqReader.getId(key);
             resultWriter.writeData(seqReader.getData(edgeId, thread_idx), seqReader.getEntryLen(edgeId) - 1, resultReader.getDbKey(id), thread_idx);
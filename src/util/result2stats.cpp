@@ -298,7 +298,7 @@ int StatsComputer::sequenceWise(typename PerSequence<T>::type call, bool onlyRes
                 // for every hit
                 int cnt = 0;
                 while (*results != '\0') {
-                    Util::parseKey(results, dbKey);
+                    Util::parseKey(results, dbKey, resultReader->getDbtype());
                     char *rest;
                     const unsigned int key = (unsigned int) strtoul(dbKey, &rest, 10);
                     if ((rest != dbKey && *rest != '\0') || errno == ERANGE) {
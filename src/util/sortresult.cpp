@@ -5,6 +5,7 @@
 #include "Util.h"
 #include "Matcher.h"
 #include "QueryMatcher.h"
+#include "PackedAlignment.h"
 
 #ifdef OPENMP
 #include <omp.h>
@@ -22,6 +23,8 @@ int sortresult(int argc, const char **argv, const Command &command) {
     DBWriter writer(par.db2.c_str(), par.db2Index.c_str(), par.threads, par.compressed, reader.getDbtype());
     writer.open();
     Debug::Progress progress(reader.getSize());
+    // only alignment results can contain packed records
+    const bool alignmentInput = Parameters::isEqualDbtype(reader.getDbtype(), Parameters::DBTYPE_ALIGNMENT_RES);
 
    #pragma omp parallel
     {
@@ -46,8 +49,10 @@ int sortresult(int argc, const char **argv, const Command &command) {
             char *data = reader.getData(i, thread_idx);
 
             int format = -1;
+            bool packed = false;
             while (*data != '\0') {
-                const size_t columns = Util::getWordsOfLine(data, entry, 255);
+                packed = alignmentInput && PackedAlignment::isPacked(data);
+                const size_t columns = packed ? PackedAlignment::columnCount(data) : Util::getWordsOfLine(data, entry, 255);
                 if (columns >= Matcher::ALN_RES_WITH_OUT_BT_COL_CNT) {
                     alnResults.emplace_back(Matcher::parseAlignmentRecord(data, true));
                     format = columns >= Matcher::ALN_RES_WITH_BT_COL_CNT ? 1 : 0;
@@ -65,7 +70,8 @@ int sortresult(int argc, const char **argv, const Command &command) {
             if (format == 0 || format == 1) {
                 std::sort(alnResults.begin(), alnResults.end(), Matcher::compareHits);
                 for (size_t i = 0; i < alnResults.size(); ++i) {
-                    size_t length = Matcher::resultToBuffer(buffer, alnResults[i], format == 1, false);
+                    size_t length = packed ? Matcher::resultToPackedBuffer(buffer, alnResults[i], format == 1)
+                                           : Matcher::resultToBuffer(buffer, alnResults[i], format == 1, false);
                     writer.writeAdd(buffer, length, thread_idx);
                 }
             } else if (format == 2) {
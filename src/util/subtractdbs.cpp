@@ -10,6 +10,7 @@
 #include "Debug.h"
 #include "DBWriter.h"
 #include "Util.h"
+#include "PackedAlignment.h"
 #include "Parameters.h"
 
 #include <map>
@@ -31,6 +32,9 @@ void dosubstractresult(std::string leftDb, std::string rightDb, std::string outD
     DBWriter writer(outDb.c_str(), (outDb + std::string(".index")).c_str(), threads, compressed, leftDbr.getDbtype());
     writer.open();
     const size_t LINE_BUFFER_SIZE = 1000000;
+    // only alignment results can contain packed records
+    const bool leftAlignment = Parameters::isEqualDbtype(leftDbr.getDbtype(), Parameters::DBTYPE_ALIGNMENT_RES);
+    const bool rightAlignment = Parameters::isEqualDbtype(rightDbr.getDbtype(), Parameters::DBTYPE_ALIGNMENT_RES);
 #pragma omp parallel
     {
         int thread_idx = 0;
@@ -54,13 +58,19 @@ void dosubstractresult(std::string leftDb, std::string rightDb, std::string outD
             {
                 char *data = (char *) leftData;
                 while (*data != '\0') {
-                    Util::parseKey(data, key);
+                    Util::parseKey(data, key, leftDbr.getDbtype());
                     unsigned int dbKey = std::strtoul(key, NULL, 10);
                     double evalue = 0.0;
-                    const size_t columns = Util::getWordsOfLine(data, entry, 255);
-                    // its an aln result (parse e-value)
-                    if (columns >= Matcher::ALN_RES_WITH_OUT_BT_COL_CNT) {
-                        evalue = strtod(entry[3], NULL);
+                    if (leftAlignment && PackedAlignment::isPacked(data)) {
+                        PackedAlignment::Record rec;
+                        PackedAlignment::readRecord(data, rec);
+                        evalue = rec.eval;
+                    } else {
+                        const size_t columns = Util::getWordsOfLine(data, entry, 255);
+                        // its an aln result (parse e-value)
+                        if (columns >= Matcher::ALN_RES_WITH_OUT_BT_COL_CNT) {
+                            evalue = strtod(entry[3], NULL);
+                        }
                     }
                     if(evalue <= evalThreshold){
                         elementLookup[dbKey] = true;
@@ -74,12 +84,18 @@ void dosubstractresult(std::string leftDb, std::string rightDb, std::string outD
 
             if (data != NULL) {
                 while (*data != '\0') {
-                    Util::parseKey(data, key);
+                    Util::parseKey(data, key, rightDbr.getDbtype());
                     unsigned int element = std::strtoul(key, NULL, 10);
                     double evalue = 0.0;
-                    const size_t columns = Util::getWordsOfLine(data, entry, 255);
-                    if (columns >= Matcher::ALN_RES_WITH_OUT_BT_COL_CNT) {
-                        evalue = strtod(entry[3], NULL);
+                    if (rightAlignment && PackedAlignment::isPacked(data)) {
+                        PackedAlignment::Record rec;
+                        PackedAlignment::readRecord(data, rec);
+                        evalue = rec.eval;
+                    } else {
+                        const size_t columns = Util::getWordsOfLine(data, entry, 255);
+                        if (columns >= Matcher::ALN_RES_WITH_OUT_BT_COL_CNT) {
+                            evalue = strtod(entry[3], NULL);
+                        }
                     }
                     if(evalue <= evalThreshold) {
                         elementLookup[element] = false;
@@ -93,7 +109,7 @@ void dosubstractresult(std::string leftDb, std::string rightDb, std::string outD
                 while (*data != '\0') {
                     char *start = data;
                     data = Util::skipLine(data);
-                    Util::parseKey(start, key);
+                    Util::parseKey(start, key, leftDbr.getDbtype());
                     unsigned int elementIdx = std::strtoul(key, NULL, 10);
                     if (elementLookup[elementIdx]) {
                         minusResultsOutString.append(start, data - start);
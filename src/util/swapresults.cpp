@@ -4,6 +4,7 @@
 #include "DBWriter.h"
 #include "Debug.h"
 #include "Util.h"
+#include "PackedAlignment.h"
 #include "QueryMatcher.h"
 #include "Parameters.h"
 #include "AlignmentSymmetry.h"
@@ -59,7 +60,7 @@ int doswap(Parameters& par, bool isGeneralMode) {
                 progress.updateProgress();
                 char *data = resultReader.getData(i, thread_idx);
                 while (*data != '\0') {
-                    Util::parseKey(data, key);
+                    Util::parseKey(data, key, resultReader.getDbtype());
                     unsigned int dbKey = std::strtoul(key, NULL, 10);
                     maxTargetId = std::max(maxTargetId, dbKey);
                     data = Util::skipLine(data);
@@ -90,6 +91,8 @@ int doswap(Parameters& par, bool isGeneralMode) {
     resultDbr.open(DBReader<unsigned int>::SORT_BY_OFFSET);
 
     const size_t resultSize = resultDbr.getSize();
+    // only alignment results can contain packed records
+    const bool alignmentInput = Parameters::isEqualDbtype(resultDbr.getDbtype(), Parameters::DBTYPE_ALIGNMENT_RES);
     Debug(Debug::INFO) << "Computing offsets.\n";
     size_t *targetElementSize = new size_t[maxTargetId + 2]; // extra element for offset + 1 index id
     memset(targetElementSize, 0, sizeof(size_t) * (maxTargetId + 2));
@@ -113,13 +116,14 @@ int doswap(Parameters& par, bool isGeneralMode) {
                 char *data = resultDbr.getData(i, thread_idx);
                 char dbKeyBuffer[255 + 1];
                 while (*data != '\0') {
-                    Util::parseKey(data, dbKeyBuffer);
-                    size_t targetKeyLen = strlen(dbKeyBuffer);
+                    Util::parseKey(data, dbKeyBuffer, resultDbr.getDbtype());
+                    const bool isPacked = alignmentInput && PackedAlignment::isPacked(data);
+                    size_t targetKeyLen = isPacked ? PackedAlignment::dbKeyLength(data) : strlen(dbKeyBuffer);
                     const unsigned int dbKey = (unsigned int) strtoul(dbKeyBuffer, NULL, 10);
                     char *nextLine = Util::skipLine(data);
                     size_t lineLen = nextLine - data;
                     lineLen -= targetKeyLen;
-                    lineLen += queryKeyLen;
+                    lineLen += isPacked ? PackedAlignment::uintLength(resultId) : queryKeyLen;
                     __sync_fetch_and_add(&(targetElementSize[dbKey]), lineLen);
                     data = nextLine;
                 }
@@ -178,21 +182,29 @@ int doswap(Parameters& par, bool isGeneralMode) {
                 char *tmpBuff = Itoa::u32toa_sse2((uint32_t) queryKey, queryKeyStr);
                 *(tmpBuff) = '\0';
                 size_t queryKeyLen = strlen(queryKeyStr);
+                char packedQueryKey[16];
+                size_t packedQueryKeyLen = PackedAlignment::writeUInt(packedQueryKey, queryKey) - packedQueryKey;
                 char dbKeyBuffer[255 + 1];
                 while (*data != '\0') {
-                    Util::parseKey(data, dbKeyBuffer);
-                    size_t targetKeyLen = strlen(dbKeyBuffer);
+                    Util::parseKey(data, dbKeyBuffer, resultDbr.getDbtype());
+                    const bool isPacked = alignmentInput && PackedAlignment::isPacked(data);
+                    // packed records keep their flags in front of the key
+                    size_t keyOffset = isPacked ? PackedAlignment::dbKeyOffset(data) : 0;
+                    size_t targetKeyLen = isPacked ? PackedAlignment::dbKeyLength(data) : strlen(dbKeyBuffer);
+                    const char *newKey = isPacked ? packedQueryKey : queryKeyStr;
+                    size_t newKeyLen = isPacked ? packedQueryKeyLen : queryKeyLen;
                     char *nextLine = Util::skipLine(data);
                     size_t oldLineLen = nextLine - data;
                     size_t newLineLen = oldLineLen;
                     newLineLen -= targetKeyLen;
-                    newLineLen += queryKeyLen;
+                    newLineLen += newKeyLen;
                     const unsigned int dbKey = (unsigned int) strtoul(dbKeyBuffer, NULL, 10);
                     // update offset but do not copy memory
                     size_t offset = __sync_fetch_and_add(&(targetElementSize[dbKey]), newLineLen) - prevBytesToWrite;
                     if(dbKey >= prevDbKeyToWrite && dbKey <=  dbKeyToWrite){
-                        memcpy(&tmpData[offset], queryKeyStr, queryKeyLen);
-                        memcpy(&tmpData[offset + queryKeyLen], data + targetKeyLen, oldLineLen - targetKeyLen);
+                        memcpy(&tmpData[offset], data, keyOffset);
+                        memcpy(&tmpData[offset + keyOffset], newKey, newKeyLen);
+                        memcpy(&tmpData[offset + keyOffset + newKeyLen], data + keyOffset + targetKeyLen, oldLineLen - keyOffset - targetKeyLen);
                     }
                     data = nextLine;
                 }
@@ -206,6 +218,7 @@ int doswap(Parameters& par, bool isGeneralMode) {
 
         Debug(Debug::INFO) << "\nOutput database: " << parOutDbStr << "\n";
         bool isAlignmentResult = false;
+        bool isPackedResult = false;
         bool hasBacktrace = false;
         const char *entry[255];
         for (size_t i = 0; i < resultDbr.getSize(); i++){
@@ -213,7 +226,8 @@ int doswap(Parameters& par, bool isGeneralMode) {
             if (*data == '\0'){
                 continue;
             }
-            const size_t columns = Util::getWordsOfLine(data, entry, 255);
+            isPackedResult = alignmentInput && PackedAlignment::isPacked(data);
+            const size_t columns = isPackedResult ? PackedAlignment::columnCount(data) : Util::getWordsOfLine(data, entry, 255);
             isAlignmentResult = columns >= Matcher::ALN_RES_WITH_OUT_BT_COL_CNT;
             hasBacktrace = columns >= Matcher::ALN_RES_WITH_BT_COL_CNT;
             break;
@@ -287,7 +301,8 @@ int doswap(Parameters& par, bool isGeneralMode) {
                     for (size_t j = 0; j < curRes.size(); j++) {
                         const Matcher::result_t &res = curRes[j];
                         if (isAlignmentResult) {
-                            size_t len = Matcher::resultToBuffer(buffer, res, hasBacktrace, false);
+                            size_t len = isPackedResult ? Matcher::resultToPackedBuffer(buffer, res, hasBacktrace)
+                                                        : Matcher::resultToBuffer(buffer, res, hasBacktrace, false);
                             ss.append(buffer, len);
                         } else {
                             hit_t hit;
@@ -372,6 +372,11 @@ int search(int argc, const char **argv, const Command& command) {
 
         float originalEval = par.evalThr;
         par.evalThr = (par.evalThr < par.evalProfile) ? par.evalThr  : par.evalProfile;
+        // a query without new hits keeps its profile, if the following iterations search with the same
+        // parameters they would only find the same hits again and the query can be skipped
+        bool sameIterationParameters = true;
+        std::string firstPrefilterPar;
+        std::string firstAlignmentPar;
         for (int i = 0; i < par.numIterations; i++) {
             if (i == 0 && (searchMode & Parameters::SEARCH_MODE_FLAG_TARGET_PROFILE) == false) {
                 par.realign = true;
@@ -386,22 +391,30 @@ int search(int argc, const char **argv, const Command& command) {
                 par.evalThr = originalEval;
             }
 
-            cmd.addVariable(std::string("PREFILTER_PAR_" + SSTR(i)).c_str(),
-                            par.createParameterString(par.prefilter).c_str());
+            std::string prefilterPar = par.createParameterString(par.prefilter);
+            std::string alignmentPar;
             if (isUngappedMode) {
                 par.rescoreMode = Parameters::RESCORE_MODE_ALIGNMENT;
-                cmd.addVariable(std::string("ALIGNMENT_PAR_" + SSTR(i)).c_str(),
-                                par.createParameterString(par.rescorediagonal).c_str());
+                alignmentPar = par.createParameterString(par.rescorediagonal);
                 par.rescoreMode = originalRescoreMode;
             } else {
-                cmd.addVariable(std::string("ALIGNMENT_PAR_" + SSTR(i)).c_str(),
-                                par.createParameterString(par.align).c_str());
+                alignmentPar = par.createParameterString(par.align);
             }
+            if (i == 1) {
+                firstPrefilterPar = prefilterPar;
+                firstAlignmentPar = alignmentPar;
+            } else if (i > 1 && (prefilterPar != firstPrefilterPar || alignmentPar != firstAlignmentPar)) {
+                sameIterationParameters = false;
+            }
+            cmd.addVariable(std::string("PREFILTER_PAR_" + SSTR(i)).c_str(), prefilterPar.c_str());
+            cmd.addVariable(std::string("ALIGNMENT_PAR_" + SSTR(i)).c_str(), alignmentPar.c_str());
             par.pca = 0.0;
             cmd.addVariable(std::string("PROFILE_PAR_" + SSTR(i)).c_str(),
                             par.createParameterString(par.result2profile).c_str());
             par.pca = 1.0;
         }
+        // converged queries are found by their empty alignment result, which only works without compression
+        cmd.addVariable("SKIP_CONVERGED", (sameIterationParameters && par.compressed == 0) ? "TRUE" : NULL);
 
         FileUtil::writeFile(tmpDir + "/blastpgp.sh", blastpgp_sh, blastpgp_sh_len);
         program = std::string(tmpDir + "/blastpgp.sh");